@@ -32,6 +32,11 @@ void CheckInplaceRegstDescId(const TaskProto& task_proto) {
     int64_t in_regst_desc_id = pair.second.inplace_consumed_regst_desc_id();
     CHECK(consumed_regst_desc_ids.find(in_regst_desc_id) != consumed_regst_desc_ids.end());
   }
+  for (const auto& pair : task_proto.produced_regst_desc()) {
+    for (const InplaceSubRegstDesc& sub : pair.second.inplace_sub_regst_desc()) {
+      CHECK(consumed_regst_desc_ids.find(sub.regst_desc_id()) != consumed_regst_desc_ids.end());
+    }
+  }
 }
 
 }  // namespace
@@ -46,6 +51,12 @@ bool IsLastRegstInPieceWithOrder(const Regst* regst, ColIdOrder order) {
          || (order == ColIdOrder::kDescending && regst->col_id() == 0);
 }
 
+Actor::~Actor() {
+  if (Global<RegstStallRecorder>::Get() != nullptr && !regst_desc_id2stall_time_.empty()) {
+    Global<RegstStallRecorder>::Get()->Add(regst_desc_id2stall_time_);
+  }
+}
+
 void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
                  const ThreadCtx& thread_ctx) {
   job_desc_ = job_desc;
@@ -69,6 +80,8 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
 
   remaining_eord_cnt_ = 0;
   msg_handler_ = nullptr;
+  is_stalled_on_writeable_ = false;
+  stall_begin_time_ = 0;
   eord_regst_desc_ids_.clear();
 
   for (const auto& pair : task_proto.produced_regst_desc()) {
@@ -112,11 +125,21 @@ void Actor::TakeOverInplaceConsumedAndProduced(
     const PbMap<std::string, RegstDescProto>& produced_ids) {
   for (const auto& pair : produced_ids) {
     int64_t out_regst_desc_id = pair.second.regst_desc_id();
-    if (pair.second.has_inplace_consumed_regst_desc_id() == false) { continue; }
-    int64_t in_regst_desc_id = pair.second.inplace_consumed_regst_desc_id();
-    inplace_regst_desc_id_in2out_.insert(std::make_pair(in_regst_desc_id, out_regst_desc_id));
-    inplace_regst_desc_id_out2in_.insert(std::make_pair(out_regst_desc_id, in_regst_desc_id));
-    inplace_consumed_rs_.InsertRegstDescId(in_regst_desc_id);
+    std::vector<std::pair<int64_t, int64_t>> in_regst_desc_id_and_offsets;
+    if (pair.second.has_inplace_consumed_regst_desc_id()) {
+      in_regst_desc_id_and_offsets.emplace_back(pair.second.inplace_consumed_regst_desc_id(), 0);
+    }
+    for (const InplaceSubRegstDesc& sub : pair.second.inplace_sub_regst_desc()) {
+      in_regst_desc_id_and_offsets.emplace_back(sub.regst_desc_id(), sub.byte_offset());
+    }
+    if (in_regst_desc_id_and_offsets.empty()) { continue; }
+    for (const auto& in_pair : in_regst_desc_id_and_offsets) {
+      int64_t in_regst_desc_id = in_pair.first;
+      CHECK(inplace_regst_desc_id_in2out_.emplace(in_regst_desc_id, out_regst_desc_id).second);
+      inplace_regst_desc_id2byte_offset_.emplace(in_regst_desc_id, in_pair.second);
+      inplace_regst_desc_id_out2in_[out_regst_desc_id].push_back(in_regst_desc_id);
+      inplace_consumed_rs_.InsertRegstDescId(in_regst_desc_id);
+    }
     inplace_produced_rs_.InsertRegstDescId(out_regst_desc_id);
   }
   inplace_consumed_rs_.InitedDone();
@@ -126,9 +149,9 @@ void Actor::TakeOverInplaceConsumedAndProduced(
       for (const auto& regst : pair.second) {
         CHECK_EQ(0, inplace_produced_rs_.TryPushBackRegst(regst.get()));
         if (regst->consumers_actor_id().size() == 0) {
-          CHECK(inplace_in_ids_with_no_out_consumed_
-                    .emplace(inplace_regst_desc_id_out2in_.at(pair.first))
-                    .second);
+          for (int64_t in_regst_desc_id : inplace_regst_desc_id_out2in_.at(pair.first)) {
+            CHECK(inplace_in_ids_with_no_out_consumed_.emplace(in_regst_desc_id).second);
+          }
         }
       }
     }
@@ -292,8 +315,10 @@ int Actor::HandlerNormal(const ActorMsg& msg) {
       } else if (inplace_consumed_rs_.HasRegstDescId(regst->regst_desc_id())) {
         CHECK_EQ(0, inplace_consumed_rs_.TryPushBackRegst(regst));
         int64_t out_regst_desc_id = inplace_regst_desc_id_in2out_.at(regst->regst_desc_id());
+        const char* out_dptr = static_cast<const char*>(
+            inplace_produced_rs_.Front(out_regst_desc_id)->packed_blob()->dptr());
         CHECK(regst->packed_blob()->dptr()
-              == inplace_produced_rs_.Front(out_regst_desc_id)->packed_blob()->dptr());
+              == out_dptr + inplace_regst_desc_id2byte_offset_.at(regst->regst_desc_id()));
       } else if (TryUpdtStateAsProducedRegst(regst) == 0) {
         // do nothing
       } else {
@@ -398,6 +423,32 @@ void Actor::ActUntilFail() {
 
     AsyncSendQueuedMsg();
   }
+  if (Global<RegstStallRecorder>::Get() != nullptr) { UpdtRegstStallTime(); }
+}
+
+void Actor::UpdtRegstStallTime() {
+  const double cur_time = GetCurTime();
+  for (int64_t regst_desc_id : stalled_regst_desc_ids_) {
+    RegstStallTime* stall_time = &regst_desc_id2stall_time_[regst_desc_id];
+    if (is_stalled_on_writeable_) {
+      stall_time->writeable_wait_time += cur_time - stall_begin_time_;
+    } else {
+      stall_time->readable_wait_time += cur_time - stall_begin_time_;
+    }
+  }
+  stalled_regst_desc_ids_.clear();
+  auto AddStalledRegstDescId = [&](int64_t regst_desc_id) {
+    stalled_regst_desc_ids_.push_back(regst_desc_id);
+  };
+  is_stalled_on_writeable_ = !IsWriteReady();
+  if (is_stalled_on_writeable_) {
+    naive_produced_rs_.ForEachEmptyRegstDescId(AddStalledRegstDescId);
+    inplace_produced_rs_.ForEachEmptyRegstDescId(AddStalledRegstDescId);
+  } else {
+    naive_consumed_rs_.ForEachEmptyRegstDescId(AddStalledRegstDescId);
+    inplace_consumed_rs_.ForEachEmptyRegstDescId(AddStalledRegstDescId);
+  }
+  stall_begin_time_ = cur_time;
 }
 
 void Actor::AsyncSendNaiveProducedRegstMsgToConsumer() {
@@ -645,11 +696,12 @@ int Actor::TryUpdtStateAsProducedRegst(Regst* regst) {
   if (reading_cnt_it->second != 0) { return 0; }
 
   if (inplace_produced_rs_.TryPushBackRegst(regst) == 0) {
-    int64_t in_regst_desc_id = inplace_regst_desc_id_out2in_.at(regst->regst_desc_id());
-    Regst* in_regst = inplace_consumed_rs_.Front(in_regst_desc_id);
-    CHECK(in_regst);
-    AsyncSendRegstMsgToProducer(in_regst);
-    CHECK_EQ(0, inplace_consumed_rs_.TryPopFrontRegst(in_regst_desc_id));
+    for (int64_t in_regst_desc_id : inplace_regst_desc_id_out2in_.at(regst->regst_desc_id())) {
+      Regst* in_regst = inplace_consumed_rs_.Front(in_regst_desc_id);
+      CHECK(in_regst);
+      AsyncSendRegstMsgToProducer(in_regst);
+      CHECK_EQ(0, inplace_consumed_rs_.TryPopFrontRegst(in_regst_desc_id));
+    }
   } else if (naive_produced_rs_.TryPushBackRegst(regst) != 0) {
     UpdtStateAsCustomizedProducedRegst(regst);
   }
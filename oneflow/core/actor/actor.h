@@ -27,6 +27,7 @@ limitations under the License.
 #include "oneflow/core/register/register_manager.h"
 #include "oneflow/core/thread/thread_context.h"
 #include "oneflow/core/actor/register_slot.h"
+#include "oneflow/core/actor/regst_stall_recorder.h"
 
 namespace oneflow {
 
@@ -38,7 +39,7 @@ bool IsLastRegstInPieceWithOrder(const Regst*, ColIdOrder);
 class Actor {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Actor);
-  virtual ~Actor() = default;
+  virtual ~Actor();
 
   const JobDesc& job_desc() const { return *job_desc_; }
 
@@ -172,6 +173,7 @@ class Actor {
                   // area
   }
   void TryLogActEvent(const std::function<void()>& Callback) const;
+  void UpdtRegstStallTime();
 
   // Ready
   bool IsReadReady() const;
@@ -243,11 +245,18 @@ class Actor {
   bool is_inplace_consumed_eord_;
   HashSet<int64_t> inplace_in_ids_with_no_out_consumed_;
   HashMap<int64_t, int64_t> inplace_regst_desc_id_in2out_;
-  HashMap<int64_t, int64_t> inplace_regst_desc_id_out2in_;
+  HashMap<int64_t, std::vector<int64_t>> inplace_regst_desc_id_out2in_;
+  HashMap<int64_t, int64_t> inplace_regst_desc_id2byte_offset_;
 
   std::deque<ActorMsg> async_msg_queue_;
   bool is_kernel_launch_synchronized_;
   std::vector<int64_t> tmp_regst_desc_id_vec_;
+
+  // regst descs the actor has been blocked on since stall_begin_time_
+  std::vector<int64_t> stalled_regst_desc_ids_;
+  bool is_stalled_on_writeable_;
+  double stall_begin_time_;
+  HashMap<int64_t, RegstStallTime> regst_desc_id2stall_time_;
 };
 
 std::unique_ptr<Actor> NewActor(const TaskProto&, const ThreadCtx&);
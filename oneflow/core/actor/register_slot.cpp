@@ -102,6 +102,12 @@ void RegstSlot::ForChosenRegstDeq(std::function<bool(int64_t)> IsChosenRegstDesc
   }
 }
 
+void RegstSlot::ForEachEmptyRegstDescId(const std::function<void(int64_t)>& Handler) const {
+  for (const auto& kv : regst_desc_id2regsts_) {
+    if (kv.second.empty()) { Handler(kv.first); }
+  }
+}
+
 void RegstSlot::ForEachFrontRegst(std::function<void(Regst*)> Handler) const {
   ForChosenFrontRegst([](int64_t) { return true; }, Handler);
 }
@@ -38,6 +38,7 @@ class RegstSlot final {
   void ForChosenFrontRegst(std::function<bool(int64_t)>, std::function<void(Regst*)>) const;
   void ForChosenRegstDeq(std::function<bool(int64_t)>,
                          std::function<void(const std::deque<Regst*>&)>) const;
+  void ForEachEmptyRegstDescId(const std::function<void(int64_t)>&) const;
 
   Regst* Front(int64_t regst_desc_id) const;
   Regst* SoleFront() const;
@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/regst_stall_recorder.h"
+
+namespace oneflow {
+
+namespace {
+
+void AddStallTime(const RegstStallTime& stall_time, RegstStallTime* sum) {
+  sum->writeable_wait_time += stall_time.writeable_wait_time;
+  sum->readable_wait_time += stall_time.readable_wait_time;
+}
+
+}  // namespace
+
+void RegstStallRecorder::Add(const HashMap<int64_t, RegstStallTime>& regst_desc_id2stall_time) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const auto& pair : regst_desc_id2stall_time) {
+    AddStallTime(pair.second, &regst_desc_id2stall_time_[pair.first]);
+  }
+}
+
+void RegstStallRecorder::ToProto(RegstStallList* regst_stall_list) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  regst_stall_list->Clear();
+  for (const auto& pair : regst_desc_id2stall_time_) {
+    RegstStall* regst_stall = regst_stall_list->add_regst_stall();
+    regst_stall->set_regst_desc_id(pair.first);
+    regst_stall->set_writeable_wait_time(pair.second.writeable_wait_time);
+    regst_stall->set_readable_wait_time(pair.second.readable_wait_time);
+  }
+}
+
+void MergeRegstStallList(const RegstStallList& other, RegstStallList* regst_stall_list) {
+  RegstStallRecorder merged;
+  for (const RegstStallList* list : std::vector<const RegstStallList*>{regst_stall_list, &other}) {
+    HashMap<int64_t, RegstStallTime> regst_desc_id2stall_time;
+    for (const RegstStall& regst_stall : list->regst_stall()) {
+      RegstStallTime* stall_time = &regst_desc_id2stall_time[regst_stall.regst_desc_id()];
+      stall_time->writeable_wait_time += regst_stall.writeable_wait_time();
+      stall_time->readable_wait_time += regst_stall.readable_wait_time();
+    }
+    merged.Add(regst_desc_id2stall_time);
+  }
+  merged.ToProto(regst_stall_list);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_ACTOR_REGST_STALL_RECORDER_H_
+#define ONEFLOW_CORE_ACTOR_REGST_STALL_RECORDER_H_
+
+#include <mutex>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+struct RegstStallTime {
+  double writeable_wait_time = 0;
+  double readable_wait_time = 0;
+};
+
+// Sums up, over the actors of this machine, how long they were blocked on each regst desc. Actors
+// only measure while it exists, so it is created around the runtimes used for regst_num tuning.
+class RegstStallRecorder final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RegstStallRecorder);
+  RegstStallRecorder() = default;
+  ~RegstStallRecorder() = default;
+
+  void Add(const HashMap<int64_t, RegstStallTime>& regst_desc_id2stall_time);
+  void ToProto(RegstStallList* regst_stall_list) const;
+
+ private:
+  mutable std::mutex mutex_;
+  HashMap<int64_t, RegstStallTime> regst_desc_id2stall_time_;
+};
+
+void MergeRegstStallList(const RegstStallList& other, RegstStallList* regst_stall_list);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_ACTOR_REGST_STALL_RECORDER_H_
@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/regst_stall_recorder.h"
+
+namespace oneflow {
+
+namespace {
+
+void AddRegstStall(int64_t regst_desc_id, double writeable_wait_time, double readable_wait_time,
+                   RegstStallList* regst_stall_list) {
+  RegstStall* regst_stall = regst_stall_list->add_regst_stall();
+  regst_stall->set_regst_desc_id(regst_desc_id);
+  regst_stall->set_writeable_wait_time(writeable_wait_time);
+  regst_stall->set_readable_wait_time(readable_wait_time);
+}
+
+HashMap<int64_t, const RegstStall*> RegstStall4RegstDescId(const RegstStallList& regst_stall_list) {
+  HashMap<int64_t, const RegstStall*> regst_desc_id2regst_stall;
+  for (const RegstStall& regst_stall : regst_stall_list.regst_stall()) {
+    CHECK(regst_desc_id2regst_stall.emplace(regst_stall.regst_desc_id(), &regst_stall).second);
+  }
+  return regst_desc_id2regst_stall;
+}
+
+}  // namespace
+
+TEST(RegstStallRecorder, merge_regst_stall_list) {
+  RegstStallList regst_stall_list;
+  AddRegstStall(1, 2, 1, &regst_stall_list);
+  AddRegstStall(2, 0, 3, &regst_stall_list);
+  RegstStallList other;
+  AddRegstStall(1, 1.5, 0, &other);
+  AddRegstStall(3, 4, 0, &other);
+  MergeRegstStallList(other, &regst_stall_list);
+
+  const auto regst_desc_id2regst_stall = RegstStall4RegstDescId(regst_stall_list);
+  ASSERT_EQ(regst_desc_id2regst_stall.size(), 3);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(1)->writeable_wait_time(), 3.5);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(1)->readable_wait_time(), 1);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(2)->writeable_wait_time(), 0);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(2)->readable_wait_time(), 3);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(3)->writeable_wait_time(), 4);
+  ASSERT_DOUBLE_EQ(regst_desc_id2regst_stall.at(3)->readable_wait_time(), 0);
+}
+
+TEST(RegstStallRecorder, merge_into_empty_list) {
+  RegstStallList regst_stall_list;
+  RegstStallList other;
+  AddRegstStall(5, 1, 2, &other);
+  MergeRegstStallList(other, &regst_stall_list);
+  ASSERT_EQ(regst_stall_list.regst_stall_size(), 1);
+  ASSERT_EQ(regst_stall_list.regst_stall(0).regst_desc_id(), 5);
+  ASSERT_DOUBLE_EQ(regst_stall_list.regst_stall(0).writeable_wait_time(), 1);
+  ASSERT_DOUBLE_EQ(regst_stall_list.regst_stall(0).readable_wait_time(), 2);
+}
+
+}  // namespace oneflow
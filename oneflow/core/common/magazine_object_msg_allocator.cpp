@@ -0,0 +1,201 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <algorithm>
+#include <functional>
+#include "oneflow/core/common/magazine_object_msg_allocator.h"
+
+namespace oneflow {
+
+namespace {
+
+struct ThreadExitHook final {
+  ~ThreadExitHook() {
+    if (OnExit) { OnExit(); }
+  }
+  std::function<void()> OnExit;
+};
+
+}  // namespace
+
+class MagazineObjectMsgAllocator::ThreadCache final {
+ public:
+  ThreadCache(const ThreadCache&) = delete;
+  ThreadCache(ThreadCache&&) = delete;
+  explicit ThreadCache(MagazineObjectMsgAllocator* allocator)
+      : allocator_(allocator), allocate_cnt_(0) {
+    for (int i = 0; i < kSizeClassNum; ++i) {
+      size_class2head_[i] = nullptr;
+      size_class2block_cnt_[i] = 0;
+    }
+    std::unique_lock<std::mutex> lock(allocator_->thread_cache_mutex_);
+    allocator_->thread_caches_.push_back(this);
+  }
+  ~ThreadCache() {
+    for (int i = 0; i < kSizeClassNum; ++i) {
+      FreeBlock* head = size_class2head_[i];
+      if (head == nullptr) { continue; }
+      FreeBlock* tail = head;
+      while (tail->next != nullptr) { tail = tail->next; }
+      allocator_->PushFreeList(i, head, tail);
+    }
+    std::unique_lock<std::mutex> lock(allocator_->thread_cache_mutex_);
+    auto* thread_caches = &allocator_->thread_caches_;
+    thread_caches->erase(std::find(thread_caches->begin(), thread_caches->end(), this));
+    allocator_->exited_thread_allocate_cnt_ += allocate_cnt();
+  }
+
+  int64_t allocate_cnt() const { return allocate_cnt_.load(std::memory_order_relaxed); }
+
+  char* Allocate(int size_class) {
+    if (size_class2head_[size_class] == nullptr) { Refill(size_class); }
+    FreeBlock* block = size_class2head_[size_class];
+    size_class2head_[size_class] = block->next;
+    --size_class2block_cnt_[size_class];
+    // only this thread writes the counter, others just read it
+    allocate_cnt_.store(allocate_cnt() + 1, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(block);
+  }
+
+  void Deallocate(int size_class, char* ptr) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(ptr);
+    block->next = size_class2head_[size_class];
+    size_class2head_[size_class] = block;
+    if (++size_class2block_cnt_[size_class] >= 2 * kMagazineSize) { Spill(size_class); }
+  }
+
+ private:
+  void Refill(int size_class) {
+    FreeBlock* head = allocator_->TakeFreeList(size_class);
+    int64_t block_cnt = 0;
+    if (head == nullptr) {
+      head = allocator_->NewSlab(size_class, &block_cnt);
+    } else {
+      for (FreeBlock* block = head; block != nullptr; block = block->next) { ++block_cnt; }
+    }
+    size_class2head_[size_class] = head;
+    size_class2block_cnt_[size_class] = block_cnt;
+  }
+
+  // keeps the most recently freed magazine and hands the rest to other threads
+  void Spill(int size_class) {
+    FreeBlock* last_kept = size_class2head_[size_class];
+    for (int64_t i = 1; i < kMagazineSize; ++i) { last_kept = last_kept->next; }
+    FreeBlock* head = last_kept->next;
+    last_kept->next = nullptr;
+    FreeBlock* tail = head;
+    while (tail->next != nullptr) { tail = tail->next; }
+    allocator_->PushFreeList(size_class, head, tail);
+    size_class2block_cnt_[size_class] = kMagazineSize;
+  }
+
+  MagazineObjectMsgAllocator* allocator_;
+  FreeBlock* size_class2head_[kSizeClassNum];
+  int64_t size_class2block_cnt_[kSizeClassNum];
+  std::atomic<int64_t> allocate_cnt_;
+};
+
+MagazineObjectMsgAllocator::MagazineObjectMsgAllocator(ObjectMsgAllocator* backend_allocator)
+    : backend_allocator_(backend_allocator), slab_byte_size_(0), exited_thread_allocate_cnt_(0) {
+  for (int i = 0; i < kSizeClassNum; ++i) { size_class2free_list_[i] = nullptr; }
+}
+
+MagazineObjectMsgAllocator* MagazineObjectMsgAllocator::GlobalAllocator() {
+  static MagazineObjectMsgAllocator* allocator =
+      new MagazineObjectMsgAllocator(ObjectMsgDefaultAllocator::GlobalObjectMsgAllocator());
+  return allocator;
+}
+
+int MagazineObjectMsgAllocator::SizeClass4Size(std::size_t size) {
+  int shift = kSizeClassShiftMin;
+  while ((static_cast<std::size_t>(1) << shift) < size) { ++shift; }
+  return shift <= kSizeClassShiftMax ? shift - kSizeClassShiftMin : -1;
+}
+
+MagazineObjectMsgAllocator::ThreadCache* MagazineObjectMsgAllocator::GetThreadCache() {
+  // plain pointers stay valid after thread_local destructors ran, unlike a thread_local object,
+  // so object msgs released by other thread_local or static destructors still find their way
+  static thread_local ThreadCache* thread_cache = nullptr;
+  static thread_local bool is_thread_exiting = false;
+  if (thread_cache == nullptr && !is_thread_exiting) {
+    static thread_local ThreadExitHook thread_exit_hook;
+    thread_cache = new ThreadCache(this);
+    thread_exit_hook.OnExit = []() {
+      is_thread_exiting = true;
+      delete thread_cache;
+      thread_cache = nullptr;
+    };
+  }
+  return thread_cache;
+}
+
+char* MagazineObjectMsgAllocator::Allocate(std::size_t size) {
+  const int size_class = SizeClass4Size(size);
+  if (size_class < 0) { return backend_allocator_->Allocate(size); }
+  ThreadCache* thread_cache = GetThreadCache();
+  if (thread_cache != nullptr) { return thread_cache->Allocate(size_class); }
+  ++exited_thread_allocate_cnt_;
+  return backend_allocator_->Allocate(static_cast<std::size_t>(1)
+                                      << (size_class + kSizeClassShiftMin));
+}
+
+void MagazineObjectMsgAllocator::Deallocate(char* ptr, std::size_t size) {
+  const int size_class = SizeClass4Size(size);
+  if (size_class < 0) { return backend_allocator_->Deallocate(ptr, size); }
+  ThreadCache* thread_cache = GetThreadCache();
+  if (thread_cache != nullptr) { return thread_cache->Deallocate(size_class, ptr); }
+  FreeBlock* block = reinterpret_cast<FreeBlock*>(ptr);
+  PushFreeList(size_class, block, block);
+}
+
+int64_t MagazineObjectMsgAllocator::allocate_cnt() const {
+  std::unique_lock<std::mutex> lock(thread_cache_mutex_);
+  int64_t allocate_cnt = exited_thread_allocate_cnt_;
+  for (const ThreadCache* thread_cache : thread_caches_) {
+    allocate_cnt += thread_cache->allocate_cnt();
+  }
+  return allocate_cnt;
+}
+
+MagazineObjectMsgAllocator::FreeBlock* MagazineObjectMsgAllocator::TakeFreeList(int size_class) {
+  // taking the whole list at once is what keeps the list free of the ABA problem
+  return size_class2free_list_[size_class].exchange(nullptr, std::memory_order_acquire);
+}
+
+void MagazineObjectMsgAllocator::PushFreeList(int size_class, FreeBlock* head, FreeBlock* tail) {
+  std::atomic<FreeBlock*>* free_list = &size_class2free_list_[size_class];
+  FreeBlock* old_head = free_list->load(std::memory_order_relaxed);
+  do {
+    tail->next = old_head;
+  } while (!free_list->compare_exchange_weak(old_head, head, std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+MagazineObjectMsgAllocator::FreeBlock* MagazineObjectMsgAllocator::NewSlab(int size_class,
+                                                                           int64_t* block_cnt) {
+  const std::size_t block_size = static_cast<std::size_t>(1) << (size_class + kSizeClassShiftMin);
+  *block_cnt = std::max<int64_t>(kSlabSize / block_size, 1);
+  char* slab = backend_allocator_->Allocate(*block_cnt * block_size);
+  slab_byte_size_ += *block_cnt * block_size;
+  FreeBlock* head = nullptr;
+  for (int64_t i = *block_cnt - 1; i >= 0; --i) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * block_size);
+    block->next = head;
+    head = block;
+  }
+  return head;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MAGAZINE_OBJECT_MSG_ALLOCATOR_H_
+#define ONEFLOW_CORE_COMMON_MAGAZINE_OBJECT_MSG_ALLOCATOR_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "oneflow/core/object_msg/object_msg.h"
+
+namespace oneflow {
+
+// Size-class allocator for object msgs that are allocated on one thread and freed on another,
+// e.g. instruction msgs built by the main thread and released by the vm scheduler.
+//
+// Every thread keeps a magazine of free blocks per size class and serves Allocate/Deallocate from
+// it without any synchronization. A thread whose magazine overflows pushes a batch of blocks onto
+// the lock-free free list of the size class, and a thread whose magazine runs dry takes the whole
+// list at once, so blocks flow back from the freeing thread to the allocating one without locks.
+// Memory is carved from slabs of the backend allocator and is never given back.
+class MagazineObjectMsgAllocator final : public ObjectMsgAllocator {
+ public:
+  MagazineObjectMsgAllocator(const MagazineObjectMsgAllocator&) = delete;
+  MagazineObjectMsgAllocator(MagazineObjectMsgAllocator&&) = delete;
+  ~MagazineObjectMsgAllocator() override = default;
+
+  // leaked on purpose, thread caches flush into it when their threads exit
+  static MagazineObjectMsgAllocator* GlobalAllocator();
+
+  char* Allocate(std::size_t size) override;
+  void Deallocate(char* ptr, std::size_t size) override;
+
+  // number of Allocate calls on all threads so far
+  int64_t allocate_cnt() const;
+  int64_t slab_byte_size() const { return slab_byte_size_.load(); }
+
+  static const int kSizeClassShiftMin = 5;
+  static const int kSizeClassShiftMax = 12;
+  static const int kSizeClassNum = kSizeClassShiftMax - kSizeClassShiftMin + 1;
+  static const int64_t kMagazineSize = 64;
+  static const std::size_t kSlabSize = 64 * 1024;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  class ThreadCache;
+  friend class ThreadCache;
+
+  explicit MagazineObjectMsgAllocator(ObjectMsgAllocator* backend_allocator);
+
+  static int SizeClass4Size(std::size_t size);
+  ThreadCache* GetThreadCache();
+  FreeBlock* TakeFreeList(int size_class);
+  void PushFreeList(int size_class, FreeBlock* head, FreeBlock* tail);
+  FreeBlock* NewSlab(int size_class, int64_t* block_cnt);
+
+  ObjectMsgAllocator* backend_allocator_;
+  std::atomic<FreeBlock*> size_class2free_list_[kSizeClassNum];
+  std::atomic<int64_t> slab_byte_size_;
+  mutable std::mutex thread_cache_mutex_;
+  std::vector<const ThreadCache*> thread_caches_;
+  std::atomic<int64_t> exited_thread_allocate_cnt_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MAGAZINE_OBJECT_MSG_ALLOCATOR_H_
@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <thread>
+#include "oneflow/core/common/magazine_object_msg_allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(MagazineObjectMsgAllocator, allocate_deallocate) {
+  MagazineObjectMsgAllocator* allocator = MagazineObjectMsgAllocator::GlobalAllocator();
+  const int64_t allocate_cnt = allocator->allocate_cnt();
+  for (std::size_t size : {1, 32, 33, 1000, 4096, 4097, 100000}) {
+    char* ptr = allocator->Allocate(size);
+    std::memset(ptr, 0xff, size);
+    allocator->Deallocate(ptr, size);
+  }
+  // blocks larger than the biggest size class are not served by the magazines
+  ASSERT_EQ(allocator->allocate_cnt(), allocate_cnt + 5);
+}
+
+TEST(MagazineObjectMsgAllocator, reuse_blocks_freed_by_other_thread) {
+  MagazineObjectMsgAllocator* allocator = MagazineObjectMsgAllocator::GlobalAllocator();
+  const std::size_t size = 200;
+  const int64_t block_num = 10 * MagazineObjectMsgAllocator::kMagazineSize;
+  std::vector<char*> ptrs;
+  for (int64_t i = 0; i < block_num; ++i) { ptrs.push_back(allocator->Allocate(size)); }
+  std::thread([&]() {
+    for (char* ptr : ptrs) { allocator->Deallocate(ptr, size); }
+  }).join();
+  const int64_t slab_byte_size = allocator->slab_byte_size();
+  for (int64_t i = 0; i < block_num; ++i) { ptrs.at(i) = allocator->Allocate(size); }
+  ASSERT_EQ(allocator->slab_byte_size(), slab_byte_size);
+  std::sort(ptrs.begin(), ptrs.end());
+  ASSERT_TRUE(std::unique(ptrs.begin(), ptrs.end()) == ptrs.end());
+  for (char* ptr : ptrs) { allocator->Deallocate(ptr, size); }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -189,6 +189,18 @@ void NumaAwareCudaMallocHost(int32_t dev, void** ptr, size_t size) {
 #endif
 }
 
+std::vector<int32_t> CudaDeviceGetLocalCpus(int32_t dev) {
+  std::vector<int32_t> cpus;
+#ifdef PLATFORM_POSIX
+  cpu_set_t cpu_set;
+  CudaDeviceGetCpuAffinity(dev, &cpu_set);
+  FOR_RANGE(int32_t, cpu, 0, CPU_SETSIZE) {
+    if (CPU_ISSET(cpu, &cpu_set)) { cpus.push_back(cpu); }
+  }
+#endif
+  return cpus;
+}
+
 cudaDataType_t GetCudaDataType(DataType val) {
 #define MAKE_ENTRY(type_cpp, type_cuda) \
   if (val == GetDataType<type_cpp>::value) { return type_cuda; }
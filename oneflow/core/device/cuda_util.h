@@ -94,6 +94,9 @@ void NumaAwareCudaMallocHost(int32_t dev, T** ptr, size_t size) {
   NumaAwareCudaMallocHost(dev, reinterpret_cast<void**>(ptr), size);
 }
 
+// Cpus attached to the same numa node as the device, empty if unknown.
+std::vector<int32_t> CudaDeviceGetLocalCpus(int32_t dev);
+
 #define CUDA_DATA_TYPE_SEQ                 \
   OF_PP_MAKE_TUPLE_SEQ(float, CUDA_R_32F)  \
   OF_PP_MAKE_TUPLE_SEQ(double, CUDA_R_64F) \
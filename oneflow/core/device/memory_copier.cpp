@@ -13,9 +13,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "oneflow/core/device/memory_copier.h"
 #include "oneflow/core/common/auto_registration_factory.h"
-#include "oneflow/core/common/nd_index_offset_helper.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -75,30 +78,108 @@ MemoryCopyNdDesc GetDescInBytes(const MemoryCopyNdDesc& desc) {
   return desc_in_bytes;
 }
 
-}  // namespace
+// Bytes moved by one task of the thread pool, smaller copies run on the calling thread.
+const int64_t kHostCopyTaskByteSize = 1 << 18;
+// Copies writing more than this bypass the cache with non-temporal stores, the destination would
+// only evict the working set of the caller.
+const int64_t kHostNonTemporalCopyByteSize = 1 << 24;
+const int64_t kHostNonTemporalMinRowSize = 256;
+
+void NonTemporalCopy(unsigned char* dst, const unsigned char* src, size_t count) {
+#ifdef __SSE2__
+  const size_t head = std::min(count, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+  std::memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  count -= head;
+  const size_t body = count / 64 * 64;
+  for (size_t i = 0; i < body; i += 64) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+    const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+    const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), v0);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), v1);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), v2);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), v3);
+  }
+  std::memcpy(dst + body, src + body, count - body);
+#else
+  std::memcpy(dst, src, count);
+#endif
+}
+
+void NonTemporalCopyFence() {
+#ifdef __SSE2__
+  _mm_sfence();
+#endif
+}
 
-template<int32_t NDIMS>
-void CopyNDCpuImpl(DeviceCtx* ctx, void* dst, const void* src, const MemoryCopyNdDesc& desc) {
-  NdIndexOffsetHelper<int64_t, NDIMS> src_helper(desc.src_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> dst_helper(desc.dst_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> copy_helper(desc.extent.dim_vec().data());
-  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
-    int64_t copy_idx[NDIMS];
-    int64_t src_idx[NDIMS];
-    int64_t dst_idx[NDIMS];
-    copy_helper.OffsetToNdIndex(i, copy_idx);
-    FOR_RANGE(int64_t, j, 0, NDIMS) {
-      src_idx[j] = desc.src_pos.At(j) + copy_idx[j];
-      dst_idx[j] = desc.dst_pos.At(j) + copy_idx[j];
+// The copy as rows of row_size contiguous bytes, which are enumerated by the outer axes.
+struct HostCopyRows {
+  int64_t row_size;
+  int64_t row_num;
+  std::vector<int64_t> outer_extent;
+  std::vector<int64_t> dst_strides;
+  std::vector<int64_t> src_strides;
+  int64_t dst_offset;
+  int64_t src_offset;
+};
+
+HostCopyRows GetHostCopyRows(const MemoryCopyNdDesc& desc) {
+  const int64_t num_axes = MemoryCopyNdDescGetNumAxes(desc);
+  HostCopyRows rows;
+  rows.row_size = desc.extent.At(num_axes - 1);
+  rows.row_num = 1;
+  rows.dst_offset = desc.dst_pos.At(num_axes - 1);
+  rows.src_offset = desc.src_pos.At(num_axes - 1);
+  FOR_RANGE(int64_t, i, 0, num_axes - 1) {
+    rows.outer_extent.push_back(desc.extent.At(i));
+    rows.dst_strides.push_back(desc.dst_shape.Count(i + 1));
+    rows.src_strides.push_back(desc.src_shape.Count(i + 1));
+    rows.row_num *= desc.extent.At(i);
+    rows.dst_offset += desc.dst_pos.At(i) * rows.dst_strides.back();
+    rows.src_offset += desc.src_pos.At(i) * rows.src_strides.back();
+  }
+  return rows;
+}
+
+// Copies row_cnt rows from row_begin, or the [col_begin, col_end) bytes of them.
+void CopyHostRows(const HostCopyRows& rows, int64_t row_begin, int64_t row_cnt, int64_t col_begin,
+                  int64_t col_end, bool non_temporal, unsigned char* dst,
+                  const unsigned char* src) {
+  const int64_t outer_num_axes = rows.outer_extent.size();
+  std::vector<int64_t> index(outer_num_axes);
+  int64_t dst_offset = rows.dst_offset + col_begin;
+  int64_t src_offset = rows.src_offset + col_begin;
+  int64_t remaining = row_begin;
+  for (int64_t i = outer_num_axes - 1; i >= 0; --i) {
+    index.at(i) = remaining % rows.outer_extent.at(i);
+    remaining /= rows.outer_extent.at(i);
+    dst_offset += index.at(i) * rows.dst_strides.at(i);
+    src_offset += index.at(i) * rows.src_strides.at(i);
+  }
+  const size_t count = col_end - col_begin;
+  FOR_RANGE(int64_t, row, 0, row_cnt) {
+    if (non_temporal) {
+      NonTemporalCopy(dst + dst_offset, src + src_offset, count);
+    } else {
+      std::memcpy(dst + dst_offset, src + src_offset, count);
+    }
+    for (int64_t i = outer_num_axes - 1; i >= 0; --i) {
+      dst_offset += rows.dst_strides.at(i);
+      src_offset += rows.src_strides.at(i);
+      if (++index.at(i) < rows.outer_extent.at(i)) { break; }
+      dst_offset -= index.at(i) * rows.dst_strides.at(i);
+      src_offset -= index.at(i) * rows.src_strides.at(i);
+      index.at(i) = 0;
     }
-    const int64_t src_offset = src_helper.NdIndexToOffset(src_idx);
-    const int64_t dst_offset = dst_helper.NdIndexToOffset(dst_idx);
-    unsigned char* dst_ptr = reinterpret_cast<unsigned char*>(dst) + dst_offset;
-    const unsigned char* src_ptr = reinterpret_cast<const unsigned char*>(src) + src_offset;
-    *dst_ptr = *src_ptr;
   }
+  if (non_temporal) { NonTemporalCopyFence(); }
 }
 
+}  // namespace
+
 MemoryCopyNdDesc MemoryCopyNdDesc::CreateDimReducedDesc() const {
   MemoryCopyNdDesc reduced;
   DimVector dst_shape_vec;
@@ -198,18 +279,30 @@ void HostMemoryCopier::Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t
   memcpy(dst, src, count);
 }
 
-void HostMemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
-                              const MemoryCopyNdDesc& desc) const {
-  const int32_t num_axes = desc.src_shape.NumAxes();
-  if (num_axes == 4) {
-    CopyNDCpuImpl<4>(ctx, dst, src, desc);
-  } else if (num_axes == 5) {
-    CopyNDCpuImpl<5>(ctx, dst, src, desc);
-  } else if (num_axes == 6) {
-    CopyNDCpuImpl<6>(ctx, dst, src, desc);
-  } else {
-    UNIMPLEMENTED();
-  }
+void HostMemoryCopier::Copy(DeviceCtx* ctx, void* dst, const void* src,
+                            const MemoryCopyNdDesc& desc) const {
+  CheckMemoryCopyNdDesc(desc);
+  const HostCopyRows rows = GetHostCopyRows(desc.CreateDimReducedDesc());
+  const int64_t byte_size = rows.row_num * rows.row_size;
+  if (byte_size == 0) { return; }
+  const bool non_temporal =
+      byte_size >= kHostNonTemporalCopyByteSize && rows.row_size >= kHostNonTemporalMinRowSize;
+  // long rows are split into byte ranges, short ones are batched
+  const int64_t col_parts = RoundUp(rows.row_size, kHostCopyTaskByteSize) / kHostCopyTaskByteSize;
+  const int64_t col_part_size = RoundUp(rows.row_size, col_parts) / col_parts;
+  const int64_t rows_per_task =
+      col_parts > 1 ? 1 : std::max<int64_t>(1, kHostCopyTaskByteSize / rows.row_size);
+  const int64_t task_num = RoundUp(rows.row_num, rows_per_task) / rows_per_task * col_parts;
+  auto* dst_ptr = reinterpret_cast<unsigned char*>(dst);
+  const auto* src_ptr = reinterpret_cast<const unsigned char*>(src);
+  auto Handler = [&](size_t task_id) {
+    const int64_t row_begin = task_id / col_parts * rows_per_task;
+    const int64_t row_cnt = std::min(rows_per_task, rows.row_num - row_begin);
+    const int64_t col_begin = task_id % col_parts * col_part_size;
+    const int64_t col_end = std::min(col_begin + col_part_size, rows.row_size);
+    CopyHostRows(rows, row_begin, row_cnt, col_begin, col_end, non_temporal, dst_ptr, src_ptr);
+  };
+  MaybeMultiThreadLoop(task_num, Handler);
 }
 
 #ifdef WITH_CUDA
@@ -252,6 +345,8 @@ void CudaAsyncMemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
   }
 }
 
+#endif
+
 REGISTER_DEFAULT_MEMORY_COPIER(DeviceType::kCPU, []() { return new HostMemoryCopier(); });
 
 #ifdef WITH_CUDA
@@ -266,8 +361,6 @@ MemoryCopier* NewDefaultMemoryCopier(DeviceType device_type) {
       ->Create();
 }
 
-#endif
-
 #define SPECIALIZE_COPY_ELEM(dtype)                                                        \
   template void MemoryCopier::CopyElem<dtype>(DeviceCtx * ctx, void* dst, const void* src, \
                                               const MemoryCopyNdDesc& desc) const;
@@ -278,11 +371,4 @@ SPECIALIZE_COPY_ELEM(int32_t)
 SPECIALIZE_COPY_ELEM(int64_t)
 SPECIALIZE_COPY_ELEM(int8_t)
 
-#define SPECIALIZE_COPY_ND_CPU_IMPL(NDIMS)                                        \
-  template void CopyNDCpuImpl<NDIMS>(DeviceCtx * ctx, void* dst, const void* src, \
-                                     const MemoryCopyNdDesc& desc);
-SPECIALIZE_COPY_ND_CPU_IMPL(4)
-SPECIALIZE_COPY_ND_CPU_IMPL(5)
-SPECIALIZE_COPY_ND_CPU_IMPL(6)
-
 }  // namespace oneflow
@@ -33,8 +33,6 @@ struct MemoryCopyNdDesc {
   MemoryCopyNdDesc CreateDimReducedDesc() const;
 };
 
-template<int32_t NDIMS>
-void CopyNDCpuImpl(DeviceCtx* ctx, void* dst, const void* src, const MemoryCopyNdDesc& desc);
 template<int32_t NDIMS>
 void CopyNDGpuImpl(DeviceCtx* ctx, void* dst, const void* src, const MemoryCopyNdDesc& desc);
 
@@ -65,10 +63,13 @@ class HostMemoryCopier final : public MemoryCopier {
   HostMemoryCopier() = default;
   ~HostMemoryCopier() override = default;
 
+  // Splits copies larger than a few hundred KB across Global<ThreadPool> by rows, or by bytes of
+  // long rows, and writes very large destinations with non-temporal stores.
+  void Copy(DeviceCtx* ctx, void* dst, const void* src,
+            const MemoryCopyNdDesc& desc) const override;
+
  private:
   void Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const override;
-  void CopyND(DeviceCtx* ctx, void* dst, const void* src,
-              const MemoryCopyNdDesc& desc) const override;
 };
 
 #ifdef WITH_CUDA
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/device/memory_copier.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+void TestHostMemoryCopier(const std::vector<int64_t>& src_dims,
+                          const std::vector<int64_t>& dst_dims,
+                          const std::vector<int64_t>& src_pos,
+                          const std::vector<int64_t>& dst_pos,
+                          const std::vector<int64_t>& extent) {
+  const int64_t num_axes = extent.size();
+  MemoryCopyNdDesc desc;
+  desc.src_shape = Shape(DimVector(src_dims.begin(), src_dims.end()));
+  desc.dst_shape = Shape(DimVector(dst_dims.begin(), dst_dims.end()));
+  desc.src_pos = NdIndex(DimVector(src_pos.begin(), src_pos.end()));
+  desc.dst_pos = NdIndex(DimVector(dst_pos.begin(), dst_pos.end()));
+  desc.extent = Shape(DimVector(extent.begin(), extent.end()));
+  std::vector<int32_t> src(desc.src_shape.elem_cnt());
+  std::iota(src.begin(), src.end(), 0);
+  std::vector<int32_t> dst(desc.dst_shape.elem_cnt(), -1);
+  HostMemoryCopier copier;
+  copier.CopyElem<int32_t>(nullptr, dst.data(), src.data(), desc);
+
+  std::vector<int32_t> expected(dst.size(), -1);
+  std::vector<int64_t> index(num_axes, 0);
+  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
+    int64_t src_offset = 0;
+    int64_t dst_offset = 0;
+    FOR_RANGE(int64_t, axis, 0, num_axes) {
+      src_offset += (src_pos[axis] + index[axis]) * desc.src_shape.Count(axis + 1);
+      dst_offset += (dst_pos[axis] + index[axis]) * desc.dst_shape.Count(axis + 1);
+    }
+    expected[dst_offset] = src[src_offset];
+    for (int64_t axis = num_axes - 1; axis >= 0; --axis) {
+      if (++index[axis] < extent[axis]) { break; }
+      index[axis] = 0;
+    }
+  }
+  ASSERT_EQ(dst, expected);
+}
+
+}  // namespace
+
+TEST(HostMemoryCopier, matches_reference) {
+  const bool own_thread_pool = Global<ThreadPool>::Get() == nullptr;
+  if (own_thread_pool) { Global<ThreadPool>::New(4); }
+  TestHostMemoryCopier({1000}, {1200}, {17}, {100}, {900});
+  TestHostMemoryCopier({64, 3}, {70, 5}, {2, 0}, {5, 1}, {60, 3});
+  TestHostMemoryCopier({4, 6, 8}, {5, 6, 9}, {1, 0, 2}, {0, 0, 1}, {3, 6, 5});
+  TestHostMemoryCopier({3, 4, 5, 6}, {4, 4, 6, 7}, {0, 1, 2, 3}, {1, 0, 0, 1}, {3, 3, 3, 3});
+  TestHostMemoryCopier({2, 3, 4, 5, 6}, {2, 3, 4, 5, 8}, {0, 0, 0, 0, 0}, {0, 0, 0, 0, 1},
+                       {2, 3, 4, 5, 6});
+  // many tiny rows batched into a task
+  TestHostMemoryCopier({1 << 16, 2}, {1 << 16, 3}, {0, 0}, {0, 1}, {1 << 16, 2});
+  // rows longer than a task split by bytes, large enough for non-temporal stores
+  TestHostMemoryCopier({5, 1 << 20}, {5, (1 << 20) + 3}, {0, 1}, {0, 3}, {5, (1 << 20) - 1});
+  if (own_thread_pool) { Global<ThreadPool>::Delete(); }
+}
+
+}  // namespace oneflow
@@ -64,6 +64,16 @@ Maybe<void> RunPhysicalInstruction(const vm::InstructionListProto& instruction_l
   return vm::Run(instruction_list_proto);
 }
 
+// Steady state eager steps reuse their symbols and send no new ones.
+Maybe<void> AddEagerSymbols(const std::string& eager_symbol_list_str) {
+  if (eager_symbol_list_str.empty()) { return Maybe<void>::Ok(); }
+  EagerSymbolList eager_symbol_list;
+  CHECK_OR_RETURN(TxtString2PbMessage(eager_symbol_list_str, &eager_symbol_list))
+      << "EagerSymbolList parse failed";
+  for (const auto& eager_symbol : eager_symbol_list.eager_symbol()) { StorageAdd(eager_symbol); }
+  return Maybe<void>::Ok();
+}
+
 }  // namespace
 
 Maybe<void> RunPhysicalInstruction(const std::string& instruction_list_proto_str,
@@ -88,5 +98,17 @@ Maybe<void> RunLogicalInstruction(const std::string& instruction_list_proto_str,
   return RunLogicalInstruction(instruction_list_proto, eager_symbol_list);
 }
 
+Maybe<void> RunPhysicalEncodedInstruction(const int64_t* words, int64_t size,
+                                          const std::string& eager_symbol_list_str) {
+  JUST(AddEagerSymbols(eager_symbol_list_str));
+  return vm::RunEncodedInstructions(words, size);
+}
+
+Maybe<void> RunLogicalEncodedInstruction(const int64_t* words, int64_t size,
+                                         const std::string& eager_symbol_list_str) {
+  JUST(AddEagerSymbols(eager_symbol_list_str));
+  return vm::RunEncodedInstructions(words, size);
+}
+
 }  // namespace eager
 }  // namespace oneflow
@@ -26,6 +26,13 @@ Maybe<void> RunPhysicalInstruction(const std::string& instruction_list_proto_str
 Maybe<void> RunLogicalInstruction(const std::string& instruction_list_proto_str,
                                   const std::string& eager_symbol_list_str);
 
+// Instructions in the flat encoding of vm/instruction_encoding.h. The text format instruction
+// list above is kept for debugging.
+Maybe<void> RunPhysicalEncodedInstruction(const int64_t* words, int64_t size,
+                                          const std::string& eager_symbol_list_str);
+Maybe<void> RunLogicalEncodedInstruction(const int64_t* words, int64_t size,
+                                         const std::string& eager_symbol_list_str);
+
 }  // namespace eager
 }  // namespace oneflow
 
@@ -31,6 +31,7 @@ limitations under the License.
 #include "oneflow/core/vm/instruction.msg.h"
 #include "oneflow/core/vm/instruction_type.h"
 #include "oneflow/core/vm/object.h"
+#include "oneflow/core/vm/oneflow_vm.h"
 #include "oneflow/core/framework/user_op_registry_manager.h"
 #include "oneflow/core/job/foreign_callback.h"
 #include "oneflow/core/register/ofblob.h"
@@ -405,6 +406,36 @@ Maybe<T*> GetSharedOpKernel(vm::Instruction* instruction, DeviceType device_type
   return rw_mutexed_object->Init<T>(op_conf, job_desc_ptr, device_type);
 }
 
+// Aborts as before, unless the vm schedules asynchronously: then the error is handed to OneflowVM
+// and returned to the python caller at its next sync point.
+void CheckOkOrReportToVm(Maybe<void>&& maybe, const std::function<std::string()>& GetContext) {
+  if (maybe.IsOk()) { return; }
+  auto* oneflow_vm = Global<OneflowVM>::Get();
+  if (oneflow_vm != nullptr && oneflow_vm->enable_async_schedule()) {
+    auto error = std::make_shared<ErrorProto>(*maybe.error());
+    error->set_msg(error->msg() + GetContext());
+    oneflow_vm->ReportError(error);
+  } else {
+    LOG(FATAL) << maybe.GetSerializedError() << GetContext();
+  }
+}
+
+// An instruction after a failed one may read its unwritten outputs, so it is not run until the
+// error has been returned by OneflowVM::Sync.
+bool HasVmScheduleError() {
+  auto* oneflow_vm = Global<OneflowVM>::Get();
+  return oneflow_vm != nullptr && oneflow_vm->HasScheduleError();
+}
+
+std::string InstructionErrorContext(vm::Instruction* instruction) {
+  std::stringstream ss;
+  ss << "\nmachine_id: " << instruction->stream().machine_id()
+     << "\ndevice_id: " << instruction->stream().device_id()
+     << "\n============ parallel_conf ============\n"
+     << instruction->parallel_desc()->parallel_conf().DebugString();
+  return ss.str();
+}
+
 }  // namespace
 
 Maybe<void> CallOpKernelInstructionType::MaybeInfer(vm::Instruction* instruction,
@@ -418,12 +449,11 @@ Maybe<void> CallOpKernelInstructionType::MaybeInfer(vm::Instruction* instruction
 }
 
 void CallOpKernelInstructionType::Infer(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<CallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(MaybeInfer(instruction, args.Get()))
-      << "\ndevice_tag: " << device_tag() << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString();
+  CheckOkOrReportToVm(MaybeInfer(instruction, args.Get()), [&]() {
+    return std::string("\ndevice_tag: ") + device_tag() + InstructionErrorContext(instruction);
+  });
 }
 
 Maybe<void> CallOpKernelInstructionType::MaybeCompute(vm::Instruction* instruction,
@@ -434,12 +464,11 @@ Maybe<void> CallOpKernelInstructionType::MaybeCompute(vm::Instruction* instructi
 }
 
 void CallOpKernelInstructionType::Compute(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<CallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(MaybeCompute(instruction, args.Get()))
-      << "\ndevice_tag: " << device_tag() << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString();
+  CheckOkOrReportToVm(MaybeCompute(instruction, args.Get()), [&]() {
+    return std::string("\ndevice_tag: ") + device_tag() + InstructionErrorContext(instruction);
+  });
 }
 
 Maybe<const OperatorConf*> GetOpConf(vm::Instruction* instruction,
@@ -449,6 +478,16 @@ Maybe<const OperatorConf*> GetOpConf(vm::Instruction* instruction,
   return &JUST(operand_op_conf->Get<vm::ObjectWrapper<OperatorConf>>())->Get();
 }
 
+namespace {
+
+std::string StatelessCallOpKernelErrorContext(vm::Instruction* instruction,
+                                              const StatelessCallOpKernelInstrOperand& args) {
+  return InstructionErrorContext(instruction) + "\n============ op_conf ============\n"
+         + CHECK_JUST(GetOpConf(instruction, args))->DebugString();
+}
+
+}  // namespace
+
 Maybe<void> UserStatelessCallOpKernelInstructionType::Infer(
     vm::Instruction* instruction, const StatelessCallOpKernelInstrOperand& args) const {
   DeviceType device_type = JUST(DeviceType4DeviceTag(this->device_tag()));
@@ -460,14 +499,11 @@ Maybe<void> UserStatelessCallOpKernelInstructionType::Infer(
 }
 
 void UserStatelessCallOpKernelInstructionType::Infer(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<StatelessCallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(Infer(instruction, args.Get()))
-      << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString()
-      << "\n============ op_conf ============\n"
-      << CHECK_JUST(GetOpConf(instruction, args.Get()))->DebugString();
+  CheckOkOrReportToVm(Infer(instruction, args.Get()), [&]() {
+    return StatelessCallOpKernelErrorContext(instruction, args.Get());
+  });
 }
 
 Maybe<void> UserStatelessCallOpKernelInstructionType::Compute(
@@ -478,14 +514,11 @@ Maybe<void> UserStatelessCallOpKernelInstructionType::Compute(
 }
 
 void UserStatelessCallOpKernelInstructionType::Compute(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<StatelessCallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(Compute(instruction, args.Get()))
-      << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString()
-      << "\n============ op_conf ============\n"
-      << CHECK_JUST(GetOpConf(instruction, args.Get()))->DebugString();
+  CheckOkOrReportToVm(Compute(instruction, args.Get()), [&]() {
+    return StatelessCallOpKernelErrorContext(instruction, args.Get());
+  });
 }
 
 std::shared_ptr<MemoryCase> SystemStatelessCallOpKernelInstructionType::GetOutBlobMemCase(
@@ -504,14 +537,11 @@ Maybe<void> SystemStatelessCallOpKernelInstructionType::Infer(
 }
 
 void SystemStatelessCallOpKernelInstructionType::Infer(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<StatelessCallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(Infer(instruction, args.Get()))
-      << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString()
-      << "\n============ op_conf ============\n"
-      << CHECK_JUST(GetOpConf(instruction, args.Get()))->DebugString();
+  CheckOkOrReportToVm(Infer(instruction, args.Get()), [&]() {
+    return StatelessCallOpKernelErrorContext(instruction, args.Get());
+  });
 }
 
 Maybe<void> SystemStatelessCallOpKernelInstructionType::Compute(
@@ -523,14 +553,11 @@ Maybe<void> SystemStatelessCallOpKernelInstructionType::Compute(
 }
 
 void SystemStatelessCallOpKernelInstructionType::Compute(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FlatMsgView<StatelessCallOpKernelInstrOperand> args(instruction->instr_msg().operand());
-  CHECK_OK(Compute(instruction, args.Get()))
-      << "\nmachine_id: " << instruction->stream().machine_id()
-      << "\ndevice_id: " << instruction->stream().device_id()
-      << "\n============ parallel_conf ============\n"
-      << instruction->parallel_desc()->parallel_conf().DebugString()
-      << "\n============ op_conf ============\n"
-      << CHECK_JUST(GetOpConf(instruction, args.Get()))->DebugString();
+  CheckOkOrReportToVm(Compute(instruction, args.Get()), [&]() {
+    return StatelessCallOpKernelErrorContext(instruction, args.Get());
+  });
 }
 
 template<typename T>
@@ -544,11 +571,14 @@ void FeedOrFetchBlob(vm::Instruction* instruction) {
   Global<ForeignCallback>::Get()->OfBlobCall(args->unique_callback_id(), of_blob_ptr);
 }
 
+// a skipped fetch never calls back, the python reader gets the error from its vm sync instead
 void FetchBlobHeaderInstructionType::Infer(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FeedOrFetchBlob<FetchBlobInstrOperand>(instruction);
 }
 
 void FetchBlobBodyInstructionType::Compute(vm::Instruction* instruction) const {
+  if (HasVmScheduleError()) { return; }
   FeedOrFetchBlob<FetchBlobInstrOperand>(instruction);
 }
 
@@ -15,32 +15,150 @@ limitations under the License.
 */
 #include "oneflow/core/framework/op_kernel_infer_cache.h"
 #include "oneflow/core/framework/op_kernel.h"
-#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/job/sbp_parallel.h"
 
 namespace oneflow {
 
 namespace user_op {
 
+namespace {
+
+// Like Operator::GetOpConfWithoutOpNameAndLbn but also drops output lbns, which carry the op name,
+// so that identical ops in different places of the job map to one symbol.
+Symbol<OperatorConf> UserOpConfSymWithoutOpNameAndLbn(const OperatorConf& op_conf) {
+  CHECK(op_conf.has_user_conf());
+  OperatorConf ret(op_conf);
+  ret.set_name("undefined-op-name");
+  UserOpConf* user_conf = ret.mutable_user_conf();
+  for (auto& pair : *user_conf->mutable_input()) {
+    for (std::string& lbn : *pair.second.mutable_s()) { lbn = "undefined-op-name/undefined-ibn"; }
+  }
+  for (auto& pair : *user_conf->mutable_output()) {
+    for (std::string& lbn : *pair.second.mutable_s()) { lbn = "undefined-op-name/undefined-obn"; }
+  }
+  return SymbolOf(ret);
+}
+
+// Kernels with different sbp signatures or parallel contexts may infer different shapes from the
+// same input shapes, so they only share a cache if those match as well.
+struct SharedLruCacheKey final {
+  OpInferCacheKey op_infer_cache_key;
+  Symbol<SbpSignature> sbp_signature_sym;
+  int64_t parallel_id;
+  int64_t parallel_num;
+};
+
+bool operator==(const SharedLruCacheKey& lhs, const SharedLruCacheKey& rhs) {
+  return lhs.op_infer_cache_key == rhs.op_infer_cache_key
+         && lhs.sbp_signature_sym == rhs.sbp_signature_sym && lhs.parallel_id == rhs.parallel_id
+         && lhs.parallel_num == rhs.parallel_num;
+}
+
+struct SharedLruCacheKeyHash final {
+  size_t operator()(const SharedLruCacheKey& key) const {
+    return std::hash<OpInferCacheKey>()(key.op_infer_cache_key)
+           ^ std::hash<Symbol<SbpSignature>>()(key.sbp_signature_sym)
+           ^ std::hash<int64_t>()(key.parallel_id) ^ (std::hash<int64_t>()(key.parallel_num) << 1);
+  }
+};
+
+// Caches stay alive as long as one kernel uses them; keyed on OpInferCacheKey without input shapes.
+std::shared_ptr<OpInferLruCache> GetSharedLruCache(const SharedLruCacheKey& key) {
+  static std::mutex mutex;
+  static std::unordered_map<SharedLruCacheKey, std::weak_ptr<OpInferLruCache>,
+                            SharedLruCacheKeyHash>
+      key2cache;
+  std::unique_lock<std::mutex> lock(mutex);
+  const auto found_it = key2cache.find(key);
+  if (found_it != key2cache.end()) {
+    std::shared_ptr<OpInferLruCache> cache = found_it->second.lock();
+    if (cache) { return cache; }
+  }
+  // drops the entries of caches whose kernels are all gone
+  for (auto it = key2cache.begin(); it != key2cache.end();) {
+    if (it->second.expired()) {
+      it = key2cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::shared_ptr<OpInferLruCache> cache(new OpInferLruCache());
+  key2cache[key] = cache;
+  return cache;
+}
+
+}  // namespace
+
+OpInferLruCache::~OpInferLruCache() {
+  VLOG(2) << "op infer cache hit: " << hit_cnt_ << ", miss: " << miss_cnt_
+          << ", evict: " << evict_cnt_;
+}
+
+OpInferLruCache::ValueType OpInferLruCache::Get(const KeyType& key) {
+  HashEqTraitPtr<const KeyType> ptr_wrapper(&key, std::hash<KeyType>()(key));
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto it = key2lru_iter_.find(ptr_wrapper);
+  if (it == key2lru_iter_.end()) {
+    miss_cnt_ += 1;
+    return nullptr;
+  }
+  hit_cnt_ += 1;
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  return it->second->second;
+}
+
+void OpInferLruCache::Put(const KeyType& key, const ValueType& value) {
+  const size_t hash_value = std::hash<KeyType>()(key);
+  std::unique_lock<std::mutex> lock(mutex_);
+  // another kernel sharing this cache may have inferred the same key meanwhile
+  if (key2lru_iter_.find(HashEqTraitPtr<const KeyType>(&key, hash_value)) != key2lru_iter_.end()) {
+    return;
+  }
+  if (lru_list_.size() >= kMaxSize) {
+    const KeyType* lru_key = lru_list_.back().first.get();
+    key2lru_iter_.erase(HashEqTraitPtr<const KeyType>(lru_key, std::hash<KeyType>()(*lru_key)));
+    lru_list_.pop_back();
+    evict_cnt_ += 1;
+  }
+  lru_list_.emplace_front(std::unique_ptr<const KeyType>(new KeyType(key)), value);
+  HashEqTraitPtr<const KeyType> ptr_wrapper(lru_list_.front().first.get(), hash_value);
+  CHECK(key2lru_iter_.emplace(ptr_wrapper, lru_list_.begin()).second);
+}
+
+size_t OpInferLruCache::size() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return lru_list_.size();
+}
+
+int64_t OpInferLruCache::hit_cnt() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return hit_cnt_;
+}
+
+int64_t OpInferLruCache::miss_cnt() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return miss_cnt_;
+}
+
+int64_t OpInferLruCache::evict_cnt() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return evict_cnt_;
+}
+
 OpKernelInferCache::OpKernelInferCache(const KernelConf& kernel_conf, const JobDesc& job_desc) {
-  const OperatorConf& op_conf = kernel_conf.op_attribute().op_conf();
-  std::shared_ptr<Operator> op = ConstructOp(op_conf, &job_desc);
   cache_key_.job_desc = &job_desc;
-  cache_key_.op_conf_sym = op->GetOpConfWithoutOpNameAndLbn();
-  cache_key_.ibn_idx2shape_sym.resize(op->input_bns().size());
+  cache_key_.op_conf_sym = UserOpConfSymWithoutOpNameAndLbn(kernel_conf.op_attribute().op_conf());
   cache_key_.dtype_signature_sym = SymbolOf(kernel_conf.dtype_signature());
-}
-
-bool OpKernelInferCache::IsCacheHit() const {
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(&cache_key_, hash_value);
-  return cached_key2value_.find(ptr_wrapper) != cached_key2value_.end();
+  SharedLruCacheKey shared_cache_key;
+  shared_cache_key.op_infer_cache_key = cache_key_;
+  shared_cache_key.sbp_signature_sym = SymbolOf(kernel_conf.user_conf().sbp_sig());
+  shared_cache_key.parallel_id = kernel_conf.user_conf().parallel_ctx().parallel_id();
+  shared_cache_key.parallel_num = kernel_conf.user_conf().parallel_ctx().parallel_num();
+  lru_cache_ = GetSharedLruCache(shared_cache_key);
 }
 
 OpKernelInferCache::ValueType OpKernelInferCache::GetCacheValue() const {
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(&cache_key_, hash_value);
-  CHECK(cached_key2value_.find(ptr_wrapper) != cached_key2value_.end());
-  return cached_key2value_.at(ptr_wrapper);
+  return lru_cache_->Get(cache_key_);
 }
 
 void OpKernelInferCache::UpdateCacheKey(KernelInferContext* ctx) {
@@ -50,6 +168,7 @@ void OpKernelInferCache::UpdateCacheKey(KernelInferContext* ctx) {
     return SymbolOf(shape);
   };
   const auto& inputs = ctx->inputs();
+  cache_key_.ibn_idx2shape_sym.resize(inputs.size());
   FOR_RANGE(int, i, 0, inputs.size()) {
     const auto& arg_pair = inputs.at(i);
     cache_key_.ibn_idx2shape_sym.at(i) = GetSymbolOfShape(arg_pair.first, arg_pair.second);
@@ -57,7 +176,6 @@ void OpKernelInferCache::UpdateCacheKey(KernelInferContext* ctx) {
 }
 
 void OpKernelInferCache::UpdateCacheValue(KernelInferContext* ctx) {
-  if (cached_key2value_.size() >= max_size_) { Reset(); }
   auto* cache_value = new OpInferCacheValue();
   cache_value->obn_idx2shape_sym.resize(ctx->outputs().size());
   FOR_RANGE(int, i, 0, ctx->outputs().size()) {
@@ -68,30 +186,7 @@ void OpKernelInferCache::UpdateCacheValue(KernelInferContext* ctx) {
     out_shape_view.ToShape(&out_shape);
     cache_value->obn_idx2shape_sym.at(i).reset(out_shape);
   }
-  KeyType* new_key = new KeyType(cache_key_);
-  key_storage_.emplace_back(new_key);
-  size_t hash_value = std::hash<KeyType>()(cache_key_);
-  HashEqTraitPtr<const KeyType> ptr_wrapper(new_key, hash_value);
-  CHECK(cached_key2value_.emplace(ptr_wrapper, ValueType(cache_value)).second);
-}
-
-void OpKernelInferCache::Reset() {
-  CHECK_EQ(cached_key2value_.size(), key_storage_.size());
-  HashMap to_release_key2values;
-  KeyStorage to_release_key_storage;
-  std::swap(cached_key2value_, to_release_key2values);
-  std::swap(key_storage_, to_release_key_storage);
-  if (to_release_key2values.size() <= kReleaseInIndependentThreadThreshold) {
-    to_release_key2values.clear();
-    to_release_key_storage.clear();
-  } else {
-    std::thread(
-        [](HashMap&& cache, KeyStorage&& key_storage) {
-          cache.clear();
-          key_storage.clear();
-        },
-        std::move(to_release_key2values), std::move(to_release_key_storage));
-  }
+  lru_cache_->Put(cache_key_, ValueType(cache_value));
 }
 
 }  // namespace user_op
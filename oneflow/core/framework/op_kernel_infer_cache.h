@@ -26,28 +26,57 @@ namespace user_op {
 
 class KernelInferContext;
 
+// Output shapes of user op kernels keyed on op conf and input shapes, evicting the least recently
+// used entry once full. Kernels with the same job desc, op conf (ignoring op name and lbns), dtype
+// signature, sbp signature and parallel context share one instance, so every method locks.
+class OpInferLruCache final {
+ public:
+  using KeyType = OpInferCacheKey;
+  using ValueType = std::shared_ptr<const OpInferCacheValue>;
+  static constexpr size_t kMaxSize = 8192;
+
+  OpInferLruCache() : hit_cnt_(0), miss_cnt_(0), evict_cnt_(0) {}
+  ~OpInferLruCache();
+
+  // Returns nullptr on miss.
+  ValueType Get(const KeyType& key);
+  void Put(const KeyType& key, const ValueType& value);
+
+  size_t size() const;
+  int64_t hit_cnt() const;
+  int64_t miss_cnt() const;
+  int64_t evict_cnt() const;
+
+ private:
+  using LruList = std::list<std::pair<std::unique_ptr<const KeyType>, ValueType>>;
+  using HashMap = std::unordered_map<HashEqTraitPtr<const KeyType>, LruList::iterator>;
+
+  // most recently used first
+  LruList lru_list_;
+  HashMap key2lru_iter_;
+  int64_t hit_cnt_;
+  int64_t miss_cnt_;
+  int64_t evict_cnt_;
+  mutable std::mutex mutex_;
+};
+
 class OpKernelInferCache final {
  public:
   using KeyType = OpInferCacheKey;
   using ValueType = std::shared_ptr<const OpInferCacheValue>;
-  using HashMap = std::unordered_map<HashEqTraitPtr<const KeyType>, ValueType>;
-  using KeyStorage = std::list<std::unique_ptr<KeyType>>;
-  static constexpr size_t kReleaseInIndependentThreadThreshold = 4096;
 
   OpKernelInferCache(const KernelConf& kernel_conf, const JobDesc& job_desc);
   ~OpKernelInferCache() = default;
 
-  bool IsCacheHit() const;
+  // Returns nullptr if the shapes of the current key were never inferred.
   ValueType GetCacheValue() const;
   void UpdateCacheKey(KernelInferContext* ctx);
   void UpdateCacheValue(KernelInferContext* ctx);
-  void Reset();
+  const OpInferLruCache& lru_cache() const { return *lru_cache_; }
 
  private:
   KeyType cache_key_;
-  HashMap cached_key2value_;
-  KeyStorage key_storage_;
-  size_t max_size_;
+  std::shared_ptr<OpInferLruCache> lru_cache_;
 };
 
 }  // namespace user_op
@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/op_kernel_infer_cache.h"
+
+namespace oneflow {
+
+namespace user_op {
+
+namespace test {
+
+namespace {
+
+OpInferCacheKey MakeKey(int64_t dim) {
+  OperatorConf op_conf;
+  op_conf.set_name("test_op");
+  OpInferCacheKey key;
+  key.job_desc = nullptr;
+  key.op_conf_sym = SymbolOf(op_conf);
+  key.dtype_signature_sym = SymbolOf(DTypeSignature());
+  key.ibn_idx2shape_sym.push_back(SymbolOf(Shape({dim})));
+  return key;
+}
+
+OpInferLruCache::ValueType MakeValue(int64_t dim) {
+  auto* value = new OpInferCacheValue();
+  value->obn_idx2shape_sym.push_back(SymbolOf(Shape({dim, dim})));
+  return OpInferLruCache::ValueType(value);
+}
+
+}  // namespace
+
+TEST(OpInferLruCache, hit_and_miss) {
+  OpInferLruCache cache;
+  ASSERT_TRUE(cache.Get(MakeKey(1)) == nullptr);
+  ASSERT_EQ(cache.miss_cnt(), 1);
+  cache.Put(MakeKey(1), MakeValue(1));
+  const auto value = cache.Get(MakeKey(1));
+  ASSERT_TRUE(value != nullptr);
+  ASSERT_EQ(*value->obn_idx2shape_sym.at(0), Shape({1, 1}));
+  ASSERT_EQ(cache.hit_cnt(), 1);
+  ASSERT_TRUE(cache.Get(MakeKey(2)) == nullptr);
+  ASSERT_EQ(cache.miss_cnt(), 2);
+  // putting a key twice keeps the first value
+  cache.Put(MakeKey(1), MakeValue(3));
+  ASSERT_EQ(cache.size(), 1);
+  ASSERT_EQ(*cache.Get(MakeKey(1))->obn_idx2shape_sym.at(0), Shape({1, 1}));
+}
+
+TEST(OpInferLruCache, evict_least_recently_used) {
+  const size_t max_size = OpInferLruCache::kMaxSize;
+  OpInferLruCache cache;
+  FOR_RANGE(int64_t, i, 0, max_size) { cache.Put(MakeKey(i), MakeValue(i)); }
+  ASSERT_EQ(cache.size(), max_size);
+  ASSERT_EQ(cache.evict_cnt(), 0);
+  // key 0 becomes the most recently used one, so key 1 is evicted next
+  ASSERT_TRUE(cache.Get(MakeKey(0)) != nullptr);
+  cache.Put(MakeKey(max_size), MakeValue(max_size));
+  ASSERT_EQ(cache.size(), max_size);
+  ASSERT_EQ(cache.evict_cnt(), 1);
+  ASSERT_TRUE(cache.Get(MakeKey(0)) != nullptr);
+  ASSERT_TRUE(cache.Get(MakeKey(1)) == nullptr);
+  ASSERT_TRUE(cache.Get(MakeKey(max_size)) != nullptr);
+}
+
+}  // namespace test
+
+}  // namespace user_op
+
+}  // namespace oneflow
@@ -30,6 +30,13 @@ void GroupParallelIdByMachine(const ParallelDesc& pd,
   }
 }
 
+bool IsConsecutive(const std::vector<int64_t>& parallel_ids) {
+  FOR_RANGE(int64_t, i, 1, parallel_ids.size()) {
+    if (parallel_ids.at(i) != parallel_ids.at(i - 1) + 1) { return false; }
+  }
+  return true;
+}
+
 bool ContainsEmptySlice(const std::vector<TensorSliceView>& slices) {
   return std::any_of(slices.cbegin(), slices.cend(),
                      [](const TensorSliceView& slice) { return slice.IsEmpty(); });
@@ -127,6 +134,82 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
     dst_node->ConnectToSrcNodeWithSlice(src_node, NewEdge(), src_slice);
     return dst_node;
   };
+  using HostTransfer = std::pair<TaskNode*, TensorSliceView>;
+  // Funnels what the devices of in_machine_id send to the devices of out_machine_id through one
+  // transfer between the hosts when that is cheaper: the part of all their out slices is summed
+  // or gathered on in_machine_id, sent once, and every out node slices it from the host buffer.
+  // The transfer is null when the flat per device transfers are kept.
+  const auto GetHostTransfer =
+      [&ctx, &lbi, &GetBoxingGpuThrdId, &NewEdge](
+          const ParallelDesc& in_pd, const ParallelDesc& out_pd, const SbpParallel& in_sbp,
+          const SbpParallel& out_sbp, const BlobDesc& blob_desc,
+          const std::vector<TaskNode*>& in_nodes, int64_t in_machine_id, int64_t out_machine_id,
+          HashMap<std::pair<int64_t, int64_t>, HostTransfer>* machine_ids2host_transfer)
+      -> const HostTransfer& {
+    const auto key = std::make_pair(in_machine_id, out_machine_id);
+    auto it = machine_ids2host_transfer->find(key);
+    if (it != machine_ids2host_transfer->end()) { return it->second; }
+    it = machine_ids2host_transfer->emplace(key, HostTransfer(nullptr, TensorSliceView())).first;
+    const bool is_add = in_sbp.has_partial_sum_parallel();
+    HashMap<int64_t, std::vector<int64_t>> machine_id2in_parallel_ids;
+    HashMap<int64_t, std::vector<int64_t>> machine_id2out_parallel_ids;
+    GroupParallelIdByMachine(in_pd, &machine_id2in_parallel_ids);
+    GroupParallelIdByMachine(out_pd, &machine_id2out_parallel_ids);
+    const std::vector<int64_t>& in_ids = machine_id2in_parallel_ids.at(in_machine_id);
+    const std::vector<int64_t>& out_ids = machine_id2out_parallel_ids.at(out_machine_id);
+    if (out_ids.size() <= 1 || !IsConsecutive(in_ids) || !IsConsecutive(out_ids)) {
+      return it->second;
+    }
+    const std::vector<TensorSliceView> in_slices =
+        SubTskGphBuilderUtil::GetTensorSliceView(in_pd.parallel_num(), in_sbp, blob_desc);
+    const std::vector<TensorSliceView> out_slices =
+        SubTskGphBuilderUtil::GetTensorSliceView(out_pd.parallel_num(), out_sbp, blob_desc);
+    std::vector<TensorSliceView> host_out_slices;
+    for (const int64_t out_id : out_ids) { host_out_slices.push_back(out_slices.at(out_id)); }
+    const TensorSliceView host_out_slice =
+        TensorSliceView::Concatenate(host_out_slices, out_sbp.split_parallel().axis());
+    std::vector<int64_t> src_in_ids;
+    TensorSliceView host_slice;
+    if (is_add) {
+      src_in_ids = in_ids;
+      host_slice = host_out_slice;
+    } else {
+      std::vector<TensorSliceView> intersections;
+      for (const int64_t in_id : in_ids) {
+        const TensorSliceView intersection = host_out_slice.Intersect(in_slices.at(in_id));
+        if (intersection.IsEmpty()) { continue; }
+        src_in_ids.push_back(in_id);
+        intersections.push_back(intersection);
+      }
+      if (intersections.empty()) { return it->second; }
+      host_slice = TensorSliceView::Concatenate(intersections, in_sbp.split_parallel().axis());
+    }
+    const int64_t fan_out = std::count_if(out_ids.cbegin(), out_ids.cend(), [&](int64_t out_id) {
+      return !out_slices.at(out_id).Intersect(host_slice).IsEmpty();
+    });
+    const int64_t byte_size =
+        host_slice.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+    if (!SubTskGphBuilderUtil::IsHostLeaderTransferCheaper(fan_out, byte_size)) {
+      return it->second;
+    }
+    auto* leader_node = ctx->task_graph()->NewNode<SliceBoxingTaskNode>();
+    int64_t leader_thrd_id = -1;
+    if (in_pd.device_type() == DeviceType::kCPU) {
+      leader_thrd_id = Global<IDMgr>::Get()->PickCpuThrdIdEvenly(in_machine_id);
+    } else if (in_pd.device_type() == DeviceType::kGPU) {
+      leader_thrd_id =
+          GetBoxingGpuThrdId(in_nodes.at(src_in_ids.front())->GpuPhyId(), CudaWorkType::kCopyD2H);
+    }
+    leader_node->Init(lbi, host_slice, is_add ? kSliceBoxingTaskModeAdd : kSliceBoxingTaskModeCopy,
+                      in_machine_id, leader_thrd_id, Global<IDMgr>::Get()->CpuMemZoneId());
+    for (const int64_t in_id : src_in_ids) {
+      leader_node->ConnectToSrcNodeWithSlice(in_nodes.at(in_id), NewEdge(), in_slices.at(in_id));
+    }
+    it->second.first = ctx->GetProxyNode(leader_node, Global<IDMgr>::Get()->CpuMemZoneId(),
+                                         out_machine_id, Global<IDMgr>::Get()->CpuMemZoneId());
+    it->second.second = host_slice;
+    return it->second;
+  };
   const auto BuildSubTaskGphS2B = [&ctx, &CreateBoxingNode121, &NewEdge](
                                       const ParallelDesc& in_pd, const ParallelDesc& out_pd,
                                       const SbpParallel& in_sbp, const SbpParallel& out_sbp,
@@ -157,7 +240,7 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
     }
   };
   const auto BuildSubTaskGphS2S = [&ctx, &lbi, &CreateBoxingNode121, &CreateBoxingNodeToHost,
-                                   &GetBoxingGpuThrdId,
+                                   &GetBoxingGpuThrdId, &GetHostTransfer,
                                    &NewEdge](const ParallelDesc& in_pd, const ParallelDesc& out_pd,
                                              const SbpParallel& in_sbp, const SbpParallel& out_sbp,
                                              const BlobDesc& blob_desc,
@@ -172,6 +255,7 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
     CHECK(!ContainsEmptySlice(out_slices));
     HashMap<int64_t, std::vector<int64_t>> machine_id2in_parallel_ids;
     GroupParallelIdByMachine(in_pd, &machine_id2in_parallel_ids);
+    HashMap<std::pair<int64_t, int64_t>, HostTransfer> machine_ids2host_transfer;
     FOR_RANGE(int64_t, out_id, 0, out_pd.parallel_num()) {
       const TensorSliceView& out_slice = out_slices.at(out_id);
       SliceBoxingTaskNode* out_node =
@@ -223,6 +307,16 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
             }
           }
         } else {
+          const HostTransfer& host_transfer =
+              GetHostTransfer(in_pd, out_pd, in_sbp, out_sbp, blob_desc, in_nodes, in_machine_id,
+                              out_node->machine_id(), &machine_ids2host_transfer);
+          if (host_transfer.first != nullptr) {
+            if (!out_slice.Intersect(host_transfer.second).IsEmpty()) {
+              out_node->ConnectToSrcNodeWithSlice(host_transfer.first, NewEdge(),
+                                                  host_transfer.second);
+            }
+            continue;
+          }
           std::vector<TensorSliceView> intersections;
           for (const int64_t in_id : in_parallel_ids) {
             intersections.push_back(out_slice.Intersect(in_slices.at(in_id)));
@@ -255,10 +349,12 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
     }
   };
   const auto BuildSubTaskGphP2S =
-      [&ctx, &lbi, &CreateBoxingNode121, &CreateBoxingNodeToHost, &GetBoxingGpuThrdId, &NewEdge](
-          const ParallelDesc& in_pd, const ParallelDesc& out_pd, const SbpParallel& in_sbp,
-          const SbpParallel& out_sbp, const BlobDesc& blob_desc,
-          const std::vector<TaskNode*>& in_nodes, std::vector<TaskNode*>* out_nodes) {
+      [&ctx, &lbi, &CreateBoxingNode121, &CreateBoxingNodeToHost, &GetBoxingGpuThrdId,
+       &GetHostTransfer, &NewEdge](const ParallelDesc& in_pd, const ParallelDesc& out_pd,
+                                   const SbpParallel& in_sbp, const SbpParallel& out_sbp,
+                                   const BlobDesc& blob_desc,
+                                   const std::vector<TaskNode*>& in_nodes,
+                                   std::vector<TaskNode*>* out_nodes) {
         CHECK(SubTskGphBuilderUtil::IsBoxingP2S(in_sbp, out_sbp));
         const TensorSliceView in_slice =
             SubTskGphBuilderUtil::GetBroadcastTensorSliceView(blob_desc);
@@ -267,6 +363,7 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
         CHECK(!ContainsEmptySlice(out_slices));
         HashMap<int64_t, std::vector<int64_t>> machine_id2in_parallel_ids;
         GroupParallelIdByMachine(in_pd, &machine_id2in_parallel_ids);
+        HashMap<std::pair<int64_t, int64_t>, HostTransfer> machine_ids2host_transfer;
         FOR_RANGE(int64_t, out_id, 0, out_pd.parallel_num()) {
           const TensorSliceView& out_slice = out_slices.at(out_id);
           SliceBoxingTaskNode* out_node =
@@ -288,6 +385,16 @@ Maybe<void> SliceBoxingSubTskGphBuilder::Build(
                 }
               }
             } else {
+              const HostTransfer& host_transfer = GetHostTransfer(
+                  in_pd, out_pd, in_sbp, out_sbp, blob_desc, in_nodes, in_machine_id,
+                  out_node->machine_id(), &machine_ids2host_transfer);
+              if (host_transfer.first != nullptr) {
+                if (!out_slice.Intersect(host_transfer.second).IsEmpty()) {
+                  out_node->ConnectToSrcNodeWithSlice(host_transfer.first, NewEdge(),
+                                                      host_transfer.second);
+                }
+                continue;
+              }
               auto* local_add_node = ctx->task_graph()->NewNode<SliceBoxingTaskNode>();
               int64_t local_add_thrd_id = -1;
               if (in_pd.device_type() == DeviceType::kCPU) {
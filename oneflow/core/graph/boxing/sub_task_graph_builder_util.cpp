@@ -118,4 +118,13 @@ int64_t SubTskGphBuilderUtil::GetDistance(const TaskNode* src, const TaskNode* d
   }
 }
 
+bool SubTskGphBuilderUtil::IsHostLeaderTransferCheaper(int64_t fan_out, int64_t byte_size) {
+  if (fan_out <= 1) { return false; }
+  // saves fan_out - 1 transfer overheads, but the devices wait for the whole buffer instead of
+  // their own part, which costs about half of the transfer time on average
+  const double saved_us = (fan_out - 1) * kCommNetTransferOverheadUs;
+  const double delayed_us = byte_size / kCommNetBytesPerUs / 2;
+  return saved_us > delayed_us;
+}
+
 }  // namespace oneflow
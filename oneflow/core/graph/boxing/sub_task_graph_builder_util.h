@@ -28,6 +28,8 @@ struct SubTskGphBuilderUtil {
   static constexpr int64_t kDistanceSameMachine = 1;
   static constexpr int64_t kDistanceDiffMachine = 2;
   static constexpr int64_t kDistanceMax = 3;
+  static constexpr double kCommNetTransferOverheadUs = 20;
+  static constexpr double kCommNetBytesPerUs = 1250;
 
   static bool IsDeviceTypeCPUOrGPU(const ParallelDesc& parallel_desc);
   static std::vector<TensorSliceView> GetTensorSliceView(int64_t parallel_num,
@@ -46,6 +48,9 @@ struct SubTskGphBuilderUtil {
   static bool BlobHasDynamicShape(const BlobDesc& blob_desc);
   static bool IsErrorBoxingNotSupported(const ErrorProto& error);
   static int64_t GetDistance(const TaskNode* src, const TaskNode* dst);
+  // Whether fan_out transfers from one host to the devices of another are better sent as one
+  // transfer of byte_size into a host buffer that the devices slice from.
+  static bool IsHostLeaderTransferCheaper(int64_t fan_out, int64_t byte_size);
 
   template<typename NodeType>
   static int64_t FindNearestNodeIndex(const std::vector<NodeType*> from_nodes,
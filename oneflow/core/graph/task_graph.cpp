@@ -22,6 +22,8 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/operator/variable_op.h"
 #include "oneflow/core/operator/user_op_util.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/memory/memory_case_util.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/graph/boxing/sub_task_graph_builder_context.h"
 #include "oneflow/core/graph/boxing/sub_task_graph_builder.h"
@@ -56,6 +58,29 @@ bool IsConnectToTickOp(const TaskNode* node) {
   return false;
 }
 
+const Operator* GetSoleUserOp(const TaskNode* task_node, const std::string& op_type_name) {
+  if (task_node->exec_gph().node_num() != 1) { return nullptr; }
+  const Operator* op = task_node->exec_gph().SoleNode()->op().get();
+  if (!op->op_conf().has_user_conf()) { return nullptr; }
+  if (op->op_conf().user_conf().op_type_name() != op_type_name) { return nullptr; }
+  return op;
+}
+
+bool IsStaticDenseBlobDesc(const BlobDesc* blob_desc) {
+  return !blob_desc->is_dynamic() && !blob_desc->is_tensor_list()
+         && !blob_desc->is_body_disabled() && !blob_desc->header_is_opaque();
+}
+
+int64_t ByteSizeOfBlobBody(const BlobDesc* blob_desc) {
+  return blob_desc->shape().elem_cnt() * GetSizeOfDataType(blob_desc->data_type());
+}
+
+// concat/split_like along axis only moves whole contiguous bodies when all dims before axis are 1
+bool IsContiguousAlongAxis(const Operator* op, const BlobDesc* blob_desc) {
+  const int64_t axis = user_op::UserOpConfWrapper(op->op_conf()).attr<int64_t>("axis");
+  return blob_desc->shape().Count(0, axis) == 1;
+}
+
 std::function<TaskNode*(const std::string&)> MakeGetterTaskNode4SoleOpName(
     const HashSet<TaskNode*>& task_nodes) {
   auto op_name2task_nodes = std::make_shared<HashMap<std::string, HashSet<TaskNode*>>>();
@@ -406,6 +431,91 @@ void TaskGraph::SetTaskRegstInplaceInfo(const InplaceObasInfo& obas_info,
   });
 }
 
+void TaskGraph::SetSplitAndConcatRegstInplaceInfo(const HashSet<TaskNode*>& dev_nodes) const {
+  auto IsMemReusableRegst = [&](const RegstDesc* regst) -> bool {
+    return regst->regst_desc_type().has_data_regst_desc() && regst->NumOfLbi() > 0
+           && dev_nodes.find(const_cast<TaskNode*>(regst->producer())) != dev_nodes.end()
+           && regst->enable_reuse_mem()
+           && regst->hint_inplace_consumed_regst_desc_id() == -1;
+  };
+  // register i of a view would sit at i times the body size of the viewed regst, which only
+  // matches the offsets below for a single register, so views pin their regsts to one register
+  auto CanPinOneRegister = [](const RegstDesc* regst) -> bool {
+    return regst->min_register_num() == 1;
+  };
+  // split_like: the packed out regst becomes a view of the in regst when every out blob sits at
+  // the same byte offset in the out regst as its slice of the in blob
+  for (TaskNode* task_node : dev_nodes) {
+    const Operator* op = GetSoleUserOp(task_node, "split_like");
+    if (op == nullptr) { continue; }
+    const ExecNode* exec_node = task_node->exec_gph().SoleNode();
+    RegstDesc* in_regst = exec_node->RegstDesc4BnInOp(GenRepeatedBn("in", 0));
+    RegstDesc* out_regst = exec_node->RegstDesc4BnInOp(GenRepeatedBn("out", 0));
+    if (!IsMemReusableRegst(in_regst) || !IsMemReusableRegst(out_regst)) { continue; }
+    if (in_regst->NumOfLbi() != 1 || in_regst->consumers().size() != 1) { continue; }
+    if (!(in_regst->mem_case() == out_regst->mem_case())) { continue; }
+    if (!CanPinOneRegister(in_regst) || !CanPinOneRegister(out_regst)) { continue; }
+    const BlobDesc* in_blob_desc = in_regst->SoleBlobDesc();
+    if (!IsStaticDenseBlobDesc(in_blob_desc) || !IsContiguousAlongAxis(op, in_blob_desc)) {
+      continue;
+    }
+    const int32_t out_num = user_op::UserOpConfWrapper(op->op_conf()).output_size("out");
+    if (out_regst->NumOfLbi() != out_num) { continue; }
+    bool is_view = true;
+    int64_t offset = 0;
+    FOR_RANGE(int32_t, i, 0, out_num) {
+      const std::string obn = GenRepeatedBn("out", i);
+      const LogicalBlobId& lbi = op->BnInOp2Lbi(obn);
+      if (exec_node->RegstDesc4BnInOp(obn) != out_regst
+          || !IsStaticDenseBlobDesc(out_regst->GetBlobDesc(lbi))
+          || out_regst->ByteOffsetInPackedBlobDescBody(lbi) != offset) {
+        is_view = false;
+        break;
+      }
+      offset += ByteSizeOfBlobBody(out_regst->GetBlobDesc(lbi));
+    }
+    if (is_view) {
+      in_regst->UpdtMaxRegstNumIfNeed(1);
+      out_regst->UpdtMaxRegstNumIfNeed(1);
+      out_regst->set_hint_inplace_consumed_regst_desc_id(in_regst->regst_desc_id());
+    }
+  }
+  // concat: each input regst that is consumed only by the concat becomes a sub regst of the out
+  // regst, so its producer writes straight into the out body
+  for (TaskNode* task_node : dev_nodes) {
+    const Operator* op = GetSoleUserOp(task_node, "concat");
+    if (op == nullptr) { continue; }
+    const ExecNode* exec_node = task_node->exec_gph().SoleNode();
+    RegstDesc* out_regst = exec_node->RegstDesc4BnInOp(GenRepeatedBn("out", 0));
+    if (!IsMemReusableRegst(out_regst) || out_regst->NumOfLbi() != 1) { continue; }
+    if (!CanPinOneRegister(out_regst)) { continue; }
+    const BlobDesc* out_blob_desc = out_regst->SoleBlobDesc();
+    if (!IsStaticDenseBlobDesc(out_blob_desc) || !IsContiguousAlongAxis(op, out_blob_desc)) {
+      continue;
+    }
+    const int64_t out_aligned_size = GetCudaAlignedSize(ByteSizeOfBlobBody(out_blob_desc));
+    const int32_t in_num = user_op::UserOpConfWrapper(op->op_conf()).input_size("in");
+    HashSet<const RegstDesc*> visited_in_regsts;
+    int64_t offset = 0;
+    FOR_RANGE(int32_t, i, 0, in_num) {
+      const std::string ibn = GenRepeatedBn("in", i);
+      RegstDesc* in_regst = exec_node->RegstDesc4BnInOp(ibn);
+      const int64_t in_size = ByteSizeOfBlobBody(in_regst->GetBlobDesc(op->BnInOp2Lbi(ibn)));
+      const bool is_first_visit = visited_in_regsts.insert(in_regst).second;
+      if (is_first_visit && IsMemReusableRegst(in_regst) && in_regst->NumOfLbi() == 1
+          && in_regst->consumers().size() == 1 && in_regst->mem_case() == out_regst->mem_case()
+          && IsStaticDenseBlobDesc(in_regst->SoleBlobDesc()) && CanPinOneRegister(in_regst)
+          && offset % kCudaAlignSize == 0
+          && offset + GetCudaAlignedSize(in_size) <= out_aligned_size) {
+        in_regst->UpdtMaxRegstNumIfNeed(1);
+        out_regst->UpdtMaxRegstNumIfNeed(1);
+        out_regst->AddHintInplaceSubRegstDesc(in_regst->regst_desc_id(), offset);
+      }
+      offset += in_size;
+    }
+  }
+}
+
 void TaskGraph::ForEachGpuDeviceNodes(
     const std::function<void(const HashSet<TaskNode*>& dev_nodes)>& Handler) const {
   HashMap<std::pair<int64_t, int64_t>, HashSet<TaskNode*>> global_dev_phy_id2nodes;
@@ -424,6 +534,37 @@ void TaskGraph::EnableInplaceMemSharing(
     InplaceObasInfo safe_inplace_obas_info;
     GetSafeInplaceOpBlobArgList(&safe_inplace_obas_info, dev_nodes, IsOpNameDataOrCtrlReachable);
     SetTaskRegstInplaceInfo(safe_inplace_obas_info, dev_nodes);
+    SetSplitAndConcatRegstInplaceInfo(dev_nodes);
+  });
+}
+
+void TaskGraph::BoundRegstNumByPipelineStage(
+    const std::function<int64_t(const std::string&)>& StageId4OpName, int64_t stage_num,
+    int64_t batch_time_shape_elem_cnt) {
+  ForEachNode([&](TaskNode* task_node) {
+    if (task_node->IsMeaningLess()) { return; }
+    auto* comp_task_node = dynamic_cast<CompTaskNode*>(task_node);
+    if (comp_task_node == nullptr) { return; }
+    int64_t stage_id = -1;
+    for (const auto& op : comp_task_node->logical_node()->op_vec()) {
+      stage_id = StageId4OpName(op->op_name());
+      if (stage_id >= 0) { break; }
+    }
+    if (stage_id < 0) { return; }
+    // stage k holds the activations of at most stage_num - k micro batches, after this warm up
+    // every forward has to wait for a backward to free a register, which is the 1F1B order
+    const int32_t regst_num = stage_num - stage_id;
+    for (const auto& pair : comp_task_node->produced_regsts()) {
+      RegstDesc* regst = pair.second.get();
+      if (!regst->regst_desc_type().has_data_regst_desc()) { continue; }
+      // batch rate regsts, e.g. accumulated model diffs, are left alone
+      if (regst->data_regst_time_shape()->elem_cnt() <= batch_time_shape_elem_cnt) { continue; }
+      if (regst_num < regst->min_register_num() || regst_num > regst->max_register_num()) {
+        continue;
+      }
+      regst->UpdtMinRegstNumIfNeed(regst_num);
+      regst->UpdtMaxRegstNumIfNeed(regst_num);
+    }
   });
 }
 
@@ -42,6 +42,10 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
 
   void EnableInplaceMemSharing(const std::function<bool(const std::string&, const std::string&)>&
                                    IsOpNameDataOrCtrlReachable);
+  // StageId4OpName returns -1 for ops outside of the pipeline.
+  void BoundRegstNumByPipelineStage(
+      const std::function<int64_t(const std::string&)>& StageId4OpName, int64_t stage_num,
+      int64_t batch_time_shape_elem_cnt);
 
   void AcyclicTopoForEachNode(const std::function<void(TaskNode* node)>& Handler) const;
 
@@ -92,6 +96,7 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
           IsOpNameDataOrCtrlReachable) const;
   void SetTaskRegstInplaceInfo(const InplaceObasInfo& obas_info,
                                const HashSet<TaskNode*>& dev_nodes) const;
+  void SetSplitAndConcatRegstInplaceInfo(const HashSet<TaskNode*>& dev_nodes) const;
   void ForEachGpuDeviceNodes(
       const std::function<void(const HashSet<TaskNode*>& dev_nodes)>& Handler) const;
 
@@ -21,6 +21,61 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+bool IsPipelineUnpackOp(const OpNode* node) {
+  return node->op().op_conf().has_unpack_conf()
+         && node->op().op_name().find("System-Pipeline-Unpack-") == 0;
+}
+
+// Stages are the placements met, in topological order, by the ops downstream of the pipeline
+// unpack ops. Backward ops share the placement, hence the stage, of their forward ops.
+HashMap<std::string, int64_t> PipelineStageId4OpName(const OpGraph& op_graph, int64_t* stage_num) {
+  HashSet<const OpNode*> in_pipeline;
+  std::vector<const ParallelDesc*> stage_id2parallel_desc;
+  HashMap<std::string, int64_t> op_name2stage_id;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    bool is_in_pipeline = false;
+    for (const OpEdge* edge : node->in_edges()) {
+      const OpNode* src = edge->src_node();
+      is_in_pipeline = is_in_pipeline || IsPipelineUnpackOp(src) || in_pipeline.count(src) > 0;
+    }
+    if (!is_in_pipeline) { return; }
+    in_pipeline.insert(node);
+    size_t stage_id = 0;
+    while (stage_id < stage_id2parallel_desc.size()
+           && !(*stage_id2parallel_desc.at(stage_id) == node->parallel_desc())) {
+      stage_id += 1;
+    }
+    if (stage_id == stage_id2parallel_desc.size()) {
+      stage_id2parallel_desc.push_back(&node->parallel_desc());
+    }
+    op_name2stage_id.emplace(node->op().op_name(), stage_id);
+  });
+  *stage_num = stage_id2parallel_desc.size();
+  return op_name2stage_id;
+}
+
+void SchedulePipelineStages(const JobDesc& job_desc, TaskGraph* task_gph) {
+  const int64_t micro_batch_num = job_desc.Int64("pipeline_num_micro_batches");
+  int64_t stage_num = 0;
+  const HashMap<std::string, int64_t> op_name2stage_id =
+      PipelineStageId4OpName(*Global<OpGraph>::Get(), &stage_num);
+  if (stage_num == 0) { return; }
+  task_gph->BoundRegstNumByPipelineStage(
+      [&](const std::string& op_name) -> int64_t {
+        const auto it = op_name2stage_id.find(op_name);
+        return it == op_name2stage_id.end() ? -1 : it->second;
+      },
+      stage_num, job_desc.TotalBatchNum() * job_desc.NumOfPiecesInBatch());
+  // with S stages and M micro batches every stage idles for S - 1 of the M + S - 1 slots
+  const double bubble_fraction = (stage_num - 1.0) / (micro_batch_num + stage_num - 1.0);
+  LOG(INFO) << "pipeline of job " << job_desc.job_name() << ": " << stage_num << " stages, "
+            << micro_batch_num << " micro batches, 1F1B bubble fraction " << bubble_fraction;
+}
+
+}  // namespace
+
 void Compiler::GenNetTopo(Plan* plan) const {
   HashMap<int64_t, int64_t> rid2mid;
   HashMap<int64_t, int64_t> tid2mid;
@@ -85,6 +140,9 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
     task_gph->EnableInplaceMemSharing(IsReachable);
   }
   task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  if (job_desc.IsTrain() && job_desc.Int64("pipeline_num_micro_batches") > 1) {
+    SchedulePipelineStages(job_desc, task_gph.get());
+  }
 
   task_gph->ForEachNode([&](TaskNode* task_node) {
     if (task_node->IsMeaningLess()) { return; }
@@ -0,0 +1,266 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/critical_path_profile.h"
+
+namespace oneflow {
+
+namespace {
+
+enum class ActDepKind { kSelf, kInput, kOutput };
+
+bool IsCommTaskType(TaskType task_type) {
+  return task_type == TaskType::kCopyCommNet || task_type == TaskType::kCollectiveBoxingGeneric;
+}
+
+class ActDepGraph final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActDepGraph);
+  ActDepGraph(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events);
+  ~ActDepGraph() = default;
+
+  int64_t event_num() const { return events_.size(); }
+  const ActEvent& event(int64_t i) const { return *events_.at(i); }
+  const TaskProto* task(int64_t actor_id) const;
+  // -1 if no dependency finished before act i did
+  int64_t critical_dep(int64_t i) const { return critical_deps_.at(i).first; }
+  ActDepKind critical_dep_kind(int64_t i) const { return critical_deps_.at(i).second; }
+  int64_t SelfDep(int64_t i) const;
+
+ private:
+  void ForEachDep(int64_t i, const std::function<void(int64_t, ActDepKind)>& Handler) const;
+
+  HashMap<int64_t, const TaskProto*> task_id2task_;
+  HashMap<int64_t, const RegstDescProto*> regst_desc_id2regst_desc_;
+  std::vector<const ActEvent*> events_;
+  HashMap<std::pair<int64_t, int64_t>, int64_t> actor_act_id2event_;
+  HashMap<std::pair<int64_t, int64_t>, std::vector<int64_t>> regst_uid2consumer_events_;
+  std::vector<std::pair<int64_t, ActDepKind>> critical_deps_;
+};
+
+ActDepGraph::ActDepGraph(const Plan& plan,
+                         const std::list<std::unique_ptr<ActEvent>>& act_events) {
+  for (const TaskProto& task : plan.task()) {
+    task_id2task_.emplace(task.task_id(), &task);
+    for (const auto& pair : task.produced_regst_desc()) {
+      regst_desc_id2regst_desc_.emplace(pair.second.regst_desc_id(), &pair.second);
+    }
+  }
+  for (const auto& act_event : act_events) {
+    const int64_t i = events_.size();
+    if (!actor_act_id2event_.emplace(std::make_pair(act_event->actor_id(), act_event->act_id()), i)
+             .second) {
+      continue;
+    }
+    events_.push_back(act_event.get());
+    for (const ReadableRegstInfo& readable : act_event->readable_regst_infos()) {
+      regst_uid2consumer_events_[std::make_pair(readable.regst_desc_id(), readable.act_id())]
+          .push_back(i);
+    }
+  }
+  critical_deps_.resize(events_.size(), std::make_pair(-1, ActDepKind::kSelf));
+  FOR_RANGE(int64_t, i, 0, events_.size()) {
+    double critical_dep_stop_time = 0;
+    ForEachDep(i, [&](int64_t dep, ActDepKind kind) {
+      const double stop_time = event(dep).stop_time();
+      // deps finishing after the act are clock skew between machines, dropping them also keeps
+      // the critical path acyclic
+      if (stop_time >= event(i).stop_time()) { return; }
+      if (critical_deps_.at(i).first == -1 || stop_time > critical_dep_stop_time) {
+        critical_deps_.at(i) = std::make_pair(dep, kind);
+        critical_dep_stop_time = stop_time;
+      }
+    });
+  }
+}
+
+const TaskProto* ActDepGraph::task(int64_t actor_id) const {
+  const auto it = task_id2task_.find(actor_id);
+  return it == task_id2task_.end() ? nullptr : it->second;
+}
+
+int64_t ActDepGraph::SelfDep(int64_t i) const {
+  const auto it = actor_act_id2event_.find(
+      std::make_pair(event(i).actor_id(), event(i).act_id() - 1));
+  return it == actor_act_id2event_.end() ? -1 : it->second;
+}
+
+void ActDepGraph::ForEachDep(int64_t i,
+                             const std::function<void(int64_t, ActDepKind)>& Handler) const {
+  const ActEvent& act_event = event(i);
+  const int64_t self_dep = SelfDep(i);
+  if (self_dep != -1) { Handler(self_dep, ActDepKind::kSelf); }
+  for (const ReadableRegstInfo& readable : act_event.readable_regst_infos()) {
+    const auto regst_desc_it = regst_desc_id2regst_desc_.find(readable.regst_desc_id());
+    if (regst_desc_it == regst_desc_id2regst_desc_.end()) { continue; }
+    const auto producer_it = actor_act_id2event_.find(
+        std::make_pair(regst_desc_it->second->producer_task_id(), readable.act_id()));
+    if (producer_it == actor_act_id2event_.end()) { continue; }
+    Handler(producer_it->second, ActDepKind::kInput);
+  }
+  // act k writes into the slot that the consumers of act k - register_num released
+  const TaskProto* actor_task = task(act_event.actor_id());
+  if (actor_task == nullptr) { return; }
+  for (const auto& pair : actor_task->produced_regst_desc()) {
+    const RegstDescProto& regst_desc = pair.second;
+    const auto consumers_it = regst_uid2consumer_events_.find(
+        std::make_pair(regst_desc.regst_desc_id(), act_event.act_id() - regst_desc.register_num()));
+    if (consumers_it == regst_uid2consumer_events_.end()) { continue; }
+    for (const int64_t consumer : consumers_it->second) { Handler(consumer, ActDepKind::kOutput); }
+  }
+}
+
+}  // namespace
+
+void AnalyzeCriticalPath(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                         CriticalPathProfile* profile) {
+  profile->Clear();
+  profile->set_critical_path_time(0);
+  const ActDepGraph graph(plan, act_events);
+  if (graph.event_num() == 0) { return; }
+
+  HashMap<int64_t, ActorTimeBreakdown> actor_id2breakdown;
+  auto Breakdown4ActorId = [&](int64_t actor_id) -> ActorTimeBreakdown* {
+    auto it = actor_id2breakdown.find(actor_id);
+    if (it == actor_id2breakdown.end()) {
+      ActorTimeBreakdown breakdown;
+      breakdown.set_actor_id(actor_id);
+      breakdown.set_act_num(0);
+      breakdown.set_compute_time(0);
+      breakdown.set_comm_time(0);
+      breakdown.set_input_wait_time(0);
+      breakdown.set_output_wait_time(0);
+      breakdown.set_critical_path_time(0);
+      it = actor_id2breakdown.emplace(actor_id, breakdown).first;
+    }
+    return &it->second;
+  };
+  int64_t last_event = 0;
+  std::map<int64_t, int64_t> act_id2last_event;
+  FOR_RANGE(int64_t, i, 0, graph.event_num()) {
+    const ActEvent& act_event = graph.event(i);
+    ActorTimeBreakdown* breakdown = Breakdown4ActorId(act_event.actor_id());
+    breakdown->set_act_num(breakdown->act_num() + 1);
+    // the time queued on the device stream counts as compute, the actor could not act anyway
+    const double act_time = act_event.stop_time() - act_event.ready_time();
+    const TaskProto* task = graph.task(act_event.actor_id());
+    if (task != nullptr && IsCommTaskType(task->task_type())) {
+      breakdown->set_comm_time(breakdown->comm_time() + act_time);
+    } else {
+      breakdown->set_compute_time(breakdown->compute_time() + act_time);
+    }
+    const int64_t self_dep = graph.SelfDep(i);
+    if (self_dep != -1 && graph.critical_dep(i) != -1) {
+      const double idle_time =
+          std::max(0.0, act_event.ready_time() - graph.event(self_dep).stop_time());
+      if (graph.critical_dep_kind(i) == ActDepKind::kInput) {
+        breakdown->set_input_wait_time(breakdown->input_wait_time() + idle_time);
+      } else if (graph.critical_dep_kind(i) == ActDepKind::kOutput) {
+        breakdown->set_output_wait_time(breakdown->output_wait_time() + idle_time);
+      }
+    }
+    if (act_event.stop_time() > graph.event(last_event).stop_time()) { last_event = i; }
+    auto it = act_id2last_event.find(act_event.act_id());
+    if (it == act_id2last_event.end()) {
+      act_id2last_event.emplace(act_event.act_id(), i);
+    } else if (act_event.stop_time() > graph.event(it->second).stop_time()) {
+      it->second = i;
+    }
+  }
+
+  // every act on the path is charged the time from its critical dep finishing to its own stop,
+  // so the charges add up to the path length
+  int64_t head = last_event;
+  for (int64_t cur = last_event; cur != -1; cur = graph.critical_dep(cur)) {
+    const int64_t dep = graph.critical_dep(cur);
+    const double begin_time =
+        dep == -1 ? graph.event(cur).ready_time() : graph.event(dep).stop_time();
+    ActorTimeBreakdown* breakdown = Breakdown4ActorId(graph.event(cur).actor_id());
+    breakdown->set_critical_path_time(breakdown->critical_path_time()
+                                      + graph.event(cur).stop_time() - begin_time);
+    head = cur;
+  }
+  profile->set_critical_path_time(graph.event(last_event).stop_time()
+                                  - graph.event(head).ready_time());
+
+  // act ids only name pieces when every actor acts once per piece, which fails for actors like
+  // the pipeline unpack or the gradient accumulation ones
+  int64_t act_num = -1;
+  for (const auto& pair : actor_id2breakdown) {
+    if (act_num != -1 && pair.second.act_num() != act_num) {
+      LOG(WARNING) << "per piece critical paths skipped, actor " << pair.first << " acted "
+                   << pair.second.act_num() << " times while others acted " << act_num
+                   << " times";
+      act_id2last_event.clear();
+      break;
+    }
+    act_num = pair.second.act_num();
+  }
+  for (const auto& pair : act_id2last_event) {
+    PieceCriticalPath* piece = profile->add_piece();
+    piece->set_act_id(pair.first);
+    std::vector<int64_t> path;
+    for (int64_t cur = pair.second; cur != -1; cur = graph.critical_dep(cur)) {
+      if (graph.event(cur).act_id() != pair.first) { break; }
+      path.push_back(cur);
+    }
+    piece->set_duration(graph.event(path.front()).stop_time()
+                        - graph.event(path.back()).ready_time());
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      piece->add_actor_id(graph.event(*it).actor_id());
+    }
+  }
+
+  std::vector<ActorTimeBreakdown> breakdowns;
+  for (const auto& pair : actor_id2breakdown) { breakdowns.push_back(pair.second); }
+  std::sort(breakdowns.begin(), breakdowns.end(),
+            [](const ActorTimeBreakdown& lhs, const ActorTimeBreakdown& rhs) {
+              if (lhs.critical_path_time() != rhs.critical_path_time()) {
+                return lhs.critical_path_time() > rhs.critical_path_time();
+              }
+              return lhs.actor_id() < rhs.actor_id();
+            });
+  for (const ActorTimeBreakdown& breakdown : breakdowns) { *profile->add_actor() = breakdown; }
+}
+
+std::string CriticalPathReport(const Plan& plan, const CriticalPathProfile& profile) {
+  HashMap<int64_t, TaskType> task_id2task_type;
+  for (const TaskProto& task : plan.task()) {
+    task_id2task_type.emplace(task.task_id(), task.task_type());
+  }
+  double acc_piece_duration = 0;
+  for (const PieceCriticalPath& piece : profile.piece()) { acc_piece_duration += piece.duration(); }
+  std::string report = "critical_path_time:" + std::to_string(profile.critical_path_time());
+  if (profile.piece_size() > 0) {
+    report += " avg_piece_critical_path_time:"
+              + std::to_string(acc_piece_duration / profile.piece_size());
+  }
+  report += "\n";
+  for (const ActorTimeBreakdown& breakdown : profile.actor()) {
+    const auto type_it = task_id2task_type.find(breakdown.actor_id());
+    report += "actor_id:" + std::to_string(breakdown.actor_id())
+              + " act_num:" + std::to_string(breakdown.act_num())
+              + " critical_path_time:" + std::to_string(breakdown.critical_path_time())
+              + " compute_time:" + std::to_string(breakdown.compute_time())
+              + " comm_time:" + std::to_string(breakdown.comm_time())
+              + " input_wait_time:" + std::to_string(breakdown.input_wait_time())
+              + " output_wait_time:" + std::to_string(breakdown.output_wait_time()) + " type:"
+              + (type_it == task_id2task_type.end() ? "unknown" : TaskType_Name(type_it->second))
+              + "\n";
+  }
+  return report;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,38 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_CRITICAL_PATH_PROFILE_H_
+#define ONEFLOW_CORE_JOB_CRITICAL_PATH_PROFILE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+// Rebuilds the dependency DAG of act events: an act depends on the previous act of its actor, on
+// the acts that produced the regsts it read, and on the consumers that freed the regst slot it
+// writes into. Following the dependency that finished last from the last act gives the critical
+// path, which is reported per actor and per piece. Pieces are told apart by act id, so they are
+// only reported when every actor acted the same number of times, i.e. once per piece.
+void AnalyzeCriticalPath(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                         CriticalPathProfile* profile);
+
+// Actors ranked by their time on the critical path, one per line.
+std::string CriticalPathReport(const Plan& plan, const CriticalPathProfile& profile);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_CRITICAL_PATH_PROFILE_H_
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/critical_path_profile.h"
+
+namespace oneflow {
+
+namespace {
+
+void AddTask(int64_t task_id, TaskType task_type, int64_t produced_regst_desc_id,
+             int32_t register_num, Plan* plan) {
+  TaskProto* task = plan->add_task();
+  task->set_task_id(task_id);
+  task->set_task_type(task_type);
+  if (produced_regst_desc_id == -1) { return; }
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(produced_regst_desc_id);
+  regst_desc->set_producer_task_id(task_id);
+  regst_desc->set_register_num(register_num);
+}
+
+void AddActEvent(int64_t actor_id, int64_t act_id, double ready_time, double stop_time,
+                 int64_t readable_regst_desc_id,
+                 std::list<std::unique_ptr<ActEvent>>* act_events) {
+  std::unique_ptr<ActEvent> act_event(new ActEvent());
+  act_event->set_actor_id(actor_id);
+  act_event->set_act_id(act_id);
+  act_event->set_ready_time(ready_time);
+  act_event->set_start_time(ready_time);
+  act_event->set_stop_time(stop_time);
+  if (readable_regst_desc_id != -1) {
+    ReadableRegstInfo* readable = act_event->add_readable_regst_infos();
+    readable->set_regst_desc_id(readable_regst_desc_id);
+    readable->set_act_id(act_id);
+  }
+  act_events->push_back(std::move(act_event));
+}
+
+}  // namespace
+
+// actor 1 -> regst 10 (one slot) -> actor 2 -> regst 20 (two slots) -> actor 3 (comm)
+TEST(CriticalPathProfile, attributes_waits_and_path) {
+  Plan plan;
+  AddTask(1, TaskType::kNormalForward, 10, 1, &plan);
+  AddTask(2, TaskType::kNormalForward, 20, 2, &plan);
+  AddTask(3, TaskType::kCopyCommNet, -1, 0, &plan);
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  AddActEvent(1, 0, 0, 1, -1, &act_events);
+  AddActEvent(2, 0, 1, 4, 10, &act_events);
+  // actor 1 waits for actor 2 to release the only slot of regst 10
+  AddActEvent(1, 1, 4, 5, -1, &act_events);
+  AddActEvent(3, 0, 4, 6, 20, &act_events);
+  AddActEvent(2, 1, 5, 8, 10, &act_events);
+  AddActEvent(3, 1, 8, 10, 20, &act_events);
+  CriticalPathProfile profile;
+  AnalyzeCriticalPath(plan, act_events, &profile);
+
+  ASSERT_DOUBLE_EQ(profile.critical_path_time(), 10);
+  ASSERT_EQ(profile.actor_size(), 3);
+  const ActorTimeBreakdown& actor2 = profile.actor(0);
+  ASSERT_EQ(actor2.actor_id(), 2);
+  ASSERT_DOUBLE_EQ(actor2.critical_path_time(), 6);
+  ASSERT_DOUBLE_EQ(actor2.compute_time(), 6);
+  ASSERT_DOUBLE_EQ(actor2.input_wait_time(), 1);
+  ASSERT_DOUBLE_EQ(actor2.output_wait_time(), 0);
+  const ActorTimeBreakdown& actor1 = profile.actor(1);
+  ASSERT_EQ(actor1.actor_id(), 1);
+  ASSERT_DOUBLE_EQ(actor1.critical_path_time(), 2);
+  ASSERT_DOUBLE_EQ(actor1.output_wait_time(), 3);
+  const ActorTimeBreakdown& actor3 = profile.actor(2);
+  ASSERT_EQ(actor3.actor_id(), 3);
+  ASSERT_DOUBLE_EQ(actor3.comm_time(), 4);
+  ASSERT_DOUBLE_EQ(actor3.compute_time(), 0);
+  ASSERT_DOUBLE_EQ(actor3.input_wait_time(), 2);
+
+  ASSERT_EQ(profile.piece_size(), 2);
+  FOR_RANGE(int64_t, i, 0, 2) {
+    ASSERT_EQ(profile.piece(i).act_id(), i);
+    ASSERT_DOUBLE_EQ(profile.piece(i).duration(), 6);
+    ASSERT_EQ(std::vector<int64_t>(profile.piece(i).actor_id().begin(),
+                                   profile.piece(i).actor_id().end()),
+              std::vector<int64_t>({1, 2, 3}));
+  }
+}
+
+// actor 1 acts twice per piece, as an unpack actor would, so act ids no longer name pieces
+TEST(CriticalPathProfile, skips_pieces_without_one_act_per_piece) {
+  Plan plan;
+  AddTask(1, TaskType::kNormalForward, 10, 2, &plan);
+  AddTask(2, TaskType::kNormalForward, -1, 0, &plan);
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  AddActEvent(1, 0, 0, 1, -1, &act_events);
+  AddActEvent(1, 1, 1, 2, -1, &act_events);
+  AddActEvent(2, 0, 2, 4, 10, &act_events);
+  CriticalPathProfile profile;
+  AnalyzeCriticalPath(plan, act_events, &profile);
+
+  ASSERT_DOUBLE_EQ(profile.critical_path_time(), 4);
+  ASSERT_EQ(profile.actor_size(), 2);
+  ASSERT_EQ(profile.piece_size(), 0);
+}
+
+}  // namespace oneflow
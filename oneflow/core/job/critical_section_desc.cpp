@@ -101,20 +101,29 @@ void CriticalSectionDesc::UpdateCriticalSectionIds2IntersectingIds() {
   CHECK_EQ(inited_, false);
   critical_section_id2intersecting_ids_.resize(critical_sections_.size());
   HashMap<int64_t, HashSet<int64_t>> mem_block_id2critical_section_ids;
+  HashMap<int64_t, HashSet<int64_t>> mem_block_id2writing_critical_section_ids;
   HashMap<int64_t, HashSet<int64_t>> chunk_id2critical_section_ids;
   FOR_RANGE(int64_t, i, 0, critical_sections_.size()) {
+    const HashSet<int64_t> read_only_mem_block_ids(
+        critical_sections_.at(i)->read_only_mem_block_id().begin(),
+        critical_sections_.at(i)->read_only_mem_block_id().end());
     for (int64_t mem_block_id : critical_sections_.at(i)->mem_block_id()) {
       mem_block_id2critical_section_ids[mem_block_id].insert(i);
+      if (read_only_mem_block_ids.count(mem_block_id) == 0) {
+        mem_block_id2writing_critical_section_ids[mem_block_id].insert(i);
+      }
     }
     for (int64_t chunk_id : critical_sections_.at(i)->chunk_id()) {
       chunk_id2critical_section_ids[chunk_id].insert(i);
     }
   }
-  for (const auto& pair : mem_block_id2critical_section_ids) {
-    for (int64_t first_id : pair.second) {
-      for (int64_t second_id : pair.second) {
-        if (first_id != second_id) {
-          critical_section_id2intersecting_ids_[first_id].insert(second_id);
+  // critical sections sharing a mem block only conflict when one of them writes it
+  for (const auto& pair : mem_block_id2writing_critical_section_ids) {
+    for (int64_t writing_id : pair.second) {
+      for (int64_t other_id : mem_block_id2critical_section_ids.at(pair.first)) {
+        if (writing_id != other_id) {
+          critical_section_id2intersecting_ids_[writing_id].insert(other_id);
+          critical_section_id2intersecting_ids_[other_id].insert(writing_id);
         }
       }
     }
@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/critical_section_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+class CriticalSectionDescTest : public testing::Test {
+ protected:
+  void SetUp() override { Global<CriticalSectionDesc>::New(); }
+  void TearDown() override { Global<CriticalSectionDesc>::Delete(); }
+};
+
+// adds the total job critical section of job_id, whose mem blocks are written unless listed in
+// read_only_mem_block_ids
+void AddTotalJobCriticalSection(int64_t job_id, const std::vector<int64_t>& mem_block_ids,
+                                const std::vector<int64_t>& read_only_mem_block_ids) {
+  std::unique_ptr<CriticalSection> critical_section(new CriticalSection());
+  critical_section->set_job_id(job_id);
+  critical_section->set_source_tick_op_name("source_tick_" + std::to_string(job_id));
+  critical_section->set_sink_tick_op_name("sink_tick_" + std::to_string(job_id));
+  critical_section->mutable_total_job_critical_section();
+  *critical_section->mutable_mem_block_id() = {mem_block_ids.begin(), mem_block_ids.end()};
+  *critical_section->mutable_read_only_mem_block_id() = {read_only_mem_block_ids.begin(),
+                                                         read_only_mem_block_ids.end()};
+  Global<CriticalSectionDesc>::Get()->AddCriticalSection(std::move(critical_section));
+}
+
+std::vector<HashSet<int64_t>> DumpIntersectingIds() {
+  PbRpf<Int64List> id2id_list;
+  Global<CriticalSectionDesc>::Get()->DumpCriticalSectionId2IntersectinIds(&id2id_list);
+  std::vector<HashSet<int64_t>> ret;
+  for (const Int64List& id_list : id2id_list) {
+    ret.emplace_back(id_list.value().begin(), id_list.value().end());
+  }
+  return ret;
+}
+
+}  // namespace
+
+// two predict jobs reading the same variables, block 1, next to private blocks 2 and 3
+TEST_F(CriticalSectionDescTest, jobs_only_reading_shared_variables_overlap) {
+  AddTotalJobCriticalSection(0, {1, 2}, {1});
+  AddTotalJobCriticalSection(1, {1, 3}, {1});
+  Global<CriticalSectionDesc>::Get()->Done();
+  const std::vector<HashSet<int64_t>> intersecting_ids = DumpIntersectingIds();
+  ASSERT_EQ(intersecting_ids.size(), 2);
+  ASSERT_TRUE(intersecting_ids.at(0).empty());
+  ASSERT_TRUE(intersecting_ids.at(1).empty());
+}
+
+// a train job updating the variables of block 1 read by two predict jobs
+TEST_F(CriticalSectionDescTest, job_writing_shared_block_stays_exclusive) {
+  AddTotalJobCriticalSection(0, {1, 2}, {});
+  AddTotalJobCriticalSection(1, {1, 3}, {1});
+  AddTotalJobCriticalSection(2, {1, 4}, {1});
+  Global<CriticalSectionDesc>::Get()->Done();
+  const std::vector<HashSet<int64_t>> intersecting_ids = DumpIntersectingIds();
+  ASSERT_EQ(intersecting_ids.size(), 3);
+  ASSERT_EQ(intersecting_ids.at(0), (HashSet<int64_t>{1, 2}));
+  ASSERT_EQ(intersecting_ids.at(1), (HashSet<int64_t>{0}));
+  ASSERT_EQ(intersecting_ids.at(2), (HashSet<int64_t>{0}));
+}
+
+// a read-only block does not let jobs overlap when they share a chunk
+TEST_F(CriticalSectionDescTest, shared_chunk_stays_exclusive) {
+  AddTotalJobCriticalSection(0, {1}, {1});
+  AddTotalJobCriticalSection(1, {1}, {1});
+  FOR_RANGE(int64_t, i, 0, 2) {
+    Global<CriticalSectionDesc>::Get()->MutCriticalSection(i)->add_chunk_id(5);
+  }
+  Global<CriticalSectionDesc>::Get()->Done();
+  const std::vector<HashSet<int64_t>> intersecting_ids = DumpIntersectingIds();
+  ASSERT_EQ(intersecting_ids.at(0), (HashSet<int64_t>{1}));
+  ASSERT_EQ(intersecting_ids.at(1), (HashSet<int64_t>{0}));
+}
+
+}  // namespace oneflow
@@ -31,6 +31,7 @@ class EnvDesc final {
   int32_t ctrl_port() const { return env_proto_.ctrl_port(); }
   int32_t data_port() const { return env_proto_.data_port(); }
   bool grpc_use_no_signal() const { return env_proto_.grpc_use_no_signal(); }
+  bool enable_async_eager_execution() const { return env_proto_.enable_async_eager_execution(); }
   int64_t GetMachineId(const std::string& addr) const;
 
  private:
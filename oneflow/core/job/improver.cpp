@@ -192,6 +192,10 @@ void ForEachInferredMemBlockId(const PlanTaskGraph& plan_task_graph,
   ForEachSameColoredChainRegstDescWithConsumer(plan_task_graph, HandleMemBlockId);
 }
 
+// register_num is raised only for regst descs stalled at least this ratio of the worst one
+const double kMinRaisedStallRatio = 0.1;
+const size_t kMaxRaisedRegstDescNum = 8;
+
 double CalcRegstNum(double regst_desc_duration, double ii, double ii_scale) {
   return ((ii_scale - 1) * ii + regst_desc_duration) / (ii_scale * ii);
 }
@@ -409,6 +413,19 @@ void SetInplaceConsumedRegstDescId(
           regst_desc->set_inplace_consumed_regst_desc_id(hint);
         }
       }
+      CHECK_EQ(regst_desc->inplace_sub_regst_desc_size(), 0);
+      for (const InplaceSubRegstDesc& hint_sub : regst_desc->hint_inplace_sub_regst_desc()) {
+        const RegstDescProto* sub_regst_desc =
+            regst_desc_id2regst_desc.at(hint_sub.regst_desc_id());
+        // the byte offset only holds for a single register, see SetSplitAndConcatRegstInplaceInfo
+        if (sub_regst_desc->mem_block_id() != -1
+            && sub_regst_desc->mem_block_id() == regst_desc->mem_block_id()
+            && sub_regst_desc->mem_block_offset()
+                   == regst_desc->mem_block_offset() + hint_sub.byte_offset()
+            && sub_regst_desc->register_num() == 1 && regst_desc->register_num() == 1) {
+          *regst_desc->mutable_inplace_sub_regst_desc()->Add() = hint_sub;
+        }
+      }
     }
   }
 }
@@ -580,6 +597,15 @@ Maybe<void> Improver::CheckAllZoneNotOOM(
   return Maybe<void>::Ok();
 }
 
+Maybe<void> Improver::CheckPlanNotOOM(const Plan& plan) const {
+  MemZoneRegstDescs mz_regst_descs;
+  MakeMemZoneRegstDescs(plan, &mz_regst_descs);
+  // with a duration of one ii every regst desc keeps the register_num already set in plan
+  HashMap<int64_t, double> zero2one{{0, 1}};
+  auto Zero2One = [&](int64_t) -> const HashMap<int64_t, double>& { return zero2one; };
+  return CheckAllZoneNotOOM(mz_regst_descs, Zero2One, Zero2One, 1);
+}
+
 double Improver::CalcMaxRegstDescDuration(
     const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
     const MemZoneRegstDescs& mz_regst_descs) const {
@@ -636,10 +662,21 @@ Maybe<void> Improver::ForEachImprovedRegstNum(
         BinarySearchII(ii, PathDurations4RegstDescId, PathIIScales4RegstDescId, mz_regst_descs));
   }
   LOG(INFO) << "memory " << (is_memory_limited ? "limited" : "unlimited") << " ii: " << ii;
+  HashSet<int64_t> inplace_sub_regst_desc_ids;
+  for (const auto& task_proto : plan.task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      if (pair.second.inplace_sub_regst_desc_size() == 0) { continue; }
+      inplace_sub_regst_desc_ids.insert(pair.second.regst_desc_id());
+      for (const InplaceSubRegstDesc& sub : pair.second.inplace_sub_regst_desc()) {
+        inplace_sub_regst_desc_ids.insert(sub.regst_desc_id());
+      }
+    }
+  }
   for (const auto& task_proto : plan.task()) {
     for (const auto& pair : task_proto.produced_regst_desc()) {
       uint64_t regst_num = 0;
-      if (pair.second.has_inplace_consumed_regst_desc_id()) {
+      if (pair.second.has_inplace_consumed_regst_desc_id()
+          || inplace_sub_regst_desc_ids.count(pair.second.regst_desc_id()) > 0) {
         regst_num = pair.second.register_num();
       } else {
         regst_num =
@@ -690,11 +727,7 @@ Maybe<Plan> Improver::GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd,
   Init(amd, naive_plan);
   Plan complete_plan = GenAndInferMemBlockId(naive_plan);
   // Check if there is any zone out of memory even though all register_num == 1
-  MemZoneRegstDescs mz_regst_descs;
-  MakeMemZoneRegstDescs(complete_plan, &mz_regst_descs);
-  HashMap<int64_t, double> zero2one{{0, 1}};
-  auto Zero2One = [&](int64_t) -> const HashMap<int64_t, double>& { return zero2one; };
-  JUST(CheckAllZoneNotOOM(mz_regst_descs, Zero2One, Zero2One, 1));
+  JUST(CheckPlanNotOOM(complete_plan));
   SetUniqueMemBlockId4UnreusedMemRegst(&complete_plan);
   GenMemBlockAndChunk4Plan(&complete_plan);
   return complete_plan;
@@ -724,6 +757,112 @@ Maybe<Plan> Improver::Improve(const AvailableMemDesc& amd, const Plan& naive_pla
   return plan;
 }
 
+Maybe<Plan> Improver::RetuneRegstNum(const AvailableMemDesc& amd, const Plan& naive_plan,
+                                      const Plan& cur_plan,
+                                      const RegstStallList& regst_stall_list) {
+  Init(amd, naive_plan);
+  Plan plan(naive_plan);
+  auto SetRegstNum = MakeSetterSetPlanRegstNum(&plan);
+  HashMap<int64_t, const RegstDescProto*> regst_desc_id2cur_regst_desc;
+  for (const auto& task_proto : cur_plan.task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      regst_desc_id2cur_regst_desc.emplace(pair.second.regst_desc_id(), &pair.second);
+    }
+  }
+  HashMap<int64_t, const RegstDescProto*> regst_desc_id2regst_desc;
+  HashSet<int64_t> inplace_regst_desc_ids;
+  for (const auto& task_proto : naive_plan.task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      const RegstDescProto& regst_desc = pair.second;
+      regst_desc_id2regst_desc.emplace(regst_desc.regst_desc_id(), &regst_desc);
+      SetRegstNum(regst_desc.regst_desc_id(),
+                  regst_desc_id2cur_regst_desc.at(regst_desc.regst_desc_id())->register_num());
+      if (regst_desc.has_hint_inplace_consumed_regst_desc_id()) {
+        inplace_regst_desc_ids.insert(regst_desc.regst_desc_id());
+        inplace_regst_desc_ids.insert(regst_desc.hint_inplace_consumed_regst_desc_id());
+      }
+      for (const InplaceSubRegstDesc& sub : regst_desc.hint_inplace_sub_regst_desc()) {
+        inplace_regst_desc_ids.insert(regst_desc.regst_desc_id());
+        inplace_regst_desc_ids.insert(sub.regst_desc_id());
+      }
+    }
+  }
+  // inplace pairs must keep equal register_num, so only standalone data regsts are retuned
+  auto FindTunableRegstDesc = [&](int64_t regst_desc_id) -> const RegstDescProto* {
+    const auto it = regst_desc_id2regst_desc.find(regst_desc_id);
+    if (it == regst_desc_id2regst_desc.end()) { return nullptr; }
+    if (!it->second->regst_desc_type().has_data_regst_desc()) { return nullptr; }
+    if (inplace_regst_desc_ids.count(regst_desc_id) > 0) { return nullptr; }
+    return it->second;
+  };
+  auto CurRegstNum = [&](int64_t regst_desc_id) {
+    return regst_desc_id2cur_regst_desc.at(regst_desc_id)->register_num();
+  };
+
+  double max_writeable_wait_time = 0;
+  for (const RegstStall& regst_stall : regst_stall_list.regst_stall()) {
+    max_writeable_wait_time = std::max(max_writeable_wait_time, regst_stall.writeable_wait_time());
+  }
+  // a producer waiting for a free slot is throttled by register_num, grow the worst of them
+  std::vector<const RegstStall*> raised;
+  // a consumer waiting for input while its producer never waits has slots that are never filled
+  std::vector<const RegstStall*> shrunk;
+  for (const RegstStall& regst_stall : regst_stall_list.regst_stall()) {
+    const RegstDescProto* regst_desc = FindTunableRegstDesc(regst_stall.regst_desc_id());
+    if (regst_desc == nullptr) { continue; }
+    const int64_t regst_num = CurRegstNum(regst_stall.regst_desc_id());
+    if (regst_stall.writeable_wait_time() > 0
+        && regst_stall.writeable_wait_time() >= kMinRaisedStallRatio * max_writeable_wait_time
+        && regst_num < regst_desc->max_register_num()) {
+      raised.push_back(&regst_stall);
+    } else if (regst_stall.writeable_wait_time() == 0 && regst_stall.readable_wait_time() > 0
+               && regst_num > regst_desc->min_register_num()) {
+      shrunk.push_back(&regst_stall);
+    }
+  }
+  std::sort(raised.begin(), raised.end(), [](const RegstStall* lhs, const RegstStall* rhs) {
+    return lhs->writeable_wait_time() > rhs->writeable_wait_time();
+  });
+  if (raised.size() > kMaxRaisedRegstDescNum) { raised.resize(kMaxRaisedRegstDescNum); }
+  if (raised.empty()) {
+    LOG(INFO) << "no regst desc is throttled by its register_num";
+    return cur_plan;
+  }
+  // memory is only given back when some regst desc asks for more
+  for (const RegstStall* regst_stall : shrunk) {
+    SetRegstNum(regst_stall->regst_desc_id(), CurRegstNum(regst_stall->regst_desc_id()) - 1);
+  }
+  // the least stalled raises are given up first until the plan fits in memory
+  while (true) {
+    for (const RegstStall* regst_stall : raised) {
+      SetRegstNum(regst_stall->regst_desc_id(), CurRegstNum(regst_stall->regst_desc_id()) + 1);
+    }
+    Plan complete_plan = GenAndInferMemBlockId(plan);
+    const auto& oom_status = TRY(CheckPlanNotOOM(complete_plan));
+    if (oom_status.IsOk()) {
+      for (const RegstStall* regst_stall : raised) {
+        LOG(INFO) << "regst desc " << regst_stall->regst_desc_id() << " register_num "
+                  << CurRegstNum(regst_stall->regst_desc_id()) << " -> "
+                  << CurRegstNum(regst_stall->regst_desc_id()) + 1
+                  << ", writeable wait time: " << regst_stall->writeable_wait_time();
+      }
+      FixReliantCtrlRegstNum(complete_plan, MakeGetterGetPlanRegstNum(&complete_plan),
+                             MakeSetterSetPlanRegstNum(&complete_plan));
+      SetUniqueMemBlockId4UnreusedMemRegst(&complete_plan);
+      GenMemBlockAndChunk4Plan(&complete_plan);
+      return complete_plan;
+    }
+    if (!oom_status.error()->has_memory_zone_out_of_memory()) { return oom_status.error(); }
+    const RegstStall* given_up = raised.back();
+    SetRegstNum(given_up->regst_desc_id(), CurRegstNum(given_up->regst_desc_id()));
+    raised.pop_back();
+    if (raised.empty()) {
+      LOG(INFO) << "no memory left to raise register_num";
+      return cur_plan;
+    }
+  }
+}
+
 Plan Improver::GenAndInferMemBlockId(const Plan& naive_plan) const {
   Plan plan(naive_plan);
   PlanTaskGraph plan_task_graph(naive_plan);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/graph/chain_act_graph.h"
+#include "oneflow/core/actor/act_event.pb.h"
 
 namespace oneflow {
 
@@ -33,6 +34,10 @@ class Improver final {
   Maybe<Plan> Improve(const AvailableMemDesc& amd, const Plan& naive_plan,
                       const std::string& act_event_filepath);
   Maybe<Plan> GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd, const Plan& naive_plan);
+  // Raises register_num of the regst descs whose producers waited longest for a free slot in
+  // cur_plan, within the memory budget, and regenerates the memory blocks of naive_plan.
+  Maybe<Plan> RetuneRegstNum(const AvailableMemDesc& amd, const Plan& naive_plan,
+                             const Plan& cur_plan, const RegstStallList& regst_stall_list);
 
  private:
   Plan GenAndInferMemBlockId(const Plan& naive_plan) const;
@@ -58,6 +63,7 @@ class Improver final {
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Ratio4RegstDescId,
       const MemZoneRegstDescs& mz_regst_descs) const;
+  Maybe<void> CheckPlanNotOOM(const Plan& plan) const;
   uint64_t AvailableMemSize(int64_t machine_id, int64_t memory_zone_id) const;
   int64_t GetMemoryZoneId(const MemoryCase& mem_case) const;
   void MakeMemZoneRegstDescs(const Plan& plan, MemZoneRegstDescs* mz2regst_desc) const;
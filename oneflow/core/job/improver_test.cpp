@@ -0,0 +1,265 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/improver.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/register/blob_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+// every register of the big regst holds 1MB, the small one a single float
+const int64_t kBigElemCnt = 256 * 1024;
+// byte offset of the concat input inside the concat output
+const int64_t kSubByteOffset = 1024;
+
+EnvProto GetEnvProto() {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  ret.set_ctrl_port(9527);
+  return ret;
+}
+
+Resource GetResource(int32_t gpu_device_num) {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(gpu_device_num);
+  ret.set_cpu_device_num(1);
+  ret.set_reserved_host_mem_mbyte(0);
+  ret.set_reserved_device_mem_mbyte(0);
+  return ret;
+}
+
+void NewGlobals(int32_t gpu_device_num) {
+  Global<EnvDesc>::New(GetEnvProto());
+  Global<ResourceDesc, ForSession>::New(GetResource(gpu_device_num));
+  Global<IDMgr>::New();
+  Global<JobDesc>::New(JobConfigProto(), 0);
+}
+
+void DeleteGlobals() {
+  Global<JobDesc>::Delete();
+  Global<IDMgr>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+class ImproverTest : public testing::Test {
+ protected:
+  void SetUp() override { NewGlobals(0); }
+  void TearDown() override { DeleteGlobals(); }
+};
+
+class ImproverInplaceTest : public testing::Test {
+ protected:
+  void SetUp() override { NewGlobals(1); }
+  void TearDown() override { DeleteGlobals(); }
+};
+
+TaskProto* AddTask(int64_t order_in_graph, int64_t thrd_id, Plan* plan) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_machine_id(0);
+  task->set_thrd_id(thrd_id);
+  task->set_task_id(Global<IDMgr>::Get()->NewTaskId(0, thrd_id, 0));
+  task->set_job_id(0);
+  task->mutable_task_set_info()->set_area_id(0);
+  task->mutable_task_set_info()->set_chain_id(0);
+  task->mutable_task_set_info()->set_order_in_graph(order_in_graph);
+  task->mutable_exec_sequence();
+  return task;
+}
+
+TaskProto* AddCpuTask(int64_t order_in_graph, Plan* plan) {
+  return AddTask(order_in_graph, Global<IDMgr>::Get()->GetCpuDeviceThrdId(0), plan);
+}
+
+TaskProto* AddGpuTask(int64_t order_in_graph, Plan* plan) {
+  return AddTask(order_in_graph, Global<IDMgr>::Get()->GetGpuComputeThrdId(0), plan);
+}
+
+RegstDescProto* AddProducedRegst(TaskProto* task, int64_t regst_desc_id, int64_t elem_cnt,
+                                 int32_t max_register_num, const TaskProto* consumer) {
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(regst_desc_id);
+  regst_desc->set_producer_task_id(task->task_id());
+  if (consumer != nullptr) { regst_desc->add_consumer_task_id(consumer->task_id()); }
+  regst_desc->set_min_register_num(1);
+  regst_desc->set_max_register_num(max_register_num);
+  regst_desc->set_register_num(1);
+  regst_desc->mutable_mem_case()->mutable_host_mem();
+  regst_desc->set_enable_reuse_mem(false);
+  DataRegstDesc* data_regst_desc = regst_desc->mutable_regst_desc_type()->mutable_data_regst_desc();
+  BlobDesc(Shape({elem_cnt}), DataType::kFloat)
+      .ToProto(data_regst_desc->mutable_packed_blob_desc());
+  Shape({1, 1}).ToProto(data_regst_desc->mutable_time_shape());
+  return regst_desc;
+}
+
+// task 0 produces the big regst 1 for task 1, which produces the small regst 2
+Plan MakeNaivePlan() {
+  Plan plan;
+  TaskProto* producer = AddCpuTask(0, &plan);
+  TaskProto* consumer = AddCpuTask(1, &plan);
+  AddProducedRegst(producer, 1, kBigElemCnt, 3, consumer);
+  AddProducedRegst(consumer, 2, 1, 3, nullptr);
+  return plan;
+}
+
+AvailableMemDesc MakeAvailableMemDesc(uint64_t host_mem_size) {
+  AvailableMemDesc amd;
+  amd.add_machine_amd()->add_zone_size(host_mem_size);
+  return amd;
+}
+
+RegstStallList MakeWriteStalledRegstStallList() {
+  RegstStallList regst_stall_list;
+  RegstStall* stalled = regst_stall_list.add_regst_stall();
+  stalled->set_regst_desc_id(1);
+  stalled->set_writeable_wait_time(10);
+  stalled->set_readable_wait_time(0);
+  RegstStall* idle = regst_stall_list.add_regst_stall();
+  idle->set_regst_desc_id(2);
+  idle->set_writeable_wait_time(0);
+  idle->set_readable_wait_time(0);
+  return regst_stall_list;
+}
+
+const RegstDescProto& RegstDesc4RegstDescId(const Plan& plan, int64_t regst_desc_id) {
+  for (const TaskProto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      if (pair.second.regst_desc_id() == regst_desc_id) { return pair.second; }
+    }
+  }
+  UNIMPLEMENTED();
+  return plan.task(0).produced_regst_desc().begin()->second;
+}
+
+int64_t RegisterNum4RegstDescId(const Plan& plan, int64_t regst_desc_id) {
+  return RegstDesc4RegstDescId(plan, regst_desc_id).register_num();
+}
+
+// task 0 produces the concat input regst 1, a 1KB sub regst at offset 1KB of the 2KB concat out
+// regst 2 produced by task 1 and consumed by task 2
+Plan MakeConcatPlan(int32_t sub_register_num) {
+  Plan plan;
+  TaskProto* in_producer = AddGpuTask(0, &plan);
+  TaskProto* concat = AddGpuTask(1, &plan);
+  TaskProto* out_consumer = AddGpuTask(2, &plan);
+  RegstDescProto* sub = AddProducedRegst(in_producer, 1, 256, 3, concat);
+  RegstDescProto* parent = AddProducedRegst(concat, 2, 512, 3, out_consumer);
+  AddProducedRegst(out_consumer, 3, 1, 3, nullptr);
+  for (TaskProto* task : {in_producer, concat, out_consumer}) {
+    RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+    regst_desc->mutable_mem_case()->mutable_device_cuda_mem()->set_device_id(0);
+    regst_desc->set_enable_reuse_mem(true);
+  }
+  sub->set_register_num(sub_register_num);
+  InplaceSubRegstDesc* hint_sub = parent->add_hint_inplace_sub_regst_desc();
+  hint_sub->set_regst_desc_id(sub->regst_desc_id());
+  hint_sub->set_byte_offset(kSubByteOffset);
+  return plan;
+}
+
+// zone 0 is the device memory of gpu 0, zone 1 the host memory
+AvailableMemDesc MakeGpuAvailableMemDesc() {
+  AvailableMemDesc amd;
+  AvailableMemDescOfMachine* machine_amd = amd.add_machine_amd();
+  machine_amd->add_zone_size(8 * kMB);
+  machine_amd->add_zone_size(8 * kMB);
+  return amd;
+}
+
+}  // namespace
+
+TEST_F(ImproverTest, write_stalled_regst_gains_a_register) {
+  const Plan naive_plan = MakeNaivePlan();
+  const AvailableMemDesc amd = MakeAvailableMemDesc(8 * kMB);
+  const Plan cur_plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, naive_plan));
+  const Plan plan = *CHECK_JUST(
+      Improver().RetuneRegstNum(amd, naive_plan, cur_plan, MakeWriteStalledRegstStallList()));
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 1), 2);
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 2), 1);
+  ASSERT_GT(plan.block_chunk_list().mem_block_size(), 0);
+}
+
+TEST_F(ImproverTest, raise_is_rolled_back_when_out_of_memory) {
+  const Plan naive_plan = MakeNaivePlan();
+  // room for one 1MB register but not for two
+  const AvailableMemDesc amd = MakeAvailableMemDesc(kMB + kMB / 2);
+  const Plan cur_plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, naive_plan));
+  const Plan plan = *CHECK_JUST(
+      Improver().RetuneRegstNum(amd, naive_plan, cur_plan, MakeWriteStalledRegstStallList()));
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 1), 1);
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 2), 1);
+}
+
+TEST_F(ImproverTest, regst_at_max_register_num_is_kept) {
+  Plan naive_plan = MakeNaivePlan();
+  (*naive_plan.mutable_task(0)->mutable_produced_regst_desc())["out"].set_max_register_num(1);
+  const AvailableMemDesc amd = MakeAvailableMemDesc(8 * kMB);
+  const Plan cur_plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, naive_plan));
+  const Plan plan = *CHECK_JUST(
+      Improver().RetuneRegstNum(amd, naive_plan, cur_plan, MakeWriteStalledRegstStallList()));
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 1), 1);
+}
+
+TEST_F(ImproverInplaceTest, concat_sub_regst_is_placed_in_its_parent) {
+  const AvailableMemDesc amd = MakeGpuAvailableMemDesc();
+  const Plan plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, MakeConcatPlan(1)));
+  const RegstDescProto& sub = RegstDesc4RegstDescId(plan, 1);
+  const RegstDescProto& parent = RegstDesc4RegstDescId(plan, 2);
+  ASSERT_EQ(parent.inplace_sub_regst_desc_size(), 1);
+  ASSERT_EQ(parent.inplace_sub_regst_desc(0).regst_desc_id(), 1);
+  ASSERT_EQ(sub.mem_block_id(), parent.mem_block_id());
+  ASSERT_EQ(sub.mem_block_offset(), parent.mem_block_offset() + kSubByteOffset);
+}
+
+// register i of the sub regst would land inside register i - 1 of the parent
+TEST_F(ImproverInplaceTest, sub_regst_with_more_registers_is_not_inplaced) {
+  const AvailableMemDesc amd = MakeGpuAvailableMemDesc();
+  const Plan plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, MakeConcatPlan(2)));
+  const RegstDescProto& sub = RegstDesc4RegstDescId(plan, 1);
+  const RegstDescProto& parent = RegstDesc4RegstDescId(plan, 2);
+  ASSERT_EQ(parent.inplace_sub_regst_desc_size(), 0);
+  ASSERT_EQ(sub.register_num(), 2);
+  ASSERT_NE(sub.mem_block_id(), parent.mem_block_id());
+}
+
+TEST_F(ImproverInplaceTest, retune_keeps_inplaced_regsts_at_one_register) {
+  const AvailableMemDesc amd = MakeGpuAvailableMemDesc();
+  const Plan naive_plan = MakeConcatPlan(1);
+  const Plan cur_plan = *CHECK_JUST(Improver().GenAndInferMemBlockIdOnly(amd, naive_plan));
+  RegstStallList regst_stall_list;
+  FOR_RANGE(int64_t, regst_desc_id, 1, 4) {
+    RegstStall* stalled = regst_stall_list.add_regst_stall();
+    stalled->set_regst_desc_id(regst_desc_id);
+    stalled->set_writeable_wait_time(10);
+    stalled->set_readable_wait_time(0);
+  }
+  const Plan plan =
+      *CHECK_JUST(Improver().RetuneRegstNum(amd, naive_plan, cur_plan, regst_stall_list));
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 1), 1);
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 2), 1);
+  ASSERT_EQ(RegisterNum4RegstDescId(plan, 3), 2);
+  ASSERT_EQ(RegstDesc4RegstDescId(plan, 2).inplace_sub_regst_desc_size(), 1);
+}
+
+}  // namespace oneflow
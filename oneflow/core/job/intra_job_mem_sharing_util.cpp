@@ -199,7 +199,7 @@ void GenRegstAllocFreeTimeLineAndRegstMutualExclusions(
     std::vector<HashSet<RegstDescProto*>>* alloc_regsts_timeline,
     std::vector<HashSet<RegstDescProto*>>* free_regsts_timeline,
     HashMap<RegstDescProto*, HashSet<RegstDescProto*>>* regst2mutual_exclusion_regsts,
-    HashMap<RegstDescProto*, RegstDescProto*>* consumer2inplaced_regst) {
+    HashMap<RegstDescProto*, std::pair<RegstDescProto*, int64_t>>* consumer2inplaced_regst) {
   CHECK(alloc_regsts_timeline->empty() && free_regsts_timeline->empty());
   CHECK(regst2mutual_exclusion_regsts->empty());
   CHECK(consumer2inplaced_regst->empty());
@@ -225,46 +225,79 @@ void GenRegstAllocFreeTimeLineAndRegstMutualExclusions(
     return free_index;
   };
 
-  auto TryFindFirstInplacedRegstDesc = [&](RegstDescProto* consumer_regst) -> RegstDescProto* {
-    RegstDescProto* inplaced_regst = nullptr;
-    while (consumer_regst->has_hint_inplace_consumed_regst_desc_id()
-           && consumer_regst->hint_inplace_consumed_regst_desc_id() != -1) {
+  // a regst either shares the body of its inplace consumed regst, or is a sub regst placed at
+  // some byte offset inside the body of the regst produced by its consumer (see concat)
+  HashMap<RegstDescProto*, std::pair<RegstDescProto*, int64_t>> regst2inplaced_parent;
+  for (RegstDescProto* regst_desc : mem_reused_regsts) {
+    if (regst_desc->has_hint_inplace_consumed_regst_desc_id()
+        && regst_desc->hint_inplace_consumed_regst_desc_id() != -1) {
       RegstDescProto* hint_inplaced_regst =
-          regst_desc_id2regst_desc.at(consumer_regst->hint_inplace_consumed_regst_desc_id());
+          regst_desc_id2regst_desc.at(regst_desc->hint_inplace_consumed_regst_desc_id());
       if (mem_reused_regsts.find(hint_inplaced_regst) != mem_reused_regsts.end()) {
-        inplaced_regst = hint_inplaced_regst;
-        consumer_regst = hint_inplaced_regst;
-      } else {
-        break;
+        CHECK(regst2inplaced_parent.emplace(regst_desc, std::make_pair(hint_inplaced_regst, 0))
+                  .second);
       }
     }
+  }
+  for (RegstDescProto* regst_desc : mem_reused_regsts) {
+    for (const InplaceSubRegstDesc& sub : regst_desc->hint_inplace_sub_regst_desc()) {
+      RegstDescProto* sub_regst = regst_desc_id2regst_desc.at(sub.regst_desc_id());
+      if (mem_reused_regsts.find(sub_regst) == mem_reused_regsts.end()) { continue; }
+      regst2inplaced_parent.emplace(sub_regst, std::make_pair(regst_desc, sub.byte_offset()));
+    }
+  }
+
+  auto TryFindFirstInplacedRegstDesc = [&](RegstDescProto* consumer_regst,
+                                           int64_t* offset) -> RegstDescProto* {
+    RegstDescProto* inplaced_regst = nullptr;
+    *offset = 0;
+    auto it = regst2inplaced_parent.find(consumer_regst);
+    while (it != regst2inplaced_parent.end()) {
+      CHECK(it->second.first != consumer_regst);
+      inplaced_regst = it->second.first;
+      *offset += it->second.second;
+      it = regst2inplaced_parent.find(inplaced_regst);
+    }
     return inplaced_regst;
   };
 
+  HashMap<int64_t, int64_t> regst_desc_id2alloc_index;
   HashMap<int64_t, int64_t> regst_desc_id2free_index;
   for (RegstDescProto* regst_desc : mem_reused_regsts) {
-    RegstDescProto* inplaced_regst_desc = TryFindFirstInplacedRegstDesc(regst_desc);
+    int64_t offset = 0;
+    RegstDescProto* inplaced_regst_desc = TryFindFirstInplacedRegstDesc(regst_desc, &offset);
     if (inplaced_regst_desc != nullptr) {
-      CHECK(consumer2inplaced_regst->emplace(regst_desc, inplaced_regst_desc).second);
+      CHECK(consumer2inplaced_regst
+                ->emplace(regst_desc, std::make_pair(inplaced_regst_desc, offset))
+                .second);
       continue;
     }
 
-    CHECK(alloc_regsts_timeline->at(task_id2sorted_id.at(regst_desc->producer_task_id()))
-              .insert(regst_desc)
+    CHECK(regst_desc_id2alloc_index
+              .emplace(regst_desc->regst_desc_id(),
+                       task_id2sorted_id.at(regst_desc->producer_task_id()))
               .second);
     CHECK(regst_desc_id2free_index
               .emplace(regst_desc->regst_desc_id(), FindLastFreeIndexInSortedTasks(regst_desc))
               .second);
   }
-  // inplace extend regst free index
+  // inplace extend regst alloc and free index, sub regsts are produced before their parent
   for (auto pair : *consumer2inplaced_regst) {
     RegstDescProto* consumer_regst_desc = pair.first;
-    int64_t inplaced_regst_desc_id = pair.second->regst_desc_id();
+    int64_t inplaced_regst_desc_id = pair.second.first->regst_desc_id();
     CHECK(regst_desc_id2free_index.find(inplaced_regst_desc_id) != regst_desc_id2free_index.end());
+    regst_desc_id2alloc_index.at(inplaced_regst_desc_id) =
+        std::min(regst_desc_id2alloc_index.at(inplaced_regst_desc_id),
+                 task_id2sorted_id.at(consumer_regst_desc->producer_task_id()));
     regst_desc_id2free_index.at(inplaced_regst_desc_id) =
         std::max(regst_desc_id2free_index.at(inplaced_regst_desc_id),
                  FindLastFreeIndexInSortedTasks(consumer_regst_desc));
   }
+  for (const auto& pair : regst_desc_id2alloc_index) {
+    CHECK(alloc_regsts_timeline->at(pair.second)
+              .insert(regst_desc_id2regst_desc.at(pair.first))
+              .second);
+  }
   for (const auto& pair : regst_desc_id2free_index) {
     CHECK(free_regsts_timeline->at(pair.second)
               .insert(regst_desc_id2regst_desc.at(pair.first))
@@ -653,7 +686,8 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
   HashMap<int64_t, HashMap<RegstDescProto*, HashSet<RegstDescProto*>>>
       mem_chain2regst2mutual_exclusion_regsts;
   // info for inplace
-  HashMap<int64_t, HashMap<RegstDescProto*, RegstDescProto*>> mem_chain2consumer2inplaced_regst;
+  HashMap<int64_t, HashMap<RegstDescProto*, std::pair<RegstDescProto*, int64_t>>>
+      mem_chain2consumer2inplaced_regst;
 
   // step 1: generate regst alloc/free queue AND regst mutual exclusions
   for (const auto& pair : mem_chain2mem_reused_regsts) {
@@ -713,11 +747,12 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
     for (auto& consumer_inplace_pair : mem_chain2consumer2inplaced_regst.at(pair.first)) {
       RegstDescProto* consumer_regst_desc = consumer_inplace_pair.first;
       CHECK_EQ(consumer_regst_desc->mem_block_id(), -1);
-      RegstDescProto* inplaced_regst_desc = consumer_inplace_pair.second;
+      RegstDescProto* inplaced_regst_desc = consumer_inplace_pair.second.first;
       CHECK_EQ(inplaced_regst_desc->mem_block_id(), mem_block_id);
       CHECK_NE(inplaced_regst_desc->mem_block_offset(), -1);
       consumer_regst_desc->set_mem_block_id(inplaced_regst_desc->mem_block_id());
-      consumer_regst_desc->set_mem_block_offset(inplaced_regst_desc->mem_block_offset());
+      consumer_regst_desc->set_mem_block_offset(inplaced_regst_desc->mem_block_offset()
+                                                + consumer_inplace_pair.second.second);
     }
   }
 }
@@ -922,6 +922,7 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
     JUST(DoPass("SetDefaultVariableConf"));
     JUST(DoPass("AutoMixedPrecision"));
     JUST(DoPass("TieUpChainHeadersUnReachableFromAnyVariableOps"));
+    JUST(DoPass("PipelineMicroBatchPass"));
     JUST(DoPass("NonDistributedOptimizerPass"));
     JUST(DoPass("AutoTrainStep"));
     JUST(DoPass("AutoLearningRate"));
@@ -932,6 +933,11 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
     JUST(DoPass("DoParallelCastBeforeWideningTypeCast"));
     JUST(DoPass("AddLbiDiffWatcherOpConfs"));
     JUST(DoPass("PruneParallelCastOpsPass"));
+    JUST(DoPass("MultiTensorModelUpdatePass"));
+    JUST(DoPass("Int8CalibrationPass"));
+    JUST(DoPass("Int8QuantizationPass"));
+    JUST(DoPass("FuseMatmulBiasActPass"));
+    JUST(DoPass("FuseElementwisePass"));
     JUST(DoPass("DumpVariableInfoPass"));
   }
   JUST(DoPass("DumpTimeShapeAndBlobParallelConfPass"));
@@ -29,6 +29,8 @@ limitations under the License.
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/actor/regst_stall_recorder.h"
+#include "oneflow/core/framework/config_def.h"
 #include "oneflow/core/job/oneflow.h"
 #include "oneflow/core/job/model_io_v2_job.h"
 #include "oneflow/core/job/model_io_job.h"
@@ -56,6 +58,11 @@ struct hash<oneflow::ParallelBlobConf> {
 
 namespace oneflow {
 
+REGISTER_FUNCTION_CONFIG_DEF().Int64(
+    "regst_num_tuning_rounds", 0,
+    "after the experiment run, rerun the improved plan this many times and raise register_num of "
+    "the regsts actors stall on, ignored by jobs that update variables");
+
 bool operator==(const ParallelBlobConf& lhs, const ParallelBlobConf& rhs) {
   return BlobDesc(lhs.logical_blob_desc_conf()) == BlobDesc(rhs.logical_blob_desc_conf())
          && lhs.parallel_conf() == rhs.parallel_conf() && lhs.sbp_conf() == rhs.sbp_conf();
@@ -284,8 +291,64 @@ void GenCollectiveBoxingPlan(Job* job, Plan* plan) {
   }
 }
 
+// tuning reruns the real job, which must therefore leave every variable as it was
+bool IsRegstNumTunable(const Job& job) {
+  if (job.job_conf().has_train_conf()) { return false; }
+  for (const OperatorConf& op_conf : job.net().op()) {
+    if (op_conf.has_assign_conf()) { return false; }
+    if (op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == "assign") {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string regst_stall_list_key(int64_t round, int64_t machine_id) {
+  return "regst_stall_list_" + std::to_string(round) + "_" + std::to_string(machine_id);
+}
+
+// Runs plan on every machine with the stall recorder on and gathers the stalls on the master.
+void RunAndCollectRegstStall(const Plan& plan, int64_t round, RegstStallList* regst_stall_list) {
+  const std::string plan_name = "regst_num_tuning_plan_" + std::to_string(round);
+  Plan this_machine_plan;
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+    PushPlan(plan_name, plan);
+    this_machine_plan = plan;
+  } else {
+    PullPlan(plan_name, &this_machine_plan);
+  }
+  OF_BARRIER();
+  Global<RegstStallRecorder>::New();
+  { Runtime tuning_run(this_machine_plan, GlobalJobDesc().piece_num_of_experiment_phase(), true); }
+  RegstStallList this_machine_stall_list;
+  Global<RegstStallRecorder>::Get()->ToProto(&this_machine_stall_list);
+  Global<RegstStallRecorder>::Delete();
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  Global<CtrlClient>::Get()->PushKV(regst_stall_list_key(round, this_machine_id),
+                                    this_machine_stall_list);
+  OF_BARRIER();
+  if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+    regst_stall_list->Clear();
+    FOR_RANGE(int64_t, machine_id, 0, Global<ResourceDesc, ForSession>::Get()->TotalMachineNum()) {
+      RegstStallList machine_stall_list;
+      Global<CtrlClient>::Get()->PullKV(regst_stall_list_key(round, machine_id),
+                                        &machine_stall_list);
+      MergeRegstStallList(machine_stall_list, regst_stall_list);
+    }
+  }
+  OF_BARRIER();
+  Global<CtrlClient>::Get()->ClearKV(regst_stall_list_key(round, this_machine_id));
+}
+
 Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_complete) {
   const JobDesc& job_desc = GlobalJobDesc();
+  // decided before the master completes the job, so that all machines agree on the rounds
+  int64_t tuning_rounds = job_desc.Int64("regst_num_tuning_rounds");
+  if (tuning_rounds > 0 && !IsRegstNumTunable(*job)) {
+    LOG(WARNING) << "regst_num_tuning_rounds is ignored by job " << job_desc.job_name()
+                 << ", which updates variables";
+    tuning_rounds = 0;
+  }
   Plan naive_plan;
   Plan complete_plan;
   double start = GetCurTime();
@@ -319,6 +382,17 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
       OF_BARRIER();
       TeePersistentLogStream::Create("improved_plan")->Write(*improved_plan);
     }
+    // regst_num tuning rounds, only register_num and memory blocks are regenerated
+    FOR_RANGE(int64_t, round, 0, tuning_rounds) {
+      RegstStallList regst_stall_list;
+      RunAndCollectRegstStall(*improved_plan, round, &regst_stall_list);
+      if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+        TeePersistentLogStream::Create("regst_stall_list_" + std::to_string(round))
+            ->Write(regst_stall_list);
+        *improved_plan = *JUST(Improver().RetuneRegstNum(
+            *Global<AvailableMemDesc>::Get(), naive_plan, *improved_plan, regst_stall_list));
+      }
+    }
   } else {
     *improved_plan = complete_plan;
   }
@@ -725,6 +799,53 @@ bool NeedAllocateMemory(const RegstDescTypeProto& regst_desc_type) {
          && regst_desc_type.data_regst_desc().packed_blob_desc().is_body_disabled() == false;
 }
 
+// A job writes a mem block if it produces a regst in it, variables aside since their kernel does
+// nothing, or consumes a regst in it through a mutable input.
+std::vector<HashSet<int64_t>> MakeJobId2WrittenMemBlockIds(const Plan& plan, int64_t job_size) {
+  HashMap<int64_t, std::vector<int64_t>> regst_desc_id2mem_block_ids;
+  for (const auto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      auto* mem_block_ids = &regst_desc_id2mem_block_ids[pair.second.regst_desc_id()];
+      if (NeedAllocateMemory(pair.second.regst_desc_type())) {
+        mem_block_ids->push_back(pair.second.mem_block_id());
+      }
+      if (pair.second.has_separated_header_mem_block_id()
+          && pair.second.separated_header_mem_block_id() != -1) {
+        mem_block_ids->push_back(pair.second.separated_header_mem_block_id());
+      }
+    }
+  }
+  std::vector<HashSet<int64_t>> job_id2written_mem_block_ids(job_size);
+  for (const auto& task : plan.task()) {
+    HashSet<int64_t>* written = &job_id2written_mem_block_ids.at(task.job_id());
+    auto AddWrittenRegstDesc = [&](int64_t regst_desc_id) {
+      const auto& mem_block_ids = regst_desc_id2mem_block_ids.at(regst_desc_id);
+      written->insert(mem_block_ids.begin(), mem_block_ids.end());
+    };
+    const auto& exec_nodes = task.exec_sequence().exec_node();
+    const bool is_variable_task =
+        exec_nodes.size() == 1
+        && exec_nodes.Get(0).kernel_conf().op_attribute().op_conf().has_variable_conf();
+    if (!is_variable_task) {
+      for (const auto& pair : task.produced_regst_desc()) {
+        AddWrittenRegstDesc(pair.second.regst_desc_id());
+      }
+    }
+    for (const ExecNodeProto& exec_node : exec_nodes) {
+      const auto& ibn2modifier = exec_node.kernel_conf()
+                                     .op_attribute()
+                                     .arg_modifier_signature()
+                                     .ibn2input_blob_modifier();
+      for (const auto& pair : ibn2modifier) {
+        if (!pair.second.is_mutable()) { continue; }
+        const auto it = exec_node.bn_in_op2regst_desc_id().find(pair.first);
+        if (it != exec_node.bn_in_op2regst_desc_id().end()) { AddWrittenRegstDesc(it->second); }
+      }
+    }
+  }
+  return job_id2written_mem_block_ids;
+}
+
 void FinishGlobalCriticalSectionDesc(const Plan& plan, int64_t job_size) {
   std::vector<HashMap<std::string, HashSet<int64_t>>> job_id2sole_op_name2mem_block_ids(job_size);
   std::vector<HashSet<int64_t>> job_id2mem_block_ids(job_size);
@@ -757,6 +878,8 @@ void FinishGlobalCriticalSectionDesc(const Plan& plan, int64_t job_size) {
     for (int64_t job_id : chunk.job_id()) { job_id2chunk_ids.at(job_id).insert(chunk.chunk_id()); }
   }
 
+  const std::vector<HashSet<int64_t>> job_id2written_mem_block_ids =
+      MakeJobId2WrittenMemBlockIds(plan, job_size);
   HashMap<int64_t, HashSet<int64_t>> job_id2input_output_mem_block_ids;
   auto* critical_section_desc = Global<CriticalSectionDesc>::Get();
   // set mem_block_id for InputOutputCriticalSection
@@ -798,6 +921,12 @@ void FinishGlobalCriticalSectionDesc(const Plan& plan, int64_t job_size) {
         }
       }
       *critical_section->mutable_mem_block_id() = {mem_block_ids->begin(), mem_block_ids->end()};
+      // shared variables that only get read let jobs run side by side, see CriticalSectionDesc
+      for (int64_t mem_block_id : *mem_block_ids) {
+        if (job_id2written_mem_block_ids.at(job_id).count(mem_block_id) == 0) {
+          critical_section->add_read_only_mem_block_id(mem_block_id);
+        }
+      }
       *critical_section->mutable_chunk_id() = {job_id2chunk_ids.at(job_id).begin(),
                                                job_id2chunk_ids.at(job_id).end()};
     }
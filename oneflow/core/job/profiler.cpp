@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/job/profiler.h"
+#include "oneflow/core/job/critical_path_profile.h"
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/common/str_util.h"
@@ -108,6 +109,12 @@ void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath)
                << " bottleneck_score:" << std::to_string(pair.second.CalcBottleNeckScore())
                << " type:" << TaskType_Name(task_id2task_type.at(pair.first)) << "\n";
   }
+
+  CriticalPathProfile critical_path_profile;
+  AnalyzeCriticalPath(plan, act_events, &critical_path_profile);
+  TeePersistentLogStream::Create("oneflow.profile.critical_path")
+      ->Write(CriticalPathReport(plan, critical_path_profile));
+  TeePersistentLogStream::Create("critical_path_profile")->Write(critical_path_profile);
 }
 
 }  // namespace oneflow
@@ -50,4 +50,12 @@ CollectiveBoxingConf ResourceDesc::collective_boxing_conf() const {
   }
 }
 
+CpuAffinityConf ResourceDesc::cpu_affinity_conf() const {
+  if (resource_.has_cpu_affinity_conf()) {
+    return resource_.cpu_affinity_conf();
+  } else {
+    return CpuAffinityConf();
+  }
+}
+
 }  // namespace oneflow
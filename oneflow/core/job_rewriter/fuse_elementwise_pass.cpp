@@ -0,0 +1,273 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/user/ops/math_unary_elementwise_seq.h"
+#include "oneflow/user/ops/math_binary_elementwise_seq.h"
+#include "oneflow/user/ops/math_binary_broadcast_seq.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_fuse_elementwise", true,
+    "fold chains of cpu elementwise ops into one fused_elementwise op in predict jobs");
+
+namespace {
+
+#define OP_TYPE_NAME_SEQ_ELEM(op_type_name, func_prefix) op_type_name,
+
+// op types the fused_elementwise kernel has a step for, keyed by how they name their args
+const HashSet<std::string> kUnaryMathOpTypes = {
+    OF_PP_FOR_EACH_TUPLE(OP_TYPE_NAME_SEQ_ELEM, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)};
+const HashSet<std::string> kBinaryMathOpTypes = {
+    OF_PP_FOR_EACH_TUPLE(OP_TYPE_NAME_SEQ_ELEM, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)
+        OF_PP_FOR_EACH_TUPLE(OP_TYPE_NAME_SEQ_ELEM, MATH_BINARY_BROADCAST_FUNC_SEQ)};
+
+#undef OP_TYPE_NAME_SEQ_ELEM
+
+const std::string& OpTypeName4Node(const OpNode* node) {
+  return node->op().op_conf().user_conf().op_type_name();
+}
+
+const LogicalBlobId& OutLbi4Node(const OpNode* node) {
+  return node->op().BnInOp2Lbi(node->op().SoleObn());
+}
+
+bool IsScalarShape(const Shape& shape) { return shape.NumAxes() == 1 && shape.At(0) == 1; }
+
+// Inputs of an elementwise op in operand order, empty if the op can not be a chain step.
+std::vector<std::string> ElementwiseInputLbns(const OpNode* node) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (!op_conf.has_user_conf()) { return {}; }
+  const user_op::UserOpConfWrapper user_op_conf(op_conf);
+  const std::string& op_type_name = OpTypeName4Node(node);
+  if (kUnaryMathOpTypes.find(op_type_name) != kUnaryMathOpTypes.end()) {
+    return {user_op_conf.input("x", 0)};
+  } else if (kBinaryMathOpTypes.find(op_type_name) != kBinaryMathOpTypes.end()) {
+    return {user_op_conf.input("x", 0), user_op_conf.input("y", 0)};
+  } else if (op_type_name == "add_n" && user_op_conf.input_size("in") == 2) {
+    return {user_op_conf.input("in", 0), user_op_conf.input("in", 1)};
+  } else if (op_type_name == "relu" || op_type_name == "scalar_add"
+             || op_type_name == "scalar_mul" || op_type_name == "cast") {
+    return {user_op_conf.input("in", 0)};
+  } else {
+    return {};
+  }
+}
+
+// The constant of scalar_add/scalar_mul as the float the fused op stores, false if a double chain
+// would lose precision through it.
+bool GetScalarOperand(const OpNode* node, DataType data_type, float* scalar) {
+  const user_op::UserOpConfWrapper user_op_conf(node->op().op_conf());
+  double value = 0;
+  if (user_op_conf.attr<bool>("has_float_operand")) {
+    value = user_op_conf.attr<double>("float_operand");
+  } else if (user_op_conf.attr<bool>("has_int_operand")) {
+    value = static_cast<double>(user_op_conf.attr<int64_t>("int_operand"));
+  } else {
+    return false;
+  }
+  *scalar = static_cast<float>(value);
+  return data_type == DataType::kFloat || static_cast<double>(*scalar) == value;
+}
+
+bool IsFusibleCastDataType(DataType data_type) {
+  return data_type == DataType::kFloat || data_type == DataType::kDouble
+         || data_type == DataType::kInt8 || data_type == DataType::kInt32
+         || data_type == DataType::kInt64;
+}
+
+struct ElementwiseChain {
+  std::vector<const OpNode*> nodes;
+  // index into ElementwiseInputLbns of the chain value for every node but the head
+  std::vector<int32_t> chain_input_indices;
+};
+
+class FuseElementwisePass final : public OpGraphPass {
+ public:
+  FuseElementwisePass() = default;
+  ~FuseElementwisePass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsPredict() && GlobalJobDesc().Bool("enable_fuse_elementwise");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> FuseElementwisePass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  // cast only ends a chain, the other steps compute in the data type of the chain
+  auto IsFusible = [&](const OpNode* node) -> bool {
+    const std::vector<std::string> input_lbns = ElementwiseInputLbns(node);
+    if (input_lbns.empty()) { return false; }
+    if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+    if (!node->op().op_conf().ctrl_in_op_name().empty()) { return false; }
+    if (ctrl_in_op_names.find(node->op().op_name()) != ctrl_in_op_names.end()) { return false; }
+    const BlobDesc& out_desc = node->LogicalBlobDesc4Lbi(OutLbi4Node(node));
+    if (out_desc.is_dynamic()) { return false; }
+    const std::string& op_type_name = OpTypeName4Node(node);
+    const DataType data_type =
+        node->LogicalBlobDesc4Lbi(GenLogicalBlobId(input_lbns.at(0))).data_type();
+    if (data_type != DataType::kFloat && data_type != DataType::kDouble) { return false; }
+    if (op_type_name == "cast") { return IsFusibleCastDataType(out_desc.data_type()); }
+    if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+      float scalar = 0;
+      return GetScalarOperand(node, data_type, &scalar);
+    }
+    for (const std::string& lbn : input_lbns) {
+      const Shape& shape = node->LogicalBlobDesc4Lbi(GenLogicalBlobId(lbn)).shape();
+      if (shape != out_desc.shape() && !IsScalarShape(shape)) { return false; }
+    }
+    return true;
+  };
+  // producer links into consumer at input_index without boxing and without anyone else reading it
+  auto IsChainLink = [&](const OpNode* producer, const OpNode* consumer,
+                         int32_t input_index) -> bool {
+    if (OpTypeName4Node(producer) == "cast") { return false; }
+    if (producer->out_edges().size() != 1) { return false; }
+    if (producer->parallel_desc() != consumer->parallel_desc()) { return false; }
+    const LogicalBlobId& lbi = OutLbi4Node(producer);
+    const std::vector<std::string> input_lbns = ElementwiseInputLbns(consumer);
+    FOR_RANGE(int32_t, i, 0, input_lbns.size()) {
+      if ((GenLogicalBlobId(input_lbns.at(i)) == lbi) != (i == input_index)) { return false; }
+    }
+    const LogicalBlobId& consumer_out_lbi = OutLbi4Node(consumer);
+    return producer->LogicalBlobDesc4Lbi(lbi).shape()
+               == consumer->LogicalBlobDesc4Lbi(consumer_out_lbi).shape()
+           && producer->SbpParallel4Lbi(lbi) == consumer->SbpParallel4Lbi(lbi)
+           && producer->SbpParallel4Lbi(lbi) == consumer->SbpParallel4Lbi(consumer_out_lbi);
+  };
+
+  HashSet<const OpNode*> fusible_nodes;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (IsFusible(node)) { fusible_nodes.insert(node); }
+  });
+  HashMap<const OpNode*, std::pair<const OpNode*, int32_t>> node2next;
+  HashSet<const OpNode*> non_head_nodes;
+  for (const OpNode* node : fusible_nodes) {
+    // the first input that links to a chain step carries the chain, the others become operands
+    const std::vector<std::string> input_lbns = ElementwiseInputLbns(node);
+    FOR_RANGE(int32_t, i, 0, input_lbns.size()) {
+      const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(input_lbns.at(i)).op_name());
+      if (fusible_nodes.find(producer) != fusible_nodes.end() && IsChainLink(producer, node, i)) {
+        node2next.emplace(producer, std::make_pair(node, i));
+        non_head_nodes.insert(node);
+        break;
+      }
+    }
+  }
+  std::vector<ElementwiseChain> chains;
+  for (const auto& pair : node2next) {
+    if (non_head_nodes.find(pair.first) != non_head_nodes.end()) { continue; }
+    ElementwiseChain chain;
+    chain.nodes.push_back(pair.first);
+    for (auto it = node2next.find(pair.first); it != node2next.end();
+         it = node2next.find(it->second.first)) {
+      chain.nodes.push_back(it->second.first);
+      chain.chain_input_indices.push_back(it->second.second);
+    }
+    chains.push_back(chain);
+  }
+
+  // a chain may read the output of another one, so resolve lbns through the fused outputs
+  OpReplacer op_replacer;
+  for (const ElementwiseChain& chain : chains) {
+    const OpNode* tail = chain.nodes.back();
+    op_replacer.ReplaceOutput(tail, OutLbi4Node(tail),
+                              tail->op().op_name() + "-fused_elementwise/out_0");
+    for (const OpNode* node : chain.nodes) {
+      if (node != tail) { op_replacer.DelOp(node); }
+    }
+  }
+
+  for (const ElementwiseChain& chain : chains) {
+    const OpNode* head = chain.nodes.front();
+    const OpNode* tail = chain.nodes.back();
+    std::vector<std::string> fused_input_lbns;
+    HashMap<std::string, int32_t> lbn2input_index;
+    auto InputIndex4Lbn = [&](const std::string& lbn) -> int32_t {
+      const auto it = lbn2input_index.find(lbn);
+      if (it != lbn2input_index.end()) { return it->second; }
+      lbn2input_index.emplace(lbn, fused_input_lbns.size());
+      fused_input_lbns.push_back(lbn);
+      return fused_input_lbns.size() - 1;
+    };
+    std::vector<std::string> op_types;
+    std::vector<int32_t> operand_indices;
+    std::vector<int32_t> swap_operands;
+    std::vector<float> scalar_operands;
+    FOR_RANGE(size_t, step, 0, chain.nodes.size()) {
+      const OpNode* node = chain.nodes.at(step);
+      const std::string& op_type_name = OpTypeName4Node(node);
+      const std::vector<std::string> input_lbns = ElementwiseInputLbns(node);
+      int32_t chain_input_index = 0;
+      if (step == 0) {
+        // the head reads the first input that has the full shape
+        const Shape& out_shape = node->LogicalBlobDesc4Lbi(OutLbi4Node(node)).shape();
+        while (node->LogicalBlobDesc4Lbi(GenLogicalBlobId(input_lbns.at(chain_input_index)))
+                   .shape()
+               != out_shape) {
+          ++chain_input_index;
+        }
+        InputIndex4Lbn(op_replacer.NewLbn4Lbn(input_lbns.at(chain_input_index)));
+      } else {
+        chain_input_index = chain.chain_input_indices.at(step - 1);
+      }
+      if (op_type_name == "cast") { continue; }
+      float scalar = 0;
+      if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+        const DataType data_type = node->LogicalBlobDesc4Lbi(OutLbi4Node(node)).data_type();
+        CHECK_OR_RETURN(GetScalarOperand(node, data_type, &scalar));
+      }
+      op_types.push_back(op_type_name);
+      int32_t operand_index = -1;
+      if (input_lbns.size() == 2) {
+        const std::string& operand_lbn = input_lbns.at(1 - chain_input_index);
+        operand_index = InputIndex4Lbn(op_replacer.NewLbn4Lbn(operand_lbn));
+      }
+      operand_indices.push_back(operand_index);
+      swap_operands.push_back(chain_input_index == 1 ? 1 : 0);
+      scalar_operands.push_back(scalar);
+    }
+    user_op::UserOpConfWrapperBuilder fused_op_builder(tail->op().op_name() + "-fused_elementwise");
+    fused_op_builder.Op("fused_elementwise");
+    for (const std::string& lbn : fused_input_lbns) { fused_op_builder.Input("in", lbn); }
+    const auto fused_op =
+        fused_op_builder.Output("out")
+            .Attr<std::vector<std::string>>("op_types", op_types)
+            .Attr<std::vector<int32_t>>("operand_indices", operand_indices)
+            .Attr<std::vector<int32_t>>("swap_operands", swap_operands)
+            .Attr<std::vector<float>>("scalar_operands", scalar_operands)
+            .Attr<DataType>("out_data_type",
+                            tail->LogicalBlobDesc4Lbi(OutLbi4Node(tail)).data_type())
+            .Build();
+    job_builder->AddOps(head->parallel_desc().parallel_conf(), {fused_op.op_conf()});
+  }
+  op_replacer.Apply(job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("FuseElementwisePass", FuseElementwisePass);
+
+}  // namespace oneflow
@@ -0,0 +1,136 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_fuse_matmul_bias_act", true,
+    "fold cpu matmul -> bias_add [-> relu/gelu] chains into fused_matmul_bias_act in predict jobs");
+
+namespace {
+
+// Returns the consumer of the sole output of node if it is the only one and reads it via ibn.
+const OpNode* SoleConsumer4Ibn(const OpNode* node, const std::string& ibn) {
+  if (node->out_edges().size() != 1) { return nullptr; }
+  const OpNode* consumer = node->SoleOutEdge()->dst_node();
+  const LogicalBlobId& out_lbi = node->op().BnInOp2Lbi("out_0");
+  for (const std::string& consumer_ibn : consumer->op().input_bns()) {
+    const bool is_out_lbi = consumer->op().BnInOp2Lbi(consumer_ibn) == out_lbi;
+    if (is_out_lbi != (consumer_ibn == ibn)) { return nullptr; }
+  }
+  return consumer;
+}
+
+struct FusedChain {
+  const OpNode* matmul_node;
+  const OpNode* bias_add_node;
+  const OpNode* last_node;
+  std::string activation;
+};
+
+class FuseMatmulBiasActPass final : public OpGraphPass {
+ public:
+  FuseMatmulBiasActPass() = default;
+  ~FuseMatmulBiasActPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsPredict() && GlobalJobDesc().Bool("enable_fuse_matmul_bias_act");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> FuseMatmulBiasActPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  auto IsFusible = [&](const OpNode* node, const ParallelDesc& parallel_desc) -> bool {
+    return node->parallel_desc() == parallel_desc && node->op().op_conf().ctrl_in_op_name().empty()
+           && ctrl_in_op_names.find(node->op().op_name()) == ctrl_in_op_names.end();
+  };
+  std::vector<FusedChain> chains;
+  op_graph.ForEachNode([&](const OpNode* matmul_node) {
+    if (!IsUserOpWithType(matmul_node, "matmul")) { return; }
+    const ParallelDesc& parallel_desc = matmul_node->parallel_desc();
+    if (parallel_desc.device_type() != DeviceType::kCPU) { return; }
+    if (!IsFusible(matmul_node, parallel_desc)) { return; }
+    const DataType data_type =
+        matmul_node->LogicalBlobDesc4Lbi(matmul_node->op().BnInOp2Lbi("out_0")).data_type();
+    if (data_type != DataType::kFloat && data_type != DataType::kDouble) { return; }
+
+    const OpNode* bias_add_node = SoleConsumer4Ibn(matmul_node, "a_0");
+    if (bias_add_node == nullptr || !IsUserOpWithType(bias_add_node, "bias_add")) { return; }
+    if (!IsFusible(bias_add_node, parallel_desc)) { return; }
+    if (user_op::UserOpConfWrapper(bias_add_node->op().op_conf()).attr<int32_t>("axis") != 1) {
+      return;
+    }
+    FusedChain chain;
+    chain.matmul_node = matmul_node;
+    chain.bias_add_node = bias_add_node;
+    chain.last_node = bias_add_node;
+    chain.activation = "none";
+    const OpNode* act_node = SoleConsumer4Ibn(bias_add_node, "in_0");
+    if (act_node != nullptr && IsFusible(act_node, parallel_desc)) {
+      if (IsUserOpWithType(act_node, "relu")) {
+        chain.activation = "relu";
+      } else if (IsUserOpWithType(act_node, "gelu")) {
+        chain.activation = "gelu";
+      }
+      if (chain.activation != "none") { chain.last_node = act_node; }
+    }
+    chains.push_back(chain);
+  });
+
+  // a chain may consume the output of another one, so resolve lbns through the fused outputs
+  OpReplacer op_replacer;
+  for (const FusedChain& chain : chains) {
+    op_replacer.ReplaceOutput(chain.last_node, chain.last_node->op().BnInOp2Lbi("out_0"),
+                              chain.last_node->op().op_name() + "-fused_matmul_bias_act/out_0");
+    op_replacer.DelOp(chain.matmul_node);
+    op_replacer.DelOp(chain.bias_add_node);
+  }
+
+  for (const FusedChain& chain : chains) {
+    const user_op::UserOpConfWrapper matmul_op(chain.matmul_node->op().op_conf());
+    const user_op::UserOpConfWrapper bias_add_op(chain.bias_add_node->op().op_conf());
+    const auto fused_op =
+        user_op::UserOpConfWrapperBuilder(chain.last_node->op().op_name()
+                                          + "-fused_matmul_bias_act")
+            .Op("fused_matmul_bias_act")
+            .Input("a", op_replacer.NewLbn4Lbn(matmul_op.input("a", 0)))
+            .Input("b", op_replacer.NewLbn4Lbn(matmul_op.input("b", 0)))
+            .Input("bias", op_replacer.NewLbn4Lbn(bias_add_op.input("b", 0)))
+            .Output("out")
+            .Attr<bool>("transpose_a", matmul_op.attr<bool>("transpose_a"))
+            .Attr<bool>("transpose_b", matmul_op.attr<bool>("transpose_b"))
+            .Attr<std::string>("activation", chain.activation)
+            .Build();
+    job_builder->AddOps(chain.matmul_node->parallel_desc().parallel_conf(), {fused_op.op_conf()});
+  }
+  op_replacer.Apply(job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("FuseMatmulBiasActPass", FuseMatmulBiasActPass);
+
+}  // namespace oneflow
@@ -0,0 +1,242 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/user/kernels/quantization_util.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF()
+    .String("int8_calibration_dir", "",
+            "directory of activation ranges used to run cpu matmul/conv2d in int8 in predict jobs")
+    .Bool("int8_calibration", false,
+          "record activation ranges into int8_calibration_dir instead of quantizing");
+
+namespace {
+
+// True if the input is read straight from a variable, the only weights quantize_weight expects.
+bool IsVariableInput(const OpNode* node, const std::string& arg_name) {
+  return node->SrcNode4Ibn(GenRepeatedBn(arg_name, 0)).op().op_conf().has_variable_conf();
+}
+
+// Only 2-D matmul on the left operand and channels_first conv2d without groups are supported, and
+// the weight, b of matmul or weight of conv2d, has to be a variable.
+bool IsInt8QuantizableOp(const OpNode* node) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (!op_conf.ctrl_in_op_name().empty()) { return false; }
+  const LogicalBlobId& out_lbi = node->op().BnInOp2Lbi("out_0");
+  if (node->LogicalBlobDesc4Lbi(out_lbi).data_type() != DataType::kFloat) { return false; }
+  const user_op::UserOpConfWrapper user_op_conf(op_conf);
+  if (IsUserOpWithType(node, "matmul")) {
+    return node->LogicalBlobDesc4Lbi(out_lbi).shape().NumAxes() == 2
+           && !user_op_conf.attr<bool>("transpose_a") && IsVariableInput(node, "b");
+  } else if (IsUserOpWithType(node, "conv2d")) {
+    return user_op_conf.attr<std::string>("data_format") == "channels_first"
+           && user_op_conf.attr<int32_t>("groups") == 1 && IsVariableInput(node, "weight");
+  } else {
+    return false;
+  }
+}
+
+std::string DataInputArgName(const OpNode* node) {
+  return IsUserOpWithType(node, "matmul") ? "a" : "in";
+}
+
+std::string CalibrationFilePath(const std::string& dir, const std::string& lbn) {
+  std::string file_name;
+  for (const char c : lbn) {
+    if (c == '/') {
+      file_name += "__";
+    } else {
+      file_name.push_back(c);
+    }
+  }
+  return JoinPath(dir, file_name);
+}
+
+bool ReadOneCalibrationRange(const std::string& path, float* min, float* max) {
+  PersistentInStream in_stream(LocalFS(), path);
+  std::string line;
+  if (in_stream.ReadLine(&line) != 0) { return false; }
+  std::istringstream line_stream(line);
+  return static_cast<bool>(line_stream >> *min >> *max);
+}
+
+// Reads the per tensor range written by min_max_observer, false if missing or degenerate. An
+// observer with more than one rank writes path-0, path-1, ..., whose ranges are merged.
+bool ReadCalibrationRange(const std::string& path, float* min, float* max) {
+  if (LocalFS()->FileExists(path)) {
+    if (!ReadOneCalibrationRange(path, min, max)) { return false; }
+  } else {
+    bool has_range = false;
+    for (int64_t i = 0; LocalFS()->FileExists(path + "-" + std::to_string(i)); ++i) {
+      float rank_min = 0;
+      float rank_max = 0;
+      if (!ReadOneCalibrationRange(path + "-" + std::to_string(i), &rank_min, &rank_max)) {
+        continue;
+      }
+      *min = has_range ? std::min(*min, rank_min) : rank_min;
+      *max = has_range ? std::max(*max, rank_max) : rank_max;
+      has_range = true;
+    }
+    if (!has_range) { return false; }
+  }
+  return *max > *min;
+}
+
+class Int8CalibrationPass final : public OpGraphPass {
+ public:
+  Int8CalibrationPass() = default;
+  ~Int8CalibrationPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsPredict() && !GlobalJobDesc().String("int8_calibration_dir").empty()
+           && GlobalJobDesc().Bool("int8_calibration");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> Int8CalibrationPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  const std::string& dir = GlobalJobDesc().String("int8_calibration_dir");
+  HashSet<std::string> observed_lbns;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!IsInt8QuantizableOp(node)) { return; }
+    const std::string lbn =
+        user_op::UserOpConfWrapper(node->op().op_conf()).input(DataInputArgName(node), 0);
+    if (!observed_lbns.insert(lbn).second) { return; }
+    const auto observer_op =
+        user_op::UserOpConfWrapperBuilder(node->op().op_name() + "-min_max_observer")
+            .Op("min_max_observer")
+            .Input("in", lbn)
+            .Attr<std::string>("output_path", CalibrationFilePath(dir, lbn))
+            .Build();
+    // observe where the blob is produced so no boxing to a single device is needed
+    ParallelConf parallel_conf =
+        op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name())->parallel_desc().parallel_conf();
+    parallel_conf.set_device_tag("cpu");
+    job_builder->AddOps(parallel_conf, {observer_op.op_conf()});
+  });
+  return Maybe<void>::Ok();
+}
+
+class Int8QuantizationPass final : public OpGraphPass {
+ public:
+  Int8QuantizationPass() = default;
+  ~Int8QuantizationPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsPredict() && !GlobalJobDesc().String("int8_calibration_dir").empty()
+           && !GlobalJobDesc().Bool("int8_calibration");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> Int8QuantizationPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  const std::string& dir = GlobalJobDesc().String("int8_calibration_dir");
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  std::vector<std::pair<const OpNode*, QuantizationParam>> node7params;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!IsInt8QuantizableOp(node)) { return; }
+    if (ctrl_in_op_names.find(node->op().op_name()) != ctrl_in_op_names.end()) { return; }
+    const std::string data_lbn =
+        user_op::UserOpConfWrapper(node->op().op_conf()).input(DataInputArgName(node), 0);
+    float min = 0;
+    float max = 0;
+    if (!ReadCalibrationRange(CalibrationFilePath(dir, data_lbn), &min, &max)) { return; }
+    node7params.emplace_back(node, ChooseUint8QuantizationParam(min, max));
+  });
+
+  // a quantized op may consume the output of another one, so resolve lbns through the new outputs
+  OpReplacer op_replacer;
+  for (const auto& pair : node7params) {
+    op_replacer.ReplaceOutput(pair.first, pair.first->op().BnInOp2Lbi("out_0"),
+                              pair.first->op().op_name() + "-int8/out_0");
+  }
+
+  for (const auto& pair : node7params) {
+    const OpNode* node = pair.first;
+    const QuantizationParam& param = pair.second;
+    const std::string& op_name = node->op().op_name();
+    const user_op::UserOpConfWrapper op_conf(node->op().op_conf());
+    const bool is_matmul = IsUserOpWithType(node, "matmul");
+    const auto quantize_op =
+        user_op::UserOpConfWrapperBuilder(op_name + "-quantize")
+            .Op("quantize")
+            .Input("in", op_replacer.NewLbn4Lbn(op_conf.input(DataInputArgName(node), 0)))
+            .Output("out")
+            .Attr<float>("scale", param.scale)
+            .Attr<int32_t>("zero_point", param.zero_point)
+            .Build();
+    const bool transpose_b = is_matmul && op_conf.attr<bool>("transpose_b");
+    const auto quantize_weight_op =
+        user_op::UserOpConfWrapperBuilder(op_name + "-quantize_weight")
+            .Op("quantize_weight")
+            .Input("in", op_replacer.NewLbn4Lbn(op_conf.input(is_matmul ? "b" : "weight", 0)))
+            .Output("out")
+            .Output("scale")
+            .Attr<int32_t>("axis", is_matmul && !transpose_b ? 1 : 0)
+            .Build();
+    user_op::UserOpConfWrapperBuilder int8_op_builder(op_name + "-int8");
+    if (is_matmul) {
+      int8_op_builder.Op("quantized_matmul")
+          .Input("a", quantize_op.output("out", 0))
+          .Input("b", quantize_weight_op.output("out", 0))
+          .Input("b_scale", quantize_weight_op.output("scale", 0))
+          .Attr<bool>("transpose_b", transpose_b)
+          .Attr<float>("a_scale", param.scale)
+          .Attr<int32_t>("a_zero_point", param.zero_point);
+    } else {
+      int8_op_builder.Op("quantized_conv2d")
+          .Input("in", quantize_op.output("out", 0))
+          .Input("weight", quantize_weight_op.output("out", 0))
+          .Input("weight_scale", quantize_weight_op.output("scale", 0))
+          .Attr<int32_t>("filters", op_conf.attr<int32_t>("filters"))
+          .Attr<std::vector<int32_t>>("padding_before",
+                                      op_conf.attr<std::vector<int32_t>>("padding_before"))
+          .Attr<std::vector<int32_t>>("kernel_size",
+                                      op_conf.attr<std::vector<int32_t>>("kernel_size"))
+          .Attr<std::vector<int32_t>>("strides", op_conf.attr<std::vector<int32_t>>("strides"))
+          .Attr<std::vector<int32_t>>("dilation_rate",
+                                      op_conf.attr<std::vector<int32_t>>("dilation_rate"))
+          .Attr<float>("in_scale", param.scale)
+          .Attr<int32_t>("in_zero_point", param.zero_point);
+      if (op_conf.has_input("bias", 0)) {
+        int8_op_builder.Input("bias", op_replacer.NewLbn4Lbn(op_conf.input("bias", 0)));
+      }
+    }
+    const auto int8_op = int8_op_builder.Output("out").Build();
+    job_builder->AddOps(node->parallel_desc().parallel_conf(),
+                        {quantize_op.op_conf(), quantize_weight_op.op_conf(), int8_op.op_conf()});
+  }
+  op_replacer.Apply(job_builder);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("Int8CalibrationPass", Int8CalibrationPass);
+REGISTER_FUNCTION_PASS("Int8QuantizationPass", Int8QuantizationPass);
+
+}  // namespace oneflow
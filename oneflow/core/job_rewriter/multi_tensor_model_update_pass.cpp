@@ -0,0 +1,156 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF().Bool(
+    "enable_multi_tensor_model_update", false,
+    "update all cpu variables of one placement and data type with a single optimizer op");
+
+namespace {
+
+std::string MultiTensorOptimizer4OpConf(const OperatorConf& op_conf) {
+  switch (op_conf.op_type_case()) {
+    case OperatorConf::kNaiveModelUpdateConf: return "naive";
+    case OperatorConf::kMomentumModelUpdateConf: return "momentum";
+    case OperatorConf::kRmspropModelUpdateConf: return "rmsprop";
+    case OperatorConf::kLarsModelUpdateConf: return "lars";
+    case OperatorConf::kAdamModelUpdateConf: return "adam";
+    default: return "";
+  }
+}
+
+const NormalModelUpdateOpUserConf& UserConf4ModelUpdateOpConf(const OperatorConf& op_conf) {
+  return *GetMsgPtrFromPbMessage<NormalModelUpdateOpUserConf>(
+      GetMessageInPbMessage(op_conf, op_conf.op_type_case()), "user_conf");
+}
+
+std::string Lbn4BnInOp(const OpNode* node, const std::string& bn_in_op) {
+  return GenLogicalBlobName(node->op().BnInOp2Lbi(bn_in_op));
+}
+
+bool IsMultiTensorUpdatableOp(const OpNode* node) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (MultiTensorOptimizer4OpConf(op_conf).empty()) { return false; }
+  if (!op_conf.ctrl_in_op_name().empty()) { return false; }
+  // the fused op updates every tensor in full on each rank
+  return node->parallel_desc().parallel_num() == 1
+         || node->SbpParallel4BnInOp("model").has_broadcast_parallel();
+}
+
+// Ops in one group share everything but the tensors they update and their weight decay.
+std::string GroupKey4Node(const OpNode* node) {
+  const DataType data_type = node->LogicalBlobDesc4Lbi(node->op().BnInOp2Lbi("model")).data_type();
+  return node->parallel_desc().parallel_conf().SerializeAsString() + "|"
+         + UserConf4ModelUpdateOpConf(node->op().op_conf()).SerializeAsString() + "|"
+         + std::to_string(data_type) + "|" + Lbn4BnInOp(node, "learning_rate") + "|"
+         + Lbn4BnInOp(node, "train_step");
+}
+
+class MultiTensorModelUpdatePass final : public OpGraphPass {
+ public:
+  MultiTensorModelUpdatePass() = default;
+  ~MultiTensorModelUpdatePass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsTrain() && GlobalJobDesc().Bool("enable_multi_tensor_model_update");
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+Maybe<void> MultiTensorModelUpdatePass::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  // keep groups in topological order so that the generated job is deterministic
+  std::vector<std::string> group_keys;
+  HashMap<std::string, std::vector<const OpNode*>> group_key2nodes;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    if (!IsMultiTensorUpdatableOp(node)) { return; }
+    if (ctrl_in_op_names.find(node->op().op_name()) != ctrl_in_op_names.end()) { return; }
+    const std::string group_key = GroupKey4Node(node);
+    auto& nodes = group_key2nodes[group_key];
+    if (nodes.empty()) { group_keys.push_back(group_key); }
+    nodes.push_back(node);
+  });
+
+  std::vector<std::string> del_op_names;
+  for (const std::string& group_key : group_keys) {
+    const std::vector<const OpNode*>& nodes = group_key2nodes.at(group_key);
+    if (nodes.size() < 2) { continue; }
+    const OpNode* first_node = nodes.front();
+    const OperatorConf& first_op_conf = first_node->op().op_conf();
+    const std::string optimizer = MultiTensorOptimizer4OpConf(first_op_conf);
+    const NormalModelUpdateOpUserConf& user_conf = UserConf4ModelUpdateOpConf(first_op_conf);
+    user_op::UserOpConfWrapperBuilder builder("System-Optimizer-MultiTensor-"
+                                              + first_node->op().op_name());
+    builder.Op("multi_tensor_model_update")
+        .Input("learning_rate", Lbn4BnInOp(first_node, "learning_rate"))
+        .Input("train_step", Lbn4BnInOp(first_node, "train_step"))
+        .Attr<std::string>("optimizer", optimizer);
+    std::vector<std::string> state_bns;
+    if (optimizer == "momentum") {
+      builder.Attr<float>("beta", user_conf.momentum_conf().beta());
+      state_bns = {"momentum"};
+    } else if (optimizer == "rmsprop") {
+      builder.Attr<float>("decay_rate", user_conf.rmsprop_conf().decay_rate())
+          .Attr<float>("epsilon", user_conf.rmsprop_conf().epsilon());
+    } else if (optimizer == "lars") {
+      builder.Attr<float>("beta", user_conf.lars_conf().momentum_beta())
+          .Attr<float>("epsilon", user_conf.lars_conf().epsilon())
+          .Attr<float>("lars_coefficient", user_conf.lars_conf().lars_coefficient());
+      state_bns = {"momentum"};
+    } else if (optimizer == "adam") {
+      const AdamModelUpdateConf& adam_conf = user_conf.adam_conf();
+      builder.Attr<float>("beta1", adam_conf.beta1())
+          .Attr<float>("beta2", adam_conf.beta2())
+          .Attr<float>("epsilon", adam_conf.epsilon())
+          .Attr<bool>("do_bias_correction", adam_conf.do_bias_correction());
+      state_bns = {"m", "v"};
+      if (adam_conf.do_bias_correction()) {
+        state_bns.push_back("beta1_t");
+        state_bns.push_back("beta2_t");
+      }
+    }
+    std::vector<float> weight_decay;
+    for (const OpNode* node : nodes) {
+      builder.Input("model", Lbn4BnInOp(node, "model"))
+          .Input("model_diff", Lbn4BnInOp(node, "model_diff"));
+      for (const std::string& bn : state_bns) { builder.Input(bn, Lbn4BnInOp(node, bn)); }
+      weight_decay.push_back(
+          GetValFromPbMessage<float>(node->op().GetCustomizedConf(), "weight_decay"));
+      del_op_names.push_back(node->op().op_name());
+    }
+    builder.Attr<std::vector<float>>("weight_decay", weight_decay);
+    const auto multi_tensor_op = builder.Build();
+    job_builder->AddOps(first_node->parallel_desc().parallel_conf(), {multi_tensor_op.op_conf()});
+  }
+  job_builder->DelOps(del_op_names);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("MultiTensorModelUpdatePass", MultiTensorModelUpdatePass);
+
+}  // namespace oneflow
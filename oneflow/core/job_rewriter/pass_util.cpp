@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/pass_util.h"
+
+namespace oneflow {
+
+bool IsUserOpWithType(const OpNode* node, const std::string& op_type_name) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+void OpReplacer::ReplaceOutput(const OpNode* node, const LogicalBlobId& lbi,
+                               const std::string& new_lbn) {
+  CHECK(old_lbn2new_lbn_.emplace(GenLogicalBlobName(lbi), new_lbn).second);
+  replaced_outputs_.emplace_back(node, lbi);
+  DelOp(node);
+}
+
+void OpReplacer::DelOp(const OpNode* node) { del_op_names_.insert(node->op().op_name()); }
+
+std::string OpReplacer::NewLbn4Lbn(const std::string& lbn) const {
+  const auto it = old_lbn2new_lbn_.find(lbn);
+  return it == old_lbn2new_lbn_.end() ? lbn : it->second;
+}
+
+void OpReplacer::Apply(JobBuilder* job_builder) const {
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  for (const auto& pair : replaced_outputs_) {
+    const LogicalBlobId& lbi = pair.second;
+    const std::string old_lbn = GenLogicalBlobName(lbi);
+    const std::string& new_lbn = old_lbn2new_lbn_.at(old_lbn);
+    for (const OpEdge* out_edge : pair.first->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      const std::string& consumer_op_name = consumer->op().op_name();
+      if (del_op_names_.find(consumer_op_name) != del_op_names_.end()) { continue; }
+      if (op_name2op_conf.find(consumer_op_name) == op_name2op_conf.end()) {
+        op_name2op_conf[consumer_op_name] = consumer->op().op_conf();
+      }
+      OperatorConf& consumer_op_conf = op_name2op_conf.at(consumer_op_name);
+      PbMessage* conf =
+          MutableMessageInPbMessage(&consumer_op_conf, consumer_op_conf.op_type_case());
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (consumer->op().BnInOp2Lbi(ibn) == lbi) {
+          ReplaceInputLbnInOpCustomizedConf(conf, ibn, old_lbn, new_lbn);
+        }
+      }
+    }
+  }
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  job_builder->DelOps(std::vector<std::string>(del_op_names_.begin(), del_op_names_.end()));
+}
+
+}  // namespace oneflow
@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_PASS_UTIL_H_
+#define ONEFLOW_CORE_JOB_REWRITER_PASS_UTIL_H_
+
+#include "oneflow/core/graph/op_graph.h"
+#include "oneflow/core/job/job_builder.h"
+
+namespace oneflow {
+
+bool IsUserOpWithType(const OpNode* node, const std::string& op_type_name);
+
+// For passes that replace ops by new ones, e.g. fused or quantized ops. Lbns of replaced outputs
+// resolve to the new ones, so that new ops may read each other, and Apply rewires the remaining
+// consumers and deletes the replaced ops.
+class OpReplacer final {
+ public:
+  OpReplacer() = default;
+  ~OpReplacer() = default;
+
+  // node gets deleted and its output lbi is read from new_lbn instead
+  void ReplaceOutput(const OpNode* node, const LogicalBlobId& lbi, const std::string& new_lbn);
+  // node gets deleted, its outputs may only be read by other deleted ops
+  void DelOp(const OpNode* node);
+  std::string NewLbn4Lbn(const std::string& lbn) const;
+  void Apply(JobBuilder* job_builder) const;
+
+ private:
+  std::vector<std::pair<const OpNode*, LogicalBlobId>> replaced_outputs_;
+  HashMap<std::string, std::string> old_lbn2new_lbn_;
+  HashSet<std::string> del_op_names_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_PASS_UTIL_H_
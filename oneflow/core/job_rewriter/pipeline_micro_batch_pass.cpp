@@ -0,0 +1,146 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/config_def.h"
+
+namespace oneflow {
+
+REGISTER_FUNCTION_CONFIG_DEF().Int64(
+    "pipeline_num_micro_batches", 1,
+    "split every batch into micro batches that flow through the placements (stages) of a training "
+    "job in 1F1B order, gradients are accumulated over the micro batches and fetched model blobs "
+    "are packed back along axis 0");
+
+namespace {
+
+class PipelineMicroBatchPass final : public OpGraphPass {
+ public:
+  PipelineMicroBatchPass() = default;
+  ~PipelineMicroBatchPass() override = default;
+  bool IsEnabled() const override {
+    return GlobalJobDesc().IsTrain() && GlobalJobDesc().Int64("pipeline_num_micro_batches") > 1;
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const override;
+};
+
+// Batches are unpacked where the data pipeline (ops not reachable from any variable) hands blobs
+// over to the model. Variables and the data blobs that can not be split along a batch axis 0, e.g.
+// constants, are repeated for every micro batch instead. The repeat grad is an acc, so the
+// optimizer still runs once per batch on the accumulated gradients. Fetched model blobs are packed
+// back to the batch rate: blobs with batch axis 0 come back as the full batch, others as the
+// concatenation along axis 0 of their micro batch values, e.g. a (1,) loss becomes (M,).
+Maybe<void> PipelineMicroBatchPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  const int64_t micro_batch_num = GlobalJobDesc().Int64("pipeline_num_micro_batches");
+  HashSet<const OpNode*> reachable_from_variable;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    bool reachable = node->op().op_conf().has_variable_conf();
+    for (const OpEdge* edge : node->in_edges()) {
+      reachable = reachable || reachable_from_variable.count(edge->src_node()) > 0;
+    }
+    if (reachable) { reachable_from_variable.insert(node); }
+  });
+
+  HashMap<LogicalBlobId, std::string> lbi2new_lbn;
+  int64_t unpack_op_cnt = 0;
+  int64_t repeat_op_cnt = 0;
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* node) -> Maybe<void> {
+    const bool is_variable = node->op().op_conf().has_variable_conf();
+    if (!is_variable && reachable_from_variable.count(node) > 0) { return Maybe<void>::Ok(); }
+    for (const OpEdge* edge : node->out_edges()) {
+      const OpNode* consumer = edge->dst_node();
+      if (reachable_from_variable.count(consumer) == 0) { continue; }
+      // a fetched variable stays at the batch rate
+      if (consumer->op().op_conf().has_return_conf()) { continue; }
+      for (const LogicalBlobId& lbi : edge->lbis()) {
+        if (lbi2new_lbn.find(lbi) == lbi2new_lbn.end()) {
+          OperatorConf op_conf;
+          const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(lbi);
+          const OptInt64* batch_axis = JUST(node->BatchAxis4Lbi(lbi));
+          const bool is_splittable = !is_variable && batch_axis->has_value()
+                                     && batch_axis->value() == 0
+                                     && IsPODDataType(blob_desc.data_type());
+          if (is_splittable) {
+            CHECK_EQ_OR_RETURN(blob_desc.shape().At(0) % micro_batch_num, 0)
+                << GenLogicalBlobName(lbi) << " with batch size " << blob_desc.shape().At(0)
+                << " can not be split into " << micro_batch_num << " micro batches";
+            op_conf.set_name("System-Pipeline-Unpack-" + lbi.op_name() + "-" + lbi.blob_name());
+            UnpackOpConf* unpack_conf = op_conf.mutable_unpack_conf();
+            unpack_conf->set_in(GenLogicalBlobName(lbi));
+            unpack_conf->set_out("out");
+            unpack_conf->set_unpack_num(micro_batch_num);
+            unpack_op_cnt += 1;
+          } else {
+            op_conf.set_name("System-Pipeline-Repeat-" + lbi.op_name() + "-" + lbi.blob_name());
+            RepeatOpConf* repeat_conf = op_conf.mutable_repeat_conf();
+            repeat_conf->set_in(GenLogicalBlobName(lbi));
+            repeat_conf->set_out("out");
+            repeat_conf->set_repeat_num(micro_batch_num);
+            repeat_op_cnt += 1;
+          }
+          op_conf.set_scope_symbol_id(node->op().op_conf().scope_symbol_id());
+          job_builder->AddOps(node->parallel_desc().parallel_conf(), {op_conf});
+          lbi2new_lbn.emplace(lbi, op_conf.name() + "/out");
+        }
+        const std::string& consumer_op_name = consumer->op().op_name();
+        if (op_name2op_conf.find(consumer_op_name) == op_name2op_conf.end()) {
+          op_name2op_conf[consumer_op_name] = consumer->op().op_conf();
+        }
+        OperatorConf& consumer_op_conf = op_name2op_conf.at(consumer_op_name);
+        PbMessage* conf =
+            MutableMessageInPbMessage(&consumer_op_conf, consumer_op_conf.op_type_case());
+        for (const std::string& ibn : consumer->op().input_bns()) {
+          if (consumer->op().BnInOp2Lbi(ibn) == lbi) {
+            ReplaceInputLbnInOpCustomizedConf(conf, ibn, GenLogicalBlobName(lbi),
+                                              lbi2new_lbn.at(lbi));
+          }
+        }
+      }
+    }
+    return Maybe<void>::Ok();
+  }));
+  int64_t pack_op_cnt = 0;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!node->op().op_conf().has_return_conf()) { return; }
+    if (reachable_from_variable.count(node) == 0) { return; }
+    const LogicalBlobId& lbi = node->op().BnInOp2Lbi("in");
+    if (op_graph.OpNode4OpName(lbi.op_name())->op().op_conf().has_variable_conf()) { return; }
+    OperatorConf pack_op_conf;
+    pack_op_conf.set_name("System-Pipeline-Pack-" + lbi.op_name() + "-" + lbi.blob_name());
+    PackOpConf* pack_conf = pack_op_conf.mutable_pack_conf();
+    pack_conf->set_in(GenLogicalBlobName(lbi));
+    pack_conf->set_out("out");
+    pack_conf->set_pack_num(micro_batch_num);
+    pack_op_conf.set_scope_symbol_id(node->op().op_conf().scope_symbol_id());
+    job_builder->AddOps(node->parallel_desc().parallel_conf(), {pack_op_conf});
+    OperatorConf return_op_conf = node->op().op_conf();
+    return_op_conf.mutable_return_conf()->set_in(pack_op_conf.name() + "/out");
+    op_name2op_conf[node->op().op_name()] = return_op_conf;
+    pack_op_cnt += 1;
+  });
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  LOG(INFO) << "pipeline: " << micro_batch_num << " micro batches, " << unpack_op_cnt
+            << " unpacked blobs, " << repeat_op_cnt << " repeated blobs, " << pack_op_cnt
+            << " packed fetches";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("PipelineMicroBatchPass", PipelineMicroBatchPass);
+
+}  // namespace oneflow
@@ -23,19 +23,6 @@ const AdamModelUpdateConf& GetAdamModelUpdateConf(const OperatorConf& op_conf) {
   return op_conf.adam_model_update_conf().user_conf().adam_conf();
 };
 
-template<typename T>
-void UpdateMomentEstimate(int64_t n, bool do_bias_correction, T beta, int32_t p,
-                          const T* model_diff, const T* beta_t, T* moment) {
-  FOR_RANGE(int64_t, i, 0, n) {
-    // Update biased moment estimate
-    moment[i] = beta * moment[i] + (1 - beta) * std::pow(model_diff[i], p);
-    if (do_bias_correction) {
-      // Correct deviation of moment estimate
-      moment[i] = moment[i] / (1 - *beta_t);
-    }
-  }
-}
-
 }  // namespace
 
 template<DeviceType device_type, typename T>
@@ -74,12 +61,16 @@ class AdamMdUpdateKernelUtil<DeviceType::kCPU, T> final {
                           T beta1, T beta2, T epsilon, bool do_bias_correction,
                           const int64_t* train_step, const T* beta1_t, const T* beta2_t,
                           const T* model_diff, T* model, T* m, T* v) {
-    // first-order moment
-    UpdateMomentEstimate<T>(n, do_bias_correction, beta1, 1, model_diff, beta1_t, m);
-    // second-order moment
-    UpdateMomentEstimate<T>(n, do_bias_correction, beta2, 2, model_diff, beta2_t, v);
+    // the moments are corrected in place, dividing by 1 keeps them as is
+    const T m_denom = do_bias_correction ? 1 - *beta1_t : 1;
+    const T v_denom = do_bias_correction ? 1 - *beta2_t : 1;
     FOR_RANGE(int64_t, i, 0, n) {
-      const T mdv = m[i] / (std::sqrt(v[i]) + epsilon);
+      const T model_diff_val = model_diff[i];
+      const T m_val = (beta1 * m[i] + (1 - beta1) * model_diff_val) / m_denom;
+      const T v_val = (beta2 * v[i] + (1 - beta2) * model_diff_val * model_diff_val) / v_denom;
+      m[i] = m_val;
+      v[i] = v_val;
+      const T mdv = m_val / (std::sqrt(v_val) + epsilon);
       model[i] = model[i] - *learning_rate * (mdv + weight_decay * model[i]);
     }
   }
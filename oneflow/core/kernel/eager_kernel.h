@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/framework/op_kernel_infer_cache.h"
 
 namespace oneflow {
 
@@ -40,6 +41,7 @@ class EagerKernel final : public Kernel {
     UNIMPLEMENTED();
   }
   std::unique_ptr<const user_op::OpKernel> kernel_;
+  std::unique_ptr<user_op::OpKernelInferCache> infer_cache_;
 };
 
 }  // namespace oneflow
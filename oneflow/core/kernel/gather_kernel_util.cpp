@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/gather_kernel_util.h"
+#include "oneflow/core/kernel/util/host_gather_scatter.h"
 
 namespace oneflow {
 
@@ -73,22 +74,8 @@ void GatherKernelUtilImpl<DeviceType::kCPU, T, K>::Forward(DeviceCtx* ctx, const
                                                            int64_t num_indices, const T* in,
                                                            const Shape& flat_in_shape, T* out,
                                                            const int64_t offset) {
-  const int64_t outer_dim_size = flat_in_shape.At(0);
-  const int64_t gather_dim_size = flat_in_shape.At(1);
-  const int64_t inner_dim_size = flat_in_shape.At(2);
-  FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
-    FOR_RANGE(int64_t, i, 0, num_indices) {
-      CHECK_GE(indices[i], 0);
-      const int64_t idx = indices[i] - offset;
-      T* to = out + outer_idx * num_indices * inner_dim_size + i * inner_dim_size;
-      if (idx >= 0 && idx < gather_dim_size) {
-        const T* from = in + outer_idx * gather_dim_size * inner_dim_size + idx * inner_dim_size;
-        std::copy(from, from + inner_dim_size, to);
-      } else {
-        std::memset(to, 0, inner_dim_size * sizeof(K));
-      }
-    }
-  }
+  HostGather<T, K>(indices, num_indices, in, flat_in_shape.At(0), flat_in_shape.At(1),
+                   flat_in_shape.At(2), offset, out);
 }
 
 #define INITIATE_GATHER_KERNEL_UTIL_CPU_IMPL(in_type_pair, index_type_pair)              \
@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/register/register_manager.h"
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/kernel/util/host_transpose.h"
+#include "oneflow/core/kernel/philox_random.h"
 #include "oneflow/core/memory/memory_case.pb.h"
 
 namespace oneflow {
@@ -28,9 +30,7 @@ void RngUniform(const int64_t elem_cnt, const T min, const T max, uint32_t rando
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_LE(min, max);
-  std::mt19937 generator(random_seed);
-  std::uniform_real_distribution<T> random_distribution(min, std::nextafter(max, GetMaxVal<T>()));
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(generator); }
+  PhiloxParallelFill(random_seed, 0, elem_cnt, PhiloxUniformDistribution<T>(min, max), dptr);
 }
 
 template<typename T>
@@ -39,9 +39,7 @@ void RngIntUniform(const int64_t elem_cnt, const T min, const T max, uint32_t ra
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_LE(min, max);
-  std::mt19937 generator(random_seed);
-  std::uniform_int_distribution<T> random_distribution(min, std::nextafter(max, GetMaxVal<T>()));
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(generator); }
+  PhiloxParallelFill(random_seed, 0, elem_cnt, PhiloxUniformIntDistribution<T>(min, max), dptr);
 }
 
 template<typename T>
@@ -49,10 +47,7 @@ void RngNormal(const int64_t elem_cnt, const T mean, const T std, uint32_t rando
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_GT(std, 0.0);
-  std::mt19937 generator(random_seed);
-  std::normal_distribution<T> random_distribution(mean, std);
-
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(generator); }
+  PhiloxParallelFill(random_seed, 0, elem_cnt, PhiloxNormalDistribution<T>(mean, std), dptr);
 }
 
 template<typename T>
@@ -62,16 +57,26 @@ void RngTruncatedNormal(const int64_t elem_cnt, const T mean, const T std, uint3
   CHECK(dptr);
   CHECK_GT(std, 0.0);
   T truncated_value = 2 * std;
-  std::mt19937 generator(random_seed);
-  std::normal_distribution<T> random_distribution(mean, std);
-  int64_t index = 0;
-  while (true) {
-    T val = random_distribution(generator);
-    if (std::abs(val - mean) < truncated_value) {
-      dptr[index++] = val;
-      if (index >= elem_cnt) { break; }
+  const PhiloxNormalDistribution<T> dist(mean, std);
+  const int64_t n = PhiloxNormalDistribution<T>::kResultElementCount;
+  // the rejection loop of output block b draws from its own subsequence b, so the number of
+  // rejections in one block never shifts the values of another
+  PhiloxParallelFor(elem_cnt, n, [&](int64_t begin, int64_t end) {
+    for (int64_t block_begin = begin; block_begin < end; block_begin += n) {
+      PhiloxRandom gen(random_seed, block_begin / n, 0);
+      const int64_t block_end = std::min(block_begin + n, end);
+      int64_t index = block_begin;
+      while (index < block_end) {
+        const typename PhiloxNormalDistribution<T>::ResultType result = dist(&gen);
+        FOR_RANGE(int64_t, j, 0, n) {
+          if (std::abs(result[j] - mean) < truncated_value) {
+            dptr[index++] = result[j];
+            if (index >= block_end) { break; }
+          }
+        }
+      }
     }
-  }
+  });
 }
 
 template<typename T>
@@ -222,29 +227,6 @@ void IntSequenceInitializer(const IntRangeInitializerConf& initializer_conf, uin
   RangeInitializer<T, IntRangeInitializerConf>(initializer_conf, random_seed, blob);
 }
 
-void ComputeOffset(const int32_t num_axes, const int64_t* shape, const int32_t* permutation,
-                   DimVector& offset) {
-  offset.resize(num_axes);
-  DimVector buff(num_axes);
-  int64_t cur_offset = 1;
-  for (int32_t i = num_axes - 1; i >= 0; --i) {
-    buff[i] = cur_offset;
-    cur_offset *= shape[i];
-  }
-  for (int32_t i = 0; i < num_axes; ++i) { offset[permutation[i]] = buff[i]; }
-}
-
-void IncreaseIndex(const int64_t* shape, DimVector& index) {
-  for (int32_t i = index.size() - 1; i >= 0; --i) {
-    ++index[i];
-    if (index[i] >= shape[i]) {
-      index[i] -= shape[i];
-    } else {
-      break;
-    }
-  }
-}
-
 template<typename T, T (*reduce_core_func)(const T, const T)>
 void MatrixRowReduce(const int64_t row_num, const int64_t col_num, const T* x, T* y) {
   FOR_RANGE(int64_t, i, 0, row_num) {
@@ -328,31 +310,7 @@ KU_IF_METHOD RowSum(DeviceCtx* ctx, const int64_t row_num, const int64_t col_num
 KU_IF_METHOD Transpose(DeviceCtx* ctx, const int32_t num_axis, const ShapeView& x_shape,
                        const ShapeView& y_shape, const PbRf<int32_t>& permutation,
                        const int64_t elem_cnt, const T* x, T* y) {
-  int64_t block_size = 1;
-  int32_t shared_idxs_num = 0;
-  for (int32_t i = num_axis - 1; i >= 0 && permutation[i] == i; --i) {
-    block_size *= y_shape.At(i);
-    ++shared_idxs_num;
-  }
-  if (num_axis < 2 || shared_idxs_num == num_axis) {
-    memcpy(y, x, elem_cnt * sizeof(T));
-    return;
-  }
-  int32_t trans_axis = num_axis - shared_idxs_num;
-  DimVector x_to_y_offset;
-  ComputeOffset(trans_axis, y_shape.ptr(), permutation.data(), x_to_y_offset);
-  DimVector x_index_digits(trans_axis, 0);
-  int64_t num_blocks = elem_cnt / block_size;
-  FOR_RANGE(int64_t, x_idx, 0, num_blocks) {
-    int64_t y_idx = std::inner_product(x_to_y_offset.cbegin(), x_to_y_offset.cend(),
-                                       x_index_digits.cbegin(), 0);
-    if (block_size == 1) {
-      y[y_idx] = x[x_idx];
-    } else {
-      memcpy(y + block_size * y_idx, x + block_size * x_idx, block_size * sizeof(T));
-    }
-    IncreaseIndex(x_shape.ptr(), x_index_digits);
-  }
+  HostTranspose<T>(num_axis, x_shape.ptr(), permutation.data(), x, y);
 }
 KU_IF_METHOD Set(DeviceCtx* ctx, const T value, T* addr) { *addr = value; }
 KU_IF_METHOD Replicate(DeviceCtx* ctx, const int64_t n, T* y, const T* x) {
@@ -0,0 +1,282 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
+#define ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as
+// 1, 2, 3", SC 2011). The output of block `offset` in stream `subsequence` is a pure function of
+// (seed, subsequence, offset), so any thread can jump to any position in O(1).
+class PhiloxRandom final {
+ public:
+  static const int kResultElementCount = 4;
+  using ResultType = std::array<uint32_t, kResultElementCount>;
+
+  PhiloxRandom(uint64_t seed, uint64_t subsequence, uint64_t offset) {
+    key_[0] = static_cast<uint32_t>(seed);
+    key_[1] = static_cast<uint32_t>(seed >> 32);
+    counter_[0] = static_cast<uint32_t>(offset);
+    counter_[1] = static_cast<uint32_t>(offset >> 32);
+    counter_[2] = static_cast<uint32_t>(subsequence);
+    counter_[3] = static_cast<uint32_t>(subsequence >> 32);
+  }
+  ~PhiloxRandom() = default;
+
+  void Skip(uint64_t count) {
+    const uint64_t offset = (static_cast<uint64_t>(counter_[1]) << 32 | counter_[0]) + count;
+    counter_[0] = static_cast<uint32_t>(offset);
+    counter_[1] = static_cast<uint32_t>(offset >> 32);
+  }
+
+  ResultType operator()() {
+    ResultType counter = counter_;
+    std::array<uint32_t, 2> key = key_;
+    FOR_RANGE(int, round, 0, kRoundNum) {
+      if (round > 0) {
+        key[0] += kPhiloxW32A;
+        key[1] += kPhiloxW32B;
+      }
+      counter = ComputeSingleRound(counter, key);
+    }
+    Skip(1);
+    return counter;
+  }
+
+ private:
+  static const int kRoundNum = 10;
+  static const uint32_t kPhiloxW32A = 0x9E3779B9;
+  static const uint32_t kPhiloxW32B = 0xBB67AE85;
+  static const uint32_t kPhiloxM4x32A = 0xD2511F53;
+  static const uint32_t kPhiloxM4x32B = 0xCD9E8D57;
+
+  static void MultiplyHighLow(uint32_t a, uint32_t b, uint32_t* result_low, uint32_t* result_high) {
+    const uint64_t product = static_cast<uint64_t>(a) * b;
+    *result_low = static_cast<uint32_t>(product);
+    *result_high = static_cast<uint32_t>(product >> 32);
+  }
+
+  static ResultType ComputeSingleRound(const ResultType& counter,
+                                       const std::array<uint32_t, 2>& key) {
+    uint32_t lo0 = 0;
+    uint32_t hi0 = 0;
+    MultiplyHighLow(kPhiloxM4x32A, counter[0], &lo0, &hi0);
+    uint32_t lo1 = 0;
+    uint32_t hi1 = 0;
+    MultiplyHighLow(kPhiloxM4x32B, counter[2], &lo1, &hi1);
+    ResultType result;
+    result[0] = hi1 ^ counter[1] ^ key[0];
+    result[1] = lo1;
+    result[2] = hi0 ^ counter[3] ^ key[1];
+    result[3] = lo0;
+    return result;
+  }
+
+  ResultType counter_;
+  std::array<uint32_t, 2> key_;
+};
+
+// Maps 23 random bits to a float uniformly distributed in [0, 1).
+inline float Uint32ToFloat(uint32_t x) {
+  const uint32_t val = (127u << 23) | (x & 0x7fffffu);
+  float f = 0;
+  std::memcpy(&f, &val, sizeof(val));
+  return f - 1.0f;
+}
+
+// Maps 52 random bits to a double uniformly distributed in [0, 1).
+inline double Uint64ToDouble(uint32_t x0, uint32_t x1) {
+  const uint64_t mhi = static_cast<uint64_t>(x0 & 0xfffffu) << 32;
+  const uint64_t val = (1023ull << 52) | mhi | x1;
+  double d = 0;
+  std::memcpy(&d, &val, sizeof(val));
+  return d - 1.0;
+}
+
+template<typename T>
+class PhiloxUniformDistribution;
+
+template<>
+class PhiloxUniformDistribution<float> final {
+ public:
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount;
+  using ResultType = std::array<float, kResultElementCount>;
+
+  PhiloxUniformDistribution(float min, float max) : min_(min), range_(max - min) {}
+
+  ResultType operator()(PhiloxRandom* gen) const {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    ResultType result;
+    FOR_RANGE(int, i, 0, kResultElementCount) {
+      result[i] = min_ + Uint32ToFloat(sample[i]) * range_;
+    }
+    return result;
+  }
+
+ private:
+  float min_;
+  float range_;
+};
+
+template<>
+class PhiloxUniformDistribution<double> final {
+ public:
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount / 2;
+  using ResultType = std::array<double, kResultElementCount>;
+
+  PhiloxUniformDistribution(double min, double max) : min_(min), range_(max - min) {}
+
+  ResultType operator()(PhiloxRandom* gen) const {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    ResultType result;
+    FOR_RANGE(int, i, 0, kResultElementCount) {
+      result[i] = min_ + Uint64ToDouble(sample[2 * i], sample[2 * i + 1]) * range_;
+    }
+    return result;
+  }
+
+ private:
+  double min_;
+  double range_;
+};
+
+// Integers uniformly distributed in [min, max], one 64-bit draw per value.
+template<typename T>
+class PhiloxUniformIntDistribution final {
+ public:
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount / 2;
+  using ResultType = std::array<T, kResultElementCount>;
+
+  PhiloxUniformIntDistribution(T min, T max)
+      : min_(min), range_(static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1) {}
+
+  ResultType operator()(PhiloxRandom* gen) const {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    ResultType result;
+    FOR_RANGE(int, i, 0, kResultElementCount) {
+      const uint64_t bits = static_cast<uint64_t>(sample[2 * i]) << 32 | sample[2 * i + 1];
+      // range_ wraps to 0 only when [min, max] covers all 2^64 values
+      const uint64_t delta = range_ == 0 ? bits : bits % range_;
+      result[i] = static_cast<T>(static_cast<uint64_t>(min_) + delta);
+    }
+    return result;
+  }
+
+ private:
+  T min_;
+  uint64_t range_;
+};
+
+// Box-Muller transform, two normal samples per pair of uniform samples.
+template<typename T>
+class PhiloxNormalDistribution;
+
+template<>
+class PhiloxNormalDistribution<float> final {
+ public:
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount;
+  using ResultType = std::array<float, kResultElementCount>;
+
+  PhiloxNormalDistribution(float mean, float std) : mean_(mean), std_(std) {}
+
+  ResultType operator()(PhiloxRandom* gen) const {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    ResultType result;
+    FOR_RANGE(int, i, 0, kResultElementCount / 2) {
+      const float u1 = std::max(Uint32ToFloat(sample[2 * i]), 1.0e-7f);
+      const float v1 = 2.0f * static_cast<float>(M_PI) * Uint32ToFloat(sample[2 * i + 1]);
+      const float radius = std::sqrt(-2.0f * std::log(u1));
+      result[2 * i] = mean_ + std_ * radius * std::sin(v1);
+      result[2 * i + 1] = mean_ + std_ * radius * std::cos(v1);
+    }
+    return result;
+  }
+
+ private:
+  float mean_;
+  float std_;
+};
+
+template<>
+class PhiloxNormalDistribution<double> final {
+ public:
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount / 2;
+  using ResultType = std::array<double, kResultElementCount>;
+
+  PhiloxNormalDistribution(double mean, double std) : mean_(mean), std_(std) {}
+
+  ResultType operator()(PhiloxRandom* gen) const {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    const double u1 = std::max(Uint64ToDouble(sample[0], sample[1]), 1.0e-7);
+    const double v1 = 2.0 * M_PI * Uint64ToDouble(sample[2], sample[3]);
+    const double radius = std::sqrt(-2.0 * std::log(u1));
+    ResultType result;
+    result[0] = mean_ + std_ * radius * std::sin(v1);
+    result[1] = mean_ + std_ * radius * std::cos(v1);
+    return result;
+  }
+
+ private:
+  double mean_;
+  double std_;
+};
+
+const int64_t kPhiloxParallelChunkSize = 16384;
+
+inline int64_t PhiloxBlockNum(int64_t elem_cnt, int64_t elems_per_block) {
+  return RoundUp(elem_cnt, elems_per_block) / elems_per_block;
+}
+
+// Splits [0, elem_cnt) into chunks whose begin is a multiple of elems_per_block and calls
+// Handler(begin, end) for each of them, on the compute thread pool when it is available.
+// Element i is meant to be drawn from block i / elems_per_block, so the result does not depend
+// on the number of threads.
+template<typename Handler>
+void PhiloxParallelFor(int64_t elem_cnt, int64_t elems_per_block, const Handler& handler) {
+  if (elem_cnt <= 0) { return; }
+  const int64_t chunk_size = RoundUp(kPhiloxParallelChunkSize, elems_per_block);
+  const int64_t chunk_num = PhiloxBlockNum(elem_cnt, chunk_size);
+  auto ChunkHandler = [&](size_t chunk_id) {
+    const int64_t begin = chunk_id * chunk_size;
+    handler(begin, std::min(begin + chunk_size, elem_cnt));
+  };
+  MaybeMultiThreadLoop(chunk_num, ChunkHandler);
+}
+
+// Fills dptr[0, elem_cnt) with dist, consuming blocks [block_offset, block_offset +
+// PhiloxBlockNum(elem_cnt, Distribution::kResultElementCount)) of stream (seed, 0).
+template<typename Distribution, typename T>
+void PhiloxParallelFill(uint64_t seed, uint64_t block_offset, int64_t elem_cnt,
+                        const Distribution& dist, T* dptr) {
+  const int64_t n = Distribution::kResultElementCount;
+  PhiloxParallelFor(elem_cnt, n, [&](int64_t begin, int64_t end) {
+    PhiloxRandom gen(seed, 0, block_offset + begin / n);
+    for (int64_t i = begin; i < end; i += n) {
+      const typename Distribution::ResultType result = dist(&gen);
+      FOR_RANGE(int64_t, j, 0, std::min(n, end - i)) { dptr[i + j] = result[j]; }
+    }
+  });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
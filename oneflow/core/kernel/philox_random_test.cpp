@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/philox_random.h"
+
+namespace oneflow {
+
+TEST(PhiloxRandom, known_answer) {
+  PhiloxRandom zero_gen(0, 0, 0);
+  const PhiloxRandom::ResultType zero_result = zero_gen();
+  ASSERT_EQ(zero_result[0], 0x6627e8d5u);
+  ASSERT_EQ(zero_result[1], 0xe169c58du);
+  ASSERT_EQ(zero_result[2], 0xbc57ac4cu);
+  ASSERT_EQ(zero_result[3], 0x9b00dbd8u);
+  PhiloxRandom max_gen(~0ull, ~0ull, ~0ull);
+  const PhiloxRandom::ResultType max_result = max_gen();
+  ASSERT_EQ(max_result[0], 0x408f276du);
+  ASSERT_EQ(max_result[1], 0x41c83b0eu);
+  ASSERT_EQ(max_result[2], 0xa20bc7c6u);
+  ASSERT_EQ(max_result[3], 0x6d5451fdu);
+}
+
+TEST(PhiloxRandom, skip) {
+  PhiloxRandom seq_gen(2020, 3, 0);
+  FOR_RANGE(int, i, 0, 7) { seq_gen(); }
+  PhiloxRandom skip_gen(2020, 3, 0);
+  skip_gen.Skip(7);
+  ASSERT_TRUE(seq_gen() == skip_gen());
+  ASSERT_TRUE(seq_gen() == PhiloxRandom(2020, 3, 8)());
+}
+
+TEST(PhiloxRandom, fill_is_position_independent) {
+  const int64_t elem_cnt = 3 * kPhiloxParallelChunkSize + 5;
+  const int64_t n = PhiloxUniformDistribution<float>::kResultElementCount;
+  const PhiloxUniformDistribution<float> dist(-1, 1);
+  std::vector<float> whole(elem_cnt);
+  PhiloxParallelFill(7, 0, elem_cnt, dist, whole.data());
+  std::vector<float> tail(elem_cnt - 2 * n);
+  PhiloxParallelFill(7, 2, tail.size(), dist, tail.data());
+  FOR_RANGE(int64_t, i, 0, tail.size()) {
+    ASSERT_EQ(whole.at(i + 2 * n), tail.at(i));
+    ASSERT_GE(tail.at(i), -1);
+    ASSERT_LT(tail.at(i), 1);
+  }
+}
+
+TEST(PhiloxRandom, uniform_int_range) {
+  std::vector<int8_t> values(1000);
+  PhiloxParallelFill(7, 0, values.size(), PhiloxUniformIntDistribution<int8_t>(-3, 4),
+                     values.data());
+  ASSERT_EQ(*std::min_element(values.begin(), values.end()), -3);
+  ASSERT_EQ(*std::max_element(values.begin(), values.end()), 4);
+}
+
+}  // namespace oneflow
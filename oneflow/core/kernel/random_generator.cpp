@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/random_generator.h"
+#include "oneflow/core/kernel/philox_random.h"
 #include "oneflow/core/common/preprocessor.h"
 
 namespace oneflow {
@@ -29,8 +30,29 @@ void RandomGenerator<DeviceType::kCPU>::Uniform(const int64_t elem_cnt, const T
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_LE(min, max);
-  std::uniform_real_distribution<T> random_distribution(min, std::nextafter(max, GetMaxVal<T>()));
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(mt19937_generator_); }
+  const PhiloxUniformDistribution<T> dist(min, max);
+  PhiloxParallelFill(seed_, offset_, elem_cnt, dist, dptr);
+  offset_ += PhiloxBlockNum(elem_cnt, PhiloxUniformDistribution<T>::kResultElementCount);
+}
+
+template<typename T, typename K>
+void RandomGenerator<DeviceType::kCPU>::Bernoulli(const int64_t elem_cnt, const T* prob, K* dptr) {
+  CHECK_GE(elem_cnt, 0);
+  const int64_t n = PhiloxRandom::kResultElementCount;
+  const uint64_t seed = seed_;
+  const uint64_t offset = offset_;
+  PhiloxParallelFor(elem_cnt, n, [&](int64_t begin, int64_t end) {
+    PhiloxRandom gen(seed, 0, offset + begin / n);
+    for (int64_t i = begin; i < end; i += n) {
+      const PhiloxRandom::ResultType sample = gen();
+      FOR_RANGE(int64_t, j, 0, std::min(n, end - i)) {
+        const T p = prob[i + j];
+        CHECK(p >= 0 && p <= 1);
+        dptr[i + j] = Uint32ToFloat(sample[j]) < p ? GetOneVal<K>() : GetZeroVal<K>();
+      }
+    }
+  });
+  offset_ += PhiloxBlockNum(elem_cnt, n);
 }
 
 #define INITIATE_CPU_RANDOM_GENERATOR_UNIFORM(T, typeproto)                                        \
@@ -40,4 +62,13 @@ void RandomGenerator<DeviceType::kCPU>::Uniform(const int64_t elem_cnt, const T
 
 OF_PP_FOR_EACH_TUPLE(INITIATE_CPU_RANDOM_GENERATOR_UNIFORM, FLOATING_DATA_TYPE_SEQ);
 
+#define INITIATE_CPU_RANDOM_GENERATOR_BERNOULLI(in_dtype_pair, out_dtype_pair)                  \
+  template void RandomGenerator<DeviceType::kCPU>::Bernoulli<OF_PP_PAIR_FIRST(in_dtype_pair),   \
+                                                             OF_PP_PAIR_FIRST(out_dtype_pair)>( \
+      const int64_t elem_cnt, const OF_PP_PAIR_FIRST(in_dtype_pair) * prob,                     \
+      OF_PP_PAIR_FIRST(out_dtype_pair) * dptr);
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(INITIATE_CPU_RANDOM_GENERATOR_BERNOULLI, FLOATING_DATA_TYPE_SEQ,
+                                 ARITHMETIC_DATA_TYPE_SEQ);
+
 }  // namespace oneflow
@@ -31,16 +31,20 @@ template<>
 class RandomGenerator<DeviceType::kCPU> final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(RandomGenerator);
-  RandomGenerator(int64_t seed, DeviceCtx* device_ctx) : mt19937_generator_(seed) {}
+  RandomGenerator(int64_t seed, DeviceCtx* device_ctx) : seed_(seed), offset_(0) {}
   ~RandomGenerator() {}
 
   template<typename T>
   void Uniform(const int64_t elem_cnt, T* dptr);
   template<typename T>
   void Uniform(const int64_t elem_cnt, const T min, const T max, T* dptr);
+  template<typename T, typename K>
+  void Bernoulli(const int64_t elem_cnt, const T* prob, K* dptr);
 
  private:
-  std::mt19937 mt19937_generator_;
+  uint64_t seed_;
+  // Philox stream position, counted in blocks of 128 random bits
+  uint64_t offset_;
 };
 
 template<>
@@ -387,6 +387,19 @@ class UserKernelRegContext final : public user_op::KernelRegContext {
   UserKernelBaseContext base_ctx_;
 };
 
+namespace {
+
+void SetOutputShapes(const OpInferCacheValue& cache_value, user_op::KernelInferContext* ctx) {
+  FOR_RANGE(int, i, 0, ctx->outputs().size()) {
+    const auto& out_arg_pair = ctx->outputs().at(i);
+    MutShapeView* mut_shape_view =
+        ctx->MutShapeView4ArgNameAndIndex(out_arg_pair.first, out_arg_pair.second);
+    mut_shape_view->set_shape(*cache_value.obn_idx2shape_sym.at(i));
+  }
+}
+
+}  // namespace
+
 class UserKernel final : public Kernel {
  public:
   OF_DISALLOW_COPY_AND_MOVE(UserKernel);
@@ -433,7 +446,8 @@ class UserKernel final : public Kernel {
                     std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
     infer_ctx_->UpdateArg2Tensor(BnInOp2Blob);
     infer_cache_->UpdateCacheKey(infer_ctx_.get());
-    if (!infer_cache_->IsCacheHit()) {
+    const std::shared_ptr<const OpInferCacheValue> cache_value_ptr = infer_cache_->GetCacheValue();
+    if (!cache_value_ptr) {
       UserKernelOpInferContext* op_infer_ctx =
           dynamic_cast<UserKernelOpInferContext*>(infer_ctx_->MutOpInferContext());
       CHECK_NOTNULL(op_infer_ctx);
@@ -454,13 +468,7 @@ class UserKernel final : public Kernel {
       }
       infer_cache_->UpdateCacheValue(infer_ctx_.get());
     } else {
-      std::shared_ptr<const OpInferCacheValue> cache_value_ptr = infer_cache_->GetCacheValue();
-      FOR_RANGE(int, i, 0, infer_ctx_->outputs().size()) {
-        const auto& out_arg_pair = infer_ctx_->outputs().at(i);
-        MutShapeView* mut_shape_view =
-            infer_ctx_->MutShapeView4ArgNameAndIndex(out_arg_pair.first, out_arg_pair.second);
-        mut_shape_view->set_shape(*cache_value_ptr->obn_idx2shape_sym.at(i));
-      }
+      SetOutputShapes(*cache_value_ptr, infer_ctx_.get());
     }
   }
 
@@ -480,6 +488,7 @@ NEW_REGISTER_KERNEL(OperatorConf::kUserConf, UserKernel).SetIsMatchedPred([](con
 EagerKernel::EagerKernel(const JobDesc* job_desc, const KernelConf& kernel_conf) {
   InitBase(job_desc, kernel_conf);
   InitOpKernel(kernel_conf);
+  infer_cache_.reset(new user_op::OpKernelInferCache(kernel_conf, *job_desc));
 }
 
 void EagerKernel::InitOpKernel(const KernelConf& kernel_conf) {
@@ -494,9 +503,17 @@ void EagerKernel::Infer(std::function<Blob*(const std::string&)> BnInOp2Blob) co
   if (!kernel_conf().need_do_shape()) { return; }
   UserKernelInferContext infer_ctx(nullptr, kernel_conf(), job_desc());
   infer_ctx.UpdateArg2Tensor(BnInOp2Blob);
+  // eager kernels are rebuilt for every call, the cache behind infer_cache_ is shared among them
+  infer_cache_->UpdateCacheKey(&infer_ctx);
+  const std::shared_ptr<const OpInferCacheValue> cache_value_ptr = infer_cache_->GetCacheValue();
+  if (cache_value_ptr) {
+    SetOutputShapes(*cache_value_ptr, &infer_ctx);
+    return;
+  }
   auto* op_infer_ctx = dynamic_cast<UserKernelOpInferContext*>(infer_ctx.MutOpInferContext());
   if (op_infer_ctx) { op_infer_ctx->UpdateArg2TensorDesc(BnInOp2Blob); }
   kernel_->InferShape(&infer_ctx);
+  infer_cache_->UpdateCacheValue(&infer_ctx);
 }
 
 std::shared_ptr<user_op::OpKernelState> EagerKernel::EagerForward(
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_blas_interface.h"
 #include "oneflow/core/register/blob.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -60,10 +61,12 @@ void BatchedGemmImpl(DeviceCtx* ctx, const enum CBLAS_ORDER order,
   const int a_stride = m * k;
   const int b_stride = k * n;
   const int c_stride = m * n;
-  FOR_RANGE(int32_t, i, 0, batch_size) {
+  auto GemmOneBatch = [&](size_t i) {
     BlasIf<DeviceType::kCPU>::OFGemm(ctx, trans_a, trans_b, m, n, k, alpha, a + i * a_stride,
                                      b + i * b_stride, beta, c + i * c_stride);
-  }
+  };
+  // batches are independent, so spread them over the compute thread pool when there is one
+  MaybeMultiThreadLoop(batch_size, GemmOneBatch);
 }
 
 }  // namespace
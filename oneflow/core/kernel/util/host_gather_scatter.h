@@ -0,0 +1,177 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_GATHER_SCATTER_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_GATHER_SCATTER_H_
+
+#include <cstring>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace host_gather_scatter {
+
+// Elements handled by one task of the thread pool, below it the whole op runs in one thread.
+const int64_t kTaskElemCnt = 1 << 14;
+// How many rows ahead of the current one a gather prefetches.
+const int64_t kPrefetchRowDistance = 8;
+
+inline void ForEachTask(int64_t task_num, int64_t elem_cnt,
+                        const std::function<void(size_t)>& Handler) {
+  if (elem_cnt > kTaskElemCnt) {
+    MaybeMultiThreadLoop(task_num, Handler);
+  } else {
+    SingleThreadLoop(task_num, Handler);
+  }
+}
+
+inline int64_t TaskNum(int64_t row_num, int64_t rows_per_task) {
+  return RoundUp(row_num, rows_per_task) / rows_per_task;
+}
+
+inline int64_t RowsPerTask(int64_t row_size) {
+  return std::max<int64_t>(1, kTaskElemCnt / std::max<int64_t>(row_size, 1));
+}
+
+template<typename T>
+inline void PrefetchRow(const T* row) {
+#if defined(__GNUC__)
+  __builtin_prefetch(row);
+#endif
+}
+
+// Positions of the in-range segment ids grouped by segment. Positions of one segment stay in
+// ascending order, so reducing a group in order adds up rows exactly like a serial loop does.
+struct SortedSegments {
+  std::vector<int64_t> positions;
+  // segment of every group, segment ids being shifted by the offset
+  std::vector<int64_t> segments;
+  // group i is positions[group_begins[i], group_begins[i + 1])
+  std::vector<int64_t> group_begins;
+
+  int64_t group_num() const { return segments.size(); }
+};
+
+template<typename K>
+SortedSegments SortSegments(const K* segment_ids, int64_t num_segment_ids,
+                            int64_t segment_id_offset, int64_t num_segments) {
+  std::vector<std::pair<int64_t, int64_t>> segment7positions;
+  segment7positions.reserve(num_segment_ids);
+  FOR_RANGE(int64_t, i, 0, num_segment_ids) {
+    CHECK_GE(segment_ids[i], 0);
+    const int64_t segment = segment_ids[i] - segment_id_offset;
+    if (segment >= 0 && segment < num_segments) { segment7positions.emplace_back(segment, i); }
+  }
+  std::sort(segment7positions.begin(), segment7positions.end());
+  SortedSegments sorted;
+  sorted.positions.reserve(segment7positions.size());
+  for (const auto& pair : segment7positions) {
+    if (sorted.segments.empty() || sorted.segments.back() != pair.first) {
+      sorted.segments.push_back(pair.first);
+      sorted.group_begins.push_back(sorted.positions.size());
+    }
+    sorted.positions.push_back(pair.second);
+  }
+  sorted.group_begins.push_back(sorted.positions.size());
+  return sorted;
+}
+
+// Calls Handler(group_begin, group_end) on ranges of groups that cover about the same number of
+// positions. Every group is handled by exactly one task, so tasks write disjoint segments and need
+// no atomics.
+inline void ForEachSegmentGroupRange(const SortedSegments& sorted, int64_t elem_cnt_per_position,
+                                     const std::function<void(int64_t, int64_t)>& Handler) {
+  const int64_t position_num = sorted.positions.size();
+  const int64_t positions_per_task = RowsPerTask(elem_cnt_per_position);
+  const int64_t task_num = TaskNum(position_num, positions_per_task);
+  const auto group_begins_end = sorted.group_begins.begin() + sorted.group_num();
+  auto FirstGroup4Position = [&](int64_t position) -> int64_t {
+    return std::lower_bound(sorted.group_begins.begin(), group_begins_end, position)
+           - sorted.group_begins.begin();
+  };
+  ForEachTask(task_num, position_num * elem_cnt_per_position, [&](size_t task_id) {
+    const int64_t group_begin = FirstGroup4Position(task_id * positions_per_task);
+    const int64_t group_end = FirstGroup4Position((task_id + 1) * positions_per_task);
+    if (group_begin < group_end) { Handler(group_begin, group_end); }
+  });
+}
+
+}  // namespace host_gather_scatter
+
+// out[o][i] = in[o][indices[i] - offset] on host memory, rows whose index falls outside
+// [offset, offset + gather_dim_size) are zero.
+template<typename T, typename K>
+void HostGather(const K* indices, int64_t num_indices, const T* in, int64_t outer_dim_size,
+                int64_t gather_dim_size, int64_t inner_dim_size, int64_t offset, T* out) {
+  using namespace host_gather_scatter;
+  const int64_t row_num = outer_dim_size * num_indices;
+  const int64_t rows_per_task = RowsPerTask(inner_dim_size);
+  auto InRow4Row = [&](int64_t row) -> const T* {
+    const int64_t outer_idx = row / num_indices;
+    const int64_t idx = indices[row % num_indices] - offset;
+    if (idx < 0 || idx >= gather_dim_size) { return nullptr; }
+    return in + (outer_idx * gather_dim_size + idx) * inner_dim_size;
+  };
+  ForEachTask(TaskNum(row_num, rows_per_task), row_num * inner_dim_size, [&](size_t task_id) {
+    const int64_t row_begin = task_id * rows_per_task;
+    const int64_t row_end = std::min(row_begin + rows_per_task, row_num);
+    FOR_RANGE(int64_t, row, row_begin, row_end) {
+      CHECK_GE(indices[row % num_indices], 0);
+      // rows of an embedding table are scattered, so fetch them ahead of the copy
+      if (row + kPrefetchRowDistance < row_end) {
+        const T* ahead = InRow4Row(row + kPrefetchRowDistance);
+        if (ahead != nullptr) { PrefetchRow(ahead); }
+      }
+      const T* from = InRow4Row(row);
+      T* to = out + row * inner_dim_size;
+      if (from != nullptr) {
+        std::copy(from, from + inner_dim_size, to);
+      } else {
+        std::memset(to, 0, inner_dim_size * sizeof(T));
+      }
+    }
+  });
+}
+
+// out[o][segment_ids[i] - offset] += data[o][i] on host memory. Rows are sorted by segment and
+// every segment is reduced by one thread in the order of i, so the result does not depend on the
+// number of threads or on how often a segment id repeats.
+template<typename T, typename K>
+void HostUnsortedSegmentSum(const K* segment_ids, const T* data, int64_t num_segment_ids,
+                            int64_t num_segments, int64_t outer_dim_size, int64_t inner_dim_size,
+                            int64_t segment_id_offset, T* out) {
+  using namespace host_gather_scatter;
+  const SortedSegments sorted =
+      SortSegments(segment_ids, num_segment_ids, segment_id_offset, num_segments);
+  ForEachSegmentGroupRange(
+      sorted, outer_dim_size * inner_dim_size, [&](int64_t group_begin, int64_t group_end) {
+        const int64_t* group_begins = sorted.group_begins.data();
+        const int64_t* positions = sorted.positions.data();
+        FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
+          FOR_RANGE(int64_t, group, group_begin, group_end) {
+            T* to = out + (outer_idx * num_segments + sorted.segments[group]) * inner_dim_size;
+            FOR_RANGE(int64_t, j, group_begins[group], group_begins[group + 1]) {
+              const T* from = data + (outer_idx * num_segment_ids + positions[j]) * inner_dim_size;
+              FOR_RANGE(int64_t, k, 0, inner_dim_size) { to[k] += from[k]; }
+            }
+          }
+        }
+      });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_GATHER_SCATTER_H_
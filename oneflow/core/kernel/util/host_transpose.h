@@ -0,0 +1,232 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
+
+#include <cstring>
+#include <numeric>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace host_transpose {
+
+// Elements moved by one task of the thread pool, below it the whole transpose runs in one thread.
+const int64_t kTaskElemCnt = 1 << 14;
+// Edge of the square tiles swapped by the innermost 2-D kernel.
+const int64_t kTileSize = 16;
+
+// The transpose y = x.permute(perm) with size-1 axes dropped and axes that stay adjacent in the
+// same order merged, e.g. NCHW -> NHWC becomes [N, C, H*W] -> [N, H*W, C].
+struct SimplifiedTranspose {
+  std::vector<int64_t> x_dims;
+  std::vector<int32_t> perm;
+};
+
+inline SimplifiedTranspose SimplifyTranspose(int32_t num_axes, const int64_t* x_dims,
+                                             const int32_t* perm) {
+  std::vector<int32_t> kept_perm;
+  FOR_RANGE(int32_t, i, 0, num_axes) {
+    if (x_dims[perm[i]] != 1) { kept_perm.push_back(perm[i]); }
+  }
+  // runs of y axes that read consecutive x axes, as [first, last] x axis
+  std::vector<std::pair<int32_t, int32_t>> runs;
+  for (const int32_t axis : kept_perm) {
+    if (!runs.empty() && runs.back().second + 1 == axis) {
+      runs.back().second = axis;
+    } else {
+      runs.emplace_back(axis, axis);
+    }
+  }
+  std::vector<int32_t> run_ids_in_x_order(runs.size());
+  std::iota(run_ids_in_x_order.begin(), run_ids_in_x_order.end(), 0);
+  std::sort(run_ids_in_x_order.begin(), run_ids_in_x_order.end(),
+            [&](int32_t lhs, int32_t rhs) { return runs.at(lhs).first < runs.at(rhs).first; });
+  SimplifiedTranspose simplified;
+  simplified.x_dims.resize(runs.size());
+  simplified.perm.resize(runs.size());
+  FOR_RANGE(int32_t, new_axis, 0, runs.size()) {
+    const int32_t run_id = run_ids_in_x_order.at(new_axis);
+    int64_t dim = 1;
+    FOR_RANGE(int32_t, axis, runs.at(run_id).first, runs.at(run_id).second + 1) {
+      dim *= x_dims[axis];
+    }
+    simplified.x_dims.at(new_axis) = dim;
+    simplified.perm.at(run_id) = new_axis;
+  }
+  return simplified;
+}
+
+// dst[c * dst_ld + r] = src[r * src_ld + c]. Full tiles have compile time bounds so the compiler
+// can unroll and vectorize them.
+template<typename T>
+inline void TransposeTile(int64_t rows, int64_t cols, const T* src, int64_t src_ld, T* dst,
+                          int64_t dst_ld) {
+  if (rows == kTileSize && cols == kTileSize) {
+    for (int64_t r = 0; r < kTileSize; ++r) {
+      for (int64_t c = 0; c < kTileSize; ++c) { dst[c * dst_ld + r] = src[r * src_ld + c]; }
+    }
+  } else {
+    FOR_RANGE(int64_t, r, 0, rows) {
+      FOR_RANGE(int64_t, c, 0, cols) { dst[c * dst_ld + r] = src[r * src_ld + c]; }
+    }
+  }
+}
+
+// Iterates y axes in order while tracking the matching x offset.
+class OuterIndex final {
+ public:
+  OuterIndex(const std::vector<int64_t>& dims, const std::vector<int64_t>& x_strides,
+             const std::vector<int64_t>& y_strides, int64_t linear_index)
+      : dims_(dims), x_strides_(x_strides), y_strides_(y_strides), digits_(dims.size()) {
+    x_offset_ = 0;
+    y_offset_ = 0;
+    for (int32_t i = dims_.size() - 1; i >= 0; --i) {
+      digits_.at(i) = linear_index % dims_.at(i);
+      linear_index /= dims_.at(i);
+      x_offset_ += digits_.at(i) * x_strides_.at(i);
+      y_offset_ += digits_.at(i) * y_strides_.at(i);
+    }
+  }
+
+  int64_t x_offset() const { return x_offset_; }
+  int64_t y_offset() const { return y_offset_; }
+
+  void Next() {
+    for (int32_t i = dims_.size() - 1; i >= 0; --i) {
+      ++digits_.at(i);
+      x_offset_ += x_strides_.at(i);
+      y_offset_ += y_strides_.at(i);
+      if (digits_.at(i) < dims_.at(i)) { break; }
+      x_offset_ -= digits_.at(i) * x_strides_.at(i);
+      y_offset_ -= digits_.at(i) * y_strides_.at(i);
+      digits_.at(i) = 0;
+    }
+  }
+
+ private:
+  const std::vector<int64_t>& dims_;
+  const std::vector<int64_t>& x_strides_;
+  const std::vector<int64_t>& y_strides_;
+  std::vector<int64_t> digits_;
+  int64_t x_offset_;
+  int64_t y_offset_;
+};
+
+inline void ForEachTask(int64_t task_num, int64_t elem_cnt,
+                        const std::function<void(size_t)>& Handler) {
+  if (elem_cnt > kTaskElemCnt) {
+    MaybeMultiThreadLoop(task_num, Handler);
+  } else {
+    SingleThreadLoop(task_num, Handler);
+  }
+}
+
+}  // namespace host_transpose
+
+// y = x.permute(perm) on host memory.
+template<typename T>
+void HostTranspose(int32_t num_axes, const int64_t* x_dims, const int32_t* perm, const T* x,
+                   T* y) {
+  using namespace host_transpose;
+  int64_t elem_cnt = 1;
+  FOR_RANGE(int32_t, i, 0, num_axes) { elem_cnt *= x_dims[i]; }
+  if (elem_cnt == 0) { return; }
+  const SimplifiedTranspose simplified = SimplifyTranspose(num_axes, x_dims, perm);
+  const int32_t n = simplified.perm.size();
+  if (n <= 1) {
+    std::memcpy(y, x, elem_cnt * sizeof(T));
+    return;
+  }
+  std::vector<int64_t> x_strides(n, 1);
+  for (int32_t i = n - 2; i >= 0; --i) {
+    x_strides.at(i) = x_strides.at(i + 1) * simplified.x_dims.at(i + 1);
+  }
+  std::vector<int64_t> y_dims(n);
+  std::vector<int64_t> y_strides(n, 1);
+  FOR_RANGE(int32_t, i, 0, n) { y_dims.at(i) = simplified.x_dims.at(simplified.perm.at(i)); }
+  for (int32_t i = n - 2; i >= 0; --i) { y_strides.at(i) = y_strides.at(i + 1) * y_dims.at(i + 1); }
+
+  if (simplified.perm.at(n - 1) == n - 1) {
+    // the innermost axis stays, so y is a gather of contiguous blocks
+    const int64_t block_size = simplified.x_dims.at(n - 1);
+    std::vector<int64_t> outer_dims(y_dims.begin(), y_dims.end() - 1);
+    std::vector<int64_t> outer_x_strides;
+    std::vector<int64_t> outer_y_strides(y_strides.begin(), y_strides.end() - 1);
+    FOR_RANGE(int32_t, i, 0, n - 1) {
+      outer_x_strides.push_back(x_strides.at(simplified.perm.at(i)));
+    }
+    const int64_t block_num = elem_cnt / block_size;
+    const int64_t blocks_per_task = std::max<int64_t>(1, kTaskElemCnt / block_size);
+    const int64_t task_num = RoundUp(block_num, blocks_per_task) / blocks_per_task;
+    ForEachTask(task_num, elem_cnt, [&](size_t task_id) {
+      const int64_t block_begin = task_id * blocks_per_task;
+      const int64_t block_end = std::min(block_begin + blocks_per_task, block_num);
+      OuterIndex outer(outer_dims, outer_x_strides, outer_y_strides, block_begin);
+      FOR_RANGE(int64_t, i, block_begin, block_end) {
+        std::memcpy(y + outer.y_offset(), x + outer.x_offset(), block_size * sizeof(T));
+        outer.Next();
+      }
+    });
+    return;
+  }
+
+  // the innermost y axis reads x axis row_x_axis and the innermost x axis lands on y axis
+  // col_y_axis, so every outer index is a 2-D transpose between those two axes
+  const int32_t row_x_axis = simplified.perm.at(n - 1);
+  const int32_t col_y_axis =
+      std::find(simplified.perm.begin(), simplified.perm.end(), n - 1) - simplified.perm.begin();
+  const int64_t rows = simplified.x_dims.at(row_x_axis);
+  const int64_t cols = simplified.x_dims.at(n - 1);
+  const int64_t src_ld = x_strides.at(row_x_axis);
+  const int64_t dst_ld = y_strides.at(col_y_axis);
+  std::vector<int64_t> outer_dims;
+  std::vector<int64_t> outer_x_strides;
+  std::vector<int64_t> outer_y_strides;
+  FOR_RANGE(int32_t, i, 0, n - 1) {
+    if (i == col_y_axis) { continue; }
+    outer_dims.push_back(y_dims.at(i));
+    outer_x_strides.push_back(x_strides.at(simplified.perm.at(i)));
+    outer_y_strides.push_back(y_strides.at(i));
+  }
+  const int64_t outer_cnt = elem_cnt / (rows * cols);
+  // a task is a strip of kTileSize rows, or several whole matrices when they are small
+  const int64_t row_tile_num = RoundUp(rows, kTileSize) / kTileSize;
+  const int64_t outer_per_task =
+      row_tile_num > 1 ? 1 : std::max<int64_t>(1, kTaskElemCnt / (rows * cols));
+  const int64_t task_num = RoundUp(outer_cnt, outer_per_task) / outer_per_task * row_tile_num;
+  ForEachTask(task_num, elem_cnt, [&](size_t task_id) {
+    const int64_t outer_begin = task_id / row_tile_num * outer_per_task;
+    const int64_t outer_end = std::min(outer_begin + outer_per_task, outer_cnt);
+    const int64_t row_begin = task_id % row_tile_num * kTileSize;
+    const int64_t row_cnt = std::min(kTileSize, rows - row_begin);
+    OuterIndex outer(outer_dims, outer_x_strides, outer_y_strides, outer_begin);
+    FOR_RANGE(int64_t, i, outer_begin, outer_end) {
+      const T* src = x + outer.x_offset() + row_begin * src_ld;
+      T* dst = y + outer.y_offset() + row_begin;
+      for (int64_t col_begin = 0; col_begin < cols; col_begin += kTileSize) {
+        TransposeTile<T>(row_cnt, std::min(kTileSize, cols - col_begin), src + col_begin, src_ld,
+                         dst + col_begin * dst_ld, dst_ld);
+      }
+      outer.Next();
+    }
+  });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_transpose.h"
+
+namespace oneflow {
+
+namespace {
+
+void TestHostTranspose(const std::vector<int64_t>& x_dims, const std::vector<int32_t>& perm) {
+  const int32_t num_axes = x_dims.size();
+  int64_t elem_cnt = 1;
+  for (const int64_t dim : x_dims) { elem_cnt *= dim; }
+  std::vector<int32_t> x(elem_cnt);
+  std::iota(x.begin(), x.end(), 0);
+  std::vector<int32_t> y(elem_cnt, -1);
+  HostTranspose<int32_t>(num_axes, x_dims.data(), perm.data(), x.data(), y.data());
+
+  std::vector<int64_t> x_strides(num_axes, 1);
+  for (int32_t i = num_axes - 2; i >= 0; --i) { x_strides[i] = x_strides[i + 1] * x_dims[i + 1]; }
+  std::vector<int64_t> y_index(num_axes, 0);
+  FOR_RANGE(int64_t, y_offset, 0, elem_cnt) {
+    int64_t x_offset = 0;
+    FOR_RANGE(int32_t, i, 0, num_axes) { x_offset += y_index[i] * x_strides[perm[i]]; }
+    ASSERT_EQ(y[y_offset], x[x_offset]);
+    for (int32_t i = num_axes - 1; i >= 0; --i) {
+      if (++y_index[i] < x_dims[perm[i]]) { break; }
+      y_index[i] = 0;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(HostTranspose, simplify_merges_adjacent_axes) {
+  const std::vector<int64_t> x_dims = {2, 3, 4, 5};
+  const std::vector<int32_t> perm = {0, 2, 3, 1};
+  const auto simplified = host_transpose::SimplifyTranspose(4, x_dims.data(), perm.data());
+  ASSERT_EQ(simplified.x_dims, std::vector<int64_t>({2, 3, 20}));
+  ASSERT_EQ(simplified.perm, std::vector<int32_t>({0, 2, 1}));
+}
+
+TEST(HostTranspose, matches_reference) {
+  TestHostTranspose({37, 53}, {1, 0});
+  TestHostTranspose({2, 3, 17, 19}, {0, 2, 3, 1});
+  TestHostTranspose({2, 17, 19, 3}, {0, 3, 1, 2});
+  TestHostTranspose({5, 7, 9}, {1, 0, 2});
+  TestHostTranspose({4, 1, 6, 1, 5}, {4, 2, 1, 0, 3});
+  TestHostTranspose({3, 4, 5, 6}, {3, 2, 1, 0});
+  TestHostTranspose({3, 4, 5}, {0, 1, 2});
+}
+
+TEST(HostTranspose, empty) {
+  TestHostTranspose({0, 3}, {1, 0});
+  TestHostTranspose({4, 0, 5}, {2, 0, 1});
+}
+
+}  // namespace oneflow
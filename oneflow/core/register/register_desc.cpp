@@ -161,6 +161,11 @@ void RegstDesc::ToProto(RegstDescProto* ret) const {
   if (hint_inplace_consumed_regst_desc_id_ != -1) {
     ret->set_hint_inplace_consumed_regst_desc_id(hint_inplace_consumed_regst_desc_id_);
   }
+  for (const auto& pair : hint_inplace_sub_regst_descs_) {
+    InplaceSubRegstDesc* sub_regst_desc = ret->add_hint_inplace_sub_regst_desc();
+    sub_regst_desc->set_regst_desc_id(pair.first);
+    sub_regst_desc->set_byte_offset(pair.second);
+  }
 }
 
 bool RegstDesc::HasSameMemSize(const RegstDesc* rhs) {
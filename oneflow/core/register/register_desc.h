@@ -67,13 +67,19 @@ class RegstDesc final {
   // mem
   const MemoryCase& mem_case() const { return mem_case_; }
   MemoryCase* mut_mem_case() { return &mem_case_; }
-  bool enable_reuse_mem() { return enable_reuse_mem_; }
+  bool enable_reuse_mem() const { return enable_reuse_mem_; }
   void set_enable_reuse_mem(bool enable_reuse_mem) { enable_reuse_mem_ = enable_reuse_mem; }
   int64_t mem_block_offset() const;
   void set_mem_block_offset(int64_t val) { mem_block_offset_ = val; }
+  int64_t hint_inplace_consumed_regst_desc_id() const {
+    return hint_inplace_consumed_regst_desc_id_;
+  }
   void set_hint_inplace_consumed_regst_desc_id(int64_t val) {
     hint_inplace_consumed_regst_desc_id_ = val;
   }
+  void AddHintInplaceSubRegstDesc(int64_t regst_desc_id, int64_t byte_offset) {
+    hint_inplace_sub_regst_descs_.emplace_back(regst_desc_id, byte_offset);
+  }
   int32_t mem_block_id() const { return mem_block_id_; }
   void set_mem_block_id(int32_t val) { mem_block_id_ = val; }
   bool HasSetMemBlockId() { return mem_block_id_ != -1; }
@@ -115,6 +121,7 @@ class RegstDesc final {
   int32_t mem_block_id_;
   int64_t mem_block_offset_;
   int32_t hint_inplace_consumed_regst_desc_id_;
+  std::vector<std::pair<int64_t, int64_t>> hint_inplace_sub_regst_descs_;
 
   std::shared_ptr<Shape> data_regst_time_shape_;
 };
@@ -22,6 +22,10 @@ limitations under the License.
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/cpu_affinity.h"
 
 namespace oneflow {
 
@@ -33,11 +37,42 @@ void CheckBlobInRegstNotDisabled(const RegstDescProto& regst_desc) {
         == false);
 }
 
+// The actor thread that consumes each mem block first, the producer's if nobody consumes it.
+HashMap<int64_t, int64_t> MemBlockId2ConsumerThrdId(const Plan& plan, int64_t this_machine_id) {
+  HashMap<int64_t, int64_t> task_id2thrd_id;
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() != this_machine_id) { continue; }
+    task_id2thrd_id.emplace(task.task_id(), task.thrd_id());
+  }
+  HashMap<int64_t, int64_t> mem_block_id2thrd_id;
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() != this_machine_id) { continue; }
+    for (const auto& pair : task.produced_regst_desc()) {
+      const RegstDescProto& regst_desc = pair.second;
+      if (regst_desc.mem_block_id() == -1) { continue; }
+      int64_t thrd_id = task.thrd_id();
+      for (const int64_t consumer_task_id : regst_desc.consumer_task_id()) {
+        const auto it = task_id2thrd_id.find(consumer_task_id);
+        if (it != task_id2thrd_id.end()) {
+          thrd_id = it->second;
+          break;
+        }
+      }
+      mem_block_id2thrd_id.emplace(regst_desc.mem_block_id(), thrd_id);
+    }
+  }
+  return mem_block_id2thrd_id;
+}
+
 }  // namespace
 
 RegstMgr::RegstMgr(const Plan& plan) {
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   HashMap<int64_t, char*> chunk_id2ptr;
+  HashMap<int64_t, int64_t> mem_block_id2thrd_id;
+  if (Global<ResourceDesc, ForSession>::Get()->cpu_affinity_conf().numa_aware_host_mem()) {
+    mem_block_id2thrd_id = MemBlockId2ConsumerThrdId(plan, this_machine_id);
+  }
   for (const ChunkProto& chunk : plan.block_chunk_list().chunk()) {
     if (chunk.machine_id() != this_machine_id) { continue; }
     if (chunk.mem_size() == 0) { continue; }
@@ -53,6 +88,15 @@ RegstMgr::RegstMgr(const Plan& plan) {
       CHECK(chunk_id2ptr.find(mem_block.chunk_id()) != chunk_id2ptr.end());
       mem_block_ptr = chunk_id2ptr.at(mem_block.chunk_id()) + mem_block.chunk_offset();
     } else {
+      // MemoryAllocator zeroes host memory right away, so pinning this thread to the consumer's
+      // cpus makes the first touch place the pages on the consumer's numa node
+      std::unique_ptr<ScopedCpuAffinity> consumer_cpu_affinity;
+      const auto thrd_it = mem_block_id2thrd_id.find(mem_block.mem_block_id());
+      if (thrd_it != mem_block_id2thrd_id.end() && mem_block.mem_case().has_host_mem()
+          && !mem_block.mem_case().host_mem().has_cuda_pinned_mem()) {
+        const std::vector<int32_t> cpus = CpuAffinity4ActorThread(thrd_it->second);
+        if (!cpus.empty()) { consumer_cpu_affinity.reset(new ScopedCpuAffinity(cpus)); }
+      }
       mem_block_ptr =
           Global<MemoryAllocator>::Get()->Allocate(mem_block.mem_case(), mem_block.mem_size());
     }
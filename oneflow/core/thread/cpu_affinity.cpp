@@ -0,0 +1,202 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/cpu_affinity.h"
+#include "oneflow/core/common/platform.h"
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#ifdef PLATFORM_POSIX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+std::vector<int32_t> GetCallingThreadCpus() {
+#ifdef PLATFORM_POSIX
+  cpu_set_t cpu_set;
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+  std::vector<int32_t> cpus;
+  FOR_RANGE(int32_t, cpu, 0, CPU_SETSIZE) {
+    if (CPU_ISSET(cpu, &cpu_set)) { cpus.push_back(cpu); }
+  }
+  return cpus;
+#else
+  std::vector<int32_t> cpus(std::thread::hardware_concurrency());
+  std::iota(cpus.begin(), cpus.end(), 0);
+  return cpus;
+#endif
+}
+
+std::vector<std::vector<int32_t>> ReadNode2Cpus() {
+  const std::vector<int32_t> allowed_cpus = GetCallingThreadCpus();
+  const HashSet<int32_t> allowed_cpu_set(allowed_cpus.begin(), allowed_cpus.end());
+  std::vector<std::vector<int32_t>> node2cpus;
+  for (int32_t node = 0;; ++node) {
+    std::ifstream is("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!is.is_open()) { break; }
+    std::string cpu_list;
+    std::getline(is, cpu_list);
+    std::vector<int32_t> cpus;
+    for (const int32_t cpu : ParseCpuList(cpu_list)) {
+      if (allowed_cpu_set.find(cpu) != allowed_cpu_set.end()) { cpus.push_back(cpu); }
+    }
+    // nodes without allowed cpus, e.g. memory only nodes, can not host a thread
+    if (!cpus.empty()) { node2cpus.push_back(cpus); }
+  }
+  if (node2cpus.empty()) { node2cpus.push_back(allowed_cpus); }
+  return node2cpus;
+}
+
+#ifdef PLATFORM_POSIX
+void CpuSet4Cpus(const std::vector<int32_t>& cpus, cpu_set_t* cpu_set) {
+  CPU_ZERO(cpu_set);
+  for (const int32_t cpu : cpus) { CPU_SET(cpu, cpu_set); }
+}
+#endif
+
+std::vector<int32_t> AllCpus() {
+  const CpuTopology& topology = CpuTopology::Get();
+  std::vector<int32_t> cpus;
+  FOR_RANGE(int32_t, node, 0, topology.numa_node_num()) {
+    const std::vector<int32_t>& node_cpus = topology.cpus4numa_node(node);
+    cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+  }
+  return cpus;
+}
+
+}  // namespace
+
+CpuAffinityPolicy CpuAffinityPolicy4Name(const std::string& name) {
+  if (name == "none") {
+    return CpuAffinityPolicy::kNone;
+  } else if (name == "numa_node") {
+    return CpuAffinityPolicy::kNumaNode;
+  } else if (name == "core") {
+    return CpuAffinityPolicy::kCore;
+  } else {
+    LOG(FATAL) << "unknown cpu affinity policy " << name
+               << ", expected one of none, numa_node and core";
+    return CpuAffinityPolicy::kNone;
+  }
+}
+
+CpuTopology::CpuTopology(const std::vector<std::vector<int32_t>>& node2cpus)
+    : node2cpus_(node2cpus) {
+  CHECK(!node2cpus_.empty());
+  size_t max_node_size = 0;
+  for (const auto& cpus : node2cpus_) {
+    CHECK(!cpus.empty());
+    max_node_size = std::max(max_node_size, cpus.size());
+  }
+  FOR_RANGE(size_t, i, 0, max_node_size) {
+    for (const auto& cpus : node2cpus_) {
+      if (i < cpus.size()) { interleaved_cpus_.push_back(cpus.at(i)); }
+    }
+  }
+}
+
+const CpuTopology& CpuTopology::Get() {
+  static const CpuTopology topology(ReadNode2Cpus());
+  return topology;
+}
+
+int32_t CpuTopology::NumaNode4Cpu(int32_t cpu) const {
+  FOR_RANGE(int32_t, node, 0, node2cpus_.size()) {
+    const std::vector<int32_t>& cpus = node2cpus_.at(node);
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) { return node; }
+  }
+  return -1;
+}
+
+std::vector<int32_t> CpuTopology::CpuSet4ThreadIndex(CpuAffinityPolicy policy,
+                                                     int64_t index) const {
+  if (policy == CpuAffinityPolicy::kNumaNode) {
+    return node2cpus_.at(index % node2cpus_.size());
+  } else if (policy == CpuAffinityPolicy::kCore) {
+    return {interleaved_cpus_.at(index % interleaved_cpus_.size())};
+  } else {
+    return {};
+  }
+}
+
+std::string CpuTopology::ToString() const {
+  std::ostringstream ss;
+  ss << numa_node_num() << " numa node(s), " << interleaved_cpus_.size() << " cpu(s)";
+  FOR_RANGE(int32_t, node, 0, node2cpus_.size()) {
+    ss << "; node " << node << ": " << CpuListToString(node2cpus_.at(node));
+  }
+  return ss.str();
+}
+
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int32_t> cpus;
+  std::istringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) { continue; }
+    const size_t dash_pos = range.find('-');
+    const int32_t first = std::stoi(range.substr(0, dash_pos));
+    const int32_t last =
+        dash_pos == std::string::npos ? first : std::stoi(range.substr(dash_pos + 1));
+    CHECK_LE(first, last);
+    FOR_RANGE(int32_t, cpu, first, last + 1) { cpus.push_back(cpu); }
+  }
+  return cpus;
+}
+
+std::string CpuListToString(const std::vector<int32_t>& cpus) {
+  std::ostringstream ss;
+  size_t i = 0;
+  while (i < cpus.size()) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus.at(j + 1) == cpus.at(j) + 1) { ++j; }
+    if (i > 0) { ss << ","; }
+    ss << cpus.at(i);
+    if (j > i) { ss << "-" << cpus.at(j); }
+    i = j + 1;
+  }
+  return ss.str();
+}
+
+void SetThreadCpuAffinity(std::thread* thread, const std::vector<int32_t>& cpus) {
+#ifdef PLATFORM_POSIX
+  cpu_set_t cpu_set;
+  CpuSet4Cpus(cpus.empty() ? AllCpus() : cpus, &cpu_set);
+  CHECK_EQ(pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set_t), &cpu_set), 0);
+#endif
+}
+
+ScopedCpuAffinity::ScopedCpuAffinity(const std::vector<int32_t>& cpus) {
+#ifdef PLATFORM_POSIX
+  saved_cpus_ = GetCallingThreadCpus();
+  cpu_set_t cpu_set;
+  CpuSet4Cpus(cpus, &cpu_set);
+  CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+#endif
+}
+
+ScopedCpuAffinity::~ScopedCpuAffinity() {
+#ifdef PLATFORM_POSIX
+  cpu_set_t cpu_set;
+  CpuSet4Cpus(saved_cpus_, &cpu_set);
+  CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+#endif
+}
+
+}  // namespace oneflow
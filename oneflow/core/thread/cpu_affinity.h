@@ -0,0 +1,76 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_THREAD_CPU_AFFINITY_H_
+#define ONEFLOW_CORE_THREAD_CPU_AFFINITY_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum class CpuAffinityPolicy {
+  kNone,      // leave threads to the os scheduler
+  kNumaNode,  // pin a thread to all cpus of one numa node
+  kCore,      // pin a thread to one cpu
+};
+
+CpuAffinityPolicy CpuAffinityPolicy4Name(const std::string& name);
+
+// Numa nodes and the cpus of each this process is allowed to run on.
+class CpuTopology final {
+ public:
+  explicit CpuTopology(const std::vector<std::vector<int32_t>>& node2cpus);
+  ~CpuTopology() = default;
+
+  // Reads /sys/devices/system/node, a single node with every allowed cpu if it is missing.
+  static const CpuTopology& Get();
+
+  int32_t numa_node_num() const { return node2cpus_.size(); }
+  const std::vector<int32_t>& cpus4numa_node(int32_t node) const { return node2cpus_.at(node); }
+  int32_t NumaNode4Cpu(int32_t cpu) const;
+
+  // Cpus for the index-th thread placed by policy, empty for kNone. Threads are spread round
+  // robin over numa nodes, so consecutive indices land on different nodes.
+  std::vector<int32_t> CpuSet4ThreadIndex(CpuAffinityPolicy policy, int64_t index) const;
+  std::string ToString() const;
+
+ private:
+  std::vector<std::vector<int32_t>> node2cpus_;
+  // cpus ordered node by node in turn, the i-th of every node before the (i+1)-th of any
+  std::vector<int32_t> interleaved_cpus_;
+};
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}, the format of sysfs cpulist files.
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list);
+std::string CpuListToString(const std::vector<int32_t>& cpus);
+
+// An empty cpus resets the thread to every allowed cpu.
+void SetThreadCpuAffinity(std::thread* thread, const std::vector<int32_t>& cpus);
+
+// Pins the calling thread to cpus until destruction. Host memory first touched in the scope is
+// allocated on the numa node of those cpus.
+class ScopedCpuAffinity final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ScopedCpuAffinity);
+  explicit ScopedCpuAffinity(const std::vector<int32_t>& cpus);
+  ~ScopedCpuAffinity();
+
+ private:
+  std::vector<int32_t> saved_cpus_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_THREAD_CPU_AFFINITY_H_
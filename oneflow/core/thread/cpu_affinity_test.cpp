@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/cpu_affinity.h"
+
+namespace oneflow {
+
+TEST(CpuAffinity, parse_cpu_list) {
+  ASSERT_EQ(ParseCpuList("0-3,8,10-11"), std::vector<int32_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(ParseCpuList("5"), std::vector<int32_t>({5}));
+  ASSERT_TRUE(ParseCpuList("").empty());
+  ASSERT_EQ(CpuListToString({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+}
+
+TEST(CpuAffinity, spread_threads_over_numa_nodes) {
+  const CpuTopology topology({{0, 1, 2}, {4, 5}});
+  ASSERT_EQ(topology.NumaNode4Cpu(5), 1);
+  ASSERT_EQ(topology.NumaNode4Cpu(3), -1);
+  ASSERT_TRUE(topology.CpuSet4ThreadIndex(CpuAffinityPolicy::kNone, 0).empty());
+  ASSERT_EQ(topology.CpuSet4ThreadIndex(CpuAffinityPolicy::kNumaNode, 3),
+            std::vector<int32_t>({4, 5}));
+  std::vector<int32_t> cores;
+  FOR_RANGE(int64_t, i, 0, 6) {
+    cores.push_back(topology.CpuSet4ThreadIndex(CpuAffinityPolicy::kCore, i).at(0));
+  }
+  ASSERT_EQ(cores, std::vector<int32_t>({0, 4, 1, 5, 2, 0}));
+}
+
+}  // namespace oneflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/job/task.pb.h"
 #include "oneflow/core/thread/thread_context.h"
+#include "oneflow/core/thread/cpu_affinity.h"
 #include "oneflow/core/actor/actor.h"
 
 namespace oneflow {
@@ -36,6 +37,9 @@ class Thread {
   void EnqueueActorMsg(const ActorMsg& msg);
 
   void JoinAllActor() { actor_thread_.join(); }
+  void SetCpuAffinity(const std::vector<int32_t>& cpus) {
+    SetThreadCpuAffinity(&actor_thread_, cpus);
+  }
 
  protected:
   Thread() = default;
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/cpu_thread.h"
 #include "oneflow/core/thread/gpu_thread.h"
+#include "oneflow/core/thread/cpu_affinity.h"
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/job/machine_context.h"
@@ -32,11 +33,17 @@ ThreadMgr::~ThreadMgr() {
     delete threads_[i];
     LOG(INFO) << "actor thread " << i << " finish";
   }
+  if (is_thread_pool_pinned_) {
+    ThreadPool* thread_pool = Global<ThreadPool>::Get();
+    FOR_RANGE(int32_t, i, 0, thread_pool->thread_num()) {
+      thread_pool->SetWorkerCpuAffinity(i, {});
+    }
+  }
 }
 
 Thread* ThreadMgr::GetThrd(int64_t thrd_id) { return threads_.at(thrd_id); }
 
-ThreadMgr::ThreadMgr(const Plan& plan) {
+ThreadMgr::ThreadMgr(const Plan& plan) : is_thread_pool_pinned_(false) {
   int64_t thrd_id = 0;
 
 #ifdef WITH_CUDA
@@ -51,6 +58,7 @@ ThreadMgr::ThreadMgr(const Plan& plan) {
   }
   threads_.push_back(new CpuThread(thrd_id++));  // comm_net
   CreatePersistenceThrd(plan, thrd_id);
+  SetCpuAffinity();
 }
 
 void ThreadMgr::CreatePersistenceThrd(const Plan& plan, int64_t thrd_id) {
@@ -66,6 +74,53 @@ void ThreadMgr::CreatePersistenceThrd(const Plan& plan, int64_t thrd_id) {
   for (int64_t i = thrd_id; i <= max_thrd_id; i++) { threads_.push_back(new CpuThread(i)); }
 }
 
+void ThreadMgr::SetCpuAffinity() {
+  const CpuTopology& topology = CpuTopology::Get();
+  LOG(INFO) << "cpu topology: " << topology.ToString();
+  FOR_RANGE(int64_t, thrd_id, 0, threads_.size()) {
+    const std::vector<int32_t> cpus = CpuAffinity4ActorThread(thrd_id);
+    if (cpus.empty()) { continue; }
+    threads_.at(thrd_id)->SetCpuAffinity(cpus);
+    LOG(INFO) << "actor thread " << thrd_id << " pinned to cpus " << CpuListToString(cpus);
+  }
+  const CpuAffinityPolicy policy = CpuAffinityPolicy4Name(
+      Global<ResourceDesc, ForSession>::Get()->cpu_affinity_conf().thread_pool_affinity());
+  if (policy == CpuAffinityPolicy::kNone) { return; }
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  FOR_RANGE(int32_t, i, 0, thread_pool->thread_num()) {
+    const std::vector<int32_t> cpus = topology.CpuSet4ThreadIndex(policy, i);
+    thread_pool->SetWorkerCpuAffinity(i, cpus);
+    LOG(INFO) << "thread pool worker " << i << " pinned to cpus " << CpuListToString(cpus);
+  }
+  is_thread_pool_pinned_ = true;
+}
+
+std::vector<int32_t> CpuAffinity4ActorThread(int64_t thrd_id) {
+  const CpuAffinityPolicy policy = CpuAffinityPolicy4Name(
+      Global<ResourceDesc, ForSession>::Get()->cpu_affinity_conf().actor_thread_affinity());
+  if (policy == CpuAffinityPolicy::kNone) { return {}; }
+  const CpuTopology& topology = CpuTopology::Get();
+  int64_t cpu_thrd_index = thrd_id;
+#ifdef WITH_CUDA
+  const int64_t gpu_device_num = Global<ResourceDesc, ForSession>::Get()->GpuDeviceNum();
+  const int64_t gpu_thrd_num = GetCudaWorkTypeSize() * gpu_device_num;
+  if (thrd_id < gpu_thrd_num) {
+    // gpu threads stay next to their device whatever the policy
+    const int64_t dev_phy_id = thrd_id % gpu_device_num;
+    std::vector<int32_t> cpus;
+    for (const int32_t cpu : CudaDeviceGetLocalCpus(dev_phy_id)) {
+      if (topology.NumaNode4Cpu(cpu) != -1) { cpus.push_back(cpu); }
+    }
+    if (cpus.empty()) {
+      cpus = topology.CpuSet4ThreadIndex(CpuAffinityPolicy::kNumaNode, dev_phy_id);
+    }
+    return cpus;
+  }
+  cpu_thrd_index -= gpu_thrd_num;
+#endif
+  return topology.CpuSet4ThreadIndex(policy, cpu_thrd_index);
+}
+
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
   FOR_RANGE(size_t, i, 0, num) { Callback(i); }
 }
@@ -84,4 +139,12 @@ void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
   bc.WaitUntilCntEqualZero();
 }
 
+void MaybeMultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
+  if (num > 1 && Global<ThreadPool>::Get() != nullptr) {
+    MultiThreadLoop(num, Callback);
+  } else {
+    SingleThreadLoop(num, Callback);
+  }
+}
+
 }  // namespace oneflow
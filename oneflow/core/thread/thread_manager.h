@@ -38,12 +38,20 @@ class ThreadMgr final {
   explicit ThreadMgr(const Plan& plan);
 
   void CreatePersistenceThrd(const Plan& plan, int64_t thrd_id);
+  void SetCpuAffinity();
 
   std::vector<Thread*> threads_;
+  bool is_thread_pool_pinned_;
 };
 
+// Cpus the actor thread thrd_id is pinned to by cpu_affinity_conf, empty if it is not pinned.
+std::vector<int32_t> CpuAffinity4ActorThread(int64_t thrd_id);
+
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
+// MultiThreadLoop when there are several iterations and a Global<ThreadPool>, SingleThreadLoop
+// otherwise, e.g. for kernels run before the runtime creates the pool
+void MaybeMultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 
 }  // namespace oneflow
 
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/thread/cpu_affinity.h"
 
 namespace oneflow {
 
@@ -41,4 +42,8 @@ void ThreadPool::AddWork(const std::function<void()>& work) {
   work_chans_.at(cur_chan_idx).Send(work);
 }
 
+void ThreadPool::SetWorkerCpuAffinity(int32_t worker_id, const std::vector<int32_t>& cpus) {
+  SetThreadCpuAffinity(&threads_.at(worker_id), cpus);
+}
+
 }  // namespace oneflow
@@ -30,6 +30,7 @@ class ThreadPool final {
 
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
+  void SetWorkerCpuAffinity(int32_t worker_id, const std::vector<int32_t>& cpus);
 
  private:
   std::vector<Channel<std::function<void()>>> work_chans_;
@@ -0,0 +1,214 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cstring>
+#include "oneflow/core/vm/instruction_encoding.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/instruction.pb.h"
+#include "oneflow/core/vm/symbol_storage.h"
+#include "oneflow/core/common/magazine_object_msg_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+COMMAND(Global<SymbolStorage<InstructionTemplate>>::SetAllocated(
+    new SymbolStorage<InstructionTemplate>()));
+
+namespace {
+
+const int64_t kEncodedFieldMask = (1 << kEncodedMirroredKindShift) - 1;
+
+Maybe<void> InitObjectOperand(int64_t operand_tag, int64_t logical_object_id, Operand* operand) {
+  switch ((operand_tag >> kEncodedMirroredKindShift) & kEncodedFieldMask) {
+    case OperandProto::kCurrentGlobalDeviceIdFieldNumber:
+      operand->__Init__(logical_object_id);
+      break;
+    case OperandProto::kSoleMirroredObjectFieldNumber:
+      operand->__Init__(logical_object_id, SoleMirroredObject());
+      break;
+    case OperandProto::kAllMirroredObjectFieldNumber:
+      operand->__Init__(logical_object_id, AllMirroredObject());
+      break;
+    default: OF_UNIMPLEMENTED() << "operand tag: " << operand_tag;
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InitOperand(int64_t operand_tag, int64_t value, InstructionOperand* operand) {
+  switch (operand_tag & kEncodedFieldMask) {
+    case InstructionOperandProto::kConstOperandFieldNumber:
+      return InitObjectOperand(operand_tag, value,
+                               operand->mutable_const_operand()->mutable_operand());
+    case InstructionOperandProto::kMutOperandFieldNumber:
+      return InitObjectOperand(operand_tag, value,
+                               operand->mutable_mut_operand()->mutable_operand());
+    case InstructionOperandProto::kMut2OperandFieldNumber:
+      return InitObjectOperand(operand_tag, value,
+                               operand->mutable_mut2_operand()->mutable_operand());
+    case InstructionOperandProto::kSymbolOperandFieldNumber:
+      return InitObjectOperand(operand_tag, value,
+                               operand->mutable_symbol_operand()->mutable_operand());
+    case InstructionOperandProto::kInitSymbolOperandFieldNumber:
+      return InitObjectOperand(operand_tag, value,
+                               operand->mutable_init_symbol_operand()->mutable_operand());
+    case InstructionOperandProto::kSeparatorFieldNumber: operand->mutable_separator(); break;
+    case InstructionOperandProto::kDoubleOperandFieldNumber: {
+      double double_operand = 0;
+      std::memcpy(&double_operand, &value, sizeof(double));
+      operand->set_double_operand(double_operand);
+      break;
+    }
+    case InstructionOperandProto::kInt64OperandFieldNumber:
+      operand->set_int64_operand(value);
+      break;
+    case InstructionOperandProto::kUint64OperandFieldNumber:
+      operand->set_uint64_operand(static_cast<uint64_t>(value));
+      break;
+    case InstructionOperandProto::kBoolOperandFieldNumber:
+      operand->set_bool_operand(value != 0);
+      break;
+    default: OF_UNIMPLEMENTED() << "operand tag: " << operand_tag;
+  }
+  return Maybe<void>::Ok();
+}
+
+// Decodes the instruction at words[*offset] and moves *offset past it. The operands flagged as
+// template args are left uninitialized and passed to AddArgSlot.
+Maybe<void> DecodeInstruction(
+    const int64_t* words, int64_t size, int64_t* offset, InstructionMsg* instr_msg,
+    const std::function<void(int64_t operand_index, int64_t operand_tag, int64_t arg_index)>&
+        AddArgSlot) {
+  CHECK_LE_OR_RETURN(*offset + 3, size) << "truncated instruction";
+  const int64_t opcode = words[*offset];
+  const int64_t parallel_desc_symbol_id = words[*offset + 1];
+  const int64_t operand_num = words[*offset + 2];
+  *offset += 3;
+  CHECK_GE_OR_RETURN(operand_num, 0);
+  CHECK_LE_OR_RETURN(*offset + operand_num * 2, size) << "truncated instruction operands";
+  instr_msg->mutable_instr_type_id()->CopyFrom(*JUST(LookupInstrTypeId4Opcode(opcode)));
+  if (parallel_desc_symbol_id != 0) {
+    instr_msg->set_parallel_desc_symbol_id(parallel_desc_symbol_id);
+  }
+  auto* operands = instr_msg->mutable_operand();
+  operands->resize(operand_num);
+  FOR_RANGE(int64_t, i, 0, operand_num) {
+    const int64_t operand_tag = words[*offset + i * 2];
+    const int64_t value = words[*offset + i * 2 + 1];
+    if (operand_tag & kEncodedTemplateArgFlag) {
+      CHECK_OR_RETURN(static_cast<bool>(AddArgSlot)) << "template arg out of a template";
+      AddArgSlot(i, operand_tag & ~kEncodedTemplateArgFlag, value);
+    } else {
+      JUST(InitOperand(operand_tag, value, operands->at(i).Mutable()));
+    }
+  }
+  *offset += operand_num * 2;
+  return Maybe<void>::Ok();
+}
+
+ObjectMsgPtr<InstructionMsg> CopyWithOwnOperandList(const InstructionMsg& instr_msg) {
+  auto copy = ObjectMsgPtr<InstructionMsg>::NewFrom(MagazineObjectMsgAllocator::GlobalAllocator());
+  copy->mutable_instr_type_id()->CopyFrom(instr_msg.instr_type_id());
+  if (instr_msg.has_parallel_desc_symbol_id()) {
+    copy->set_parallel_desc_symbol_id(instr_msg.parallel_desc_symbol_id());
+  }
+  *copy->mutable_operand() = instr_msg.operand();
+  return copy;
+}
+
+}  // namespace
+
+Maybe<void> InstructionTemplate::Init(const int64_t* words, int64_t size) {
+  arg_num_ = 0;
+  int64_t offset = 0;
+  while (offset < size) {
+    CHECK_NE_OR_RETURN(words[offset], kInstantiateTemplateOpcode) << "nested template";
+    const int64_t instr_index = instr_msgs_.size();
+    auto instr_msg = ObjectMsgPtr<InstructionMsg>::NewFrom(
+        MagazineObjectMsgAllocator::GlobalAllocator());
+    bool has_arg_slots = false;
+    JUST(DecodeInstruction(words, size, &offset, instr_msg.Mutable(),
+                           [&](int64_t operand_index, int64_t operand_tag, int64_t arg_index) {
+                             arg_slots_.push_back(
+                                 ArgSlot{instr_index, operand_index, operand_tag, arg_index});
+                             arg_num_ = std::max(arg_num_, arg_index + 1);
+                             has_arg_slots = true;
+                           }));
+    instr_msgs_.push_back(std::move(instr_msg));
+    has_arg_slots_.push_back(has_arg_slots);
+  }
+  for (const ArgSlot& slot : arg_slots_) { CHECK_GE_OR_RETURN(slot.arg_index, 0); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InstructionTemplate::Instantiate(const int64_t* args, int64_t arg_num,
+                                             InstructionMsgList* instr_msg_list) const {
+  CHECK_EQ_OR_RETURN(arg_num, arg_num_) << "template arg number mismatch";
+  InstructionMsgList tmp_instr_msg_list;
+  std::vector<InstructionMsg*> instr_msgs(instr_msgs_.size());
+  FOR_RANGE(int64_t, i, 0, instr_msgs_.size()) {
+    const InstructionMsg& template_instr_msg = instr_msgs_.at(i).Get();
+    // InstructionMsg copies share the operand list, which is fine unless args are filled in
+    auto instr_msg = has_arg_slots_.at(i) ? CopyWithOwnOperandList(template_instr_msg)
+                                          : ObjectMsgPtr<InstructionMsg>::NewFrom(
+                                              MagazineObjectMsgAllocator::GlobalAllocator(),
+                                              template_instr_msg);
+    instr_msgs.at(i) = instr_msg.Mutable();
+    tmp_instr_msg_list.EmplaceBack(std::move(instr_msg));
+  }
+  for (const ArgSlot& slot : arg_slots_) {
+    auto* operands = instr_msgs.at(slot.instr_index)->mut_operand();
+    JUST(InitOperand(slot.operand_tag, args[slot.arg_index],
+                     operands->at(slot.operand_index).Mutable()));
+  }
+  tmp_instr_msg_list.MoveTo(instr_msg_list);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DecodeInstructions(const int64_t* words, int64_t size,
+                               InstructionMsgList* instr_msg_list) {
+  auto* allocator = MagazineObjectMsgAllocator::GlobalAllocator();
+  int64_t offset = 0;
+  while (offset < size) {
+    if (words[offset] == kInstantiateTemplateOpcode) {
+      CHECK_LE_OR_RETURN(offset + 3, size) << "truncated template instantiation";
+      const int64_t template_id = words[offset + 1];
+      const int64_t arg_num = words[offset + 2];
+      CHECK_GE_OR_RETURN(arg_num, 0);
+      CHECK_LE_OR_RETURN(offset + 3 + arg_num, size) << "truncated template args";
+      const auto& instr_template =
+          JUST(Global<SymbolStorage<InstructionTemplate>>::Get()->MaybeGet(template_id));
+      JUST(instr_template->Instantiate(words + offset + 3, arg_num, instr_msg_list));
+      offset += 3 + arg_num;
+    } else {
+      auto instr_msg = ObjectMsgPtr<InstructionMsg>::NewFrom(allocator);
+      JUST(DecodeInstruction(words, size, &offset, instr_msg.Mutable(), nullptr));
+      instr_msg_list->EmplaceBack(std::move(instr_msg));
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> AddInstructionTemplate(int64_t template_id, const int64_t* words, int64_t size) {
+  CHECK_GT_OR_RETURN(template_id, 0);
+  auto* storage = Global<SymbolStorage<InstructionTemplate>>::Get();
+  CHECK_OR_RETURN(!storage->Has(template_id)) << "template_id: " << template_id;
+  InstructionTemplate instr_template;
+  JUST(instr_template.Init(words, size));
+  storage->Add(template_id, instr_template);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace vm
+}  // namespace oneflow
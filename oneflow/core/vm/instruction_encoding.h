@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_INSTRUCTION_ENCODING_H_
+#define ONEFLOW_CORE_VM_INSTRUCTION_ENCODING_H_
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/vm/instruction.msg.h"
+
+namespace oneflow {
+namespace vm {
+
+// A flat int64 encoding of instruction lists which decodes into InstructionMsg without protobuf:
+//
+//   instruction   := opcode parallel_desc_symbol_id operand_num (operand_tag operand_value)*
+//   instantiation := kInstantiateTemplateOpcode template_id arg_num arg*
+//
+// Opcodes come from LookupInstrOpcode and are only valid in the current process.
+// parallel_desc_symbol_id is 0 when the instruction has none. An operand tag is the field number
+// of the operand in InstructionOperandProto, and for object operands also the field number of the
+// mirrored object kind in OperandProto shifted by kEncodedMirroredKindShift. Object operands put
+// their logical object id in operand_value, double operands their bits.
+const int64_t kInstantiateTemplateOpcode = -1;
+const int64_t kEncodedMirroredKindShift = 8;
+// Only in templates: operand_value is the index of the instantiation arg to use.
+const int64_t kEncodedTemplateArgFlag = 1 << 16;
+
+using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+// Pre-built instructions of a repeated op signature. Operands flagged as template args, e.g. the
+// blob objects, are filled in by every instantiation, others are shared by all of them.
+class InstructionTemplate final {
+ public:
+  InstructionTemplate() = default;
+  ~InstructionTemplate() = default;
+
+  Maybe<void> Init(const int64_t* words, int64_t size);
+  Maybe<void> Instantiate(const int64_t* args, int64_t arg_num,
+                          InstructionMsgList* instr_msg_list) const;
+
+ private:
+  struct ArgSlot {
+    int64_t instr_index;
+    int64_t operand_index;
+    int64_t operand_tag;
+    int64_t arg_index;
+  };
+
+  std::vector<ObjectMsgPtr<InstructionMsg>> instr_msgs_;
+  // whether instr_msgs_.at(i) has arg slots, so that it needs its own operand list
+  std::vector<bool> has_arg_slots_;
+  std::vector<ArgSlot> arg_slots_;
+  int64_t arg_num_;
+};
+
+Maybe<void> DecodeInstructions(const int64_t* words, int64_t size,
+                               InstructionMsgList* instr_msg_list);
+
+// template_id is chosen by the caller and must be positive.
+Maybe<void> AddInstructionTemplate(int64_t template_id, const int64_t* words, int64_t size);
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_INSTRUCTION_ENCODING_H_
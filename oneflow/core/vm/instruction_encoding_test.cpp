@@ -0,0 +1,124 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/instruction_encoding.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/instruction.pb.h"
+#include "oneflow/core/vm/id_util.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+namespace {
+
+int64_t ObjectOperandTag(int64_t operand_field_number, int64_t mirrored_kind_field_number) {
+  return operand_field_number | (mirrored_kind_field_number << kEncodedMirroredKindShift);
+}
+
+TEST(InstructionEncoding, decode_matches_proto) {
+  const int64_t symbol_id = IdUtil::NewLogicalSymbolId();
+  const int64_t object_id = IdUtil::NewLogicalObjectId();
+  InstructionProto proto;
+  proto.set_instr_type_name("NewSymbol");
+  proto.set_parallel_desc_symbol_id(symbol_id);
+  proto.add_operand()->mutable_symbol_operand()->set_logical_object_id(symbol_id);
+  proto.mutable_operand(0)->mutable_symbol_operand()->mutable_sole_mirrored_object();
+  proto.add_operand()->mutable_mut_operand()->set_logical_object_id(object_id);
+  proto.mutable_operand(1)->mutable_mut_operand()->mutable_current_global_device_id();
+  proto.add_operand()->mutable_separator();
+  proto.add_operand()->set_double_operand(0.5);
+  proto.add_operand()->set_int64_operand(-3);
+  proto.add_operand()->set_bool_operand(true);
+  auto expected = ObjectMsgPtr<InstructionMsg>::New(proto);
+
+  int64_t double_bits = 0;
+  const double double_operand = 0.5;
+  std::memcpy(&double_bits, &double_operand, sizeof(double));
+  const std::vector<int64_t> words = {
+      CHECK_JUST(LookupInstrOpcode("NewSymbol")),
+      symbol_id,
+      6,
+      ObjectOperandTag(InstructionOperandProto::kSymbolOperandFieldNumber,
+                       OperandProto::kSoleMirroredObjectFieldNumber),
+      symbol_id,
+      ObjectOperandTag(InstructionOperandProto::kMutOperandFieldNumber,
+                       OperandProto::kCurrentGlobalDeviceIdFieldNumber),
+      object_id,
+      InstructionOperandProto::kSeparatorFieldNumber,
+      0,
+      InstructionOperandProto::kDoubleOperandFieldNumber,
+      double_bits,
+      InstructionOperandProto::kInt64OperandFieldNumber,
+      -3,
+      InstructionOperandProto::kBoolOperandFieldNumber,
+      1};
+  InstructionMsgList list;
+  ASSERT_TRUE(DecodeInstructions(words.data(), words.size(), &list).IsOk());
+  ASSERT_EQ(list.size(), 1);
+  const InstructionMsg& decoded = *list.Begin();
+  ASSERT_TRUE(decoded.instr_type_id() == expected->instr_type_id());
+  ASSERT_EQ(decoded.parallel_desc_symbol_id(), expected->parallel_desc_symbol_id());
+  ASSERT_TRUE(decoded.operand() == expected->operand());
+}
+
+TEST(InstructionEncoding, truncated_words_fail) {
+  const std::vector<int64_t> words = {CHECK_JUST(LookupInstrOpcode("NewSymbol")), 0, 1};
+  InstructionMsgList list;
+  ASSERT_FALSE(DecodeInstructions(words.data(), words.size(), &list).IsOk());
+}
+
+TEST(InstructionEncoding, instantiate_template) {
+  const int64_t opcode = CHECK_JUST(LookupInstrOpcode("NewSymbol"));
+  const int64_t arg_tag = ObjectOperandTag(InstructionOperandProto::kSymbolOperandFieldNumber,
+                                           OperandProto::kSoleMirroredObjectFieldNumber)
+                          | kEncodedTemplateArgFlag;
+  // the first instruction takes arg 0, the second one is shared by all instantiations
+  const std::vector<int64_t> template_words = {
+      opcode, 0, 2, arg_tag, 0, InstructionOperandProto::kInt64OperandFieldNumber, 7,
+      opcode, 0, 1, InstructionOperandProto::kInt64OperandFieldNumber, 8};
+  const int64_t template_id = 1;
+  ASSERT_TRUE(
+      AddInstructionTemplate(template_id, template_words.data(), template_words.size()).IsOk());
+  const int64_t symbol_id0 = IdUtil::NewLogicalSymbolId();
+  const int64_t symbol_id1 = IdUtil::NewLogicalSymbolId();
+  const std::vector<int64_t> words = {kInstantiateTemplateOpcode, template_id, 1, symbol_id0,
+                                      kInstantiateTemplateOpcode, template_id, 1, symbol_id1};
+  InstructionMsgList list;
+  ASSERT_TRUE(DecodeInstructions(words.data(), words.size(), &list).IsOk());
+  ASSERT_EQ(list.size(), 4);
+  std::vector<int64_t> symbol_ids;
+  std::vector<int64_t> int64_operands;
+  OBJECT_MSG_LIST_FOR_EACH_PTR(&list, instr_msg) {
+    const auto& operands = instr_msg->operand();
+    if (operands.size() == 2) {
+      symbol_ids.push_back(operands.at(0)->symbol_operand().operand().logical_object_id());
+    }
+    int64_operands.push_back(operands.back()->int64_operand());
+  }
+  ASSERT_EQ(symbol_ids, std::vector<int64_t>({symbol_id0, symbol_id1}));
+  ASSERT_EQ(int64_operands, std::vector<int64_t>({7, 8, 7, 8}));
+  const std::vector<int64_t> bad_words = {kInstantiateTemplateOpcode, template_id, 0};
+  InstructionMsgList bad_list;
+  ASSERT_FALSE(DecodeInstructions(bad_words.data(), bad_words.size(), &bad_list).IsOk());
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
@@ -28,6 +28,17 @@ HashMap<std::string, InstrTypeId>* InstrTypeId4InstructionName() {
   return &map;
 }
 
+HashMap<std::string, int64_t>* InstrOpcode4InstructionName() {
+  static HashMap<std::string, int64_t> map;
+  return &map;
+}
+
+// elements of the unordered InstrTypeId4InstructionName() keep their addresses
+std::vector<const InstrTypeId*>* InstrTypeId4Opcode() {
+  static std::vector<const InstrTypeId*> vec;
+  return &vec;
+}
+
 }  // namespace
 
 const InstrTypeId& LookupInstrTypeId(const std::string& name) {
@@ -37,6 +48,20 @@ const InstrTypeId& LookupInstrTypeId(const std::string& name) {
   return iter->second;
 }
 
+Maybe<int64_t> LookupInstrOpcode(const std::string& name) {
+  const auto& map = *InstrOpcode4InstructionName();
+  const auto& iter = map.find(name);
+  CHECK_OR_RETURN(iter != map.end()) << "instruction type name: " << name;
+  return iter->second;
+}
+
+Maybe<const InstrTypeId*> LookupInstrTypeId4Opcode(int64_t opcode) {
+  const auto& vec = *InstrTypeId4Opcode();
+  CHECK_OR_RETURN(opcode >= 0 && opcode < static_cast<int64_t>(vec.size()))
+      << "instruction opcode: " << opcode;
+  return vec.at(opcode);
+}
+
 void ForEachInstrTypeId(std::function<void(const InstrTypeId&)> DoEach) {
   for (const auto& pair : *InstrTypeId4InstructionName()) { DoEach(pair.second); }
 }
@@ -50,7 +75,11 @@ void RegisterInstrTypeId(const std::string& instruction_name, const StreamType*
                          const InstructionType* instruction_type, InterpretType interpret_type) {
   InstrTypeId instr_type_id;
   instr_type_id.__Init__(stream_type, instruction_type, interpret_type);
-  CHECK(InstrTypeId4InstructionName()->emplace(instruction_name, instr_type_id).second);
+  const auto& pair = InstrTypeId4InstructionName()->emplace(instruction_name, instr_type_id);
+  CHECK(pair.second);
+  auto* instr_type_ids = InstrTypeId4Opcode();
+  CHECK(InstrOpcode4InstructionName()->emplace(instruction_name, instr_type_ids->size()).second);
+  instr_type_ids->push_back(&pair.first->second);
 }
 
 }  // namespace vm
@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_VM_INSTRUCTION_TYPE_H_
 
 #include <glog/logging.h>
+#include "oneflow/core/common/maybe.h"
 #include "oneflow/core/vm/stream_type.h"
 #include "oneflow/core/vm/infer_stream_type.h"
 
@@ -47,6 +48,9 @@ class InstructionType {
 
 class InstrTypeId;
 const InstrTypeId& LookupInstrTypeId(const std::string& instr_type_name);
+// Dense process local ids of registered instruction type names, used by encoded instructions.
+Maybe<int64_t> LookupInstrOpcode(const std::string& instr_type_name);
+Maybe<const InstrTypeId*> LookupInstrTypeId4Opcode(int64_t opcode);
 void ForEachInstrTypeId(std::function<void(const InstrTypeId&)> DoEach);
 void RegisterInstrTypeId(const std::string& instr_type_name, const StreamType* stream_type,
                          const InstructionType* instruction_type, InterpretType interpret_type);
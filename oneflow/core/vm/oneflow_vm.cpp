@@ -14,15 +14,122 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/vm/oneflow_vm.h"
+#include "oneflow/core/common/magazine_object_msg_allocator.h"
 
 namespace oneflow {
 
-OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
-    : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
+OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id,
+                     bool enable_async_schedule)
+    : OneflowVM(vm::MakeVmDesc(resource, this_machine_id).Get(), enable_async_schedule) {}
+
+OneflowVM::OneflowVM(const vm::VmDesc& vm_desc, bool enable_async_schedule)
+    : vm_(ObjectMsgPtr<vm::VirtualMachine>::NewFrom(MagazineObjectMsgAllocator::GlobalAllocator(),
+                                                    vm_desc)),
+      init_allocate_cnt_(MagazineObjectMsgAllocator::GlobalAllocator()->allocate_cnt()),
+      enable_async_schedule_(enable_async_schedule),
+      received_cnt_(0),
+      scheduled_cnt_(0),
+      exiting_(false),
+      has_schedule_error_(false) {
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
     auto thread_pool = std::make_unique<ThreadPool>(1);
     CHECK(thread_ctx2thread_pool_.emplace(thread_ctx, std::move(thread_pool)).second);
   }
+  if (enable_async_schedule_) { schedule_thread_ = std::thread([this]() { ScheduleLoop(); }); }
+}
+
+OneflowVM::~OneflowVM() {
+  if (enable_async_schedule_) {
+    {
+      std::unique_lock<std::mutex> lock(schedule_mutex_);
+      exiting_ = true;
+    }
+    schedule_cond_.notify_all();
+    schedule_thread_.join();
+  }
+  LOG(INFO) << "vm object msg allocations per instruction: " << AllocateCntPerInstruction();
+}
+
+Maybe<void> OneflowVM::Receive(InstructionMsgList* instr_list) {
+  if (!enable_async_schedule_) {
+    vm_->Receive(instr_list);
+    ScheduleUntilEmpty();
+    return Maybe<void>::Ok();
+  }
+  JUST(CheckNoScheduleError());
+  // pending_msg_list of the vm is mutexed, so the caller only holds its lock for a list splice
+  vm_->Receive(instr_list);
+  {
+    std::unique_lock<std::mutex> lock(schedule_mutex_);
+    ++received_cnt_;
+  }
+  schedule_cond_.notify_all();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> OneflowVM::Sync() {
+  if (!enable_async_schedule_) { return Maybe<void>::Ok(); }
+  std::shared_ptr<ErrorProto> error;
+  {
+    std::unique_lock<std::mutex> lock(schedule_mutex_);
+    const int64_t received_cnt = received_cnt_;
+    // instructions behind a failed one skip their work, so waiting for all of them stays cheap
+    schedule_cond_.wait(lock, [&]() { return scheduled_cnt_ >= received_cnt; });
+    error.swap(schedule_error_);
+    has_schedule_error_ = false;
+  }
+  if (error) { return error; }
+  return Maybe<void>::Ok();
+}
+
+void OneflowVM::ReportError(const std::shared_ptr<ErrorProto>& error) {
+  {
+    std::unique_lock<std::mutex> lock(schedule_mutex_);
+    if (!schedule_error_) { schedule_error_ = error; }
+    has_schedule_error_ = true;
+  }
+  schedule_cond_.notify_all();
+}
+
+Maybe<void> OneflowVM::CheckNoScheduleError() const {
+  std::unique_lock<std::mutex> lock(schedule_mutex_);
+  if (schedule_error_) { return schedule_error_; }
+  return Maybe<void>::Ok();
+}
+
+void OneflowVM::ScheduleUntilEmpty() {
+  while (!vm_->Empty()) {
+    vm_->Schedule();
+    TryReceiveAndRun();
+  }
+}
+
+void OneflowVM::ScheduleLoop() {
+  while (true) {
+    int64_t received_cnt = 0;
+    {
+      std::unique_lock<std::mutex> lock(schedule_mutex_);
+      schedule_cond_.wait(lock, [&]() { return exiting_ || received_cnt_ > scheduled_cnt_; });
+      // instructions received before exiting are still run
+      if (received_cnt_ == scheduled_cnt_) { return; }
+      received_cnt = received_cnt_;
+    }
+    // every Receive counted in received_cnt has pushed its instructions already
+    ScheduleUntilEmpty();
+    {
+      std::unique_lock<std::mutex> lock(schedule_mutex_);
+      scheduled_cnt_ = received_cnt;
+    }
+    schedule_cond_.notify_all();
+  }
+}
+
+double OneflowVM::AllocateCntPerInstruction() const {
+  const int64_t instr_msg_cnt = vm_->scheduled_instr_msg_cnt();
+  if (instr_msg_cnt == 0) { return 0; }
+  const int64_t allocate_cnt =
+      MagazineObjectMsgAllocator::GlobalAllocator()->allocate_cnt() - init_allocate_cnt_;
+  return static_cast<double>(allocate_cnt) / instr_msg_cnt;
 }
 
 void OneflowVM::TryReceiveAndRun() {
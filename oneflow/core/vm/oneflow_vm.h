@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_ONEFLOW_VM_H_
 #define ONEFLOW_CORE_VM_ONEFLOW_VM_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include "oneflow/core/common/maybe.h"
 #include "oneflow/core/vm/interpret_type.h"
 #include "oneflow/core/vm/vm_desc.msg.h"
 #include "oneflow/core/vm/virtual_machine.msg.h"
@@ -30,17 +34,49 @@ class ThreadCtx;
 
 class OneflowVM final {
  public:
+  using InstructionMsgList = OBJECT_MSG_LIST(vm::InstructionMsg, instr_msg_link);
+
   OneflowVM(const OneflowVM&) = delete;
   OneflowVM(OneflowVM&&) = delete;
-  OneflowVM(const Resource& resource, int64_t this_machine_id);
-  ~OneflowVM() = default;
+  OneflowVM(const Resource& resource, int64_t this_machine_id, bool enable_async_schedule);
+  OneflowVM(const vm::VmDesc& vm_desc, bool enable_async_schedule);
+  ~OneflowVM();
 
-  vm::VirtualMachine* mut_vm() { return vm_.Mutable(); }
-  void TryReceiveAndRun();
+  // Hands instr_list over to the vm. Without async scheduling it runs all instructions before
+  // returning, otherwise a scheduler thread owned by this vm runs them and it returns at once.
+  Maybe<void> Receive(InstructionMsgList* instr_list);
+  // Waits until all instructions received so far are done, fails with the first error reported
+  // and clears it.
+  Maybe<void> Sync();
+
+  bool enable_async_schedule() const { return enable_async_schedule_; }
+  // Keeps the first error of an instruction run by the scheduler for the next Receive or Sync.
+  void ReportError(const std::shared_ptr<ErrorProto>& error);
+  // Instructions scheduled after a reported error skip their work until Sync clears it.
+  bool HasScheduleError() const { return has_schedule_error_; }
+  // object msg allocations per scheduled instruction msg since this vm was created
+  double AllocateCntPerInstruction() const;
 
  private:
+  void TryReceiveAndRun();
+  void ScheduleUntilEmpty();
+  void ScheduleLoop();
+  Maybe<void> CheckNoScheduleError() const;
+
   ObjectMsgPtr<vm::VirtualMachine> vm_;
   HashMap<vm::ThreadCtx*, std::unique_ptr<ThreadPool>> thread_ctx2thread_pool_;
+  int64_t init_allocate_cnt_;
+
+  // async scheduling, the counters count Receive calls and are guarded by schedule_mutex_
+  bool enable_async_schedule_;
+  mutable std::mutex schedule_mutex_;
+  std::condition_variable schedule_cond_;
+  int64_t received_cnt_;
+  int64_t scheduled_cnt_;
+  bool exiting_;
+  std::shared_ptr<ErrorProto> schedule_error_;
+  std::atomic<bool> has_schedule_error_;
+  std::thread schedule_thread_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,149 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/oneflow_vm.h"
+#include "oneflow/core/vm/control_stream_type.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/vm_util.h"
+#include "oneflow/core/vm/test_util.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+namespace {
+
+std::vector<int64_t>* RecordedValues() {
+  static std::vector<int64_t> values;
+  return &values;
+}
+
+class TestRecordInstructionType final : public InstructionType {
+ public:
+  TestRecordInstructionType() = default;
+  ~TestRecordInstructionType() override = default;
+
+  using stream_type = ControlStreamType;
+
+  // clang-format off
+  FLAT_MSG_VIEW_BEGIN(TestRecordInstruction);
+    FLAT_MSG_VIEW_DEFINE_REPEATED_PATTERN(int64_t, value);
+  FLAT_MSG_VIEW_END(TestRecordInstruction);
+  // clang-format on
+
+  void Infer(VirtualMachine* vm, InstructionMsg* instr_msg) const override {}
+  void Compute(VirtualMachine* vm, InstructionMsg* instr_msg) const override {
+    // skips its work after an error like the opkernel instructions do
+    if (Global<OneflowVM>::Get()->HasScheduleError()) { return; }
+    FlatMsgView<TestRecordInstruction> view;
+    CHECK(view.Match(instr_msg->operand()));
+    FOR_RANGE(int, i, 0, view->value_size()) { RecordedValues()->push_back(view->value(i)); }
+  }
+  void Infer(Instruction*) const override { UNIMPLEMENTED(); }
+  void Compute(Instruction*) const override { UNIMPLEMENTED(); }
+};
+COMMAND(RegisterInstructionType<TestRecordInstructionType>("TestRecord"));
+
+class TestReportErrorInstructionType final : public InstructionType {
+ public:
+  TestReportErrorInstructionType() = default;
+  ~TestReportErrorInstructionType() override = default;
+
+  using stream_type = ControlStreamType;
+
+  void Infer(VirtualMachine* vm, InstructionMsg* instr_msg) const override {}
+  void Compute(VirtualMachine* vm, InstructionMsg* instr_msg) const override {
+    Maybe<void> maybe = Error::CheckFailed() << "test error";
+    Global<OneflowVM>::Get()->ReportError(maybe.error());
+  }
+  void Infer(Instruction*) const override { UNIMPLEMENTED(); }
+  void Compute(Instruction*) const override { UNIMPLEMENTED(); }
+};
+COMMAND(RegisterInstructionType<TestReportErrorInstructionType>("TestReportError"));
+
+void NewAsyncOneflowVM() {
+  auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"TestRecord", "TestReportError"});
+  Global<OneflowVM>::New(vm_desc.Get(), true);
+}
+
+TEST(OneflowVM, async_schedule_keeps_order) {
+  NewAsyncOneflowVM();
+  RecordedValues()->clear();
+  const int64_t list_num = 100;
+  FOR_RANGE(int64_t, i, 0, list_num) {
+    OneflowVM::InstructionMsgList list;
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(i * 2));
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(i * 2 + 1));
+    ASSERT_TRUE(Global<OneflowVM>::Get()->Receive(&list).IsOk());
+  }
+  ASSERT_TRUE(Global<OneflowVM>::Get()->Sync().IsOk());
+  ASSERT_EQ(RecordedValues()->size(), list_num * 2);
+  FOR_RANGE(int64_t, i, 0, list_num * 2) { ASSERT_EQ(RecordedValues()->at(i), i); }
+  Global<OneflowVM>::Delete();
+}
+
+TEST(OneflowVM, async_schedule_reports_error_at_sync) {
+  NewAsyncOneflowVM();
+  RecordedValues()->clear();
+  {
+    OneflowVM::InstructionMsgList list;
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(0));
+    list.EmplaceBack(NewInstruction("TestReportError"));
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(1));
+    ASSERT_TRUE(Global<OneflowVM>::Get()->Receive(&list).IsOk());
+  }
+  {
+    OneflowVM::InstructionMsgList list;
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(2));
+    // may already fail with the error, either way its instruction is not run
+    Global<OneflowVM>::Get()->Receive(&list);
+  }
+  const auto& maybe = Global<OneflowVM>::Get()->Sync();
+  ASSERT_FALSE(maybe.IsOk());
+  ASSERT_EQ(maybe.error()->msg(), "test error");
+  // the instructions behind the failed one are not run
+  ASSERT_EQ(*RecordedValues(), std::vector<int64_t>({0}));
+  ASSERT_FALSE(Global<OneflowVM>::Get()->HasScheduleError());
+  Global<OneflowVM>::Delete();
+}
+
+TEST(OneflowVM, async_schedule_clears_error_after_sync) {
+  NewAsyncOneflowVM();
+  RecordedValues()->clear();
+  {
+    OneflowVM::InstructionMsgList list;
+    list.EmplaceBack(NewInstruction("TestReportError"));
+    ASSERT_TRUE(Global<OneflowVM>::Get()->Receive(&list).IsOk());
+  }
+  ASSERT_FALSE(Global<OneflowVM>::Get()->Sync().IsOk());
+  ASSERT_TRUE(Global<OneflowVM>::Get()->Sync().IsOk());
+  {
+    OneflowVM::InstructionMsgList list;
+    list.EmplaceBack(NewInstruction("TestRecord")->add_int64_operand(3));
+    ASSERT_TRUE(Global<OneflowVM>::Get()->Receive(&list).IsOk());
+  }
+  ASSERT_TRUE(Global<OneflowVM>::Get()->Sync().IsOk());
+  ASSERT_EQ(*RecordedValues(), std::vector<int64_t>({3}));
+  Global<OneflowVM>::Delete();
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
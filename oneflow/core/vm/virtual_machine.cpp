@@ -403,6 +403,7 @@ void VirtualMachine::Schedule() {
   if (pending_msg_list().size() > 0) {
     TmpPendingInstrMsgList tmp_pending_msg_list;
     mut_pending_msg_list()->MoveTo(&tmp_pending_msg_list);
+    set_scheduled_instr_msg_cnt(scheduled_instr_msg_cnt() + tmp_pending_msg_list.size());
     FilterAndRunSourceInstructions(&tmp_pending_msg_list);
     NewInstructionList new_instruction_list;
     MakeInstructions(&tmp_pending_msg_list, /*out*/ &new_instruction_list);
@@ -52,6 +52,8 @@ OBJECT_MSG_BEGIN(VirtualMachine);
   OBJECT_MSG_DEFINE_OPTIONAL(VmResourceDesc, vm_resource_desc);
   OBJECT_MSG_DEFINE_STRUCT(Range, machine_id_range);
   OBJECT_MSG_DEFINE_PTR(ObjectMsgAllocator, vm_thread_only_allocator);
+  // instruction msgs taken from pending_msg_list, infer instruction msgs included
+  OBJECT_MSG_DEFINE_OPTIONAL(int64_t, scheduled_instr_msg_cnt);
 
   //links
   OBJECT_MSG_DEFINE_MUTEXED_LIST_HEAD(InstructionMsg, instr_msg_link, pending_msg_list);
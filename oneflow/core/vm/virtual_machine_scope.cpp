@@ -17,13 +17,15 @@ limitations under the License.
 #include "oneflow/core/vm/virtual_machine.msg.h"
 #include "oneflow/core/vm/oneflow_vm.h"
 #include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/job/env_desc.h"
 
 namespace oneflow {
 namespace vm {
 
 VirtualMachineScope::VirtualMachineScope(const Resource& resource) {
   const auto& machine_ctx = *Global<MachineCtx>::Get();
-  Global<OneflowVM>::New(resource, machine_ctx.this_machine_id());
+  Global<OneflowVM>::New(resource, machine_ctx.this_machine_id(),
+                         Global<EnvDesc>::Get()->enable_async_eager_execution());
 }
 
 VirtualMachineScope::~VirtualMachineScope() { Global<OneflowVM>::Delete(); }
@@ -15,10 +15,12 @@ limitations under the License.
 */
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/magazine_object_msg_allocator.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/oneflow_vm.h"
 #include "oneflow/core/vm/instruction.msg.h"
 #include "oneflow/core/vm/instruction.pb.h"
+#include "oneflow/core/vm/instruction_encoding.h"
 #include "oneflow/core/vm/stream_type.h"
 #include "oneflow/core/vm/instruction_type.h"
 #include "oneflow/core/job/resource_desc.h"
@@ -30,7 +32,8 @@ namespace vm {
 using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
 
 ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name) {
-  return ObjectMsgPtr<InstructionMsg>::New(instr_type_name);
+  return ObjectMsgPtr<InstructionMsg>::NewFrom(MagazineObjectMsgAllocator::GlobalAllocator(),
+                                               instr_type_name);
 }
 
 Maybe<void> Run(const std::string& instruction_list_str) {
@@ -43,18 +46,20 @@ Maybe<void> Run(const std::string& instruction_list_str) {
 Maybe<void> Run(const InstructionListProto& instruction_list_proto) {
   InstructionMsgList instr_msg_list;
   for (const auto& instr_proto : instruction_list_proto.instruction()) {
-    auto instr_msg = ObjectMsgPtr<InstructionMsg>::New(instr_proto);
+    auto instr_msg = ObjectMsgPtr<InstructionMsg>::NewFrom(
+        MagazineObjectMsgAllocator::GlobalAllocator(), instr_proto);
     instr_msg_list.EmplaceBack(std::move(instr_msg));
   }
-  auto* oneflow_vm = JUST(GlobalMaybe<OneflowVM>());
-  auto* vm = oneflow_vm->mut_vm();
-  vm->Receive(&instr_msg_list);
-  while (!vm->Empty()) {
-    vm->Schedule();
-    oneflow_vm->TryReceiveAndRun();
-  }
-  return Maybe<void>::Ok();
+  return JUST(GlobalMaybe<OneflowVM>())->Receive(&instr_msg_list);
 }
 
+Maybe<void> RunEncodedInstructions(const int64_t* words, int64_t size) {
+  InstructionMsgList instr_msg_list;
+  JUST(DecodeInstructions(words, size, &instr_msg_list));
+  return JUST(GlobalMaybe<OneflowVM>())->Receive(&instr_msg_list);
+}
+
+Maybe<void> Sync() { return JUST(GlobalMaybe<OneflowVM>())->Sync(); }
+
 }  // namespace vm
 }  // namespace oneflow
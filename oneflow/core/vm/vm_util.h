@@ -29,6 +29,10 @@ ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name);
 
 Maybe<void> Run(const std::string& instruction_list_proto_str);
 Maybe<void> Run(const InstructionListProto& instruction_list_proto);
+// Runs instructions in the flat encoding of instruction_encoding.h.
+Maybe<void> RunEncodedInstructions(const int64_t* words, int64_t size);
+// Waits for the instructions run so far, which matters when the vm schedules asynchronously.
+Maybe<void> Sync();
 
 }  // namespace vm
 }  // namespace oneflow
@@ -0,0 +1,68 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import argparse
+import time
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+parser = argparse.ArgumentParser(description="eager op dispatch throughput")
+parser.add_argument("--device_type", type=str, default="cpu", required=False)
+parser.add_argument("--op_num", type=int, default=1000, required=False)
+parser.add_argument("--iter_num", type=int, default=10, required=False)
+parser.add_argument("--elem_cnt", type=int, default=16, required=False)
+parser.add_argument(
+    "--async_eager_execution",
+    default=False,
+    action="store_true",
+    help="schedule eager instructions on the vm thread",
+)
+args = parser.parse_args()
+
+
+def main():
+    flow.env.enable_async_eager_execution(args.async_eager_execution)
+    flow.enable_eager_execution()
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.mirrored_view())
+
+    @flow.global_function(function_config=func_config)
+    def EagerOpChain(x: oft.ListNumpy.Placeholder((args.elem_cnt,))):
+        with flow.scope.placement(args.device_type, "0:0"):
+            y = x
+            for _ in range(args.op_num):
+                y = flow.math.relu(y)
+            # the only sync point of the job
+            y.numpy(0)
+
+    x = np.random.rand(args.elem_cnt).astype(np.float32)
+    EagerOpChain([x])
+    flow.sync_default_session()
+    start = time.time()
+    for _ in range(args.iter_num):
+        EagerOpChain([x])
+    flow.sync_default_session()
+    duration = time.time() - start
+    print(
+        "async: {}, eager ops per second: {:.1f}".format(
+            args.async_eager_execution, args.op_num * args.iter_num / duration
+        )
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import argparse
+import tempfile
+import time
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+parser = argparse.ArgumentParser(description="step time overhead of summary logging")
+parser.add_argument("--iter_num", type=int, default=200, required=False)
+parser.add_argument("--hidden_size", type=int, default=1024, required=False)
+parser.add_argument("--batch_size", type=int, default=64, required=False)
+parser.add_argument(
+    "--summary_per_step",
+    type=int,
+    default=10,
+    required=False,
+    help="scalars logged by every step, next to one histogram of the output",
+)
+parser.add_argument("--logdir", type=str, default="", required=False)
+args = parser.parse_args()
+
+
+def _make_jobs(logdir):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.mirrored_view())
+    shape = (args.batch_size, args.hidden_size)
+    weight_shape = (args.hidden_size, args.hidden_size)
+
+    def Step(x, w):
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.math.relu(flow.matmul(x, w))
+
+    @flow.global_function(function_config=func_config)
+    def CreateWriter():
+        flow.summary.create_summary_writer(logdir)
+
+    @flow.global_function(function_config=func_config)
+    def StepJob(
+        x: oft.ListNumpy.Placeholder(shape),
+        w: oft.ListNumpy.Placeholder(weight_shape),
+    ):
+        return Step(x, w)
+
+    @flow.global_function(function_config=func_config)
+    def StepWithSummaryJob(
+        x: oft.ListNumpy.Placeholder(shape),
+        w: oft.ListNumpy.Placeholder(weight_shape),
+        step: oft.ListNumpy.Placeholder((1,), dtype=flow.int64),
+        tag: oft.ListNumpy.Placeholder((32,), dtype=flow.int8),
+    ):
+        y = Step(x, w)
+        with flow.scope.placement("cpu", "0:0"):
+            for _ in range(args.summary_per_step):
+                flow.summary.scalar(flow.math.reduce_mean(y), step, tag)
+            flow.summary.histogram(y, step, tag)
+        return y
+
+    @flow.global_function(function_config=func_config)
+    def FlushJob():
+        flow.summary.flush_summary_writer()
+
+    return CreateWriter, StepJob, StepWithSummaryJob, FlushJob
+
+
+def _mean_step_time(run_step):
+    # the first step includes kernel initialization
+    run_step(0)
+    start = time.time()
+    for i in range(args.iter_num):
+        run_step(i + 1)
+    return (time.time() - start) / args.iter_num
+
+
+def main():
+    logdir = args.logdir if args.logdir else tempfile.mkdtemp()
+    CreateWriter, StepJob, StepWithSummaryJob, FlushJob = _make_jobs(logdir)
+    CreateWriter()
+    x = np.random.rand(args.batch_size, args.hidden_size).astype(np.float32)
+    w = np.random.rand(args.hidden_size, args.hidden_size).astype(np.float32)
+    tag = np.fromstring("benchmark", dtype=np.int8)
+
+    def RunStep(i):
+        StepJob([x], [w]).get()
+
+    def RunStepWithSummary(i):
+        step = np.array([i], dtype=np.int64)
+        StepWithSummaryJob([x], [w], [step], [tag]).get()
+
+    step_time = _mean_step_time(RunStep)
+    summary_step_time = _mean_step_time(RunStepWithSummary)
+    # the writer thread may still hold events, their write is not part of the steps
+    FlushJob()
+    print(
+        "step time: {:.3f} ms, with {} scalars and a histogram: {:.3f} ms, "
+        "overhead: {:.1f}%".format(
+            step_time * 1000,
+            args.summary_per_step,
+            summary_step_time * 1000,
+            (summary_step_time / step_time - 1) * 100,
+        )
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -19,6 +19,7 @@ import oneflow.python.eager.blob_cache as blob_cache_util
 import oneflow.python.eager.blob_register as blob_register_util
 import oneflow.python.eager.vm_util as vm_util
 import oneflow.python.framework.blob_trait as blob_trait
+import oneflow.python.framework.c_api_util as c_api_util
 import oneflow.python.framework.python_callback as python_callback
 import oneflow.python.lib.core.async_util as async_util
 
@@ -88,10 +89,17 @@ def FetchTensorBlobAsNumpyList(parallel_size, blob_object):
             )
 
         vm_util.PhysicalRun(BuildFetchBlobBodyInstruction)
+        _RaiseVmError()
 
     return async_util.Await(parallel_size, AsyncFetchBlobBody)
 
 
+def _RaiseVmError():
+    # with async eager execution a fetch behind a failed instruction is skipped and
+    # never calls back, so wait for the vm and raise its error instead
+    c_api_util.SyncVm()
+
+
 def _GetPhysicalBlobHeaderCache(blob_object):
     blob_cache = blob_cache_util.FindOrCreateBlobCache(blob_object)
     return blob_cache.GetHeaderCache(_FetchBlobHeader)
@@ -113,6 +121,7 @@ def _FetchBlobHeader(blob_object):
             )
 
         vm_util.PhysicalRun(BuildFetchBlobHeaderInstruction)
+        _RaiseVmError()
 
     return async_util.Await(1, AsyncFetchBlobHeader)[0]
 
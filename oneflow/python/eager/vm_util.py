@@ -38,6 +38,7 @@ import oneflow.python.framework.python_callback as python_callback
 import oneflow.python.framework.session_context as session_ctx
 from oneflow.python.eager.opkernel_object import OpKernelObject
 import oneflow.python.vm.id_util as vm_id_util
+import oneflow.python.vm.instruction_encoding as instruction_encoding
 
 
 def PhysicalRun(build):
@@ -45,6 +46,7 @@ def PhysicalRun(build):
         build,
         vm_id_util.PhysicalIdGenerator(),
         c_api_util.RunPhysicalInstruction,
+        c_api_util.RunPhysicalEncodedInstruction,
         _ReleasePhysicalObject,
     )
 
@@ -54,19 +56,28 @@ def LogicalRun(build):
         build,
         vm_id_util.LogicalIdGenerator(),
         c_api_util.RunLogicalInstruction,
+        c_api_util.RunLogicalEncodedInstruction,
         _ReleaseLogicalObject,
     )
 
 
-def _Run(build, id_generator, run_api, release_object):
-    instruction_list = session_ctx.GetDefaultSession().instruction_list
-    eager_symbol_list = session_ctx.GetDefaultSession().eager_symbol_list
+def _Run(build, id_generator, run_text_api, run_encoded_api, release_object):
+    sess = session_ctx.GetDefaultSession()
+    instruction_list = sess.instruction_list
+    eager_symbol_list = sess.eager_symbol_list
     build(
         InstructionsBuilder(
             id_generator, release_object, instruction_list, eager_symbol_list
         )
     )
-    run_api(instruction_list, eager_symbol_list)
+    if sess.config_proto.resource.enable_debug_mode:
+        # text format instructions are readable in error messages and logs
+        run_text_api(instruction_list, eager_symbol_list)
+    else:
+        encoded = instruction_encoding.EncodeInstructionListWithTemplate(
+            instruction_list
+        )
+        run_encoded_api(encoded, eager_symbol_list)
     instruction_list.ClearField("instruction")
     eager_symbol_list.ClearField("eager_symbol")
 
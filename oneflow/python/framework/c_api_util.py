@@ -589,6 +589,57 @@ def RunPhysicalInstruction(vm_instruction_list, eager_symbol_list):
         raise JobBuildAndInferError(error)
 
 
+def RunLogicalEncodedInstruction(encoded_instructions, eager_symbol_list):
+    symbols = _EagerSymbolListToString(eager_symbol_list)
+    error_str = oneflow_internal.RunLogicalEncodedInstruction(
+        encoded_instructions, symbols
+    )
+    error = text_format.Parse(error_str, error_util.ErrorProto())
+    if error.HasField("error_type"):
+        raise JobBuildAndInferError(error)
+
+
+def RunPhysicalEncodedInstruction(encoded_instructions, eager_symbol_list):
+    symbols = _EagerSymbolListToString(eager_symbol_list)
+    error_str = oneflow_internal.RunPhysicalEncodedInstruction(
+        encoded_instructions, symbols
+    )
+    error = text_format.Parse(error_str, error_util.ErrorProto())
+    if error.HasField("error_type"):
+        raise JobBuildAndInferError(error)
+
+
+def _EagerSymbolListToString(eager_symbol_list):
+    # symbols are only sent once, so most eager steps have none
+    if len(eager_symbol_list.eager_symbol) == 0:
+        return ""
+    return str(text_format.MessageToString(eager_symbol_list))
+
+
+def GetInstructionOpcode(instr_type_name):
+    opcode, error_str = oneflow_internal.GetInstructionOpcode(instr_type_name)
+    error = text_format.Parse(error_str, error_util.ErrorProto())
+    if error.HasField("error_type"):
+        raise JobBuildAndInferError(error)
+    return opcode
+
+
+def AddInstructionTemplate(template_id, encoded_instructions):
+    error_str = oneflow_internal.AddInstructionTemplate(
+        template_id, encoded_instructions
+    )
+    error = text_format.Parse(error_str, error_util.ErrorProto())
+    if error.HasField("error_type"):
+        raise JobBuildAndInferError(error)
+
+
+def SyncVm():
+    error_str = oneflow_internal.SyncVm()
+    error = text_format.Parse(error_str, error_util.ErrorProto())
+    if error.HasField("error_type"):
+        raise JobBuildAndInferError(error)
+
+
 def CurrentMachineId():
     machine_id, error_str = oneflow_internal.CurrentMachineId()
     error = text_format.Parse(error_str, error_util.ErrorProto())
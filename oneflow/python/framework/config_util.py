@@ -520,6 +520,60 @@ def nccl_fusion_broadcast(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_fusion_broadcast = val
 
 
+@oneflow_export("config.cpu_affinity.actor_thread_affinity")
+def api_actor_thread_affinity(val: str) -> None:
+    r"""Pin cpu actor threads to cpus. Gpu actor threads are pinned next to their device
+    unless val is "none".
+
+    Args:
+        val (str): "none", "numa_node" (all cpus of a numa node, nodes taken round robin)
+            or "core" (one cpu each, spread over numa nodes)
+    """
+    return enable_if.unique([actor_thread_affinity, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def actor_thread_affinity(val):
+    sess = session_ctx.GetDefaultSession()
+    assert val in ("none", "numa_node", "core")
+    sess.config_proto.resource.cpu_affinity_conf.actor_thread_affinity = val
+
+
+@oneflow_export("config.cpu_affinity.thread_pool_affinity")
+def api_thread_pool_affinity(val: str) -> None:
+    r"""Pin the workers of the compute thread pool to cpus.
+
+    Args:
+        val (str): "none", "numa_node" or "core", see actor_thread_affinity
+    """
+    return enable_if.unique([thread_pool_affinity, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_pool_affinity(val):
+    sess = session_ctx.GetDefaultSession()
+    assert val in ("none", "numa_node", "core")
+    sess.config_proto.resource.cpu_affinity_conf.thread_pool_affinity = val
+
+
+@oneflow_export("config.cpu_affinity.numa_aware_host_mem")
+def api_numa_aware_host_mem(val: bool = True) -> None:
+    r"""Whether or not allocate host regst memory on the numa node of the actor thread
+    consuming it. Only takes effect when actor threads are pinned.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([numa_aware_host_mem, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def numa_aware_host_mem(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.cpu_affinity_conf.numa_aware_host_mem = val
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
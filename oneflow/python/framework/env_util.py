@@ -166,6 +166,25 @@ def grpc_use_no_signal(val=True):
     default_env_proto.grpc_use_no_signal = val
 
 
+@oneflow_export("env.enable_async_eager_execution")
+def api_enable_async_eager_execution(val: bool = True) -> None:
+    r"""Run eager instructions on a dedicated vm scheduler thread. Python returns as soon as the
+    instructions are queued and only waits when fetching blobs or calling `flow.sync_default_session`,
+    both wait for all queued instructions. Errors raised by queued instructions are reported at the
+    next sync point, so a blob is never read from behind a failed instruction.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_async_eager_execution, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.env_initialized)
+def enable_async_eager_execution(val=True):
+    assert type(val) is bool
+    default_env_proto.enable_async_eager_execution = val
+
+
 @oneflow_export("env.log_dir")
 def api_log_dir(val: str) -> None:
     r"""Specify a dir to store OneFlow's logging files. If not specified, it is `./log` by default.
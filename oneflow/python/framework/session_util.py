@@ -246,6 +246,8 @@ class Session(object):
             self.cond_var_.wait()
         assert self.running_job_cnt_ == 0
         self.cond_var_.release()
+        # eager instructions may still be queued when the vm schedules asynchronously
+        c_api_util.SyncVm()
 
     def ForceReleaseEagerBlobs(self):
         blob_register_util.GetDefaultBlobRegister().ForceReleaseAll()
@@ -155,6 +155,38 @@ void RunPhysicalInstruction(const std::string& vm_instruction_list,
       .GetDataAndSerializedErrorProto(error_str);
 }
 
+void RunLogicalEncodedInstruction(long* array, int size, const std::string& eager_symbol_list_str,
+                                  std::string* error_str) {
+  static_assert(sizeof(long) == sizeof(int64_t), "");
+  return oneflow::RunLogicalEncodedInstruction(reinterpret_cast<const int64_t*>(array), size,
+                                               eager_symbol_list_str)
+      .GetDataAndSerializedErrorProto(error_str);
+}
+
+void RunPhysicalEncodedInstruction(long* array, int size, const std::string& eager_symbol_list_str,
+                                   std::string* error_str) {
+  static_assert(sizeof(long) == sizeof(int64_t), "");
+  return oneflow::RunPhysicalEncodedInstruction(reinterpret_cast<const int64_t*>(array), size,
+                                                eager_symbol_list_str)
+      .GetDataAndSerializedErrorProto(error_str);
+}
+
+long GetInstructionOpcode(const std::string& instr_type_name, std::string* error_str) {
+  return oneflow::GetInstructionOpcode(instr_type_name)
+      .GetDataAndSerializedErrorProto(error_str, 0LL);
+}
+
+void AddInstructionTemplate(long long template_id, long* array, int size,
+                            std::string* error_str) {
+  return oneflow::AddInstructionTemplate(template_id, reinterpret_cast<const int64_t*>(array),
+                                         size)
+      .GetDataAndSerializedErrorProto(error_str);
+}
+
+void SyncVm(std::string* error_str) {
+  return oneflow::SyncVm().GetDataAndSerializedErrorProto(error_str);
+}
+
 long CurrentMachineId(std::string* error_str) {
   return oneflow::CurrentMachineId().GetDataAndSerializedErrorProto(error_str, 0LL);
 }
@@ -44,6 +44,8 @@ limitations under the License.
 #include "oneflow/core/vm/instruction.pb.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/id_util.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/instruction_encoding.h"
 #include "oneflow/core/eager/eager_util.h"
 #include "oneflow/core/eager/eager_symbol_storage.h"
 
@@ -283,6 +285,26 @@ Maybe<void> RunPhysicalInstruction(const std::string& instruction_list_str,
   return eager::RunPhysicalInstruction(instruction_list_str, eager_symbol_list_str);
 }
 
+Maybe<void> RunLogicalEncodedInstruction(const int64_t* words, int64_t size,
+                                         const std::string& eager_symbol_list_str) {
+  return eager::RunLogicalEncodedInstruction(words, size, eager_symbol_list_str);
+}
+
+Maybe<void> RunPhysicalEncodedInstruction(const int64_t* words, int64_t size,
+                                          const std::string& eager_symbol_list_str) {
+  return eager::RunPhysicalEncodedInstruction(words, size, eager_symbol_list_str);
+}
+
+Maybe<long long> GetInstructionOpcode(const std::string& instr_type_name) {
+  return JUST(vm::LookupInstrOpcode(instr_type_name));
+}
+
+Maybe<void> AddInstructionTemplate(int64_t template_id, const int64_t* words, int64_t size) {
+  return vm::AddInstructionTemplate(template_id, words, size);
+}
+
+Maybe<void> SyncVm() { return vm::Sync(); }
+
 Maybe<long long> CurrentMachineId() {
   CHECK_NOTNULL_OR_RETURN(Global<MachineCtx>::Get());
   return Global<MachineCtx>::Get()->this_machine_id();
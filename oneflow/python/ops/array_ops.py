@@ -99,6 +99,40 @@ def gather(
         )
 
 
+@oneflow_export("embedding_bag")
+def embedding_bag(
+    params: remote_blob_util.BlobDef,
+    indices: remote_blob_util.BlobDef,
+    mode: str = "sum",
+    name: Optional[str] = None,
+) -> remote_blob_util.BlobDef:
+    r"""Gathers the rows of params selected by every row of indices and pools them, without
+    materializing the gathered rows.
+
+    Args:
+        params: A 2-D `Blob` of shape (num_embeddings, embedding_dim).
+        indices: A 2-D `Blob` of shape (num_bags, bag_size). Must be in range [0, num_embeddings).
+        mode: "sum" or "mean", how the rows of a bag are pooled. Defaults to "sum".
+        name: A name for the operation (optional).
+    Returns:
+        A blob of shape (num_bags, embedding_dim). Has the same type as params.
+    """
+    assert mode in ["sum", "mean"]
+    return (
+        flow.user_op_builder(
+            name if name is not None else id_util.UniqueStr("EmbeddingBag_")
+        )
+        .Op("embedding_bag")
+        .Input("weight", [params])
+        .Input("indices", [indices])
+        .Output("out")
+        .Attr("mode", mode)
+        .Build()
+        .InferAndTryRun()
+        .RemoteBlobList()[0]
+    )
+
+
 def infer_shape(x, shape):
     dim_index_need_infer = shape.index(-1) if shape.count(-1) == 1 else None
     in_elem_cnt = reduce(operator.mul, x.shape, 1)
@@ -35,10 +35,13 @@ def OFRecordRawDecoder(
     dtype: dtype_util.dtype,
     dim1_varying_length: bool = False,
     auto_zero_padding: bool = False,
+    dim1_length_buckets: Optional[Sequence[int]] = None,
     name: Optional[str] = None,
 ) -> BlobDef:
     if name is None:
         name = id_util.UniqueStr("OFRecordRawDecoder_")
+    if dim1_length_buckets is None:
+        dim1_length_buckets = []
     return (
         flow.user_op_builder(name)
         .Op("ofrecord_raw_decoder")
@@ -49,6 +52,7 @@ def OFRecordRawDecoder(
         .Attr("data_type", dtype)
         .Attr("dim1_varying_length", dim1_varying_length)
         .Attr("auto_zero_padding", auto_zero_padding)
+        .Attr("dim1_length_buckets", list(dim1_length_buckets))
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -567,6 +571,9 @@ def api_coco_reader(
     random_seed: Optional[int] = None,
     group_by_aspect_ratio: bool = True,
     stride_partition: bool = True,
+    annotation_index_file: str = "",
+    image_reader_num: int = 4,
+    image_prefetch_num: int = 64,
     name: str = None,
 ) -> BlobDef:
     assert name is not None
@@ -580,6 +587,9 @@ def api_coco_reader(
             random_seed=random_seed,
             group_by_aspect_ratio=group_by_aspect_ratio,
             stride_partition=stride_partition,
+            annotation_index_file=annotation_index_file,
+            image_reader_num=image_reader_num,
+            image_prefetch_num=image_prefetch_num,
             name=name,
         ),
     )
@@ -596,6 +606,9 @@ class COCOReader(module_util.Module):
         random_seed: Optional[int] = None,
         group_by_aspect_ratio: bool = True,
         stride_partition: bool = True,
+        annotation_index_file: str = "",
+        image_reader_num: int = 4,
+        image_prefetch_num: int = 64,
         name: str = None,
     ):
         assert name is not None
@@ -619,6 +632,9 @@ class COCOReader(module_util.Module):
             .Attr("random_seed", random_seed)
             .Attr("group_by_ratio", group_by_aspect_ratio)
             .Attr("stride_partition", stride_partition)
+            .Attr("annotation_index_file", annotation_index_file)
+            .Attr("image_reader_num", image_reader_num)
+            .Attr("image_prefetch_num", image_prefetch_num)
             .CheckAndComplete()
         )
         self.op_module_builder.user_op_module.InitOpKernel()
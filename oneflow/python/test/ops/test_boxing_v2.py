@@ -282,3 +282,66 @@ def test_multi_lbi(test_case):
     arg_dict["dst_device_num"] = [1, 2, 3]
     for arg in GenArgList(arg_dict):
         _test_multi_lbi(test_case, *arg)
+
+
+def _test_2n_split_to_split(test_case, src_nodes, dst_nodes, src_axis, dst_axis):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(function_config=func_config)
+    def split_to_split_job(x: oft.Numpy.Placeholder((96, 96))):
+        with flow.scope.placement("cpu", src_nodes):
+            src = flow.identity(x.with_distribute(flow.distribute.split(src_axis)))
+        with flow.scope.placement("cpu", dst_nodes):
+            dst = flow.identity(src.with_distribute(flow.distribute.split(dst_axis)))
+        return dst
+
+    x = np.random.rand(96, 96).astype(np.float32)
+    y = split_to_split_job(x).get().numpy()
+    test_case.assertTrue(np.array_equal(x, y))
+
+
+# several devices per node make the hosts exchange through one transfer per node pair
+@flow.unittest.num_nodes_required(2)
+def test_2n_split_to_split(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["src_nodes"] = [["0:0-1"], ["0:0-1", "1:0-1"]]
+    arg_dict["dst_nodes"] = [["1:0-1"], ["0:0-1", "1:0-1"]]
+    arg_dict["src_axis"] = [0, 1]
+    arg_dict["dst_axis"] = [0, 1]
+    for arg in GenArgList(arg_dict):
+        _test_2n_split_to_split(test_case, *arg)
+
+
+def _test_2n_partial_sum_to_split(test_case, src_nodes, dst_nodes, dst_axis):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(function_config=func_config)
+    def partial_sum_to_split_job(x: oft.Numpy.Placeholder((96, 96, 8))):
+        with flow.scope.placement("cpu", src_nodes):
+            src = flow.identity(x.with_distribute(flow.distribute.split(2)))
+            src = flow.math.reduce_sum(src, axis=2)
+        with flow.scope.placement("cpu", dst_nodes):
+            dst = flow.identity(src.with_distribute(flow.distribute.split(dst_axis)))
+        return dst
+
+    x = np.random.uniform(-1e-5, 1e-5, (96, 96, 8)).astype(np.float32)
+    y = partial_sum_to_split_job(x).get().numpy()
+    test_case.assertTrue(np.allclose(np.sum(x, axis=2), y))
+
+
+@flow.unittest.num_nodes_required(2)
+def test_2n_partial_sum_to_split(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["src_nodes"] = [["0:0-1"], ["0:0-1", "1:0-1"]]
+    arg_dict["dst_nodes"] = [["1:0-1"], ["0:0-1", "1:0-1"]]
+    arg_dict["dst_axis"] = [0, 1]
+    for arg in GenArgList(arg_dict):
+        _test_2n_partial_sum_to_split(test_case, *arg)
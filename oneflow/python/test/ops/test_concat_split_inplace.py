@@ -0,0 +1,188 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import socket
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.core.job.plan_pb2 as plan_pb
+import oneflow.python.framework.env_util as env_util
+from google.protobuf import text_format
+
+# (4, 128) float bodies are 2048 bytes, a multiple of the 512 bytes cuda alignment
+row_num = 4
+col_num = 128
+
+
+def _make_func_config():
+    flow.config.enable_debug_mode(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("gpu", "0:0"))
+    return func_config
+
+
+def _load_merged_plan():
+    # written by the session in debug mode, see Oneflow::Init
+    path = os.path.join(
+        env_util.default_env_proto.cpp_logging_conf.log_dir,
+        socket.gethostname(),
+        "merged_plan",
+    )
+    plan = plan_pb.Plan()
+    with open(path) as f:
+        text_format.Parse(f.read(), plan)
+    return plan
+
+
+class PlanRegsts(object):
+    def __init__(self, plan):
+        self.regst_desc_id2regst_desc = {}
+        self.op_name2exec_node = {}
+        for task in plan.task:
+            for regst_desc in task.produced_regst_desc.values():
+                self.regst_desc_id2regst_desc[regst_desc.regst_desc_id] = regst_desc
+            for exec_node in task.exec_sequence.exec_node:
+                op_name = exec_node.kernel_conf.op_attribute.op_conf.name
+                self.op_name2exec_node[op_name] = exec_node
+
+    def RegstDesc4OpNameAndBn(self, op_name, bn):
+        exec_node = self.op_name2exec_node[op_name]
+        return self.regst_desc_id2regst_desc[exec_node.bn_in_op2regst_desc_id[bn]]
+
+
+def _sub_regst_desc_id2byte_offset(regst_desc):
+    return {
+        sub.regst_desc_id: sub.byte_offset for sub in regst_desc.inplace_sub_regst_desc
+    }
+
+
+def _assert_placed_at(test_case, regst_desc, parent_regst_desc, byte_offset):
+    test_case.assertNotEqual(parent_regst_desc.mem_block_id, -1)
+    test_case.assertEqual(regst_desc.mem_block_id, parent_regst_desc.mem_block_id)
+    test_case.assertEqual(
+        regst_desc.mem_block_offset, parent_regst_desc.mem_block_offset + byte_offset
+    )
+
+
+def test_concat_inputs_in_out_mem_block(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config())
+    def ConcatJob(
+        x: oft.Numpy.Placeholder((row_num, 16)),
+        w0: oft.Numpy.Placeholder((16, col_num)),
+        w1: oft.Numpy.Placeholder((16, col_num)),
+    ):
+        a = flow.matmul(x, w0, name="MatmulA")
+        b = flow.matmul(x, w1, name="MatmulB")
+        return flow.concat([a, b], axis=0, name="Concat")
+
+    x = np.random.uniform(-1, 1, (row_num, 16)).astype(np.float32)
+    w0 = np.random.uniform(-1, 1, (16, col_num)).astype(np.float32)
+    w1 = np.random.uniform(-1, 1, (16, col_num)).astype(np.float32)
+    out = ConcatJob(x, w0, w1).get().numpy()
+    expected = np.concatenate([np.matmul(x, w0), np.matmul(x, w1)], axis=0)
+    test_case.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+
+    regsts = PlanRegsts(_load_merged_plan())
+    out_regst = regsts.RegstDesc4OpNameAndBn("Concat", "out_0")
+    a_regst = regsts.RegstDesc4OpNameAndBn("Concat", "in_0")
+    b_regst = regsts.RegstDesc4OpNameAndBn("Concat", "in_1")
+    sub_offsets = _sub_regst_desc_id2byte_offset(out_regst)
+    test_case.assertEqual(sub_offsets.get(a_regst.regst_desc_id), 0)
+    test_case.assertEqual(sub_offsets.get(b_regst.regst_desc_id), expected.nbytes // 2)
+    _assert_placed_at(test_case, a_regst, out_regst, 0)
+    _assert_placed_at(test_case, b_regst, out_regst, expected.nbytes // 2)
+
+
+def test_concat_input_with_other_consumer(test_case):
+    flow.clear_default_session()
+
+    # b is also read by the sum, so it must keep its own body
+    @flow.global_function(function_config=_make_func_config())
+    def ConcatWithSharedInputJob(
+        x: oft.Numpy.Placeholder((row_num, 16)),
+        w0: oft.Numpy.Placeholder((16, col_num)),
+        w1: oft.Numpy.Placeholder((16, col_num)),
+    ):
+        a = flow.matmul(x, w0, name="MatmulA")
+        b = flow.matmul(x, w1, name="MatmulB")
+        out = flow.concat([a, b], axis=0, name="Concat")
+        return out, flow.math.reduce_sum(b)
+
+    x = np.random.uniform(-1, 1, (row_num, 16)).astype(np.float32)
+    w0 = np.random.uniform(-1, 1, (16, col_num)).astype(np.float32)
+    w1 = np.random.uniform(-1, 1, (16, col_num)).astype(np.float32)
+    out, b_sum = ConcatWithSharedInputJob(x, w0, w1).get()
+    b = np.matmul(x, w1)
+    expected = np.concatenate([np.matmul(x, w0), b], axis=0)
+    test_case.assertTrue(np.allclose(out.numpy(), expected, rtol=1e-4, atol=1e-4))
+    test_case.assertTrue(np.allclose(b_sum.numpy(), np.sum(b), rtol=1e-4, atol=1e-3))
+
+    regsts = PlanRegsts(_load_merged_plan())
+    out_regst = regsts.RegstDesc4OpNameAndBn("Concat", "out_0")
+    a_regst = regsts.RegstDesc4OpNameAndBn("Concat", "in_0")
+    b_regst = regsts.RegstDesc4OpNameAndBn("Concat", "in_1")
+    sub_offsets = _sub_regst_desc_id2byte_offset(out_regst)
+    test_case.assertEqual(sub_offsets.get(a_regst.regst_desc_id), 0)
+    test_case.assertNotIn(b_regst.regst_desc_id, sub_offsets)
+    _assert_placed_at(test_case, a_regst, out_regst, 0)
+
+
+def test_split_like_outputs_in_in_mem_block(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config())
+    def SplitLikeJob(
+        x: oft.Numpy.Placeholder((2 * row_num, 16)),
+        w: oft.Numpy.Placeholder((16, col_num)),
+        like0: oft.Numpy.Placeholder((row_num, col_num)),
+        like1: oft.Numpy.Placeholder((row_num, col_num)),
+    ):
+        y = flow.matmul(x, w, name="Matmul")
+        return (
+            flow.user_op_builder("SplitLike")
+            .Op("split_like")
+            .Input("in", [y])
+            .Input("like", [like0, like1])
+            .Output("out", 2)
+            .Attr("axis", 0)
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()
+        )
+
+    x = np.random.uniform(-1, 1, (2 * row_num, 16)).astype(np.float32)
+    w = np.random.uniform(-1, 1, (16, col_num)).astype(np.float32)
+    like = np.zeros((row_num, col_num), dtype=np.float32)
+    out0, out1 = SplitLikeJob(x, w, like, like).get()
+    y = np.matmul(x, w)
+    test_case.assertTrue(np.allclose(out0.numpy(), y[:row_num], rtol=1e-4, atol=1e-4))
+    test_case.assertTrue(np.allclose(out1.numpy(), y[row_num:], rtol=1e-4, atol=1e-4))
+
+    regsts = PlanRegsts(_load_merged_plan())
+    in_regst = regsts.RegstDesc4OpNameAndBn("SplitLike", "in_0")
+    out_regst = regsts.RegstDesc4OpNameAndBn("SplitLike", "out_0")
+    test_case.assertEqual(
+        regsts.RegstDesc4OpNameAndBn("SplitLike", "out_1").regst_desc_id,
+        out_regst.regst_desc_id,
+    )
+    test_case.assertEqual(
+        out_regst.inplace_consumed_regst_desc_id, in_regst.regst_desc_id
+    )
+    _assert_placed_at(test_case, out_regst, in_regst, 0)
@@ -28,7 +28,7 @@ def compare_with_tensorflow(device_type, params_case, dilations, data_format):
     assert data_format in ["NCHW", "NHWC"]
     out_channels = output_shape[1] if data_format == "NCHW" else output_shape[3]
     in_channels = input_shape[1] if data_format == "NCHW" else input_shape[3]
-    assert device_type in ["gpu"]
+    assert device_type in ["gpu", "cpu"]
 
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
@@ -157,7 +157,7 @@ def compare_with_tensorflow(device_type, params_case, dilations, data_format):
 
 def test_deconv2d_NHWC_1n1c(test_case):
     arg_dict = OrderedDict()
-    arg_dict["device_type"] = ["gpu"]
+    arg_dict["device_type"] = ["gpu", "cpu"]
     # params_case: (input_shape, output_shape, padding, stirdes, kernel_size)
     arg_dict["params_case"] = [
         ((32, 3, 3, 4), (32, 3, 3, 8), "SAME", 1, 3),
@@ -173,7 +173,7 @@ def test_deconv2d_NHWC_1n1c(test_case):
 
 def test_deconv2d_NCHW_1n1c(test_case):
     arg_dict = OrderedDict()
-    arg_dict["device_type"] = ["gpu"]
+    arg_dict["device_type"] = ["gpu", "cpu"]
     # params_case: (input_shape, output_shape, padding, stirdes, kernel_size)
     arg_dict["params_case"] = [
         ((32, 4, 3, 3), (32, 8, 3, 3), "SAME", 1, 3),
@@ -0,0 +1,79 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList
+
+
+def _compare_embedding_bag_with_np(
+    test_case, num_embeddings, num_bags, bag_size, mode
+):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    params = np.random.rand(num_embeddings, 8).astype(np.float32)
+    # small tables repeat indices inside and across bags
+    indices = np.random.randint(
+        low=0, high=num_embeddings, size=(num_bags, bag_size), dtype=np.int32
+    )
+    pooled = params[indices].sum(axis=1)
+    counts = np.zeros((num_embeddings,), dtype=np.float32)
+    np.add.at(counts, indices.reshape(-1), 1)
+    if mode == "mean":
+        pooled /= bag_size
+        counts /= bag_size
+
+    def compare_diff(params_diff_blob):
+        # the loss is sum(out), so every row gets its number of occurrences as diff
+        expected = np.tile(counts[:, np.newaxis], (1, 8))
+        test_case.assertTrue(np.allclose(params_diff_blob.numpy(), expected))
+
+    @flow.global_function(type="train", function_config=func_config)
+    def embedding_bag_job(
+        params_def: oft.Numpy.Placeholder(params.shape),
+        indices_def: oft.Numpy.Placeholder(indices.shape, dtype=flow.int32),
+    ):
+        x = flow.get_variable(
+            "params",
+            shape=params.shape,
+            dtype=flow.float32,
+            initializer=flow.constant_initializer(0),
+        )
+        x = x + params_def
+        y = flow.embedding_bag(x, indices_def, mode=mode)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [1e-3]), momentum=0
+        ).minimize(y)
+        flow.watch_diff(x, compare_diff)
+        return y
+
+    out = embedding_bag_job(params, indices).get().numpy()
+    test_case.assertTrue(np.allclose(out, pooled, rtol=1e-5, atol=1e-5))
+
+
+def test_embedding_bag(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["num_embeddings"] = [5, 1000]
+    arg_dict["num_bags"] = [1, 64]
+    arg_dict["bag_size"] = [1, 7]
+    arg_dict["mode"] = ["sum", "mean"]
+    for arg in GenArgList(arg_dict):
+        _compare_embedding_bag_with_np(test_case, *arg)
@@ -0,0 +1,132 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.python.framework.c_api_util as c_api_util
+
+
+def _make_func_config(enable_fuse_elementwise):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    func_config.enable_fuse_elementwise(enable_fuse_elementwise)
+    return func_config
+
+
+def _op_type_names(job_name):
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("job not found: " + job_name)
+
+
+def _fused_elementwise(inputs, op_types, operand_indices, swap_operands, scalars):
+    return (
+        flow.user_op_builder("FusedElementwise")
+        .Op("fused_elementwise")
+        .Input("in", inputs)
+        .Output("out")
+        .Attr("op_types", op_types)
+        .Attr("operand_indices", operand_indices)
+        .Attr("swap_operands", swap_operands)
+        .Attr("scalar_operands", scalars)
+        .Attr("out_data_type", flow.float)
+        .Build()
+        .InferAndTryRun()
+        .RemoteBlobList()[0]
+    )
+
+
+def test_fused_elementwise_repeated_operand(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config(False))
+    def FusedJob(x: oft.Numpy.Placeholder((4, 5))):
+        # relu(x) + x, then * x, both read x which is in_0
+        return _fused_elementwise(
+            [x], ["relu", "add_n", "broadcast_mul"], [-1, 0, 0], [0, 0, 0], [0.0] * 3
+        )
+
+    x = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    y = FusedJob(x).get().numpy()
+    test_case.assertTrue(np.allclose(y, (np.maximum(x, 0) + x) * x, atol=1e-6))
+
+
+def test_fused_elementwise_scalar_operand(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config(False))
+    def FusedJob(x: oft.Numpy.Placeholder((4, 5)), s: oft.Numpy.Placeholder((1,))):
+        return _fused_elementwise(
+            [x, s],
+            ["broadcast_mul", "scalar_add", "scalar_mul"],
+            [1, -1, -1],
+            [0, 0, 0],
+            [0.0, 2.5, -3.0],
+        )
+
+    x = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    s = np.array([1.5], dtype=np.float32)
+    y = FusedJob(x, s).get().numpy()
+    test_case.assertTrue(np.allclose(y, (x * s + 2.5) * -3.0, atol=1e-5))
+
+
+def test_fused_elementwise_swapped_operand(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config(False))
+    def FusedJob(x: oft.Numpy.Placeholder((4, 5)), y: oft.Numpy.Placeholder((4, 5))):
+        return _fused_elementwise(
+            [x, y], ["broadcast_sub", "broadcast_div"], [1, 1], [1, 1], [0.0, 0.0]
+        )
+
+    x = np.random.uniform(0, 1, (4, 5)).astype(np.float32)
+    y = np.random.uniform(2, 3, (4, 5)).astype(np.float32)
+    z = FusedJob(x, y).get().numpy()
+    test_case.assertTrue(np.allclose(z, y / (y - x), atol=1e-5))
+
+
+def _run_elementwise_chain(enable_fuse_elementwise, x, y):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config(enable_fuse_elementwise))
+    def ChainJob(x: oft.Numpy.Placeholder((4, 5)), y: oft.Numpy.Placeholder((4, 5))):
+        # relu(x) + x repeats the chain input, y - relu(x) swaps the binary operands
+        a = flow.math.add(flow.math.relu(x), x)
+        b = flow.math.multiply(flow.math.subtract(y, flow.math.relu(a)), 2.0)
+        return flow.math.add(b, 0.5)
+
+    return ChainJob(x, y).get().numpy(), _op_type_names("ChainJob")
+
+
+def test_fuse_elementwise_pass(test_case):
+    x = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    y = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    fused, fused_op_types = _run_elementwise_chain(True, x, y)
+    unfused, unfused_op_types = _run_elementwise_chain(False, x, y)
+    a = np.maximum(x, 0) + x
+    expected = (y - np.maximum(a, 0)) * 2.0 + 0.5
+    test_case.assertTrue(np.allclose(fused, unfused, atol=1e-6))
+    test_case.assertTrue(np.allclose(fused, expected, atol=1e-5))
+    # the whole chain is one op
+    test_case.assertEqual(fused_op_types.count("fused_elementwise"), 1)
+    test_case.assertNotIn("relu", fused_op_types)
+    test_case.assertNotIn("fused_elementwise", unfused_op_types)
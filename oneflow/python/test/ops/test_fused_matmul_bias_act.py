@@ -0,0 +1,135 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.python.framework.c_api_util as c_api_util
+
+
+def _make_func_config(enable_fuse_matmul_bias_act):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    func_config.enable_fuse_matmul_bias_act(enable_fuse_matmul_bias_act)
+    return func_config
+
+
+def _matmul_bias_act(a, b, bias, transpose_a, transpose_b, activation):
+    out = flow.nn.bias_add(
+        flow.matmul(a, b, transpose_a=transpose_a, transpose_b=transpose_b), bias
+    )
+    if activation == "relu":
+        return flow.math.relu(out)
+    if activation == "gelu":
+        return flow.math.gelu(out)
+    return out
+
+
+def _op_type_names(job_name):
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("job not found: " + job_name)
+
+
+def _compare_fused_kernel(test_case, m, transpose_a, transpose_b, activation):
+    flow.clear_default_session()
+    a_shape = (4, m) if transpose_a else (m, 4)
+    b_shape = (5, 4) if transpose_b else (4, 5)
+
+    @flow.global_function(function_config=_make_func_config(False))
+    def FusedMatmulBiasActJob(
+        a: oft.Numpy.Placeholder(a_shape),
+        b: oft.Numpy.Placeholder(b_shape),
+        bias: oft.Numpy.Placeholder((5,)),
+    ):
+        fused = (
+            flow.user_op_builder("FusedMatmulBiasAct")
+            .Op("fused_matmul_bias_act")
+            .Input("a", [a])
+            .Input("b", [b])
+            .Input("bias", [bias])
+            .Output("out")
+            .Attr("transpose_a", transpose_a)
+            .Attr("transpose_b", transpose_b)
+            .Attr("activation", activation)
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()[0]
+        )
+        return fused, _matmul_bias_act(a, b, bias, transpose_a, transpose_b, activation)
+
+    a = np.random.uniform(-1, 1, a_shape).astype(np.float32)
+    b = np.random.uniform(-1, 1, b_shape).astype(np.float32)
+    bias = np.random.uniform(-1, 1, (5,)).astype(np.float32)
+    fused, unfused = FusedMatmulBiasActJob(a, b, bias).get()
+    test_case.assertTrue(np.allclose(fused.numpy(), unfused.numpy(), atol=1e-5))
+
+
+def test_fused_matmul_bias_act_kernel(test_case):
+    # 70 rows are three blocks of 32 rows for the kernel, the last one partial
+    for m in [3, 70]:
+        for transpose_a in [False, True]:
+            for transpose_b in [False, True]:
+                for activation in ["none", "relu", "gelu"]:
+                    _compare_fused_kernel(
+                        test_case, m, transpose_a, transpose_b, activation
+                    )
+
+
+def test_fuse_matmul_bias_act_pass(test_case):
+    flow.clear_default_session()
+    a = np.random.uniform(-1, 1, (3, 4)).astype(np.float32)
+    b = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    bias = np.random.uniform(-1, 1, (5,)).astype(np.float32)
+    expected = np.maximum(np.matmul(a, b) + bias, 0)
+
+    @flow.global_function(function_config=_make_func_config(True))
+    def SoleConsumerJob(
+        a: oft.Numpy.Placeholder((3, 4)),
+        b: oft.Numpy.Placeholder((4, 5)),
+        bias: oft.Numpy.Placeholder((5,)),
+    ):
+        return _matmul_bias_act(a, b, bias, False, False, "relu")
+
+    # the matmul output is also read by the sum, so it must stay
+    @flow.global_function(function_config=_make_func_config(True))
+    def MultiConsumerJob(
+        a: oft.Numpy.Placeholder((3, 4)),
+        b: oft.Numpy.Placeholder((4, 5)),
+        bias: oft.Numpy.Placeholder((5,)),
+    ):
+        matmul_out = flow.matmul(a, b)
+        out = flow.math.relu(flow.nn.bias_add(matmul_out, bias))
+        return out, flow.math.reduce_sum(matmul_out)
+
+    sole_out = SoleConsumerJob(a, b, bias).get().numpy()
+    multi_out, matmul_sum = MultiConsumerJob(a, b, bias).get()
+    test_case.assertTrue(np.allclose(sole_out, expected, atol=1e-5))
+    test_case.assertTrue(np.allclose(multi_out.numpy(), expected, atol=1e-5))
+    test_case.assertTrue(
+        np.allclose(matmul_sum.numpy(), np.sum(np.matmul(a, b)), atol=1e-4)
+    )
+    sole_op_types = _op_type_names("SoleConsumerJob")
+    test_case.assertIn("fused_matmul_bias_act", sole_op_types)
+    test_case.assertNotIn("matmul", sole_op_types)
+    multi_op_types = _op_type_names("MultiConsumerJob")
+    test_case.assertNotIn("fused_matmul_bias_act", multi_op_types)
+    test_case.assertIn("matmul", multi_op_types)
@@ -0,0 +1,75 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from collections import OrderedDict
+import oneflow as flow
+import oneflow.core.vm.instruction_pb2 as instr_util
+import oneflow.python.vm.instruction_encoding as instruction_encoding
+
+# parallel desc symbol ids no eager op uses, so every test has signatures of its own
+parallel_desc_symbol_id_base = 1 << 40
+
+
+def _MakeInstructionList(parallel_desc_symbol_id, object_id, ref_object_id):
+    instruction_list = instr_util.InstructionListProto()
+    new_object = instruction_list.instruction.add()
+    new_object.instr_type_name = "NewObject"
+    new_object.parallel_desc_symbol_id = parallel_desc_symbol_id
+    new_object.operand.add().int64_operand = object_id
+    delete_object = instruction_list.instruction.add()
+    delete_object.instr_type_name = "DeleteObject"
+    delete_object.parallel_desc_symbol_id = parallel_desc_symbol_id
+    mut_operand = delete_object.operand.add().mut_operand
+    mut_operand.logical_object_id = ref_object_id
+    mut_operand.all_mirrored_object.SetInParent()
+    return instruction_list
+
+
+def _IsInstantiation(words):
+    return words[0] == instruction_encoding._kInstantiateTemplateOpcode
+
+
+def test_instruction_template_hit_on_second_build(test_case):
+    parallel_desc_symbol_id = parallel_desc_symbol_id_base + 1
+    first = instruction_encoding.EncodeInstructionListWithTemplate(
+        _MakeInstructionList(parallel_desc_symbol_id, 101, 101)
+    )
+    test_case.assertFalse(_IsInstantiation(first))
+    second = instruction_encoding.EncodeInstructionListWithTemplate(
+        _MakeInstructionList(parallel_desc_symbol_id, 103, 103)
+    )
+    test_case.assertTrue(_IsInstantiation(second))
+    # template id, one arg for the object both instructions refer to
+    test_case.assertEqual(second[2:].tolist(), [1, 103])
+    third = instruction_encoding.EncodeInstructionListWithTemplate(
+        _MakeInstructionList(parallel_desc_symbol_id, 105, 105)
+    )
+    test_case.assertEqual(third[1], second[1])
+    test_case.assertEqual(third[2:].tolist(), [1, 105])
+
+
+def test_instruction_template_keeps_operand_aliasing(test_case):
+    parallel_desc_symbol_id = parallel_desc_symbol_id_base + 2
+    # two different objects are another signature than one object used twice
+    for _ in range(2):
+        words = instruction_encoding.EncodeInstructionListWithTemplate(
+            _MakeInstructionList(parallel_desc_symbol_id, 107, 109)
+        )
+    test_case.assertTrue(_IsInstantiation(words))
+    test_case.assertEqual(words[2:].tolist(), [2, 107, 109])
+    words = instruction_encoding.EncodeInstructionListWithTemplate(
+        _MakeInstructionList(parallel_desc_symbol_id, 111, 111)
+    )
+    test_case.assertFalse(_IsInstantiation(words))
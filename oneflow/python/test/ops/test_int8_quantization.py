@@ -0,0 +1,234 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import tempfile
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.python.framework.c_api_util as c_api_util
+
+# inputs are drawn from [-1, 1), so the calibrated uint8 parameters are known up front
+in_scale = 2.0 / 255
+in_zero_point = 128
+
+
+def _make_func_config():
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    return func_config
+
+
+def _get_weight(name, shape):
+    return flow.get_variable(
+        name,
+        shape=shape,
+        dtype=flow.float,
+        initializer=flow.random_uniform_initializer(-1, 1),
+    )
+
+
+def _quantize(x, name):
+    return (
+        flow.user_op_builder(name)
+        .Op("quantize")
+        .Input("in", [x])
+        .Output("out")
+        .Attr("scale", in_scale)
+        .Attr("zero_point", in_zero_point)
+        .Build()
+        .InferAndTryRun()
+        .RemoteBlobList()[0]
+    )
+
+
+def _quantize_weight(w, axis, name):
+    return (
+        flow.user_op_builder(name)
+        .Op("quantize_weight")
+        .Input("in", [w])
+        .Output("out")
+        .Output("scale")
+        .Attr("axis", axis)
+        .Build()
+        .InferAndTryRun()
+        .RemoteBlobList()
+    )
+
+
+def _op_type_names(job_name):
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("job not found: " + job_name)
+
+
+def _assert_close_to_float(test_case, int8_out, float_out):
+    # the int8 error grows with the reduction size, which stays small here
+    test_case.assertTrue(np.allclose(int8_out, float_out, rtol=5e-2, atol=5e-2))
+
+
+def test_quantized_matmul(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config())
+    def QuantizedMatmulJob(
+        a: oft.Numpy.Placeholder((8, 16)), b: oft.Numpy.Placeholder((16, 6))
+    ):
+        bias = _get_weight("bias", (6,))
+        b_int8, b_scale = _quantize_weight(b, 1, "QuantizeWeight")
+        out = (
+            flow.user_op_builder("QuantizedMatmul")
+            .Op("quantized_matmul")
+            .Input("a", [_quantize(a, "Quantize")])
+            .Input("b", [b_int8])
+            .Input("b_scale", [b_scale])
+            .Input("bias", [bias])
+            .Output("out")
+            .Attr("transpose_b", False)
+            .Attr("a_scale", in_scale)
+            .Attr("a_zero_point", in_zero_point)
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()[0]
+        )
+        return out, flow.nn.bias_add(flow.matmul(a, b), bias)
+
+    # b changes between the runs, so nothing quantized by the first one may be reused
+    for _ in range(2):
+        a = np.random.uniform(-1, 1, (8, 16)).astype(np.float32)
+        b = np.random.uniform(-1, 1, (16, 6)).astype(np.float32)
+        int8_out, float_out = QuantizedMatmulJob(a, b).get()
+        _assert_close_to_float(test_case, int8_out.numpy(), float_out.numpy())
+
+
+def test_quantized_conv2d(test_case):
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config())
+    def QuantizedConv2dJob(x: oft.Numpy.Placeholder((2, 3, 7, 7))):
+        weight = _get_weight("weight", (4, 3, 3, 3))
+        weight_int8, weight_scale = _quantize_weight(weight, 0, "QuantizeWeight")
+        out = (
+            flow.user_op_builder("QuantizedConv2d")
+            .Op("quantized_conv2d")
+            .Input("in", [_quantize(x, "Quantize")])
+            .Input("weight", [weight_int8])
+            .Input("weight_scale", [weight_scale])
+            .Output("out")
+            .Attr("filters", 4)
+            .Attr("padding_before", [1, 1])
+            .Attr("kernel_size", [3, 3])
+            .Attr("strides", [2, 2])
+            .Attr("dilation_rate", [1, 1])
+            .Attr("in_scale", in_scale)
+            .Attr("in_zero_point", in_zero_point)
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()[0]
+        )
+        return out, flow.nn.conv2d(x, weight, strides=2, padding="SAME")
+
+    for _ in range(2):
+        x = np.random.uniform(-1, 1, (2, 3, 7, 7)).astype(np.float32)
+        int8_out, float_out = QuantizedConv2dJob(x).get()
+        test_case.assertEqual(int8_out.numpy().shape, (2, 4, 4, 4))
+        _assert_close_to_float(test_case, int8_out.numpy(), float_out.numpy())
+
+
+def _run_calibration_round_trip(test_case, calibration_dir):
+    def MakeInt8FuncConfig(int8_calibration):
+        func_config = _make_func_config()
+        func_config.int8_calibration_dir(calibration_dir)
+        func_config.int8_calibration(int8_calibration)
+        return func_config
+
+    def Model(a, x):
+        b = _get_weight("b", (16, 6))
+        weight = _get_weight("weight", (4, 3, 3, 3))
+        matmul_out = flow.matmul(a, b)
+        # b of this matmul is no variable, so it stays in float
+        activation_matmul_out = flow.matmul(a, flow.math.relu(b))
+        conv_out = flow.nn.conv2d(x, weight, strides=1, padding="SAME")
+        return matmul_out, activation_matmul_out, conv_out, b, weight
+
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=MakeInt8FuncConfig(True))
+    def CalibrationJob(
+        a: oft.Numpy.Placeholder((8, 16)), x: oft.Numpy.Placeholder((2, 3, 5, 5))
+    ):
+        return Model(a, x)
+
+    for _ in range(3):
+        CalibrationJob(
+            np.random.uniform(-1, 1, (8, 16)).astype(np.float32),
+            np.random.uniform(-1, 1, (2, 3, 5, 5)).astype(np.float32),
+        ).get()
+    test_case.assertTrue(len(os.listdir(calibration_dir)) >= 2)
+    test_case.assertIn("min_max_observer", _op_type_names("CalibrationJob"))
+
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=MakeInt8FuncConfig(False))
+    def Int8Job(
+        a: oft.Numpy.Placeholder((8, 16)), x: oft.Numpy.Placeholder((2, 3, 5, 5))
+    ):
+        return Model(a, x)
+
+    a = np.random.uniform(-1, 1, (8, 16)).astype(np.float32)
+    x = np.random.uniform(-1, 1, (2, 3, 5, 5)).astype(np.float32)
+    matmul_out, activation_matmul_out, conv_out, b, weight = Int8Job(a, x).get()
+    op_types = _op_type_names("Int8Job")
+    test_case.assertEqual(op_types.count("quantized_matmul"), 1)
+    test_case.assertEqual(op_types.count("matmul"), 1)
+    test_case.assertIn("quantized_conv2d", op_types)
+    test_case.assertNotIn("conv2d", op_types)
+    _assert_close_to_float(test_case, matmul_out.numpy(), np.matmul(a, b.numpy()))
+    test_case.assertTrue(
+        np.allclose(
+            activation_matmul_out.numpy(),
+            np.matmul(a, np.maximum(b.numpy(), 0)),
+            atol=1e-5,
+        )
+    )
+
+    # compare against the float conv of the same weight
+    flow.clear_default_session()
+
+    @flow.global_function(function_config=_make_func_config())
+    def FloatConv2dJob(
+        x: oft.Numpy.Placeholder((2, 3, 5, 5)),
+        weight: oft.Numpy.Placeholder((4, 3, 3, 3)),
+    ):
+        return flow.nn.conv2d(x, weight, strides=1, padding="SAME")
+
+    float_conv_out = FloatConv2dJob(x, weight.numpy()).get().numpy()
+    _assert_close_to_float(test_case, conv_out.numpy(), float_conv_out)
+
+
+def test_int8_calibration_round_trip(test_case):
+    calibration_dir = tempfile.mkdtemp()
+    try:
+        _run_calibration_round_trip(test_case, calibration_dir)
+    finally:
+        shutil.rmtree(calibration_dir)
@@ -0,0 +1,104 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.python.framework.c_api_util as c_api_util
+
+
+def _make_optimizer(name):
+    lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [0.01])
+    if name == "sgd":
+        return flow.optimizer.SGD(lr_scheduler, momentum=0)
+    elif name == "momentum":
+        return flow.optimizer.SGD(lr_scheduler, momentum=0.9)
+    elif name == "rmsprop":
+        return flow.optimizer.RMSProp(lr_scheduler)
+    elif name == "lars":
+        return flow.optimizer.LARS(lr_scheduler)
+    elif name == "adam":
+        return flow.optimizer.Adam(lr_scheduler, do_bias_correction=True)
+    else:
+        raise NotImplementedError
+
+
+def _op_types(job_name):
+    # user op type names, or the op_conf field for system ops like naive_model_update
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                if op.HasField("user_conf")
+                else op.WhichOneof("op_type")
+                for op in job.net.op
+            ]
+    raise ValueError("job not found: " + job_name)
+
+
+def _train_and_get_variables(optimizer_name, x, enable_multi_tensor, step_num):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(1)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    func_config.enable_multi_tensor_model_update(enable_multi_tensor)
+
+    def _get_variables():
+        w = flow.get_variable(
+            "w", shape=(x.shape[1], 7), initializer=flow.constant_initializer(0.5)
+        )
+        b = flow.get_variable(
+            "b", shape=(7,), initializer=flow.constant_initializer(0.1)
+        )
+        return w, b
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x_def: oft.Numpy.Placeholder(x.shape)):
+        w, b = _get_variables()
+        loss = flow.math.reduce_sum(flow.math.square(flow.matmul(x_def, w) + b))
+        _make_optimizer(optimizer_name).minimize(loss)
+        return loss
+
+    @flow.global_function(function_config=func_config)
+    def eval_job():
+        return _get_variables()
+
+    for _ in range(step_num):
+        train_job(x).get()
+    variables = [blob.numpy() for blob in eval_job().get()]
+    return variables, _op_types("train_job")
+
+
+def _compare_with_separate_update(test_case, optimizer_name):
+    x = np.random.uniform(low=-1, high=1, size=(4, 5)).astype(np.float32)
+    separate, separate_op_types = _train_and_get_variables(optimizer_name, x, False, 3)
+    fused, fused_op_types = _train_and_get_variables(optimizer_name, x, True, 3)
+    # w and b are updated by one op instead of one model update op each
+    test_case.assertEqual(fused_op_types.count("multi_tensor_model_update"), 1)
+    test_case.assertFalse(
+        any(op_type.endswith("model_update_conf") for op_type in fused_op_types),
+        optimizer_name,
+    )
+    test_case.assertEqual(
+        sum(op_type.endswith("model_update_conf") for op_type in separate_op_types), 2
+    )
+    for separate_var, fused_var in zip(separate, fused):
+        test_case.assertTrue(np.allclose(separate_var, fused_var, rtol=1e-4, atol=1e-5))
+
+
+def test_multi_tensor_model_update(test_case):
+    for optimizer_name in ["sgd", "momentum", "rmsprop", "lars", "adam"]:
+        _compare_with_separate_update(test_case, optimizer_name)
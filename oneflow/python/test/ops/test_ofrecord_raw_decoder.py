@@ -0,0 +1,106 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import struct
+import tempfile
+
+import numpy as np
+import oneflow as flow
+import oneflow.core.record.record_pb2 as record_pb
+
+batch_size = 2
+max_length = 8
+buckets = [2, 4, 8]
+# the longest sample of the three batches picks the buckets 2, 4 and 8
+sample_lengths = [1, 2, 3, 1, 5, 8]
+
+
+def _make_samples():
+    return [
+        np.random.uniform(-1, 1, (length,)).astype(np.float32)
+        for length in sample_lengths
+    ]
+
+
+def _write_ofrecord_part(data_dir, samples):
+    # every record is prefixed by its int64 byte size, see OFRecordDataset
+    with open(os.path.join(data_dir, "part-0"), "wb") as f:
+        for sample in samples:
+            record = record_pb.OFRecord()
+            record.feature["x"].float_list.value.extend(sample.tolist())
+            serialized = record.SerializeToString()
+            f.write(struct.pack("q", len(serialized)))
+            f.write(serialized)
+
+
+def _decode_batches(data_dir, dim1_length_buckets):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    @flow.global_function(function_config=func_config)
+    def DecodeJob():
+        ofrecord = flow.data.ofrecord_reader(
+            data_dir, batch_size=batch_size, data_part_num=1, random_shuffle=False
+        )
+        return flow.data.OFRecordRawDecoder(
+            ofrecord,
+            "x",
+            shape=(max_length,),
+            dtype=flow.float,
+            auto_zero_padding=True,
+            dim1_length_buckets=dim1_length_buckets,
+        )
+
+    return [DecodeJob().get().numpy() for _ in range(len(sample_lengths) // batch_size)]
+
+
+def _expected_batch(samples, length):
+    batch = np.zeros((len(samples), length), dtype=np.float32)
+    for i, sample in enumerate(samples):
+        batch[i, : sample.size] = sample
+    return batch
+
+
+def _run_decoder_test(test_case, data_dir, dim1_length_buckets, expected_lengths):
+    samples = _make_samples()
+    _write_ofrecord_part(data_dir, samples)
+    batches = _decode_batches(data_dir, dim1_length_buckets)
+    for i, (batch, length) in enumerate(zip(batches, expected_lengths)):
+        test_case.assertEqual(batch.shape, (batch_size, length))
+        expected = _expected_batch(
+            samples[i * batch_size : (i + 1) * batch_size], length
+        )
+        test_case.assertTrue(np.array_equal(batch, expected))
+
+
+def test_ofrecord_raw_decoder_length_buckets(test_case):
+    data_dir = tempfile.mkdtemp()
+    try:
+        _run_decoder_test(test_case, data_dir, buckets, [2, 4, 8])
+    finally:
+        shutil.rmtree(data_dir)
+
+
+def test_ofrecord_raw_decoder_static_padding(test_case):
+    data_dir = tempfile.mkdtemp()
+    try:
+        # without buckets every batch is padded up to the static length
+        _run_decoder_test(test_case, data_dir, None, [max_length] * 3)
+    finally:
+        shutil.rmtree(data_dir)
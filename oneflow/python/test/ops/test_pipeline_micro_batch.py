@@ -0,0 +1,142 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import socket
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.core.job.plan_pb2 as plan_pb
+import oneflow.python.framework.env_util as env_util
+from google.protobuf import text_format
+
+batch_size = 8
+in_features = 6
+hidden_features = 4
+
+
+def _train_losses(micro_batch_num, xs, labels, scale):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    # writes the merged plan and the log read by the checks below
+    flow.config.enable_debug_mode(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.pipeline_num_micro_batches(micro_batch_num)
+
+    # two placements make two pipeline stages
+    @flow.global_function(type="train", function_config=func_config)
+    def PipelineJob(
+        x: oft.Numpy.Placeholder((batch_size, in_features)),
+        label: oft.Numpy.Placeholder((batch_size, 1)),
+        loss_scale: oft.Numpy.Placeholder((1,), batch_axis=None),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            w0 = flow.get_variable(
+                "w0",
+                shape=(in_features, hidden_features),
+                initializer=flow.constant_initializer(0.1),
+            )
+            hidden = flow.math.relu(flow.matmul(x, w0), name="Stage0Relu")
+        with flow.scope.placement("cpu", "0:1"):
+            w1 = flow.get_variable(
+                "w1",
+                shape=(hidden_features, 1),
+                initializer=flow.constant_initializer(0.2),
+            )
+            # the constant has no batch axis, so it is repeated rather than unpacked
+            bias = flow.constant(0.5, dtype=flow.float, shape=(1,))
+            out = flow.matmul(hidden, w1, name="Stage1Matmul") + bias
+            loss = flow.math.reduce_mean(flow.math.square(out - label)) * loss_scale
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    return [PipelineJob(x, label, scale).get().numpy() for x, label in zip(xs, labels)]
+
+
+def test_pipeline_micro_batch_loss(test_case):
+    xs = [
+        np.random.uniform(-1, 1, (batch_size, in_features)).astype(np.float32)
+        for _ in range(3)
+    ]
+    labels = [
+        np.random.uniform(-1, 1, (batch_size, 1)).astype(np.float32) for _ in range(3)
+    ]
+    scale = np.array([2.0], dtype=np.float32)
+    losses = _train_losses(1, xs, labels, scale)
+    micro_batch_num = 2
+    pipelined_losses = _train_losses(micro_batch_num, xs, labels, scale)
+    for loss, pipelined_loss in zip(losses, pipelined_losses):
+        # the fetched loss is packed back with one value per micro batch
+        test_case.assertEqual(pipelined_loss.shape, (micro_batch_num,))
+        test_case.assertTrue(
+            np.allclose(np.mean(pipelined_loss), loss, rtol=1e-4, atol=1e-5)
+        )
+
+
+def _log_path(name):
+    # glog files of the session, see InitLogging
+    return os.path.join(
+        env_util.default_env_proto.cpp_logging_conf.log_dir,
+        socket.gethostname(),
+        name,
+    )
+
+
+def _load_merged_plan():
+    plan = plan_pb.Plan()
+    with open(_log_path("merged_plan")) as f:
+        text_format.Parse(f.read(), plan)
+    return plan
+
+
+def _register_num4op_name_and_bn(plan, op_name, bn):
+    regst_desc_id2regst_desc = {}
+    regst_desc_id = None
+    for task in plan.task:
+        for regst_desc in task.produced_regst_desc.values():
+            regst_desc_id2regst_desc[regst_desc.regst_desc_id] = regst_desc
+        for exec_node in task.exec_sequence.exec_node:
+            if exec_node.kernel_conf.op_attribute.op_conf.name == op_name:
+                regst_desc_id = exec_node.bn_in_op2regst_desc_id[bn]
+    return regst_desc_id2regst_desc[regst_desc_id].register_num
+
+
+def test_pipeline_stage_register_num(test_case):
+    xs = [np.random.uniform(-1, 1, (batch_size, in_features)).astype(np.float32)]
+    labels = [np.random.uniform(-1, 1, (batch_size, 1)).astype(np.float32)]
+    scale = np.array([1.0], dtype=np.float32)
+    stage_num = 2
+    micro_batch_num = 4
+    _train_losses(micro_batch_num, xs, labels, scale)
+    plan = _load_merged_plan()
+    # stage k keeps the activations of stage_num - k micro batches in flight
+    test_case.assertEqual(
+        _register_num4op_name_and_bn(plan, "Stage0Relu", "out_0"), stage_num
+    )
+    test_case.assertEqual(
+        _register_num4op_name_and_bn(plan, "Stage1Matmul", "out_0"), stage_num - 1
+    )
+    with open(_log_path("oneflow.INFO")) as f:
+        log = f.read()
+    # (stage_num - 1) / (micro_batch_num + stage_num - 1)
+    test_case.assertIn(
+        "pipeline of job PipelineJob: 2 stages, 4 micro batches, "
+        "1F1B bubble fraction 0.2",
+        log,
+    )
@@ -0,0 +1,184 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import tensorflow as tf
+from test_util import GenArgList
+import oneflow.typing as oft
+
+# batch and channels above one, so the cpu kernels split the work between threads
+pool_confs = [
+    # 2x2 windows fully inside the input
+    {
+        "x_shape": (4, 8, 12, 12),
+        "ksize": 2,
+        "strides": 2,
+        "padding": "VALID",
+        "data_format": "NCHW",
+    },
+    # 3x3 windows, clipped on the borders only
+    {
+        "x_shape": (2, 16, 9, 9),
+        "ksize": 3,
+        "strides": 1,
+        "padding": "SAME",
+        "data_format": "NCHW",
+    },
+    {
+        "x_shape": (2, 3, 10, 10),
+        "ksize": 4,
+        "strides": 3,
+        "padding": "SAME",
+        "data_format": "NCHW",
+    },
+    # more than one 64-channel block in backward
+    {
+        "x_shape": (2, 10, 10, 130),
+        "ksize": 3,
+        "strides": 2,
+        "padding": "SAME",
+        "data_format": "NHWC",
+    },
+    {
+        "x_shape": (3, 8, 8, 70),
+        "ksize": 2,
+        "strides": 2,
+        "padding": "VALID",
+        "data_format": "NHWC",
+    },
+    {
+        "x_shape": (2, 4, 6, 6, 6),
+        "ksize": 2,
+        "strides": 2,
+        "padding": "VALID",
+        "data_format": "NCDHW",
+    },
+]
+
+
+def _run_pooling_job(x, pooling_type, ksize, strides, padding, data_format, check_dx):
+    flow.clear_default_session()
+    dim = x.ndim - 2
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def PoolingJob(x: oft.Numpy.Placeholder(x.shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            v = flow.get_variable(
+                "x",
+                shape=x.shape,
+                dtype=flow.float,
+                initializer=flow.constant_initializer(0),
+                trainable=True,
+            )
+            flow.watch_diff(v, check_dx)
+            pooling_f = getattr(flow.nn, "{}_pool{}d".format(pooling_type.lower(), dim))
+            y = pooling_f(
+                x + v,
+                ksize=ksize,
+                strides=strides,
+                padding=padding,
+                data_format=data_format,
+            )
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(y)
+        return y
+
+    return PoolingJob(x).get().numpy()
+
+
+def test_pool_cpu(test_case):
+    arg_dict = OrderedDict()
+    arg_dict["pool_conf"] = pool_confs
+    arg_dict["pooling_type"] = ["AVG", "MAX"]
+
+    for case in GenArgList(arg_dict):
+        pool_conf, pooling_type = case
+        x = np.random.randn(*pool_conf["x_shape"]).astype(np.float32)
+        dim = x.ndim - 2
+
+        with tf.GradientTape(persistent=True) as tape:
+            x_tf = tf.Variable(x)
+            pooling_f = getattr(tf.nn, "{}_pool{}d".format(pooling_type.lower(), dim))
+            y_tf = pooling_f(
+                x_tf,
+                pool_conf["ksize"],
+                pool_conf["strides"],
+                pool_conf["padding"],
+                data_format=pool_conf["data_format"],
+            )
+        dx_tf = tape.gradient(y_tf, x_tf, tf.constant(1.0, shape=y_tf.shape))
+
+        def assert_dx(dx):
+            test_case.assertTrue(
+                np.allclose(dx.numpy(), dx_tf.numpy(), rtol=1e-5, atol=1e-5), case
+            )
+
+        y = _run_pooling_job(
+            x,
+            pooling_type,
+            pool_conf["ksize"],
+            pool_conf["strides"],
+            pool_conf["padding"],
+            pool_conf["data_format"],
+            assert_dx,
+        )
+        test_case.assertEqual(y.shape, tuple(y_tf.shape))
+        test_case.assertTrue(np.allclose(y, y_tf.numpy(), rtol=1e-5, atol=1e-5), case)
+
+
+def _first_max_dx(x, ksize, strides, padding_before, out_hw):
+    # dy of ones goes to the first maximum of every window in row-major order
+    dx = np.zeros_like(x)
+    for n in range(x.shape[0]):
+        for c in range(x.shape[1]):
+            for oh in range(out_hw[0]):
+                for ow in range(out_hw[1]):
+                    h0 = max(oh * strides - padding_before, 0)
+                    w0 = max(ow * strides - padding_before, 0)
+                    h1 = min(oh * strides - padding_before + ksize, x.shape[2])
+                    w1 = min(ow * strides - padding_before + ksize, x.shape[3])
+                    window = x[n, c, h0:h1, w0:w1]
+                    h, w = np.unravel_index(np.argmax(window), window.shape)
+                    dx[n, c, h0 + h, w0 + w] += 1
+    return dx
+
+
+def test_max_pool_cpu_ties_go_to_first_max(test_case):
+    arg_dict = OrderedDict()
+    # (ksize, strides, padding, padding_before, out_hw)
+    arg_dict["window"] = [(2, 2, "VALID", 0, (2, 3)), (3, 1, "SAME", 1, (4, 6))]
+    arg_dict["data_format"] = ["NCHW", "NHWC"]
+
+    for case in GenArgList(arg_dict):
+        (ksize, strides, padding, padding_before, out_hw), data_format = case
+        # every window holds a 1, most of them twice or more
+        x = np.tile(np.array([[1, 1, 0], [0, 0, 0]], dtype=np.float32), (2, 2))
+        x = np.tile(x, (2, 3, 1, 1))
+        expected_dx = _first_max_dx(x, ksize, strides, padding_before, out_hw)
+        if data_format == "NHWC":
+            x = np.ascontiguousarray(np.transpose(x, (0, 2, 3, 1)))
+            expected_dx = np.transpose(expected_dx, (0, 2, 3, 1))
+
+        def assert_dx(dx):
+            test_case.assertTrue(np.array_equal(dx.numpy(), expected_dx), case)
+
+        y = _run_pooling_job(x, "MAX", ksize, strides, padding, data_format, assert_dx)
+        test_case.assertTrue(np.all(y == 1), case)
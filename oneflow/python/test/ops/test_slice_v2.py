@@ -18,7 +18,14 @@ import oneflow as flow
 import oneflow.typing as oft
 
 
-def _run_slice(input, index_args, dynamic=False, dtype=flow.float, input_shape=None):
+def _run_slice(
+    input,
+    index_args,
+    dynamic=False,
+    dtype=flow.float,
+    input_shape=None,
+    device_tag="gpu",
+):
     func_config = flow.FunctionConfig()
     func_config.default_data_type(dtype)
 
@@ -27,9 +34,10 @@ def _run_slice(input, index_args, dynamic=False, dtype=flow.float, input_shape=N
 
     def do_slice(x, indices):
         outputs = []
-        for slice_tup_list in indices:
-            output = flow.slice_v2(x, slice_tup_list)
-            outputs.append(output)
+        with flow.scope.placement(device_tag, "0:0"):
+            for slice_tup_list in indices:
+                output = flow.slice_v2(x, slice_tup_list)
+                outputs.append(output)
         return outputs
 
     if dynamic is True:
@@ -175,6 +183,40 @@ def test_slice_with_neg_stride2(test_case):
     _check(test_case, results, outputs)
 
 
+def test_slice_on_cpu(test_case):
+    input = np.random.rand(2, 5, 4, 4, 3).astype(np.float32)
+    results = [
+        input[:, 0:2, :, :, 1:None],
+        input[:, 1::2, :, ::2, :],
+        input[1:, 3:-4:-1, :, 1:3, :],
+    ]
+    args = [
+        [
+            (None, None, None),
+            (0, 2, None),
+            (None, None, None),
+            (None, None, None),
+            (1, None, None),
+        ],
+        [
+            (None, None, None),
+            (1, None, 2),
+            (None, None, None),
+            (None, None, 2),
+            (None, None, None),
+        ],
+        [
+            (1, None, None),
+            (3, -4, -1),
+            (None, None, None),
+            (1, 3, None),
+            (None, None, None),
+        ],
+    ]
+    outputs = _run_slice(input, args, device_tag="cpu")
+    _check(test_case, results, outputs)
+
+
 def test_slice_grad(test_case):
     input = np.random.rand(2, 5, 4).astype(np.float32)
     ref = np.zeros(input.shape, dtype=np.float32)
@@ -0,0 +1,165 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import
+
+import struct
+
+import numpy as np
+import oneflow.core.vm.instruction_pb2 as instr_util
+import oneflow.python.framework.c_api_util as c_api_util
+
+# keep in sync with oneflow/core/vm/instruction_encoding.h
+_kInstantiateTemplateOpcode = -1
+_kEncodedMirroredKindShift = 8
+_kEncodedTemplateArgFlag = 1 << 16
+
+_kObjectOperandFields = set(
+    [
+        "const_operand",
+        "mut_operand",
+        "mut2_operand",
+        "symbol_operand",
+        "init_symbol_operand",
+    ]
+)
+_operand_field2number = {
+    field.name: field.number
+    for field in instr_util.InstructionOperandProto.DESCRIPTOR.fields
+}
+_mirrored_kind2number = {
+    field.name: field.number for field in instr_util.OperandProto.DESCRIPTOR.fields
+}
+_instr_type_name2opcode = {}
+# an instruction list is made a template the second time its signature is seen
+_seen_template_keys = set()
+_template_key2template_id = {}
+
+
+def EncodeInstructionList(instruction_list, logical_object_id2arg_index={}):
+    r"""Encodes an InstructionListProto into the flat int64 buffer decoded by the vm.
+
+    Object and int64 operands whose value is in logical_object_id2arg_index become
+    template args, which is only valid for AddInstructionTemplate.
+    """
+    words = []
+    for instruction in instruction_list.instruction:
+        words.append(_Opcode4InstrTypeName(instruction.instr_type_name))
+        words.append(instruction.parallel_desc_symbol_id)
+        words.append(len(instruction.operand))
+        for operand in instruction.operand:
+            words.extend(_EncodeOperand(operand, logical_object_id2arg_index))
+    return np.array(words, dtype=np.int64)
+
+
+def EncodeInstructionListWithTemplate(instruction_list):
+    r"""Encodes an InstructionListProto like EncodeInstructionList, but as an
+    instantiation of a template when the same signature was encoded before.
+
+    The signature is the instruction list with the object ids, i.e. object operands and
+    the int64 operands of NewObject and alike, replaced by the index of their first
+    appearance, so repeated calls of an op with new blobs share one template.
+    """
+    if len(instruction_list.instruction) == 0:
+        return EncodeInstructionList(instruction_list)
+    arg_logical_object_ids = _TemplateArgs(instruction_list)
+    logical_object_id2arg_index = {
+        object_id: i for i, object_id in enumerate(arg_logical_object_ids)
+    }
+    template_words = EncodeInstructionList(
+        instruction_list, logical_object_id2arg_index
+    )
+    key = template_words.tobytes()
+    template_id = _template_key2template_id.get(key)
+    if template_id is None:
+        if key not in _seen_template_keys:
+            _seen_template_keys.add(key)
+            return EncodeInstructionList(instruction_list)
+        template_id = len(_template_key2template_id) + 1
+        c_api_util.AddInstructionTemplate(template_id, template_words)
+        _template_key2template_id[key] = template_id
+    return EncodeTemplateInstantiation(template_id, arg_logical_object_ids)
+
+
+def AddInstructionTemplate(template_id, instruction_list, arg_logical_object_ids):
+    r"""Registers instructions to be instantiated many times with different args."""
+    logical_object_id2arg_index = {
+        object_id: i for i, object_id in enumerate(arg_logical_object_ids)
+    }
+    encoded = EncodeInstructionList(instruction_list, logical_object_id2arg_index)
+    c_api_util.AddInstructionTemplate(template_id, encoded)
+
+
+def EncodeTemplateInstantiation(template_id, args):
+    words = [_kInstantiateTemplateOpcode, template_id, len(args)]
+    words.extend(args)
+    return np.array(words, dtype=np.int64)
+
+
+def _TemplateArgs(instruction_list):
+    args = []
+    arg_set = set()
+    for instruction in instruction_list.instruction:
+        for operand in instruction.operand:
+            field = operand.WhichOneof("type")
+            if field in _kObjectOperandFields:
+                value = getattr(operand, field).logical_object_id
+            elif field == "int64_operand":
+                value = operand.int64_operand
+            else:
+                continue
+            if value not in arg_set:
+                arg_set.add(value)
+                args.append(value)
+    return args
+
+
+def _Opcode4InstrTypeName(instr_type_name):
+    opcode = _instr_type_name2opcode.get(instr_type_name)
+    if opcode is None:
+        opcode = c_api_util.GetInstructionOpcode(instr_type_name)
+        _instr_type_name2opcode[instr_type_name] = opcode
+    return opcode
+
+
+def _EncodeOperand(operand, logical_object_id2arg_index):
+    field = operand.WhichOneof("type")
+    tag = _operand_field2number[field]
+    if field in _kObjectOperandFields:
+        object_operand = getattr(operand, field)
+        mirrored_kind = object_operand.WhichOneof("operand_type")
+        tag |= _mirrored_kind2number[mirrored_kind] << _kEncodedMirroredKindShift
+        return _EncodeTemplateArg(
+            tag, object_operand.logical_object_id, logical_object_id2arg_index
+        )
+    if field == "int64_operand":
+        return _EncodeTemplateArg(
+            tag, operand.int64_operand, logical_object_id2arg_index
+        )
+    if field == "separator":
+        return tag, 0
+    if field == "double_operand":
+        return tag, struct.unpack("<q", struct.pack("<d", operand.double_operand))[0]
+    if field == "uint64_operand":
+        return tag, struct.unpack("<q", struct.pack("<Q", operand.uint64_operand))[0]
+    if field == "bool_operand":
+        return tag, int(operand.bool_operand)
+    return tag, getattr(operand, field)
+
+
+def _EncodeTemplateArg(tag, value, logical_object_id2arg_index):
+    if value in logical_object_id2arg_index:
+        return tag | _kEncodedTemplateArgFlag, logical_object_id2arg_index[value]
+    return tag, value
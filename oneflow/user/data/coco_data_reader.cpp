@@ -18,22 +18,29 @@ limitations under the License.
 #include "oneflow/user/data/distributed_training_dataset.h"
 #include "oneflow/user/data/group_batch_dataset.h"
 #include "oneflow/user/data/batch_dataset.h"
+#include "oneflow/user/data/prefetch_dataset.h"
 #include "oneflow/core/persistence/file_system.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/persistent_out_stream.h"
 
 namespace oneflow {
 namespace data {
 
 COCODataReader::COCODataReader(user_op::KernelInitContext* ctx) : DataReader<COCOImage>(ctx) {
-  std::shared_ptr<const COCOMeta> meta(
-      new COCOMeta(ctx->Attr<std::string>("annotation_file"), ctx->Attr<std::string>("image_dir"),
-                   ctx->Attr<bool>("remove_images_without_annotations")));
+  std::shared_ptr<const COCOMeta> meta(new COCOMeta(
+      ctx->Attr<std::string>("annotation_file"), ctx->Attr<std::string>("image_dir"),
+      ctx->Attr<bool>("remove_images_without_annotations"),
+      ctx->Attr<std::string>("annotation_index_file")));
 
   std::unique_ptr<RandomAccessDataset<COCOImage>> coco_dataset_ptr(new COCODataset(ctx, meta));
   loader_.reset(new DistributedTrainingDataset<COCOImage>(
       ctx->parallel_ctx().parallel_num(), ctx->parallel_ctx().parallel_id(),
       ctx->Attr<bool>("stride_partition"), ctx->Attr<bool>("shuffle_after_epoch"),
       ctx->Attr<int64_t>("random_seed"), std::move(coco_dataset_ptr)));
+  // image files are read ahead of batching, grouping only needs the sizes from meta
+  loader_.reset(new PrefetchDataset<COCOImage>(
+      ctx->Attr<int32_t>("image_reader_num"), ctx->Attr<int32_t>("image_prefetch_num"),
+      [meta](COCOImage* image) { COCODataset::ReadImage(*meta, image); }, std::move(loader_)));
 
   size_t batch_size = ctx->TensorDesc4ArgNameAndIndex("image", 0)->shape().elem_cnt();
   if (ctx->Attr<bool>("group_by_ratio")) {
@@ -49,94 +56,46 @@ COCODataReader::COCODataReader(user_op::KernelInitContext* ctx) : DataReader<COC
   StartLoadThread();
 }
 
+namespace {
+
+std::vector<char> ReadWholeFile(const std::string& path) {
+  std::vector<char> content(DataFS()->GetFileSize(path));
+  PersistentInStream in_stream(DataFS(), path);
+  CHECK_EQ(in_stream.ReadFully(content.data(), content.size()), 0);
+  return content;
+}
+
+// readers of one process wait for the first one to build the index and then load it
+std::mutex coco_index_mutex;
+
+}  // namespace
+
 COCOMeta::COCOMeta(const std::string& annotation_file, const std::string& image_dir,
-                   bool remove_images_without_annotations)
+                   bool remove_images_without_annotations,
+                   const std::string& annotation_index_file)
     : image_dir_(image_dir) {
-  // Read content of annotation file (json format) to json obj
-  PersistentInStream in_stream(DataFS(), annotation_file);
-  std::string json_str;
-  std::string line;
-  while (in_stream.ReadLine(&line) == 0) { json_str += line; }
-  std::istringstream in_str_stream(json_str);
-  in_str_stream >> annotation_json_;
-  // initialize image_ids_, image_id2image_ and image_id2anno_ids_
-  for (const auto& image : annotation_json_["images"]) {
-    int64_t id = image["id"].get<int64_t>();
-    image_ids_.push_back(id);
-    CHECK(image_id2image_.emplace(id, image).second);
-    CHECK(image_id2anno_ids_.emplace(id, std::vector<int64_t>()).second);
-  }
-  // build anno map
-  for (const auto& anno : annotation_json_["annotations"]) {
-    int64_t id = anno["id"].get<int64_t>();
-    int64_t image_id = anno["image_id"].get<int64_t>();
-    // ignore crowd object for now
-    if (anno["iscrowd"].get<int>() == 1) { continue; }
-    // check if invalid segmentation
-    if (anno["segmentation"].is_array()) {
-      for (const auto& poly : anno["segmentation"]) {
-        // at least 3 points can compose a polygon
-        // every point needs 2 element (x, y) to present
-        CHECK_GT(poly.size(), 6);
-      }
+  std::unique_lock<std::mutex> lock(coco_index_mutex);
+  // the index is checked against a checksum of the annotation file, reading it is still far cheaper
+  // than parsing the json
+  const std::vector<char> annotation_json = ReadWholeFile(annotation_file);
+  if (!annotation_index_file.empty() && DataFS()->FileExists(annotation_index_file)) {
+    if (index_.Load(ReadWholeFile(annotation_index_file), annotation_json,
+                    remove_images_without_annotations)) {
+      return;
     }
-    CHECK(anno_id2anno_.emplace(id, anno).second);
-    image_id2anno_ids_.at(image_id).push_back(id);
+    LOG(INFO) << annotation_index_file << " does not match " << annotation_file << ", rebuild it";
   }
-  // remove images without annotations if necessary
-  if (remove_images_without_annotations) {
-    HashSet<int64_t> to_remove_image_ids;
-    for (int64_t image_id : image_ids_) {
-      if (!ImageHasValidAnnotations(image_id)) { to_remove_image_ids.insert(image_id); }
-    }
-    image_ids_.erase(std::remove_if(image_ids_.begin(), image_ids_.end(),
-                                    [&to_remove_image_ids](int64_t image_id) {
-                                      return to_remove_image_ids.find(image_id)
-                                             != to_remove_image_ids.end();
-                                    }),
-                     image_ids_.end());
-  }
-  // sort image ids for reproducible results
-  std::sort(image_ids_.begin(), image_ids_.end());
-  // build categories map
-  std::vector<int32_t> category_ids;
-  for (const auto& cat : annotation_json_["categories"]) {
-    category_ids.emplace_back(cat["id"].get<int32_t>());
-  }
-  std::sort(category_ids.begin(), category_ids.end());
-  int32_t contiguous_id = 1;
-  for (int32_t category_id : category_ids) {
-    CHECK(category_id2contiguous_id_.emplace(category_id, contiguous_id++).second);
-  }
-}
-
-bool COCOMeta::ImageHasValidAnnotations(int64_t image_id) const {
-  const std::vector<int64_t>& anno_id_vec = image_id2anno_ids_.at(image_id);
-  if (anno_id_vec.empty()) { return false; }
-
-  bool bbox_area_all_close_to_zero = true;
-  size_t visible_keypoints_count = 0;
-  for (int64_t anno_id : anno_id_vec) {
-    const auto& anno = anno_id2anno_.at(anno_id);
-    if (anno["bbox"][2] > 1 && anno["bbox"][3] > 1) { bbox_area_all_close_to_zero = false; }
-    if (anno.contains("keypoints")) {
-      const auto& keypoints = anno["keypoints"];
-      CHECK_EQ(keypoints.size() % 3, 0);
-      FOR_RANGE(size_t, i, 0, keypoints.size() / 3) {
-        int32_t keypoints_label = keypoints[i * 3 + 2].get<int32_t>();
-        if (keypoints_label > 0) { visible_keypoints_count += 1; }
-      }
+  CHECK(index_.Load(COCOIndex::Build(annotation_json, remove_images_without_annotations),
+                    annotation_json, remove_images_without_annotations));
+  if (!annotation_index_file.empty()) {
+    // write aside and rename, so that other processes never load a partial index
+    const std::string tmp_file = annotation_index_file + ".tmp" + std::to_string(NewRandomSeed());
+    {
+      PersistentOutStream out_stream(DataFS(), tmp_file);
+      out_stream.Write(index_.buffer().data(), index_.buffer().size());
     }
+    DataFS()->RenameFile(tmp_file, annotation_index_file);
   }
-  // check if all boxes are close to zero area
-  if (bbox_area_all_close_to_zero) { return false; }
-  // keypoints task have a slight different critera for considering
-  // if an annotation is valid
-  if (!anno_id2anno_.at(anno_id_vec.at(0)).contains("keypoints")) { return true; }
-  // for keypoint detection tasks, only consider valid images those
-  // containing at least min_keypoints_per_image
-  if (visible_keypoints_count >= kMinKeypointsPerImage) { return true; }
-  return false;
 }
 
 }  // namespace data
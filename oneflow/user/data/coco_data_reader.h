@@ -18,8 +18,8 @@ limitations under the License.
 
 #include "oneflow/user/data/data_reader.h"
 #include "oneflow/user/data/coco_parser.h"
+#include "oneflow/user/data/coco_index.h"
 #include "oneflow/core/common/str_util.h"
-#include <json.hpp>
 
 namespace oneflow {
 namespace data {
@@ -37,23 +37,15 @@ class COCODataReader final : public DataReader<COCOImage> {
 class COCOMeta final {
  public:
   COCOMeta(const std::string& annotation_file, const std::string& image_dir,
-           bool remove_images_without_annotations);
+           bool remove_images_without_annotations, const std::string& annotation_index_file);
   ~COCOMeta() = default;
 
-  int64_t Size() const { return image_ids_.size(); }
-  int64_t GetImageId(int64_t index) const { return image_ids_.at(index); }
-  int32_t GetImageHeight(int64_t index) const {
-    int64_t image_id = image_ids_.at(index);
-    return image_id2image_.at(image_id)["height"].get<int32_t>();
-  }
-  int32_t GetImageWidth(int64_t index) const {
-    int64_t image_id = image_ids_.at(index);
-    return image_id2image_.at(image_id)["width"].get<int32_t>();
-  }
+  int64_t Size() const { return index_.image_num(); }
+  int64_t GetImageId(int64_t index) const { return index_.image(index).id; }
+  int32_t GetImageHeight(int64_t index) const { return index_.image(index).height; }
+  int32_t GetImageWidth(int64_t index) const { return index_.image(index).width; }
   std::string GetImageFilePath(int64_t index) const {
-    int64_t image_id = image_ids_.at(index);
-    const auto& image_json = image_id2image_.at(image_id);
-    return JoinPath(image_dir_, image_json["file_name"].get<std::string>());
+    return JoinPath(image_dir_, index_.ImageFileName(index));
   }
   template<typename T>
   std::vector<T> GetBboxVec(int64_t index) const;
@@ -64,40 +56,29 @@ class COCOMeta final {
                                        TensorBuffer* segm_offset_mat) const;
 
  private:
-  bool ImageHasValidAnnotations(int64_t image_id) const;
-
-  static constexpr int kMinKeypointsPerImage = 10;
-  nlohmann::json annotation_json_;
+  COCOIndex index_;
   std::string image_dir_;
-  std::vector<int64_t> image_ids_;
-  HashMap<int64_t, const nlohmann::json&> image_id2image_;
-  HashMap<int64_t, const nlohmann::json&> anno_id2anno_;
-  HashMap<int64_t, std::vector<int64_t>> image_id2anno_ids_;
-  HashMap<int32_t, int32_t> category_id2contiguous_id_;
 };
 
 template<typename T>
 std::vector<T> COCOMeta::GetBboxVec(int64_t index) const {
   std::vector<T> bbox_vec;
-  int64_t image_id = image_ids_.at(index);
-  const auto& anno_ids = image_id2anno_ids_.at(image_id);
-  for (int64_t anno_id : anno_ids) {
-    const auto& bbox_json = anno_id2anno_.at(anno_id)["bbox"];
-    CHECK(bbox_json.is_array());
-    CHECK_EQ(bbox_json.size(), 4);
+  const COCOImageRecord& image = index_.image(index);
+  FOR_RANGE(int64_t, anno_idx, image.annotation_begin, image.annotation_end) {
+    const float* bbox = index_.annotation(anno_idx).bbox;
     // COCO bounding box format is [left, top, width, height]
     // we need format xyxy
     const T alginment = static_cast<T>(1);
     const T min_size = static_cast<T>(0);
-    T left = bbox_json[0].get<T>();
-    T top = bbox_json[1].get<T>();
-    T width = bbox_json[2].get<T>();
-    T height = bbox_json[3].get<T>();
+    T left = static_cast<T>(bbox[0]);
+    T top = static_cast<T>(bbox[1]);
+    T width = static_cast<T>(bbox[2]);
+    T height = static_cast<T>(bbox[3]);
     T right = left + std::max(width - alginment, min_size);
     T bottom = top + std::max(height - alginment, min_size);
     // clip to image
-    int32_t image_height = GetImageHeight(index);
-    int32_t image_width = GetImageWidth(index);
+    int32_t image_height = image.height;
+    int32_t image_width = image.width;
     left = std::min(std::max(left, min_size), image_width - alginment);
     top = std::min(std::max(top, min_size), image_height - alginment);
     right = std::min(std::max(right, min_size), image_width - alginment);
@@ -113,11 +94,9 @@ std::vector<T> COCOMeta::GetBboxVec(int64_t index) const {
 template<typename T>
 std::vector<T> COCOMeta::GetLabelVec(int64_t index) const {
   std::vector<T> label_vec;
-  int64_t image_id = image_ids_.at(index);
-  const auto& anno_ids = image_id2anno_ids_.at(image_id);
-  for (int64_t anno_id : anno_ids) {
-    int32_t category_id = anno_id2anno_.at(anno_id)["category_id"].get<int32_t>();
-    label_vec.push_back(category_id2contiguous_id_.at(category_id));
+  const COCOImageRecord& image = index_.image(index);
+  FOR_RANGE(int64_t, anno_idx, image.annotation_begin, image.annotation_end) {
+    label_vec.push_back(static_cast<T>(index_.annotation(anno_idx).label));
   }
   return label_vec;
 }
@@ -126,16 +105,14 @@ template<typename T>
 void COCOMeta::ReadSegmentationsToTensorBuffer(int64_t index, TensorBuffer* segm,
                                                TensorBuffer* segm_index) const {
   if (segm == nullptr || segm_index == nullptr) { return; }
-  int64_t image_id = image_ids_.at(index);
-  const auto& anno_ids = image_id2anno_ids_.at(image_id);
+  const COCOImageRecord& image = index_.image(index);
   std::vector<T> segm_vec;
-  for (int64_t anno_id : anno_ids) {
-    const auto& segm_json = anno_id2anno_.at(anno_id)["segmentation"];
-    if (!segm_json.is_array()) { continue; }
-    for (const auto& poly_json : segm_json) {
-      CHECK(poly_json.is_array());
-      for (const auto& elem : poly_json) { segm_vec.push_back(elem.get<T>()); }
-    }
+  FOR_RANGE(int64_t, anno_idx, image.annotation_begin, image.annotation_end) {
+    const COCOAnnotationRecord& anno = index_.annotation(anno_idx);
+    if (!anno.is_polygon_segm) { continue; }
+    const float* begin = index_.segm() + index_.polygon_offset(anno.polygon_begin);
+    const float* end = index_.segm() + index_.polygon_offset(anno.polygon_end);
+    segm_vec.insert(segm_vec.end(), begin, end);
   }
   CHECK_EQ(segm_vec.size() % 2, 0);
   int64_t num_pts = segm_vec.size() / 2;
@@ -146,14 +123,14 @@ void COCOMeta::ReadSegmentationsToTensorBuffer(int64_t index, TensorBuffer* segm
   int32_t* index_ptr = segm_index->mut_data<int32_t>();
   int i = 0;
   int32_t segm_idx = 0;
-  for (int64_t anno_id : anno_ids) {
-    const auto& segm_json = anno_id2anno_.at(anno_id)["segmentation"];
-    CHECK(segm_json.is_array());
-    FOR_RANGE(int32_t, poly_idx, 0, segm_json.size()) {
-      const auto& poly_json = segm_json[poly_idx];
-      CHECK(poly_json.is_array());
-      CHECK_EQ(poly_json.size() % 2, 0);
-      FOR_RANGE(int32_t, pt_idx, 0, poly_json.size() / 2) {
+  FOR_RANGE(int64_t, anno_idx, image.annotation_begin, image.annotation_end) {
+    const COCOAnnotationRecord& anno = index_.annotation(anno_idx);
+    CHECK(anno.is_polygon_segm);
+    FOR_RANGE(int64_t, poly_idx, 0, anno.polygon_end - anno.polygon_begin) {
+      const int64_t poly_size = index_.polygon_offset(anno.polygon_begin + poly_idx + 1)
+                                - index_.polygon_offset(anno.polygon_begin + poly_idx);
+      CHECK_EQ(poly_size % 2, 0);
+      FOR_RANGE(int32_t, pt_idx, 0, poly_size / 2) {
         index_ptr[i * 3 + 0] = pt_idx;
         index_ptr[i * 3 + 1] = poly_idx;
         index_ptr[i * 3 + 2] = segm_idx;
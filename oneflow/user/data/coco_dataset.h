@@ -41,8 +41,10 @@ class COCODataset final : public RandomAccessDataset<COCOImage> {
       : meta_(meta) {}
   ~COCODataset() = default;
 
+  // Samples come without data, ReadImage fills it with the bytes of the image file.
   LoadTargetShdPtrVec At(int64_t index) const override;
   size_t Size() const override;
+  static void ReadImage(const COCOMeta& meta, COCOImage* image);
 
  private:
   std::shared_ptr<const COCOMeta> meta_;
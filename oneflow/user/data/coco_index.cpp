@@ -0,0 +1,232 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/coco_index.h"
+#include <json.hpp>
+#include "oneflow/user/summary/crc32c.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+const char kCOCOIndexMagic[8] = {'O', 'F', 'C', 'O', 'C', 'O', 'I', 'X'};
+const int64_t kCOCOIndexVersion = 2;
+const size_t kMinKeypointsPerImage = 10;
+
+// Byte offsets of the tables in an index buffer.
+struct COCOIndexLayout {
+  size_t images;
+  size_t annotations;
+  size_t polygon_offsets;
+  size_t segm;
+  size_t file_names;
+  size_t size;
+};
+
+COCOIndexLayout Layout4Header(const COCOIndexHeader& header) {
+  size_t offset = RoundUp(sizeof(COCOIndexHeader), 8);
+  auto Append = [&](size_t size) {
+    const size_t begin = offset;
+    offset += RoundUp(size, 8);
+    return begin;
+  };
+  COCOIndexLayout layout;
+  layout.images = Append(header.image_num * sizeof(COCOImageRecord));
+  layout.annotations = Append(header.annotation_num * sizeof(COCOAnnotationRecord));
+  layout.polygon_offsets = Append((header.polygon_num + 1) * sizeof(int64_t));
+  layout.segm = Append(header.segm_elem_num * sizeof(float));
+  layout.file_names = Append(header.file_name_bytes);
+  layout.size = offset;
+  return layout;
+}
+
+bool ImageHasValidAnnotations(const std::vector<const nlohmann::json*>& annos) {
+  if (annos.empty()) { return false; }
+  bool bbox_area_all_close_to_zero = true;
+  size_t visible_keypoints_count = 0;
+  for (const nlohmann::json* anno : annos) {
+    if ((*anno)["bbox"][2] > 1 && (*anno)["bbox"][3] > 1) { bbox_area_all_close_to_zero = false; }
+    if (anno->contains("keypoints")) {
+      const auto& keypoints = (*anno)["keypoints"];
+      CHECK_EQ(keypoints.size() % 3, 0);
+      FOR_RANGE(size_t, i, 0, keypoints.size() / 3) {
+        int32_t keypoints_label = keypoints[i * 3 + 2].get<int32_t>();
+        if (keypoints_label > 0) { visible_keypoints_count += 1; }
+      }
+    }
+  }
+  // check if all boxes are close to zero area
+  if (bbox_area_all_close_to_zero) { return false; }
+  // keypoints task have a slight different critera for considering
+  // if an annotation is valid
+  if (!annos.front()->contains("keypoints")) { return true; }
+  // for keypoint detection tasks, only consider valid images those
+  // containing at least min_keypoints_per_image
+  return visible_keypoints_count >= kMinKeypointsPerImage;
+}
+
+template<typename T>
+void CopyTable(const std::vector<T>& table, size_t offset, std::vector<char>* buffer) {
+  if (table.empty()) { return; }
+  std::memcpy(buffer->data() + offset, table.data(), table.size() * sizeof(T));
+}
+
+}  // namespace
+
+std::vector<char> COCOIndex::Build(const std::vector<char>& annotation_json,
+                                   bool remove_images_without_annotations) {
+  const nlohmann::json json =
+      nlohmann::json::parse(annotation_json.cbegin(), annotation_json.cend());
+  std::vector<int64_t> image_ids;
+  HashMap<int64_t, const nlohmann::json*> image_id2image;
+  HashMap<int64_t, std::vector<const nlohmann::json*>> image_id2annos;
+  for (const auto& image : json.at("images")) {
+    int64_t id = image["id"].get<int64_t>();
+    image_ids.push_back(id);
+    CHECK(image_id2image.emplace(id, &image).second);
+    CHECK(image_id2annos.emplace(id, std::vector<const nlohmann::json*>()).second);
+  }
+  HashSet<int64_t> anno_ids;
+  for (const auto& anno : json.at("annotations")) {
+    int64_t id = anno["id"].get<int64_t>();
+    int64_t image_id = anno["image_id"].get<int64_t>();
+    // ignore crowd object for now
+    if (anno["iscrowd"].get<int>() == 1) { continue; }
+    // check if invalid segmentation
+    if (anno["segmentation"].is_array()) {
+      for (const auto& poly : anno["segmentation"]) {
+        // at least 3 points can compose a polygon
+        // every point needs 2 element (x, y) to present
+        CHECK_GT(poly.size(), 6);
+      }
+    }
+    CHECK(anno_ids.insert(id).second);
+    image_id2annos.at(image_id).push_back(&anno);
+  }
+  if (remove_images_without_annotations) {
+    image_ids.erase(std::remove_if(image_ids.begin(), image_ids.end(),
+                                   [&](int64_t image_id) {
+                                     return !ImageHasValidAnnotations(image_id2annos.at(image_id));
+                                   }),
+                    image_ids.end());
+  }
+  // sort image ids for reproducible results
+  std::sort(image_ids.begin(), image_ids.end());
+  std::vector<int32_t> category_ids;
+  for (const auto& cat : json.at("categories")) {
+    category_ids.emplace_back(cat["id"].get<int32_t>());
+  }
+  std::sort(category_ids.begin(), category_ids.end());
+  HashMap<int32_t, int32_t> category_id2label;
+  int32_t contiguous_id = 1;
+  for (int32_t category_id : category_ids) {
+    CHECK(category_id2label.emplace(category_id, contiguous_id++).second);
+  }
+
+  std::vector<COCOImageRecord> images;
+  std::vector<COCOAnnotationRecord> annotations;
+  std::vector<int64_t> polygon_offsets(1, 0);
+  std::vector<float> segm;
+  std::string file_names;
+  for (int64_t image_id : image_ids) {
+    const nlohmann::json& image_json = *image_id2image.at(image_id);
+    COCOImageRecord image{};
+    image.id = image_id;
+    image.height = image_json["height"].get<int32_t>();
+    image.width = image_json["width"].get<int32_t>();
+    const std::string& file_name = image_json["file_name"].get_ref<const std::string&>();
+    image.file_name_offset = file_names.size();
+    image.file_name_size = file_name.size();
+    file_names += file_name;
+    image.annotation_begin = annotations.size();
+    for (const nlohmann::json* anno_json : image_id2annos.at(image_id)) {
+      COCOAnnotationRecord anno{};
+      const auto& bbox_json = (*anno_json)["bbox"];
+      CHECK(bbox_json.is_array());
+      CHECK_EQ(bbox_json.size(), 4);
+      FOR_RANGE(int32_t, i, 0, 4) { anno.bbox[i] = bbox_json[i].get<float>(); }
+      anno.label = category_id2label.at((*anno_json)["category_id"].get<int32_t>());
+      const auto& segm_json = (*anno_json)["segmentation"];
+      anno.is_polygon_segm = segm_json.is_array();
+      anno.polygon_begin = polygon_offsets.size() - 1;
+      if (segm_json.is_array()) {
+        for (const auto& poly_json : segm_json) {
+          CHECK(poly_json.is_array());
+          for (const auto& elem : poly_json) { segm.push_back(elem.get<float>()); }
+          polygon_offsets.push_back(segm.size());
+        }
+      }
+      anno.polygon_end = polygon_offsets.size() - 1;
+      annotations.push_back(anno);
+    }
+    image.annotation_end = annotations.size();
+    images.push_back(image);
+  }
+
+  COCOIndexHeader header{};
+  std::memcpy(header.magic, kCOCOIndexMagic, sizeof(header.magic));
+  header.version = kCOCOIndexVersion;
+  header.annotation_file_size = annotation_json.size();
+  header.annotation_file_crc32c = summary::GetCrc32(annotation_json.data(), annotation_json.size());
+  header.remove_images_without_annotations = remove_images_without_annotations;
+  header.image_num = images.size();
+  header.annotation_num = annotations.size();
+  header.polygon_num = polygon_offsets.size() - 1;
+  header.segm_elem_num = segm.size();
+  header.file_name_bytes = file_names.size();
+  const COCOIndexLayout layout = Layout4Header(header);
+  std::vector<char> buffer(layout.size, 0);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  CopyTable(images, layout.images, &buffer);
+  CopyTable(annotations, layout.annotations, &buffer);
+  CopyTable(polygon_offsets, layout.polygon_offsets, &buffer);
+  CopyTable(segm, layout.segm, &buffer);
+  std::copy(file_names.begin(), file_names.end(), buffer.begin() + layout.file_names);
+  return buffer;
+}
+
+bool COCOIndex::Load(std::vector<char>&& buffer, const std::vector<char>& annotation_json,
+                     bool remove_images_without_annotations) {
+  if (buffer.size() < sizeof(COCOIndexHeader)) { return false; }
+  COCOIndexHeader header;
+  std::memcpy(&header, buffer.data(), sizeof(header));
+  if (std::memcmp(header.magic, kCOCOIndexMagic, sizeof(header.magic)) != 0) { return false; }
+  if (header.version != kCOCOIndexVersion) { return false; }
+  if (header.annotation_file_size != static_cast<int64_t>(annotation_json.size())) { return false; }
+  if (header.annotation_file_crc32c
+      != summary::GetCrc32(annotation_json.data(), annotation_json.size())) {
+    return false;
+  }
+  if (header.remove_images_without_annotations != remove_images_without_annotations) {
+    return false;
+  }
+  if (header.image_num < 0 || header.annotation_num < 0 || header.polygon_num < 0
+      || header.segm_elem_num < 0 || header.file_name_bytes < 0) {
+    return false;
+  }
+  const COCOIndexLayout layout = Layout4Header(header);
+  if (layout.size != buffer.size()) { return false; }
+  buffer_ = std::move(buffer);
+  images_ = reinterpret_cast<const COCOImageRecord*>(buffer_.data() + layout.images);
+  annotations_ = reinterpret_cast<const COCOAnnotationRecord*>(buffer_.data() + layout.annotations);
+  polygon_offsets_ = reinterpret_cast<const int64_t*>(buffer_.data() + layout.polygon_offsets);
+  segm_ = reinterpret_cast<const float*>(buffer_.data() + layout.segm);
+  file_names_ = buffer_.data() + layout.file_names;
+  return true;
+}
+
+}  // namespace data
+}  // namespace oneflow
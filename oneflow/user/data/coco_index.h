@@ -0,0 +1,118 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_COCO_INDEX_H_
+#define ONEFLOW_USER_DATA_COCO_INDEX_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace data {
+
+// The COCO annotations needed by COCOReader in one flat buffer, so that it can be written to a
+// file once and loaded with a single read instead of parsing the annotation json on every start.
+// The buffer is a COCOIndexHeader followed by the tables below, each 8 bytes aligned:
+//   images        COCOImageRecord[image_num], the kept images sorted by id
+//   annotations   COCOAnnotationRecord[annotation_num], grouped by image
+//   polygons      int64_t[polygon_num + 1], offsets of each polygon in segm
+//   segm          float[segm_elem_num], x y pairs of all polygons
+//   file names    char[file_name_bytes]
+struct COCOIndexHeader {
+  char magic[8];
+  int64_t version;
+  // an index only matches the annotation file and options it was built from, a file rewritten in
+  // place with the same size is told apart by its checksum
+  int64_t annotation_file_size;
+  int64_t annotation_file_crc32c;
+  int64_t remove_images_without_annotations;
+  int64_t image_num;
+  int64_t annotation_num;
+  int64_t polygon_num;
+  int64_t segm_elem_num;
+  int64_t file_name_bytes;
+};
+
+struct COCOImageRecord {
+  int64_t id;
+  // [annotation_begin, annotation_end) in the annotation table
+  int64_t annotation_begin;
+  int64_t annotation_end;
+  int64_t file_name_offset;
+  int32_t file_name_size;
+  int32_t height;
+  int32_t width;
+  int32_t reserved;
+};
+
+struct COCOAnnotationRecord {
+  // COCO format [left, top, width, height]
+  float bbox[4];
+  // category id mapped to 1, 2, ... in category id order
+  int32_t label;
+  // 0 for run length encoded segmentations, which have no polygons
+  int32_t is_polygon_segm;
+  // [polygon_begin, polygon_end) in the polygon table
+  int64_t polygon_begin;
+  int64_t polygon_end;
+};
+
+class COCOIndex final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(COCOIndex);
+  COCOIndex() = default;
+  ~COCOIndex() = default;
+
+  // Serializes the annotation json into an index buffer, only non crowd annotations are kept.
+  static std::vector<char> Build(const std::vector<char>& annotation_json,
+                                 bool remove_images_without_annotations);
+  // Takes over buffer, false if it is not an index built with the same arguments.
+  bool Load(std::vector<char>&& buffer, const std::vector<char>& annotation_json,
+            bool remove_images_without_annotations);
+
+  const std::vector<char>& buffer() const { return buffer_; }
+  int64_t image_num() const { return header().image_num; }
+  const COCOImageRecord& image(int64_t index) const {
+    CHECK_GE(index, 0);
+    CHECK_LT(index, image_num());
+    return images_[index];
+  }
+  const COCOAnnotationRecord& annotation(int64_t annotation_index) const {
+    return annotations_[annotation_index];
+  }
+  // points of a polygon are segm()[polygon_offset(i) : polygon_offset(i + 1)]
+  int64_t polygon_offset(int64_t polygon_index) const { return polygon_offsets_[polygon_index]; }
+  const float* segm() const { return segm_; }
+  std::string ImageFileName(int64_t index) const {
+    const COCOImageRecord& record = image(index);
+    return std::string(file_names_ + record.file_name_offset, record.file_name_size);
+  }
+
+ private:
+  const COCOIndexHeader& header() const {
+    return *reinterpret_cast<const COCOIndexHeader*>(buffer_.data());
+  }
+
+  std::vector<char> buffer_;
+  const COCOImageRecord* images_;
+  const COCOAnnotationRecord* annotations_;
+  const int64_t* polygon_offsets_;
+  const float* segm_;
+  const char* file_names_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_COCO_INDEX_H_
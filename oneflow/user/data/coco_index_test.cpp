@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/coco_index.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+std::vector<char> TestAnnotationJson() {
+  const std::string json = R"({
+    "images": [
+      {"id": 3, "file_name": "c.jpg", "height": 30, "width": 40},
+      {"id": 1, "file_name": "a.jpg", "height": 10, "width": 20},
+      {"id": 2, "file_name": "b.jpg", "height": 5, "width": 5}
+    ],
+    "annotations": [
+      {"id": 10, "image_id": 3, "iscrowd": 0, "category_id": 7, "bbox": [1, 2, 3, 4],
+       "segmentation": [[0, 0, 1, 0, 1, 1, 0, 1], [2, 2, 3, 2, 3, 3, 2, 3]]},
+      {"id": 11, "image_id": 3, "iscrowd": 1, "category_id": 3, "bbox": [0, 0, 9, 9],
+       "segmentation": {"counts": [], "size": [30, 40]}},
+      {"id": 12, "image_id": 1, "iscrowd": 0, "category_id": 3, "bbox": [0, 0, 0.5, 0.5],
+       "segmentation": [[0, 0, 1, 0, 1, 1, 0, 1]]}
+    ],
+    "categories": [{"id": 7}, {"id": 3}]
+  })";
+  return std::vector<char>(json.begin(), json.end());
+}
+
+}  // namespace
+
+TEST(COCOIndex, build_and_load) {
+  COCOIndex index;
+  ASSERT_TRUE(index.Load(COCOIndex::Build(TestAnnotationJson(), true), TestAnnotationJson(), true));
+  // image 1 only has a degenerate box and image 2 has no annotation
+  ASSERT_EQ(index.image_num(), 1);
+  const COCOImageRecord& image = index.image(0);
+  ASSERT_EQ(image.id, 3);
+  ASSERT_EQ(image.height, 30);
+  ASSERT_EQ(image.width, 40);
+  ASSERT_EQ(index.ImageFileName(0), "c.jpg");
+  // the crowd annotation is dropped
+  ASSERT_EQ(image.annotation_end - image.annotation_begin, 1);
+  const COCOAnnotationRecord& anno = index.annotation(image.annotation_begin);
+  ASSERT_EQ(anno.label, 2);
+  ASSERT_EQ(anno.bbox[3], 4.f);
+  ASSERT_TRUE(anno.is_polygon_segm);
+  ASSERT_EQ(anno.polygon_end - anno.polygon_begin, 2);
+  ASSERT_EQ(index.polygon_offset(anno.polygon_begin + 1), 8);
+  ASSERT_EQ(index.polygon_offset(anno.polygon_end), 16);
+  ASSERT_EQ(index.segm()[9], 2.f);
+
+  COCOIndex all_images_index;
+  ASSERT_TRUE(all_images_index.Load(COCOIndex::Build(TestAnnotationJson(), false),
+                                    TestAnnotationJson(), false));
+  ASSERT_EQ(all_images_index.image_num(), 3);
+  ASSERT_EQ(all_images_index.ImageFileName(0), "a.jpg");
+  ASSERT_EQ(all_images_index.image(1).annotation_begin, all_images_index.image(1).annotation_end);
+}
+
+TEST(COCOIndex, load_rejects_other_index) {
+  const std::vector<char> json = TestAnnotationJson();
+  const std::vector<char> buffer = COCOIndex::Build(json, true);
+  COCOIndex index;
+  const std::vector<char> truncated_json(json.begin(), json.end() - 1);
+  ASSERT_FALSE(index.Load(std::vector<char>(buffer), truncated_json, true));
+  // the same size but other content, e.g. a file rewritten in place
+  std::vector<char> edited_json = json;
+  std::replace(edited_json.begin(), edited_json.end(), '9', '8');
+  ASSERT_FALSE(index.Load(std::vector<char>(buffer), edited_json, true));
+  ASSERT_FALSE(index.Load(std::vector<char>(buffer), json, false));
+  ASSERT_FALSE(index.Load(std::vector<char>(buffer.begin(), buffer.end() - 8), json, true));
+  ASSERT_TRUE(index.Load(std::vector<char>(buffer), json, true));
+}
+
+}  // namespace data
+}  // namespace oneflow
@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_PREFETCH_DATASET_H_
+#define ONEFLOW_USER_DATA_PREFETCH_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+namespace data {
+
+// Keeps up to prefetch_num samples of the wrapped dataset in flight and completes each of them
+// with Fetch on one of reader_num threads, e.g. to read file contents. Next returns samples in
+// the order of the wrapped dataset once their Fetch has finished.
+template<typename LoadTarget>
+class PrefetchDataset final : public Dataset<LoadTarget> {
+ public:
+  using BaseDataset = Dataset<LoadTarget>;
+  using BaseDatasetUnqPtr = std::unique_ptr<BaseDataset>;
+  using LoadTargetShdPtr = std::shared_ptr<LoadTarget>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  using FetchFn = std::function<void(LoadTarget*)>;
+
+  PrefetchDataset(int32_t reader_num, int32_t prefetch_num, const FetchFn& Fetch,
+                  BaseDatasetUnqPtr&& dataset)
+      : base_(std::move(dataset)),
+        prefetch_num_(prefetch_num),
+        fetch_fn_(Fetch),
+        reader_pool_(new ThreadPool(reader_num)) {
+    CHECK_GT(reader_num, 0);
+    CHECK_GT(prefetch_num_, 0);
+  }
+  ~PrefetchDataset() override = default;
+
+  LoadTargetShdPtrVec Next() override {
+    while (in_flight_.size() < prefetch_num_) { Prefetch(); }
+    std::shared_ptr<InFlightSamples> front = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    front->fetched_counter.WaitUntilCntEqualZero();
+    return std::move(front->samples);
+  }
+
+ private:
+  struct InFlightSamples {
+    InFlightSamples(LoadTargetShdPtrVec&& samples)
+        : samples(std::move(samples)), fetched_counter(this->samples.size()) {}
+    LoadTargetShdPtrVec samples;
+    BlockingCounter fetched_counter;
+  };
+
+  void Prefetch() {
+    auto in_flight = std::make_shared<InFlightSamples>(base_->Next());
+    const FetchFn Fetch = fetch_fn_;
+    for (const LoadTargetShdPtr& sample : in_flight->samples) {
+      reader_pool_->AddWork([Fetch, in_flight, sample]() {
+        Fetch(sample.get());
+        in_flight->fetched_counter.Decrease();
+      });
+    }
+    in_flight_.push_back(std::move(in_flight));
+  }
+
+  BaseDatasetUnqPtr base_;
+  size_t prefetch_num_;
+  FetchFn fetch_fn_;
+  std::deque<std::shared_ptr<InFlightSamples>> in_flight_;
+  // destroyed first, so pending reads finish before the other members go away
+  std::unique_ptr<ThreadPool> reader_pool_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_PREFETCH_DATASET_H_
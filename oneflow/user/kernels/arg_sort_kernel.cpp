@@ -14,7 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
-#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/user/kernels/cpu_radix_sort.h"
 
 namespace oneflow {
 
@@ -34,27 +34,26 @@ class CpuArgSortKernel final : public user_op::OpKernel {
     const std::string& direction = ctx->Attr<std::string>("direction");
     const bool is_ascending = direction == "ASCENDING";
     const bool is_descending = direction == "DESCENDING";
-    FOR_RANGE(int32_t, i, 0, instance_num) {
-      const T* in_ptr_i = in->dptr<T>() + i * instance_size;
-      int32_t* out_ptr_i = out->mut_dptr<int32_t>() + i * instance_size;
-      std::iota(out_ptr_i, out_ptr_i + instance_size, 0);
-      auto comp = [&](const int32_t lhs, const int32_t rhs) {
-        const T l = in_ptr_i[lhs];
-        const T r = in_ptr_i[rhs];
-        if (l == r) {
-          return lhs < rhs;
-        } else {
-          if (is_ascending) {
-            return l < r;
-          } else if (is_descending) {
-            return l > r;
-          } else {
-            UNIMPLEMENTED();
-          }
+    if (!is_ascending && !is_descending) { UNIMPLEMENTED(); }
+    // the radix sort is stable, so equal elements keep their index order in both directions
+    using Key = typename cpu_radix_sort::RadixKeyTraits<T>::Key;
+    const T* in_ptr = in->dptr<T>();
+    int32_t* out_ptr = out->mut_dptr<int32_t>();
+    ForEachSortTask(instance_num, instance_size, [&](int64_t begin, int64_t end, int64_t chunks) {
+      std::vector<Key> keys(instance_size);
+      std::vector<Key> keys_buf(instance_size);
+      std::vector<int32_t> indices_buf(instance_size);
+      FOR_RANGE(int64_t, i, begin, end) {
+        const T* in_ptr_i = in_ptr + i * instance_size;
+        int32_t* out_ptr_i = out_ptr + i * instance_size;
+        FOR_RANGE(int32_t, j, 0, instance_size) {
+          keys[j] = cpu_radix_sort::ToRadixKey(in_ptr_i[j], is_descending);
         }
-      };
-      std::sort(out_ptr_i, out_ptr_i + instance_size, comp);
-    }
+        std::iota(out_ptr_i, out_ptr_i + instance_size, 0);
+        CpuRadixSortPairs<Key, int32_t>(instance_size, keys.data(), out_ptr_i, keys_buf.data(),
+                                        indices_buf.data(), chunks);
+      }
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 #include "oneflow/user/kernels/random_seed_util.h"
+#include "oneflow/core/kernel/random_generator.h"
 
 namespace oneflow {
 
@@ -28,12 +29,14 @@ class BernoulliKerenl final : public user_op::OpKernel {
   std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
       user_op::KernelInitContext* ctx) const override {
     int64_t seed = GetOpKernelRandomSeed(ctx);
-    return std::make_shared<OpKernelStateWrapper<std::mt19937>>(seed);
+    return std::make_shared<OpKernelStateWrapper<RandomGenerator<DeviceType::kCPU>>>(
+        seed, ctx->device_ctx());
   }
 
  private:
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
-    auto* random_generator = dynamic_cast<OpKernelStateWrapper<std::mt19937>*>(state);
+    auto* random_generator =
+        dynamic_cast<OpKernelStateWrapper<RandomGenerator<DeviceType::kCPU>>*>(state);
     user_op::Tensor* in_blob = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out_blob = ctx->Tensor4ArgNameAndIndex("out", 0);
     const T* in_dptr = in_blob->dptr<T>();
@@ -41,12 +44,7 @@ class BernoulliKerenl final : public user_op::OpKernel {
     CHECK_EQ(GetDataType<T>(), in_blob->data_type());
     CHECK_EQ(GetDataType<K>(), out_blob->data_type());
     CHECK_EQ(in_blob->shape().elem_cnt(), out_blob->shape().elem_cnt());
-    for (int32_t i = 0; i < out_blob->shape().elem_cnt(); ++i) {
-      double prob = static_cast<double>(*(in_dptr + i));
-      CHECK(prob >= 0.0 && prob <= 1.0);
-      std::bernoulli_distribution dis(prob);
-      *(out_dptr + i) = dis(*random_generator->Mutable()) ? GetOneVal<K>() : GetZeroVal<K>();
-    }
+    random_generator->Mutable()->Bernoulli(out_blob->shape().elem_cnt(), in_dptr, out_dptr);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -61,7 +61,10 @@ class ConcatKernel final : public user_op::OpKernel {
           ctx->Tensor4ArgNameAndIndex(in_arg_pair.first, in_arg_pair.second);
       const int64_t in_cols = in_tensor->shape().Count(axis);
       CHECK_EQ(in_tensor->shape().elem_cnt(), rows * in_cols);
-      if (in_cols > 0) {
+      // the input may have been planned as a view into out, then it is already in place
+      const bool is_inplace =
+          rows == 1 && in_tensor->dptr<T>() == out_tensor->dptr<T>() + out_col_offset;
+      if (in_cols > 0 && !is_inplace) {
         NewKernelUtil<device_type>::CopyColsRegion(
             ctx->device_ctx(), rows, in_cols, in_tensor->dptr<T>(), 0, in_cols,
             out_tensor->mut_dptr<T>(), out_col_offset, out_cols);
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -64,6 +65,9 @@ const T* GetImgDptr(const user_op::Tensor* tensor, int64_t idx) {
   return tensor->dptr<T>() + tensor->shape().Count(1) * idx;
 }
 
+// Col buffers below this size are scattered back to the image in one thread.
+const int64_t kCol2ImParallelElemCnt = 1 << 14;
+
 size_t CalcElemNumOfColBuf(const ShapeView& out_shape, const ShapeView& weight_shape,
                            const int32_t idx_offset) {
   int64_t col_buf_elem_cnt = 1;
@@ -155,6 +159,17 @@ class Col2ImWriter final : public ColBufWriter<T> {
   void NextImCSize() override { this->dst_ptr_ += this->c_size_; }
 };
 
+// Every channel of col2im accumulates into its own elements of the image, so channels are
+// scattered in parallel.
+void ForEachCol2ImChannel(int64_t channels, int64_t col_elem_cnt,
+                          const std::function<void(int64_t)>& Handler) {
+  if (col_elem_cnt > kCol2ImParallelElemCnt) {
+    MaybeMultiThreadLoop(channels, [&](size_t c) { Handler(c); });
+  } else {
+    SingleThreadLoop(channels, [&](size_t c) { Handler(c); });
+  }
+}
+
 template<typename T>
 using DHWValidFunc = void (ColBufWriter<T>::*)(int64_t c, int64_t kd, int64_t kh, int64_t kw);
 
@@ -246,9 +261,21 @@ struct ConvKernelUtil final {
                           const int32_t* strides, const int32_t* dilation_rate,
                           const int32_t* padding_before, T* in_diff_ptr) {
     ColBufUtil<T> col_buf_util(in_shape, out_shape, 2, strides, dilation_rate, padding_before);
-    Col2ImWriter<T> col_buf_writer(col_buf_ptr, in_diff_ptr, in_shape.Count(2), in_shape.Count(3),
-                                   in_shape.Count(4), 1, out_shape.Count(3), out_shape.Count(4), 1);
-    DoNCDWHFunc(weight_shape, col_buf_util, &col_buf_writer);
+    // the col rows of channel c are contiguous, in the loop order of DoNCDWHFunc
+    const int64_t col_row_size = out_shape.Count(2);
+    ForEachCol2ImChannel(weight_shape.At(1), weight_shape.Count(1) * col_row_size, [&](int64_t c) {
+      Col2ImWriter<T> col_buf_writer(col_buf_ptr + c * weight_shape.Count(2) * col_row_size,
+                                     in_diff_ptr + c * in_shape.Count(2), in_shape.Count(2),
+                                     in_shape.Count(3), in_shape.Count(4), 1, out_shape.Count(3),
+                                     out_shape.Count(4), 1);
+      for (int64_t kd = 0; kd != weight_shape.At(2); ++kd) {
+        for (int64_t kh = 0; kh != weight_shape.At(3); ++kh) {
+          for (int64_t kw = 0; kw != weight_shape.At(4); ++kw) {
+            col_buf_util(&col_buf_writer, c, kd, kh, kw);
+          }
+        }
+      }
+    });
   }
 
   static void NDHWCCol2Im(const T* col_buf_ptr, const ShapeView& in_shape,
@@ -256,10 +283,24 @@ struct ConvKernelUtil final {
                           const int32_t* strides, const int32_t* dilation_rate,
                           const int32_t* padding_before, T* in_diff_ptr) {
     ColBufUtil<T> col_buf_util(in_shape, out_shape, 1, strides, dilation_rate, padding_before);
-    Col2ImWriter<T> col_buf_writer(col_buf_ptr, in_diff_ptr, in_shape.Count(2), in_shape.Count(2),
-                                   in_shape.Count(3), in_shape.Count(4), out_shape.Count(2, 4),
-                                   out_shape.Count(3, 4), 1);
-    DoNDWHCFunc(weight_shape, col_buf_util, &col_buf_writer);
+    // the col rows of channel c are interleaved with the other channels, in the loop order of
+    // DoNDWHCFunc
+    const int64_t channels = weight_shape.At(4);
+    const int64_t col_row_size = out_shape.Count(1, 4);
+    ForEachCol2ImChannel(channels, weight_shape.Count(1) * col_row_size, [&](int64_t c) {
+      const T* col_row_ptr = col_buf_ptr + c * col_row_size;
+      for (int64_t kd = 0; kd != weight_shape.At(1); ++kd) {
+        for (int64_t kh = 0; kh != weight_shape.At(2); ++kh) {
+          for (int64_t kw = 0; kw != weight_shape.At(3); ++kw) {
+            Col2ImWriter<T> col_buf_writer(col_row_ptr, in_diff_ptr, in_shape.Count(2),
+                                           in_shape.Count(2), in_shape.Count(3), in_shape.Count(4),
+                                           out_shape.Count(2, 4), out_shape.Count(3, 4), 1);
+            col_buf_util(&col_buf_writer, c, kd, kh, kw);
+            col_row_ptr += channels * col_row_size;
+          }
+        }
+      }
+    });
   }
 
  private:
@@ -485,6 +526,36 @@ REGISTER_CONV_KERNEL(conv1d, double, 1);
 REGISTER_CONV_KERNEL(conv2d, double, 2);
 REGISTER_CONV_KERNEL(conv3d, double, 3);
 
+// dx = col2im(filter(T) * dy), which is also the forward of deconv with dy as its input.
+template<typename T>
+void ComputeConvDataGrad(user_op::KernelComputeContext* ctx, ConvOpKernelState<T>* conv_state,
+                         const user_op::Tensor* dy, const user_op::Tensor* filter,
+                         user_op::Tensor* dx, user_op::Tensor* col_buf) {
+  conv_state->Update(dx->shape(), dy->shape());
+  Memset<DeviceType::kCPU>(ctx->device_ctx(), dx->mut_dptr<T>(), 0,
+                           dx->shape().elem_cnt() * sizeof(T));
+
+  int32_t idx_offset = conv_state->idx_offset_;
+  FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
+    // channels first:  col_buf' = weight(T) * out[i]'
+    // channels last :  col_buf' = weight(T) * out[i]'(T)
+    NewKernelUtil<DeviceType::kCPU>::OFGemm(
+        nullptr, CblasTrans, conv_state->is_out_diff_need_trans_,
+        conv_state->weight_5d_shape_.Count(1),                        //  ci * kd * kh * kw
+        conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
+        conv_state->weight_5d_shape_.At(0),                           //  filter
+        static_cast<T>(1), filter->dptr<T>(), GetImgDptr<T>(dy, i), static_cast<T>(0),
+        col_buf->mut_dptr<T>());
+
+    // in' = col2im(col_buf')
+    conv_state->col2im_func_(col_buf->dptr<T>(), ShapeView(conv_state->in_5d_shape_),
+                             ShapeView(conv_state->weight_5d_shape_),
+                             ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
+                             conv_state->dilation_rate_3d_.data(),
+                             conv_state->padding_before_3d_.data(), GetImgMutDptr<T>(dx, i));
+  }
+}
+
 template<typename T>
 class ConvDataGradCpuKernel final : public user_op::OpKernel {
  public:
@@ -503,33 +574,10 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
     auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state);
     CHECK_NOTNULL(conv_state);
-    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
-    const user_op::Tensor* filter = ctx->Tensor4ArgNameAndIndex("filter", 0);
-    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
-    user_op::Tensor* col_buf = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
-    conv_state->Update(dx->shape(), dy->shape());
-    Memset<DeviceType::kCPU>(ctx->device_ctx(), dx->mut_dptr<T>(), 0,
-                             dx->shape().elem_cnt() * sizeof(T));
-
-    int32_t idx_offset = conv_state->idx_offset_;
-    FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
-      // channels first:  col_buf' = weight(T) * out[i]'
-      // channels last :  col_buf' = weight(T) * out[i]'(T)
-      NewKernelUtil<DeviceType::kCPU>::OFGemm(
-          nullptr, CblasTrans, conv_state->is_out_diff_need_trans_,
-          conv_state->weight_5d_shape_.Count(1),                        //  ci * kd * kh * kw
-          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
-          conv_state->weight_5d_shape_.At(0),                           //  filter
-          static_cast<T>(1), filter->dptr<T>(), GetImgDptr<T>(dy, i), static_cast<T>(0),
-          col_buf->mut_dptr<T>());
-
-      // in' = col2im(col_buf')
-      conv_state->col2im_func_(col_buf->dptr<T>(), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), GetImgMutDptr<T>(dx, i));
-    }
+    ComputeConvDataGrad<T>(ctx, conv_state, ctx->Tensor4ArgNameAndIndex("dy", 0),
+                           ctx->Tensor4ArgNameAndIndex("filter", 0),
+                           ctx->Tensor4ArgNameAndIndex("dx", 0),
+                           ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0));
   }
 };
 
@@ -553,6 +601,52 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, float);
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, double);
 
+template<typename T>
+class DeconvCpuKernel final : public user_op::OpKernel {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DeconvCpuKernel);
+  DeconvCpuKernel() = default;
+  ~DeconvCpuKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const {
+    // deconv is the data grad of the conv from out to in, with the same weight
+    return CreateConvOpKernelState<T>(ctx, "out", "in", "weight");
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state);
+    CHECK_NOTNULL(conv_state);
+    ComputeConvDataGrad<T>(ctx, conv_state, ctx->Tensor4ArgNameAndIndex("in", 0),
+                           ctx->Tensor4ArgNameAndIndex("weight", 0),
+                           ctx->Tensor4ArgNameAndIndex("out", 0),
+                           ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0));
+  }
+};
+
+#define REGISTER_DECONV_KERNEL(op_name, dtype)                                            \
+  REGISTER_USER_KERNEL(#op_name)                                                          \
+      .SetCreateFn<DeconvCpuKernel<dtype>>()                                              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                     \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                       \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))    \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                       \
+        const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();         \
+        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape(); \
+        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));            \
+        return CalcElemNumOfColBuf(in_shape, weight_shape, idx_offset) * sizeof(dtype);   \
+      })
+
+REGISTER_DECONV_KERNEL(deconv1d, float);
+REGISTER_DECONV_KERNEL(deconv2d, float);
+REGISTER_DECONV_KERNEL(deconv3d, float);
+REGISTER_DECONV_KERNEL(deconv1d, double);
+REGISTER_DECONV_KERNEL(deconv2d, double);
+REGISTER_DECONV_KERNEL(deconv3d, double);
+
 template<typename T>
 class ConvFilterGradCpuKernel final : public user_op::OpKernel {
  public:
@@ -0,0 +1,177 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_RADIX_SORT_H_
+#define ONEFLOW_USER_KERNELS_CPU_RADIX_SORT_H_
+
+#include <array>
+#include <cstring>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace cpu_radix_sort {
+
+const int32_t kRadixBits = 8;
+const int32_t kRadixSize = 1 << kRadixBits;
+// Rows shorter than this are sorted by comparison.
+const int64_t kMinRadixSortSize = 256;
+// Rows at least this long are sorted by all threads together when there are fewer rows than
+// threads.
+const int64_t kMinParallelSortSize = 1 << 16;
+
+// Maps T to an unsigned key of the same size whose unsigned order is the order of T.
+template<typename T, typename U>
+struct SignedIntRadixKeyTraits {
+  using Key = U;
+  static constexpr U kSignBit = static_cast<U>(1) << (sizeof(U) * 8 - 1);
+  static Key ToKey(T x) { return static_cast<U>(x) ^ kSignBit; }
+  static T FromKey(Key key) { return static_cast<T>(key ^ kSignBit); }
+};
+
+template<typename T, typename U>
+struct FloatRadixKeyTraits {
+  using Key = U;
+  static constexpr U kSignBit = static_cast<U>(1) << (sizeof(U) * 8 - 1);
+  // -0.0 gets the key just below 0.0, so that sorting keeps its sign bit
+  static Key ToKey(T x) {
+    U bits;
+    std::memcpy(&bits, &x, sizeof(T));
+    return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+  }
+  static T FromKey(Key key) {
+    const U bits = (key & kSignBit) ? (key ^ kSignBit) : ~key;
+    T x;
+    std::memcpy(&x, &bits, sizeof(T));
+    return x;
+  }
+};
+
+template<typename T>
+struct RadixKeyTraits;
+
+template<>
+struct RadixKeyTraits<int32_t> : public SignedIntRadixKeyTraits<int32_t, uint32_t> {};
+template<>
+struct RadixKeyTraits<int64_t> : public SignedIntRadixKeyTraits<int64_t, uint64_t> {};
+template<>
+struct RadixKeyTraits<float> : public FloatRadixKeyTraits<float, uint32_t> {};
+template<>
+struct RadixKeyTraits<double> : public FloatRadixKeyTraits<double, uint64_t> {};
+
+// Key whose ascending order is the requested order of x.
+template<typename T>
+typename RadixKeyTraits<T>::Key ToRadixKey(T x, bool descending) {
+  const typename RadixKeyTraits<T>::Key key = RadixKeyTraits<T>::ToKey(x);
+  return descending ? ~key : key;
+}
+
+template<typename T>
+T FromRadixKey(typename RadixKeyTraits<T>::Key key, bool descending) {
+  return RadixKeyTraits<T>::FromKey(descending ? ~key : key);
+}
+
+}  // namespace cpu_radix_sort
+
+// Stable LSD radix sort of keys[0, n), values follow their keys unless values is nullptr. The
+// buffers hold n elements each, the result is left in keys and values. Every pass is split into
+// num_chunks contiguous chunks handled by the thread pool, and passes over a digit that all keys
+// share are skipped.
+template<typename K, typename V>
+void CpuRadixSortPairs(int64_t n, K* keys, V* values, K* keys_buf, V* values_buf,
+                       int64_t num_chunks) {
+  using namespace cpu_radix_sort;
+  if (n < kMinRadixSortSize) {
+    std::vector<std::pair<K, V>> pairs(n);
+    FOR_RANGE(int64_t, i, 0, n) {
+      pairs[i].first = keys[i];
+      if (values != nullptr) { pairs[i].second = values[i]; }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const std::pair<K, V>& lhs, const std::pair<K, V>& rhs) {
+                       return lhs.first < rhs.first;
+                     });
+    FOR_RANGE(int64_t, i, 0, n) {
+      keys[i] = pairs[i].first;
+      if (values != nullptr) { values[i] = pairs[i].second; }
+    }
+    return;
+  }
+  num_chunks = std::max<int64_t>(1, std::min(num_chunks, n / kMinRadixSortSize));
+  auto ChunkBegin = [&](int64_t chunk) { return n * chunk / num_chunks; };
+  std::vector<std::array<int64_t, kRadixSize>> chunk_offsets(num_chunks);
+  K* src_keys = keys;
+  K* dst_keys = keys_buf;
+  V* src_values = values;
+  V* dst_values = values_buf;
+  for (int32_t shift = 0; shift < static_cast<int32_t>(sizeof(K) * 8); shift += kRadixBits) {
+    MaybeMultiThreadLoop(num_chunks, [&](size_t chunk) {
+      std::array<int64_t, kRadixSize>& hist = chunk_offsets[chunk];
+      hist.fill(0);
+      FOR_RANGE(int64_t, i, ChunkBegin(chunk), ChunkBegin(chunk + 1)) {
+        ++hist[(src_keys[i] >> shift) & (kRadixSize - 1)];
+      }
+    });
+    int64_t offset = 0;
+    bool is_same_digit = false;
+    FOR_RANGE(int32_t, digit, 0, kRadixSize) {
+      const int64_t digit_begin = offset;
+      for (std::array<int64_t, kRadixSize>& offsets : chunk_offsets) {
+        const int64_t cnt = offsets[digit];
+        offsets[digit] = offset;
+        offset += cnt;
+      }
+      if (offset - digit_begin == n) { is_same_digit = true; }
+    }
+    if (is_same_digit) { continue; }
+    MaybeMultiThreadLoop(num_chunks, [&](size_t chunk) {
+      std::array<int64_t, kRadixSize>& offsets = chunk_offsets[chunk];
+      FOR_RANGE(int64_t, i, ChunkBegin(chunk), ChunkBegin(chunk + 1)) {
+        const int64_t pos = offsets[(src_keys[i] >> shift) & (kRadixSize - 1)]++;
+        dst_keys[pos] = src_keys[i];
+        if (values != nullptr) { dst_values[pos] = src_values[i]; }
+      }
+    });
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    if (values != nullptr) { std::copy(src_values, src_values + n, values); }
+  }
+}
+
+// Calls Handler(row_begin, row_end, num_chunks) to sort rows [row_begin, row_end) of row_size
+// elements. Rows are spread over the thread pool, unless there are fewer rows than threads and
+// they are long, then each row is sorted by num_chunks threads together.
+inline void ForEachSortTask(int64_t row_num, int64_t row_size,
+                            const std::function<void(int64_t, int64_t, int64_t)>& Handler) {
+  using namespace cpu_radix_sort;
+  const int64_t thread_num =
+      Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num();
+  if (row_num < thread_num && row_size >= kMinParallelSortSize) {
+    Handler(0, row_num, thread_num);
+    return;
+  }
+  const int64_t task_num = std::min(row_num, thread_num);
+  MaybeMultiThreadLoop(task_num, [&](size_t task_id) {
+    Handler(row_num * task_id / task_num, row_num * (task_id + 1) / task_num, 1);
+  });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_RADIX_SORT_H_
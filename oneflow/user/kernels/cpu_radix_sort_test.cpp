@@ -0,0 +1,87 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include "oneflow/user/kernels/cpu_radix_sort.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+void TestRadixArgSort(const std::vector<T>& in, bool descending, int64_t num_chunks) {
+  using Key = typename cpu_radix_sort::RadixKeyTraits<T>::Key;
+  const int64_t n = in.size();
+  std::vector<Key> keys(n);
+  std::vector<Key> keys_buf(n);
+  std::vector<int32_t> indices(n);
+  std::vector<int32_t> indices_buf(n);
+  FOR_RANGE(int64_t, i, 0, n) { keys[i] = cpu_radix_sort::ToRadixKey(in[i], descending); }
+  std::iota(indices.begin(), indices.end(), 0);
+  CpuRadixSortPairs<Key, int32_t>(n, keys.data(), indices.data(), keys_buf.data(),
+                                  indices_buf.data(), num_chunks);
+
+  std::vector<int32_t> expected(n);
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(), [&](int32_t lhs, int32_t rhs) {
+    return descending ? in[lhs] > in[rhs] : in[lhs] < in[rhs];
+  });
+  ASSERT_EQ(indices, expected);
+  FOR_RANGE(int64_t, i, 0, n) {
+    ASSERT_EQ(cpu_radix_sort::FromRadixKey<T>(keys[i], descending), in[expected[i]]);
+  }
+}
+
+}  // namespace
+
+TEST(CpuRadixSort, keys_keep_order) {
+  using Traits = cpu_radix_sort::RadixKeyTraits<float>;
+  const std::vector<float> values = {std::numeric_limits<float>::lowest(), -3.5f, -1e-30f, 0.0f,
+                                     1e-30f, 2.0f, std::numeric_limits<float>::max()};
+  FOR_RANGE(size_t, i, 1, values.size()) {
+    ASSERT_LT(Traits::ToKey(values[i - 1]), Traits::ToKey(values[i]));
+  }
+  ASSERT_EQ(Traits::ToKey(-0.0f) + 1, Traits::ToKey(0.0f));
+  ASSERT_TRUE(std::signbit(Traits::FromKey(Traits::ToKey(-0.0f))));
+  ASSERT_FALSE(std::signbit(Traits::FromKey(Traits::ToKey(0.0f))));
+  ASSERT_LT(cpu_radix_sort::RadixKeyTraits<int64_t>::ToKey(-1),
+            cpu_radix_sort::RadixKeyTraits<int64_t>::ToKey(0));
+}
+
+TEST(CpuRadixSort, matches_stable_sort) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int32_t> int_dis(-1000, 1000);
+  std::uniform_real_distribution<double> real_dis(-1e6, 1e6);
+  for (const int64_t n : {7, 300, 5000}) {
+    std::vector<int32_t> ints(n);
+    std::vector<int64_t> longs(n);
+    std::vector<float> floats(n);
+    std::vector<double> doubles(n);
+    FOR_RANGE(int64_t, i, 0, n) {
+      ints[i] = int_dis(gen);
+      longs[i] = static_cast<int64_t>(int_dis(gen)) << 40;
+      floats[i] = static_cast<float>(int_dis(gen)) / 8;
+      doubles[i] = real_dis(gen);
+    }
+    for (const bool descending : {false, true}) {
+      TestRadixArgSort(ints, descending, 1);
+      TestRadixArgSort(longs, descending, 1);
+      TestRadixArgSort(floats, descending, 4);
+      TestRadixArgSort(doubles, descending, 4);
+    }
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,140 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/util/host_gather_scatter.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+T BagScale(const std::string& mode, int64_t bag_size) {
+  return mode == "mean" ? static_cast<T>(1) / static_cast<T>(bag_size) : static_cast<T>(1);
+}
+
+}  // namespace
+
+template<typename T, typename K>
+class EmbeddingBagCpuKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingBagCpuKernel() = default;
+  ~EmbeddingBagCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    using namespace host_gather_scatter;
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* indices = ctx->Tensor4ArgNameAndIndex("indices", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t num_embeddings = weight->shape().At(0);
+    const int64_t embedding_dim = weight->shape().At(1);
+    const int64_t num_bags = indices->shape().At(0);
+    const int64_t bag_size = indices->shape().At(1);
+    const T scale = BagScale<T>(ctx->Attr<std::string>("mode"), bag_size);
+    const T* weight_ptr = weight->dptr<T>();
+    const K* indices_ptr = indices->dptr<K>();
+    T* out_ptr = out->mut_dptr<T>();
+    const int64_t bags_per_task = RowsPerTask(bag_size * embedding_dim);
+    auto PoolBags = [&](size_t task_id) {
+      const int64_t bag_begin = task_id * bags_per_task;
+      const int64_t bag_end = std::min(bag_begin + bags_per_task, num_bags);
+      const int64_t index_end = bag_end * bag_size;
+      FOR_RANGE(int64_t, bag, bag_begin, bag_end) {
+        T* to = out_ptr + bag * embedding_dim;
+        std::fill(to, to + embedding_dim, static_cast<T>(0));
+        FOR_RANGE(int64_t, i, bag * bag_size, (bag + 1) * bag_size) {
+          if (i + kPrefetchRowDistance < index_end) {
+            const int64_t ahead = indices_ptr[i + kPrefetchRowDistance];
+            if (ahead >= 0 && ahead < num_embeddings) {
+              PrefetchRow(weight_ptr + ahead * embedding_dim);
+            }
+          }
+          const int64_t idx = indices_ptr[i];
+          CHECK_GE(idx, 0);
+          CHECK_LT(idx, num_embeddings);
+          const T* from = weight_ptr + idx * embedding_dim;
+          FOR_RANGE(int64_t, k, 0, embedding_dim) { to[k] += from[k]; }
+        }
+        if (scale != static_cast<T>(1)) {
+          FOR_RANGE(int64_t, k, 0, embedding_dim) { to[k] *= scale; }
+        }
+      }
+    };
+    ForEachTask(TaskNum(num_bags, bags_per_task), num_bags * bag_size * embedding_dim, PoolBags);
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T, typename K>
+class EmbeddingBagGradCpuKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingBagGradCpuKernel() = default;
+  ~EmbeddingBagGradCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    using namespace host_gather_scatter;
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* indices = ctx->Tensor4ArgNameAndIndex("indices", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int64_t num_embeddings = dx->shape().At(0);
+    const int64_t embedding_dim = dx->shape().At(1);
+    const int64_t bag_size = indices->shape().At(1);
+    const T scale = BagScale<T>(ctx->Attr<std::string>("mode"), bag_size);
+    const T* dy_ptr = dy->dptr<T>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    std::memset(dx_ptr, 0, dx->shape().elem_cnt() * sizeof(T));
+    // an index repeated in many bags is summed by a single thread in bag order, no atomics needed
+    const SortedSegments sorted = SortSegments(
+        indices->dptr<K>(), indices->shape().elem_cnt(), /*segment_id_offset=*/0, num_embeddings);
+    const int64_t* group_begins = sorted.group_begins.data();
+    const int64_t* positions = sorted.positions.data();
+    ForEachSegmentGroupRange(sorted, embedding_dim, [&](int64_t group_begin, int64_t group_end) {
+      FOR_RANGE(int64_t, group, group_begin, group_end) {
+        T* to = dx_ptr + sorted.segments[group] * embedding_dim;
+        FOR_RANGE(int64_t, j, group_begins[group], group_begins[group + 1]) {
+          const T* from = dy_ptr + positions[j] / bag_size * embedding_dim;
+          FOR_RANGE(int64_t, k, 0, embedding_dim) { to[k] += from[k]; }
+        }
+        if (scale != static_cast<T>(1)) {
+          FOR_RANGE(int64_t, k, 0, embedding_dim) { to[k] *= scale; }
+        }
+      }
+    });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_EMBEDDING_BAG_CPU_KERNELS(data_type, indices_type)                                \
+  REGISTER_USER_KERNEL("embedding_bag")                                                            \
+      .SetCreateFn<                                                                                \
+          EmbeddingBagCpuKernel<OF_PP_PAIR_FIRST(data_type), OF_PP_PAIR_FIRST(indices_type)>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                              \
+                       & (user_op::HobDataType("weight", 0) == OF_PP_PAIR_SECOND(data_type))       \
+                       & (user_op::HobDataType("indices", 0) == OF_PP_PAIR_SECOND(indices_type))); \
+  REGISTER_USER_KERNEL("embedding_bag_grad")                                                       \
+      .SetCreateFn<EmbeddingBagGradCpuKernel<OF_PP_PAIR_FIRST(data_type),                          \
+                                             OF_PP_PAIR_FIRST(indices_type)>>()                    \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                              \
+                       & (user_op::HobDataType("dx", 0) == OF_PP_PAIR_SECOND(data_type))           \
+                       & (user_op::HobDataType("indices", 0) == OF_PP_PAIR_SECOND(indices_type)));
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_EMBEDDING_BAG_CPU_KERNELS, FLOATING_DATA_TYPE_SEQ,
+                                 INDEX_DATA_TYPE_SEQ)
+
+}  // namespace oneflow
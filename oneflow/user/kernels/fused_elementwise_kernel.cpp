@@ -0,0 +1,217 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/math_unary_elementwise_func.h"
+#include "oneflow/user/kernels/math_binary_elementwise_func.h"
+#include "oneflow/user/ops/math_binary_broadcast_seq.h"
+
+namespace oneflow {
+
+namespace {
+
+// Elements pushed through the whole chain at once, the tile stays in L1 between steps.
+const int64_t kFusedTileSize = 1024;
+// Below this the kernel runs in the calling thread.
+const int64_t kFusedParallelElemCnt = 1 << 15;
+
+// Applies one step of the chain to acc in place, operand has n elements or is a single value.
+template<typename T>
+using FusedStepFunc = void (*)(int64_t n, const T* operand, bool is_operand_scalar, T* acc);
+
+template<template<typename> class Functor, typename T>
+struct ForwardUnaryOp {
+  static T Apply(const T x) { return Functor<T>::Forward(x); }
+};
+
+template<typename T>
+struct ReluOp {
+  static T Apply(const T x) { return x > static_cast<T>(0) ? x : static_cast<T>(0); }
+};
+
+template<template<typename> class Functor, typename T>
+struct ForwardBinaryOp {
+  static T Apply(const T x, const T y) { return Functor<T>::Forward(x, y); }
+};
+
+template<template<typename> class Functor, typename T>
+struct InvokeBinaryOp {
+  static T Apply(const T x, const T y) { return Functor<T>::Invoke(x, y); }
+};
+
+template<typename T, typename Op>
+void UnaryStep(int64_t n, const T* operand, bool is_operand_scalar, T* acc) {
+  FOR_RANGE(int64_t, i, 0, n) { acc[i] = Op::Apply(acc[i]); }
+}
+
+template<typename T, typename Op, bool swap>
+void BinaryStep(int64_t n, const T* operand, bool is_operand_scalar, T* acc) {
+  if (is_operand_scalar) {
+    const T y = *operand;
+    FOR_RANGE(int64_t, i, 0, n) { acc[i] = swap ? Op::Apply(y, acc[i]) : Op::Apply(acc[i], y); }
+  } else {
+    FOR_RANGE(int64_t, i, 0, n) {
+      acc[i] = swap ? Op::Apply(operand[i], acc[i]) : Op::Apply(acc[i], operand[i]);
+    }
+  }
+}
+
+template<typename T>
+struct FusedStepFuncs {
+  FusedStepFunc<T> func;
+  FusedStepFunc<T> swapped_func;
+};
+
+template<typename T, typename Op>
+FusedStepFuncs<T> MakeUnaryStepFuncs() {
+  return {&UnaryStep<T, Op>, &UnaryStep<T, Op>};
+}
+
+template<typename T, typename Op>
+FusedStepFuncs<T> MakeBinaryStepFuncs() {
+  return {&BinaryStep<T, Op, false>, &BinaryStep<T, Op, true>};
+}
+
+#define MAKE_UNARY_STEP_FUNCS_ENTRY(op_type_name, func_prefix) \
+  {op_type_name, MakeUnaryStepFuncs<T, ForwardUnaryOp<OF_PP_CAT(func_prefix, Functor), T>>()},
+
+#define MAKE_BINARY_STEP_FUNCS_ENTRY(op_type_name, func_prefix) \
+  {op_type_name, MakeBinaryStepFuncs<T, ForwardBinaryOp<OF_PP_CAT(func_prefix, Functor), T>>()},
+
+#define MAKE_BROADCAST_STEP_FUNCS_ENTRY(op_type_name, func_prefix) \
+  {op_type_name,                                                   \
+   MakeBinaryStepFuncs<T, InvokeBinaryOp<OF_PP_CAT(BinaryFunc, func_prefix), T>>()},
+
+// Every op type fuse_elementwise_pass may put in a chain. Binary steps of the same type with a
+// constant or a tensor operand share one function.
+template<typename T>
+const HashMap<std::string, FusedStepFuncs<T>>& FusedStepFuncs4OpType() {
+  static const HashMap<std::string, FusedStepFuncs<T>> op_type2funcs = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_UNARY_STEP_FUNCS_ENTRY, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)
+      OF_PP_FOR_EACH_TUPLE(MAKE_BINARY_STEP_FUNCS_ENTRY, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)
+      OF_PP_FOR_EACH_TUPLE(MAKE_BROADCAST_STEP_FUNCS_ENTRY, MATH_BINARY_BROADCAST_FUNC_SEQ)
+      {"relu", MakeUnaryStepFuncs<T, ReluOp<T>>()},
+      {"scalar_add", MakeBinaryStepFuncs<T, InvokeBinaryOp<BinaryFuncAdd, T>>()},
+      {"scalar_mul", MakeBinaryStepFuncs<T, InvokeBinaryOp<BinaryFuncMul, T>>()},
+      {"add_n", MakeBinaryStepFuncs<T, InvokeBinaryOp<BinaryFuncAdd, T>>()},
+  };
+  return op_type2funcs;
+}
+
+#undef MAKE_UNARY_STEP_FUNCS_ENTRY
+#undef MAKE_BINARY_STEP_FUNCS_ENTRY
+#undef MAKE_BROADCAST_STEP_FUNCS_ENTRY
+
+template<typename T>
+struct FusedStep {
+  FusedStepFunc<T> func;
+  int32_t operand_index;
+  T scalar_operand;
+};
+
+template<typename T>
+class FusedElementwiseKernelState final : public user_op::OpKernelState {
+ public:
+  explicit FusedElementwiseKernelState(std::vector<FusedStep<T>>&& steps)
+      : steps_(std::move(steps)) {}
+  ~FusedElementwiseKernelState() override = default;
+
+  const std::vector<FusedStep<T>>& steps() const { return steps_; }
+
+ private:
+  std::vector<FusedStep<T>> steps_;
+};
+
+}  // namespace
+
+template<typename T, typename OutT>
+class CpuFusedElementwiseKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedElementwiseKernel() = default;
+  ~CpuFusedElementwiseKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    const auto& op_types = ctx->Attr<std::vector<std::string>>("op_types");
+    const auto& operand_indices = ctx->Attr<std::vector<int32_t>>("operand_indices");
+    const auto& swap_operands = ctx->Attr<std::vector<int32_t>>("swap_operands");
+    const auto& scalar_operands = ctx->Attr<std::vector<float>>("scalar_operands");
+    std::vector<FusedStep<T>> steps(op_types.size());
+    FOR_RANGE(size_t, i, 0, op_types.size()) {
+      const FusedStepFuncs<T>& funcs = FusedStepFuncs4OpType<T>().at(op_types.at(i));
+      steps.at(i).func = swap_operands.at(i) != 0 ? funcs.swapped_func : funcs.func;
+      steps.at(i).operand_index = operand_indices.at(i);
+      steps.at(i).scalar_operand = static_cast<T>(scalar_operands.at(i));
+    }
+    return std::make_shared<FusedElementwiseKernelState<T>>(std::move(steps));
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const auto& steps = dynamic_cast<FusedElementwiseKernelState<T>*>(state)->steps();
+    const user_op::Tensor* in_0 = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    std::vector<const T*> operands(steps.size());
+    std::vector<bool> is_operand_scalar(steps.size());
+    FOR_RANGE(size_t, i, 0, steps.size()) {
+      if (steps.at(i).operand_index < 0) {
+        operands.at(i) = &steps.at(i).scalar_operand;
+        is_operand_scalar.at(i) = true;
+      } else {
+        const user_op::Tensor* operand =
+            ctx->Tensor4ArgNameAndIndex("in", steps.at(i).operand_index);
+        operands.at(i) = operand->dptr<T>();
+        is_operand_scalar.at(i) = operand->shape().elem_cnt() != elem_cnt;
+      }
+    }
+    const T* in_ptr = in_0->dptr<T>();
+    OutT* out_ptr = out->mut_dptr<OutT>();
+    auto TileHandler = [&](size_t tile_id) {
+      const int64_t begin = tile_id * kFusedTileSize;
+      const int64_t n = std::min(kFusedTileSize, elem_cnt - begin);
+      T acc[kFusedTileSize];
+      std::copy(in_ptr + begin, in_ptr + begin + n, acc);
+      FOR_RANGE(size_t, i, 0, steps.size()) {
+        const T* operand = is_operand_scalar.at(i) ? operands.at(i) : operands.at(i) + begin;
+        steps.at(i).func(n, operand, is_operand_scalar.at(i), acc);
+      }
+      FOR_RANGE(int64_t, j, 0, n) { out_ptr[begin + j] = static_cast<OutT>(acc[j]); }
+    };
+    const int64_t tile_num = RoundUp(elem_cnt, kFusedTileSize) / kFusedTileSize;
+    if (elem_cnt > kFusedParallelElemCnt) {
+      MaybeMultiThreadLoop(tile_num, TileHandler);
+    } else {
+      SingleThreadLoop(tile_num, TileHandler);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(data_type_pair, out_data_type_pair)             \
+  REGISTER_USER_KERNEL("fused_elementwise")                                                   \
+      .SetCreateFn<CpuFusedElementwiseKernel<OF_PP_PAIR_FIRST(data_type_pair),                \
+                                             OF_PP_PAIR_FIRST(out_data_type_pair)>>()         \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                         \
+                       & (user_op::HobDataType("in", 0) == OF_PP_PAIR_SECOND(data_type_pair)) \
+                       & (user_op::HobDataType("out", 0) == OF_PP_PAIR_SECOND(out_data_type_pair)));
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL, FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ INT_DATA_TYPE_SEQ)
+
+}  // namespace oneflow
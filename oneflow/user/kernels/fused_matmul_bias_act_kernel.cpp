@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// rows of out computed and post-processed together, small enough for the tile to stay in cache
+const int64_t kRowBlockSize = 32;
+
+enum class ActivationType { kNone, kRelu, kGelu };
+
+ActivationType ActivationType4Name(const std::string& name) {
+  if (name == "none") {
+    return ActivationType::kNone;
+  } else if (name == "relu") {
+    return ActivationType::kRelu;
+  } else if (name == "gelu") {
+    return ActivationType::kGelu;
+  } else {
+    UNIMPLEMENTED();
+    return ActivationType::kNone;
+  }
+}
+
+template<typename T, ActivationType act>
+void BiasActEpilogue(int64_t rows, int64_t n, const T* bias, T* out) {
+  const T inv_sqrt2 = std::sqrt(0.5);
+  FOR_RANGE(int64_t, i, 0, rows) {
+    T* row = out + i * n;
+    FOR_RANGE(int64_t, j, 0, n) {
+      const T x = row[j] + bias[j];
+      if (act == ActivationType::kRelu) {
+        row[j] = x > static_cast<T>(0) ? x : static_cast<T>(0);
+      } else if (act == ActivationType::kGelu) {
+        row[j] = 0.5 * x * (1.0 + std::erf(inv_sqrt2 * x));
+      } else {
+        row[j] = x;
+      }
+    }
+  }
+}
+
+template<typename T>
+void BiasActEpilogue(ActivationType act, int64_t rows, int64_t n, const T* bias, T* out) {
+  if (act == ActivationType::kRelu) {
+    BiasActEpilogue<T, ActivationType::kRelu>(rows, n, bias, out);
+  } else if (act == ActivationType::kGelu) {
+    BiasActEpilogue<T, ActivationType::kGelu>(rows, n, bias, out);
+  } else {
+    BiasActEpilogue<T, ActivationType::kNone>(rows, n, bias, out);
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class CpuFusedMatmulBiasActKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedMatmulBiasActKernel() = default;
+  ~CpuFusedMatmulBiasActKernel() = default;
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const CBLAS_TRANSPOSE trans_a = ctx->Attr<bool>("transpose_a") ? CblasTrans : CblasNoTrans;
+    const CBLAS_TRANSPOSE trans_b = ctx->Attr<bool>("transpose_b") ? CblasTrans : CblasNoTrans;
+    const ActivationType act = ActivationType4Name(ctx->Attr<std::string>("activation"));
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int m = out->shape().At(0);
+    const int n = out->shape().At(1);
+    const int k = trans_a == CblasTrans ? a->shape().At(0) : a->shape().At(1);
+    const int lda = trans_a == CblasTrans ? m : k;
+    const int ldb = trans_b == CblasTrans ? k : n;
+    const T* a_ptr = a->dptr<T>();
+    const T* b_ptr = b->dptr<T>();
+    const T* bias_ptr = bias->dptr<T>();
+    T* out_ptr = out->mut_dptr<T>();
+    // each row block runs its own gemm and applies bias and activation while it is still hot
+    auto RowBlockHandler = [&](size_t block_id) {
+      const int row_begin = block_id * kRowBlockSize;
+      const int rows = std::min<int64_t>(kRowBlockSize, m - row_begin);
+      const T* a_block = trans_a == CblasTrans ? a_ptr + row_begin : a_ptr + row_begin * lda;
+      T* out_block = out_ptr + row_begin * n;
+      cblas_gemm<T>(CblasRowMajor, trans_a, trans_b, rows, n, k, GetOneVal<T>(), a_block, lda,
+                    b_ptr, ldb, GetZeroVal<T>(), out_block, n);
+      BiasActEpilogue<T>(act, rows, n, bias_ptr, out_block);
+    };
+    const int64_t block_num = RoundUp(m, kRowBlockSize) / kRowBlockSize;
+    MaybeMultiThreadLoop(block_num, RowBlockHandler);
+  }
+};
+
+#define REGISTER_CPU_FUSED_MATMUL_BIAS_ACT_KERNEL(dtype)              \
+  REGISTER_USER_KERNEL("fused_matmul_bias_act")                       \
+      .SetCreateFn<CpuFusedMatmulBiasActKernel<dtype>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value));
+
+REGISTER_CPU_FUSED_MATMUL_BIAS_ACT_KERNEL(float)
+REGISTER_CPU_FUSED_MATMUL_BIAS_ACT_KERNEL(double)
+
+}  // namespace oneflow
@@ -0,0 +1,250 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// Tensors are walked in chunks of this many elements, so that a few large and many small tensors
+// spread evenly over the thread pool.
+const int64_t kChunkElemCnt = 1 << 14;
+
+struct TensorChunk {
+  int32_t tensor_id;
+  int64_t begin;
+  int64_t end;
+};
+
+std::vector<TensorChunk> SplitIntoChunks(const std::vector<int64_t>& elem_cnts) {
+  std::vector<TensorChunk> chunks;
+  FOR_RANGE(int32_t, tensor_id, 0, elem_cnts.size()) {
+    const int64_t elem_cnt = elem_cnts.at(tensor_id);
+    for (int64_t begin = 0; begin < elem_cnt; begin += kChunkElemCnt) {
+      chunks.push_back({tensor_id, begin, std::min(begin + kChunkElemCnt, elem_cnt)});
+    }
+  }
+  return chunks;
+}
+
+void ForEachChunk(const std::vector<TensorChunk>& chunks,
+                  const std::function<void(size_t, const TensorChunk&)>& Handler) {
+  auto Handle = [&](size_t i) { Handler(i, chunks.at(i)); };
+  MaybeMultiThreadLoop(chunks.size(), Handle);
+}
+
+// RMSProp keeps its mean square out of the checkpoint like rmsprop_model_update does with its tmp
+// blob, here it lives in the kernel so that it survives between iterations.
+template<typename T>
+class MeanSquareState final : public user_op::OpKernelState {
+ public:
+  explicit MeanSquareState(int64_t elem_cnt) : mean_square_(elem_cnt) {}
+  ~MeanSquareState() override = default;
+
+  T* mut_mean_square() { return mean_square_.data(); }
+
+ private:
+  std::vector<T> mean_square_;
+};
+
+}  // namespace
+
+template<typename T>
+class MultiTensorModelUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorModelUpdateKernel() = default;
+  ~MultiTensorModelUpdateKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    if (ctx->Attr<std::string>("optimizer") != "rmsprop") {
+      return std::shared_ptr<user_op::OpKernelState>(nullptr);
+    }
+    int64_t elem_cnt = 0;
+    FOR_RANGE(int32_t, i, 0, ctx->user_op_conf().input_size("model")) {
+      elem_cnt += ctx->TensorDesc4ArgNameAndIndex("model", i)->shape().elem_cnt();
+    }
+    return std::make_shared<MeanSquareState<T>>(elem_cnt);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const std::string& optimizer = ctx->Attr<std::string>("optimizer");
+    const T learning_rate =
+        static_cast<T>(*ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>());
+    const int64_t train_step = *ctx->Tensor4ArgNameAndIndex("train_step", 0)->dptr<int64_t>();
+    const std::vector<float>& weight_decay = ctx->Attr<std::vector<float>>("weight_decay");
+    const int32_t tensor_num = ctx->user_op_conf().input_size("model");
+    std::vector<int64_t> elem_cnts(tensor_num);
+    std::vector<const T*> model_diff(tensor_num);
+    FOR_RANGE(int32_t, i, 0, tensor_num) {
+      elem_cnts.at(i) = ctx->Tensor4ArgNameAndIndex("model", i)->shape().elem_cnt();
+      model_diff.at(i) = ctx->Tensor4ArgNameAndIndex("model_diff", i)->dptr<T>();
+    }
+    const std::vector<T*> model = MutPtrs4ArgName(ctx, "model");
+    const std::vector<TensorChunk> chunks = SplitIntoChunks(elem_cnts);
+
+    if (optimizer == "naive") {
+      ForEachChunk(chunks, [&](size_t, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        T* w = model.at(chunk.tensor_id);
+        const T wd = static_cast<T>(weight_decay.at(chunk.tensor_id));
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          w[i] = w[i] - learning_rate * (g[i] + wd * w[i]);
+        }
+      });
+    } else if (optimizer == "momentum") {
+      const T beta = static_cast<T>(ctx->Attr<float>("beta"));
+      const std::vector<T*> momentum = MutPtrs4ArgName(ctx, "momentum");
+      ForEachChunk(chunks, [&](size_t, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        T* w = model.at(chunk.tensor_id);
+        T* mom = momentum.at(chunk.tensor_id);
+        const T wd = static_cast<T>(weight_decay.at(chunk.tensor_id));
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          const T next_momentum = beta * mom[i] - learning_rate * g[i];
+          mom[i] = next_momentum;
+          w[i] = w[i] + next_momentum - learning_rate * wd * w[i];
+        }
+      });
+    } else if (optimizer == "rmsprop") {
+      const T decay_rate = train_step == 0 ? 0 : static_cast<T>(ctx->Attr<float>("decay_rate"));
+      const T epsilon = static_cast<T>(ctx->Attr<float>("epsilon"));
+      std::vector<T*> mean_square(tensor_num);
+      T* mean_square_ptr = dynamic_cast<MeanSquareState<T>*>(state)->mut_mean_square();
+      FOR_RANGE(int32_t, i, 0, tensor_num) {
+        mean_square.at(i) = mean_square_ptr;
+        mean_square_ptr += elem_cnts.at(i);
+      }
+      ForEachChunk(chunks, [&](size_t, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        T* w = model.at(chunk.tensor_id);
+        T* ms = mean_square.at(chunk.tensor_id);
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          ms[i] = (1 - decay_rate) * g[i] * g[i] + decay_rate * ms[i];
+          w[i] = w[i] - learning_rate * g[i] / std::sqrt(ms[i] + epsilon);
+        }
+      });
+    } else if (optimizer == "lars") {
+      const T beta = static_cast<T>(ctx->Attr<float>("beta"));
+      const T epsilon = static_cast<T>(ctx->Attr<float>("epsilon"));
+      const T lars_coefficient = static_cast<T>(ctx->Attr<float>("lars_coefficient"));
+      const std::vector<T*> momentum = MutPtrs4ArgName(ctx, "momentum");
+      // per chunk partial sums first, then the per tensor local learning rate
+      std::vector<T> model_sum_sq(chunks.size());
+      std::vector<T> model_diff_sum_sq(chunks.size());
+      ForEachChunk(chunks, [&](size_t chunk_id, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        const T* w = model.at(chunk.tensor_id);
+        T w_sum_sq = 0;
+        T g_sum_sq = 0;
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          w_sum_sq += w[i] * w[i];
+          g_sum_sq += g[i] * g[i];
+        }
+        model_sum_sq.at(chunk_id) = w_sum_sq;
+        model_diff_sum_sq.at(chunk_id) = g_sum_sq;
+      });
+      std::vector<T> model_norm(tensor_num, 0);
+      std::vector<T> model_diff_norm(tensor_num, 0);
+      FOR_RANGE(size_t, chunk_id, 0, chunks.size()) {
+        model_norm.at(chunks.at(chunk_id).tensor_id) += model_sum_sq.at(chunk_id);
+        model_diff_norm.at(chunks.at(chunk_id).tensor_id) += model_diff_sum_sq.at(chunk_id);
+      }
+      std::vector<T> local_learning_rate(tensor_num);
+      FOR_RANGE(int32_t, i, 0, tensor_num) {
+        const T w_norm = std::sqrt(model_norm.at(i) / elem_cnts.at(i));
+        const T g_norm = std::sqrt(model_diff_norm.at(i) / elem_cnts.at(i));
+        const T wd = static_cast<T>(weight_decay.at(i));
+        local_learning_rate.at(i) = learning_rate * lars_coefficient * w_norm
+                                    / (epsilon + g_norm + (train_step == 0 ? 0 : wd * w_norm));
+      }
+      ForEachChunk(chunks, [&](size_t, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        T* w = model.at(chunk.tensor_id);
+        T* mom = momentum.at(chunk.tensor_id);
+        const T wd = static_cast<T>(weight_decay.at(chunk.tensor_id));
+        const T local_lr = local_learning_rate.at(chunk.tensor_id);
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          mom[i] = beta * mom[i] - local_lr * (g[i] + wd * w[i]);
+          w[i] = w[i] + mom[i];
+        }
+      });
+    } else if (optimizer == "adam") {
+      const T beta1 = static_cast<T>(ctx->Attr<float>("beta1"));
+      const T beta2 = static_cast<T>(ctx->Attr<float>("beta2"));
+      const T epsilon = static_cast<T>(ctx->Attr<float>("epsilon"));
+      const std::vector<T*> m = MutPtrs4ArgName(ctx, "m");
+      const std::vector<T*> v = MutPtrs4ArgName(ctx, "v");
+      // the moments are divided by 1 - beta_t in place, 1 without bias correction
+      std::vector<T> m_denom(tensor_num, 1);
+      std::vector<T> v_denom(tensor_num, 1);
+      if (ctx->Attr<bool>("do_bias_correction")) {
+        const std::vector<T*> beta1_t = MutPtrs4ArgName(ctx, "beta1_t");
+        const std::vector<T*> beta2_t = MutPtrs4ArgName(ctx, "beta2_t");
+        FOR_RANGE(int32_t, i, 0, tensor_num) {
+          if (train_step != 0) {
+            *beta1_t.at(i) *= beta1;
+            *beta2_t.at(i) *= beta2;
+          }
+          m_denom.at(i) = 1 - *beta1_t.at(i);
+          v_denom.at(i) = 1 - *beta2_t.at(i);
+        }
+      }
+      ForEachChunk(chunks, [&](size_t, const TensorChunk& chunk) {
+        const T* g = model_diff.at(chunk.tensor_id);
+        T* w = model.at(chunk.tensor_id);
+        T* m_ptr = m.at(chunk.tensor_id);
+        T* v_ptr = v.at(chunk.tensor_id);
+        const T wd = static_cast<T>(weight_decay.at(chunk.tensor_id));
+        const T m_dn = m_denom.at(chunk.tensor_id);
+        const T v_dn = v_denom.at(chunk.tensor_id);
+        FOR_RANGE(int64_t, i, chunk.begin, chunk.end) {
+          const T m_i = (beta1 * m_ptr[i] + (1 - beta1) * g[i]) / m_dn;
+          const T v_i = (beta2 * v_ptr[i] + (1 - beta2) * g[i] * g[i]) / v_dn;
+          m_ptr[i] = m_i;
+          v_ptr[i] = v_i;
+          w[i] = w[i] - learning_rate * (m_i / (std::sqrt(v_i) + epsilon) + wd * w[i]);
+        }
+      });
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+
+  static std::vector<T*> MutPtrs4ArgName(user_op::KernelComputeContext* ctx,
+                                         const std::string& arg_name) {
+    std::vector<T*> ptrs(ctx->user_op_conf().input_size(arg_name));
+    FOR_RANGE(int32_t, i, 0, ptrs.size()) {
+      ptrs.at(i) = ctx->Tensor4ArgNameAndIndex(arg_name, i)->mut_dptr<T>();
+    }
+    return ptrs;
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_MODEL_UPDATE_KERNEL(dtype)              \
+  REGISTER_USER_KERNEL("multi_tensor_model_update")                   \
+      .SetCreateFn<MultiTensorModelUpdateKernel<dtype>>()             \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value));
+
+REGISTER_MULTI_TENSOR_MODEL_UPDATE_KERNEL(float)
+REGISTER_MULTI_TENSOR_MODEL_UPDATE_KERNEL(double)
+
+}  // namespace oneflow
@@ -38,8 +38,13 @@ void DecodeOneRawOFRecord(const Feature& feature, T* dptr, int64_t sample_elem_c
     CHECK_EQ(feature.bytes_list().value_size(), 1);
     const auto& value0 = feature.bytes_list().value(0);
     auto in_dptr = reinterpret_cast<const int8_t*>(value0.c_str());
+    const int64_t padding_elem_num =
+        auto_zero_padding ? std::max<int64_t>(sample_elem_cnt - value0.size(), 0) : 0;
     sample_elem_cnt = std::min<int64_t>(sample_elem_cnt, value0.size());
     CopyElem<int8_t, T>(in_dptr, dptr, sample_elem_cnt);
+    if (padding_elem_num > 0) {
+      std::memset(dptr + sample_elem_cnt, 0, padding_elem_num * sizeof(T));
+    }
   }
 #define DEFINE_ONE_ELIF(PbT, CppT)                                                                \
   else if (feature.has_##PbT##_list()) {                                                          \
@@ -67,6 +72,32 @@ void DecodeOneRawOFRecord(const Feature& feature, T* dptr, int64_t sample_elem_c
   }
 }
 
+// Number of dim1 rows of the sample, each row holding dim1_elem_cnt elements.
+int64_t Dim1LengthOfOneRawOFRecord(const Feature& feature, int64_t dim1_elem_cnt) {
+  int64_t elem_cnt = 0;
+  if (feature.has_bytes_list()) {
+    CHECK_EQ(feature.bytes_list().value_size(), 1);
+    elem_cnt = feature.bytes_list().value(0).size();
+  } else if (feature.has_float_list()) {
+    elem_cnt = feature.float_list().value_size();
+  } else if (feature.has_double_list()) {
+    elem_cnt = feature.double_list().value_size();
+  } else if (feature.has_int32_list()) {
+    elem_cnt = feature.int32_list().value_size();
+  } else if (feature.has_int64_list()) {
+    elem_cnt = feature.int64_list().value_size();
+  } else {
+    UNIMPLEMENTED();
+  }
+  return RoundUp(elem_cnt, dim1_elem_cnt) / dim1_elem_cnt;
+}
+
+const Feature& GetFeatureOfRecord(const OFRecord& record, const std::string& name) {
+  const auto it = record.feature().find(name);
+  CHECK(it != record.feature().end()) << "Field " << name << " not found";
+  return it->second;
+}
+
 }  // namespace
 
 template<typename T>
@@ -89,6 +120,25 @@ class OFRecordRawDecoderKernel final : public user_op::OpKernel {
 
     bool auto_zero_padding = ctx->Attr<bool>("auto_zero_padding");
     bool dim1_varying_length = ctx->Attr<bool>("dim1_varying_length");
+    const auto& buckets = ctx->Attr<std::vector<int64_t>>("dim1_length_buckets");
+    if (!buckets.empty()) {
+      // pad the batch only up to the smallest bucket holding its longest sample, so downstream
+      // kernels see at most buckets.size() shapes and keep hitting their infer caches
+      const int64_t dim1_elem_cnt = ctx->Attr<Shape>("shape").Count(1);
+      int64_t max_length = 0;
+      FOR_RANGE(int64_t, i, 0, record_num) {
+        max_length = std::max(max_length, Dim1LengthOfOneRawOFRecord(
+                                              GetFeatureOfRecord(records[i], name), dim1_elem_cnt));
+      }
+      const auto bucket_it = std::lower_bound(buckets.cbegin(), buckets.cend(), max_length);
+      CHECK(bucket_it != buckets.cend())
+          << "Field " << name << " has a sample of length " << max_length
+          << " longer than the last bucket " << buckets.back();
+      out_blob->mut_shape()->Set(1, *bucket_it);
+      sample_elem_cnt = *bucket_it * dim1_elem_cnt;
+      dim1_varying_length = true;
+      auto_zero_padding = true;
+    }
 
     MultiThreadLoop(record_num, [&](size_t i) {
       const OFRecord& record = *(records + i);
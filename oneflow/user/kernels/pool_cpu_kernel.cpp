@@ -16,7 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 #include "oneflow/user/utils/pool_util.h"
-#include "oneflow/core/common/eigen_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -33,312 +33,279 @@ struct PoolOpKernelState final : public user_op::OpKernelState {
   }
 };
 
+// Pooling geometry in 5-D NCDHW terms, whatever the data format.
+struct PoolGeometry {
+  int64_t batch;
+  int64_t channels;
+  int64_t in_dims[3];
+  int64_t out_dims[3];
+  int64_t pool_size[3];
+  int64_t strides[3];
+  int64_t padding_before[3];
+
+  explicit PoolGeometry(const Params3D& params_3d) {
+    const Shape in = params_3d.GetXShape5D();
+    const Shape out = params_3d.GetYShape5D();
+    batch = in.At(0);
+    channels = in.At(1);
+    FOR_RANGE(int32_t, i, 0, 3) {
+      in_dims[i] = in.At(2 + i);
+      out_dims[i] = out.At(2 + i);
+      pool_size[i] = params_3d.pool_size_3d().at(i);
+      strides[i] = params_3d.strides_3d().at(i);
+      padding_before[i] = params_3d.padding_before_3d().at(i);
+    }
+  }
+  int64_t in_spatial() const { return in_dims[0] * in_dims[1] * in_dims[2]; }
+  int64_t out_spatial() const { return out_dims[0] * out_dims[1] * out_dims[2]; }
+};
+
+// The input window [begin, end) along each spatial axis of one output position.
+struct PoolWindow {
+  int64_t begin[3];
+  int64_t end[3];
+
+  PoolWindow(const PoolGeometry& geo, const int64_t* out_index) {
+    FOR_RANGE(int32_t, i, 0, 3) {
+      const int64_t start = out_index[i] * geo.strides[i] - geo.padding_before[i];
+      end[i] = std::min(start + geo.pool_size[i], geo.in_dims[i]);
+      begin[i] = std::max(start, static_cast<int64_t>(0));
+    }
+  }
+  int64_t size() const {
+    return (end[0] - begin[0]) * (end[1] - begin[1]) * (end[2] - begin[2]);
+  }
+};
+
 template<typename T>
-struct PoolCpuKernelUtil {
- public:
-  typedef std::function<T()> ForwardInitialize;
-  typedef std::function<void(const T& lhs, T& rhs)> CFirstProcess;
-  typedef std::function<void(const int64_t in_col, const int64_t out_col,
-                             ConstEigenMatrixMap<T>& in_mat, EigenMatrixMap<T>& out_mat)>
-      CLastProcess;
-  typedef std::function<void(const int64_t size, T& out)> CFirstFinalize;
-  typedef std::function<void(const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat)>
-      CLastFinalize;
-  typedef std::function<void(const T& in, const T& out, const T& out_diff, const int64_t size,
-                             T& in_diff)>
-      CFirstProcessGrad;
-  typedef std::function<void(const int64_t out_col, const int64_t in_col, const int64_t size,
-                             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr)>
-      CLastProcessGrad;
-
-  static void CFirstForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                            user_op::Tensor* out_blob, const ForwardInitialize& initialize,
-                            const CFirstProcess& process, const CFirstFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    const T* input = in_blob->dptr<T>();
-    T* output = out_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              T res = initialize();
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t input_index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[input_index], res);
-                  }
-                }
-              }
-              finalize((dend - dstart) * (hend - hstart) * (wend - wstart), res);
-              output[pool_index] = res;
-            }
-          }
-        }
-        input += in.Count(2);
-        output += out.Count(2);
+struct MaxPoolFunctor {
+  static T Init() { return GetMinVal<T>(); }
+  static void Reduce(const T x, T& acc) { acc = x > acc ? x : acc; }
+  static T Finalize(const T acc, const int64_t size) { return acc; }
+};
+
+template<typename T>
+struct AvgPoolFunctor {
+  static T Init() { return GetZeroVal<T>(); }
+  static void Reduce(const T x, T& acc) { acc += x; }
+  static T Finalize(const T acc, const int64_t size) { return acc / static_cast<T>(size); }
+};
+
+template<typename F>
+void ForEachOutIndex(const PoolGeometry& geo, const F& Handler) {
+  int64_t out_index[3];
+  int64_t out_offset = 0;
+  for (out_index[0] = 0; out_index[0] < geo.out_dims[0]; ++out_index[0]) {
+    for (out_index[1] = 0; out_index[1] < geo.out_dims[1]; ++out_index[1]) {
+      for (out_index[2] = 0; out_index[2] < geo.out_dims[2]; ++out_index[2]) {
+        Handler(out_offset++, PoolWindow(geo, out_index));
       }
     }
   }
+}
 
-  static void CFirstBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                             const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                             user_op::Tensor* in_diff_blob, const CFirstProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    const T* output_diff = out_diff_blob->dptr<T>();
-    const T* output = out_blob->dptr<T>();
-    const T* input = in_blob->dptr<T>();
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
-    T* input_diff = in_diff_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[index], output[pool_index], output_diff[pool_index], size,
-                            input_diff[index]);
-                  }
-                }
-              }
-            }
-          }
-        }
-        // offset
-        input += in.Count(2);
-        input_diff += in.Count(2);
-        output += out.Count(2);
-        output_diff += out.Count(2);
-      }
+template<typename F>
+void ForEachInOffset(const PoolGeometry& geo, const PoolWindow& window, const F& Handler) {
+  FOR_RANGE(int64_t, d, window.begin[0], window.end[0]) {
+    FOR_RANGE(int64_t, h, window.begin[1], window.end[1]) {
+      const int64_t row_offset = (d * geo.in_dims[1] + h) * geo.in_dims[2];
+      FOR_RANGE(int64_t, w, window.begin[2], window.end[2]) { Handler(row_offset + w); }
     }
   }
+}
 
-  static void CLastForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                           user_op::Tensor* out_blob, const ForwardInitialize& forward_initialize,
-                           const CLastProcess& process, const CLastFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    ConstEigenMatrixMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    EigenMatrixMap<T> out_mat(out_blob->mut_dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int out_col = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            out_mat.col(out_col).setConstant(forward_initialize());
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int in_col = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(in_col, out_col, in_mat, out_mat);
-                }
-              }
-            }
-            finalize((hend - hstart) * (wend - wstart) * (dend - dstart), out_col, out_mat);
-          }
-        }
+// One D*H*W plane of channels_first input. kPool > 0 fixes a kPool x kPool window at compile time
+// for the windows that lie entirely inside the input.
+template<typename T, typename Functor, int64_t kPool>
+void CFirstForwardPlane(const PoolGeometry& geo, const T* in, T* out) {
+  const int64_t in_w = geo.in_dims[2];
+  ForEachOutIndex(geo, [&](const int64_t out_offset, const PoolWindow& window) {
+    T acc = Functor::Init();
+    if (kPool > 0 && window.size() == kPool * kPool) {
+      const T* in_window = in + (window.begin[0] * geo.in_dims[1] + window.begin[1]) * in_w
+                           + window.begin[2];
+      for (int64_t h = 0; h < kPool; ++h) {
+        for (int64_t w = 0; w < kPool; ++w) { Functor::Reduce(in_window[h * in_w + w], acc); }
       }
+    } else {
+      ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+        Functor::Reduce(in[in_offset], acc);
+      });
     }
+    out[out_offset] = Functor::Finalize(acc, window.size());
+  });
+}
+
+template<typename T, typename Functor>
+void CFirstForward(const PoolGeometry& geo, const T* in, T* out) {
+  const bool is_2d_square = geo.pool_size[0] == 1 && geo.pool_size[1] == geo.pool_size[2];
+  auto PlaneForward = &CFirstForwardPlane<T, Functor, 0>;
+  if (is_2d_square && geo.pool_size[1] == 2) {
+    PlaneForward = &CFirstForwardPlane<T, Functor, 2>;
+  } else if (is_2d_square && geo.pool_size[1] == 3) {
+    PlaneForward = &CFirstForwardPlane<T, Functor, 3>;
   }
+  MaybeMultiThreadLoop(geo.batch * geo.channels, [&](size_t plane) {
+    PlaneForward(geo, in + plane * geo.in_spatial(), out + plane * geo.out_spatial());
+  });
+}
+
+// One task per output row, each position vectorized across the contiguous channels.
+template<typename T, typename Functor>
+void CLastForward(const PoolGeometry& geo, const T* in, T* out) {
+  const int64_t channels = geo.channels;
+  const int64_t out_row_num = geo.out_dims[0] * geo.out_dims[1];
+  MaybeMultiThreadLoop(geo.batch * out_row_num, [&](size_t task_id) {
+    const int64_t n = task_id / out_row_num;
+    const int64_t out_row = task_id % out_row_num;
+    const T* in_sample = in + n * geo.in_spatial() * channels;
+    T* out_row_ptr = out + task_id * geo.out_dims[2] * channels;
+    int64_t out_index[3] = {out_row / geo.out_dims[1], out_row % geo.out_dims[1], 0};
+    for (; out_index[2] < geo.out_dims[2]; ++out_index[2]) {
+      const PoolWindow window(geo, out_index);
+      T* out_vec = out_row_ptr + out_index[2] * channels;
+      std::fill(out_vec, out_vec + channels, Functor::Init());
+      ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+        const T* in_vec = in_sample + in_offset * channels;
+        for (int64_t c = 0; c < channels; ++c) { Functor::Reduce(in_vec[c], out_vec[c]); }
+      });
+      const int64_t size = window.size();
+      for (int64_t c = 0; c < channels; ++c) { out_vec[c] = Functor::Finalize(out_vec[c], size); }
+    }
+  });
+}
+
+template<typename T>
+void CFirstBackward(const PoolGeometry& geo, bool is_max, const T* in, const T* out_diff,
+                    T* in_diff) {
+  std::memset(in_diff, 0, geo.batch * geo.channels * geo.in_spatial() * sizeof(T));
+  MaybeMultiThreadLoop(geo.batch * geo.channels, [&](size_t plane) {
+    const T* in_plane = in + plane * geo.in_spatial();
+    const T* out_diff_plane = out_diff + plane * geo.out_spatial();
+    T* in_diff_plane = in_diff + plane * geo.in_spatial();
+    ForEachOutIndex(geo, [&](const int64_t out_offset, const PoolWindow& window) {
+      const T dy = out_diff_plane[out_offset];
+      if (is_max) {
+        // the gradient goes to the first maximum only, found in one pass without reading y
+        int64_t arg_max = -1;
+        T max_val = GetMinVal<T>();
+        ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+          if (arg_max == -1 || in_plane[in_offset] > max_val) {
+            max_val = in_plane[in_offset];
+            arg_max = in_offset;
+          }
+        });
+        if (arg_max != -1) { in_diff_plane[arg_max] += dy; }
+      } else {
+        const T dx = dy / static_cast<T>(window.size());
+        ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+          in_diff_plane[in_offset] += dx;
+        });
+      }
+    });
+  });
+}
 
-  static void CLastBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                            const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                            user_op::Tensor* in_diff_blob, const CLastProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    // caffe2 implementation: need check
-    ConstEigenArrayMap<T> out_mat(out_blob->dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    ConstEigenArrayMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    ConstEigenArrayMap<T> out_diff_mat(out_diff_blob->dptr<T>(), out.At(1),
-                                       out.elem_cnt() / out.At(1));
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
-    EigenArrayMap<T> in_diff_mat(in_diff_blob->mut_dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int64_t pool_index = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int64_t input_index = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(pool_index, input_index, size, out_mat, in_mat, out_diff_mat,
-                          in_diff_mat);
-                }
-              }
-            }
+// Windows overlap, so tasks own disjoint channel blocks of one sample instead of output rows.
+template<typename T>
+void CLastBackward(const PoolGeometry& geo, bool is_max, const T* in, const T* out_diff,
+                   T* in_diff) {
+  const int64_t kChannelBlockSize = 64;
+  const int64_t channels = geo.channels;
+  const int64_t block_num = RoundUp(channels, kChannelBlockSize) / kChannelBlockSize;
+  std::memset(in_diff, 0, geo.batch * geo.in_spatial() * channels * sizeof(T));
+  MaybeMultiThreadLoop(geo.batch * block_num, [&](size_t task_id) {
+    const int64_t n = task_id / block_num;
+    const int64_t c_begin = task_id % block_num * kChannelBlockSize;
+    const int64_t c_end = std::min(c_begin + kChannelBlockSize, channels);
+    const T* in_sample = in + n * geo.in_spatial() * channels;
+    const T* out_diff_sample = out_diff + n * geo.out_spatial() * channels;
+    T* in_diff_sample = in_diff + n * geo.in_spatial() * channels;
+    T max_val[kChannelBlockSize];
+    int64_t arg_max[kChannelBlockSize];
+    ForEachOutIndex(geo, [&](const int64_t out_offset, const PoolWindow& window) {
+      const T* dy_vec = out_diff_sample + out_offset * channels;
+      if (is_max) {
+        // the gradient goes to the first maximum only, found in one pass without reading y
+        std::fill(max_val, max_val + kChannelBlockSize, GetMinVal<T>());
+        std::fill(arg_max, arg_max + kChannelBlockSize, -1);
+        ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+          const T* in_vec = in_sample + in_offset * channels;
+          for (int64_t c = c_begin; c < c_end; ++c) {
+            const bool is_greater = arg_max[c - c_begin] == -1 || in_vec[c] > max_val[c - c_begin];
+            max_val[c - c_begin] = is_greater ? in_vec[c] : max_val[c - c_begin];
+            arg_max[c - c_begin] = is_greater ? in_offset : arg_max[c - c_begin];
           }
+        });
+        for (int64_t c = c_begin; c < c_end; ++c) {
+          const int64_t in_offset = arg_max[c - c_begin];
+          if (in_offset != -1) { in_diff_sample[in_offset * channels + c] += dy_vec[c]; }
         }
+      } else {
+        const T scale = GetOneVal<T>() / static_cast<T>(window.size());
+        ForEachInOffset(geo, window, [&](const int64_t in_offset) {
+          T* dx_vec = in_diff_sample + in_offset * channels;
+          for (int64_t c = c_begin; c < c_end; ++c) { dx_vec[c] += dy_vec[c] * scale; }
+        });
       }
-    }
-  }
+    });
+  });
+}
 
-  static void AvgFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+template<typename T>
+struct PoolCpuKernelUtil {
+ public:
+  template<template<typename> class Functor>
+  static void FWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
+    const PoolGeometry geo(pool_state->GetParams3D());
     const std::string& data_format = ctx->Attr<std::string>("data_format");
     if (data_format == "channels_first") {
-      CFirstForward(pool_state->GetParams3D(), x, y, GetZeroVal<T>,
-                    [](const T& lhs, T& rhs) { rhs += lhs; },
-                    [](const int64_t size, T& out) { out /= size; });
+      CFirstForward<T, Functor<T>>(geo, x->dptr<T>(), y->mut_dptr<T>());
     } else if (data_format == "channels_last") {
-      CLastForward(pool_state->GetParams3D(), x, y, GetZeroVal<T>,
-                   [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-                      EigenMatrixMap<T>& out_mat) { out_mat.col(out_col) += in_mat.col(in_col); },
-                   [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {
-                     out_mat.col(col) /= size;
-                   });
+      CLastForward<T, Functor<T>>(geo, x->dptr<T>(), y->mut_dptr<T>());
     } else {
       UNIMPLEMENTED();
     }
   }
 
-  static void AvgBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+  static void BWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+                        bool is_max) {
     const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
+    const PoolGeometry geo(pool_state->GetParams3D());
     const std::string& data_format = ctx->Attr<std::string>("data_format");
     if (data_format == "channels_first") {
-      CFirstBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                     [](const T& in, const T& out, const T& out_diff, const int64_t size,
-                        T& in_diff) { in_diff += (out_diff / static_cast<T>(size)); });
+      CFirstBackward<T>(geo, is_max, x->dptr<T>(), dy->dptr<T>(), dx->mut_dptr<T>());
     } else if (data_format == "channels_last") {
-      CLastBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                    [](const int64_t out_col, const int64_t in_col, const int64_t size,
-                       ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                       ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-                      in_diff_arr.col(in_col) += out_diff_arr.col(out_col) / static_cast<T>(size);
-                    });
+      CLastBackward<T>(geo, is_max, x->dptr<T>(), dy->dptr<T>(), dx->mut_dptr<T>());
     } else {
       UNIMPLEMENTED();
     }
   }
 
+  static void AvgFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+    FWCompute<AvgPoolFunctor>(ctx, state);
+  }
+
+  static void AvgBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+    BWCompute(ctx, state, false);
+  }
+
   static void MaxFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
-    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
-    auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
-    CHECK(pool_state != nullptr);
-    pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstForward(pool_state->GetParams3D(), x, y, GetMinVal<T>,
-                    [](const T& lhs, T& rhs) {
-                      if (lhs > rhs) { rhs = lhs; }
-                    },
-                    [](const int64_t size, T& out) {});
-    } else if (data_format == "channels_last") {
-      CLastForward(pool_state->GetParams3D(), x, y, GetMinVal<T>,
-                   [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-                      EigenMatrixMap<T>& out_mat) {
-                     out_mat.col(out_col) = out_mat.col(out_col).cwiseMax(in_mat.col(in_col));
-                   },
-                   [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {});
-    } else {
-      UNIMPLEMENTED();
-    }
+    FWCompute<MaxPoolFunctor>(ctx, state);
   }
 
   static void MaxBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
-    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
-    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
-    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
-    auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
-    CHECK(pool_state != nullptr);
-    pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const T& in, const T& out, const T& out_diff, const int64_t size, T& in_diff) {
-            if (in == out) { in_diff += out_diff; }
-          });
-    } else if (data_format == "channels_last") {
-      CLastBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const int64_t out_col, const int64_t in_col, const int64_t size,
-             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-            in_diff_arr.col(in_col) +=
-                out_diff_arr.col(out_col)
-                * (in_arr.col(in_col).cwiseEqual(out_arr.col(out_col)).template cast<T>());
-          });
-    } else {
-      UNIMPLEMENTED();
-    }
+    BWCompute(ctx, state, true);
   }
 };
 
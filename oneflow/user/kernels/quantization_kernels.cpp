@@ -0,0 +1,201 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/persistent_out_stream.h"
+#include "oneflow/user/kernels/quantization_util.h"
+
+namespace oneflow {
+
+namespace {
+
+struct MinMaxObserverState final : public user_op::OpKernelState {
+  std::vector<float> min;
+  std::vector<float> max;
+  std::string output_path;
+};
+
+}  // namespace
+
+template<typename T>
+class MinMaxObserverKernel final : public user_op::OpKernel {
+ public:
+  MinMaxObserverKernel() = default;
+  ~MinMaxObserverKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    auto state = std::make_shared<MinMaxObserverState>();
+    state->output_path = ctx->Attr<std::string>("output_path");
+    // every rank keeps the range of its own slice, the reader merges them
+    if (ctx->parallel_ctx().parallel_num() > 1) {
+      state->output_path += "-" + std::to_string(ctx->parallel_ctx().parallel_id());
+    }
+    LocalFS()->RecursivelyCreateDirIfNotExist(Dirname(state->output_path));
+    return state;
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    if (in->shape().elem_cnt() == 0) { return; }
+    auto* observer_state = dynamic_cast<MinMaxObserverState*>(state);
+    CHECK_NOTNULL(observer_state);
+    const int32_t axis = ctx->Attr<int32_t>("per_channel_axis");
+    const int64_t channel_num = axis == -1 ? 1 : in->shape().At(axis);
+    const int64_t inner_size = axis == -1 ? in->shape().elem_cnt() : in->shape().Count(axis + 1);
+    const int64_t outer_size = in->shape().elem_cnt() / (channel_num * inner_size);
+    std::vector<float>* min = &observer_state->min;
+    std::vector<float>* max = &observer_state->max;
+    if (min->empty()) {
+      min->assign(channel_num, GetMaxVal<float>());
+      max->assign(channel_num, GetMinVal<float>());
+    }
+    CHECK_EQ(min->size(), channel_num);
+    const T* in_ptr = in->dptr<T>();
+    bool is_widened = false;
+    FOR_RANGE(int64_t, i, 0, outer_size) {
+      FOR_RANGE(int64_t, c, 0, channel_num) {
+        const T* slice = in_ptr + (i * channel_num + c) * inner_size;
+        const auto min_max = std::minmax_element(slice, slice + inner_size);
+        if (static_cast<float>(*min_max.first) < min->at(c)) {
+          min->at(c) = static_cast<float>(*min_max.first);
+          is_widened = true;
+        }
+        if (static_cast<float>(*min_max.second) > max->at(c)) {
+          max->at(c) = static_cast<float>(*min_max.second);
+          is_widened = true;
+        }
+      }
+    }
+    // the file always holds the latest range, so it only needs rewriting when the range grows
+    if (!is_widened) { return; }
+    std::string text;
+    FOR_RANGE(int64_t, c, 0, channel_num) {
+      text += std::to_string(min->at(c)) + " " + std::to_string(max->at(c)) + "\n";
+    }
+    PersistentOutStream out_stream(LocalFS(), observer_state->output_path);
+    out_stream << text;
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MIN_MAX_OBSERVER_KERNEL(dtype)                       \
+  REGISTER_USER_KERNEL("min_max_observer")                            \
+      .SetCreateFn<MinMaxObserverKernel<dtype>>()                     \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value));
+
+REGISTER_MIN_MAX_OBSERVER_KERNEL(float)
+REGISTER_MIN_MAX_OBSERVER_KERNEL(double)
+
+class QuantizeKernel final : public user_op::OpKernel {
+ public:
+  QuantizeKernel() = default;
+  ~QuantizeKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const float inv_scale = 1.0f / ctx->Attr<float>("scale");
+    const int32_t zero_point = ctx->Attr<int32_t>("zero_point");
+    const float* in_ptr = in->dptr<float>();
+    uint8_t* out_ptr = out->mut_dptr<uint8_t>();
+    FOR_RANGE(int64_t, i, 0, in->shape().elem_cnt()) {
+      out_ptr[i] = QuantizeValue<uint8_t>(in_ptr[i], inv_scale, zero_point);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantize").SetCreateFn<QuantizeKernel>().SetIsMatchedHob(
+    user_op::HobDeviceType() == DeviceType::kCPU);
+
+class DequantizeKernel final : public user_op::OpKernel {
+ public:
+  DequantizeKernel() = default;
+  ~DequantizeKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const float scale = ctx->Attr<float>("scale");
+    const int32_t zero_point = ctx->Attr<int32_t>("zero_point");
+    const uint8_t* in_ptr = in->dptr<uint8_t>();
+    float* out_ptr = out->mut_dptr<float>();
+    FOR_RANGE(int64_t, i, 0, in->shape().elem_cnt()) {
+      out_ptr[i] = scale * static_cast<float>(static_cast<int32_t>(in_ptr[i]) - zero_point);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("dequantize").SetCreateFn<DequantizeKernel>().SetIsMatchedHob(
+    user_op::HobDeviceType() == DeviceType::kCPU);
+
+class QuantizeWeightKernel final : public user_op::OpKernel {
+ public:
+  QuantizeWeightKernel() = default;
+  ~QuantizeWeightKernel() = default;
+
+ private:
+  // The variable may be loaded or trained between runs, so it is quantized again by every run.
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    int8_t* out_ptr = out->mut_dptr<int8_t>();
+    float* scale_ptr = scale->mut_dptr<float>();
+    const int64_t channel_num = scale->shape().elem_cnt();
+    const int32_t axis = ctx->Attr<int32_t>("axis");
+    const int64_t outer_size = in->shape().Count(0, axis);
+    const int64_t inner_size = in->shape().Count(axis + 1);
+    const float* in_ptr = in->dptr<float>();
+    std::fill(scale_ptr, scale_ptr + channel_num, 0.0f);
+    FOR_RANGE(int64_t, i, 0, outer_size) {
+      FOR_RANGE(int64_t, c, 0, channel_num) {
+        const float* slice = in_ptr + (i * channel_num + c) * inner_size;
+        FOR_RANGE(int64_t, j, 0, inner_size) {
+          scale_ptr[c] = std::max(scale_ptr[c], std::abs(slice[j]));
+        }
+      }
+    }
+    FOR_RANGE(int64_t, c, 0, channel_num) { scale_ptr[c] = ChooseInt8SymmetricScale(scale_ptr[c]); }
+    FOR_RANGE(int64_t, i, 0, outer_size) {
+      FOR_RANGE(int64_t, c, 0, channel_num) {
+        const int64_t offset = (i * channel_num + c) * inner_size;
+        const float inv_scale = 1.0f / scale_ptr[c];
+        FOR_RANGE(int64_t, j, 0, inner_size) {
+          out_ptr[offset + j] = QuantizeValue<int8_t>(in_ptr[offset + j], inv_scale, 0);
+        }
+      }
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantize_weight")
+    .SetCreateFn<QuantizeWeightKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceType() == DeviceType::kCPU);
+
+}  // namespace oneflow
@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_QUANTIZATION_UTIL_H_
+#define ONEFLOW_USER_KERNELS_QUANTIZATION_UTIL_H_
+
+#include <cmath>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+// Activations are quantized to asymmetric uint8 with a zero point, weights to symmetric int8 with
+// one scale per output channel, so real = scale * (q - zero_point).
+struct QuantizationParam {
+  float scale;
+  int32_t zero_point;
+};
+
+// The range is widened to contain 0 so that zero padding stays exact after quantization.
+inline QuantizationParam ChooseUint8QuantizationParam(float min, float max) {
+  min = std::min(min, 0.0f);
+  max = std::max(max, 0.0f);
+  QuantizationParam param;
+  param.scale = max > min ? (max - min) / 255.0f : 1.0f;
+  const float zero_point = std::nearbyint(-min / param.scale);
+  param.zero_point = static_cast<int32_t>(std::min(std::max(zero_point, 0.0f), 255.0f));
+  return param;
+}
+
+inline float ChooseInt8SymmetricScale(float abs_max) {
+  return abs_max > 0.0f ? abs_max / 127.0f : 1.0f;
+}
+
+template<typename Q>
+inline Q QuantizeValue(float x, float inv_scale, int32_t zero_point) {
+  const int32_t q = static_cast<int32_t>(std::nearbyint(x * inv_scale)) + zero_point;
+  return static_cast<Q>(std::min<int32_t>(std::max<int32_t>(q, GetMinVal<Q>()), GetMaxVal<Q>()));
+}
+
+inline int32_t DotU8S8S32(int64_t k, const uint8_t* a, const int8_t* b) {
+  int32_t acc = 0;
+  FOR_RANGE(int64_t, i, 0, k) { acc += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]); }
+  return acc;
+}
+
+inline int32_t SumS8S32(int64_t k, const int8_t* b) {
+  int32_t sum = 0;
+  FOR_RANGE(int64_t, i, 0, k) { sum += b[i]; }
+  return sum;
+}
+
+// out[i * n + j] = a_scale * b_scale[j] * sum_k (a[i][k] - a_zero_point) * b[j][k] + bias[j]
+// where both a (m x k) and b (n x k) are row major, so every dot product reads contiguous memory.
+// The int32 accumulator is requantized straight to float. bias may be nullptr.
+inline void QuantizedGemmU8S8ToFloat(int64_t m, int64_t n, int64_t k, const uint8_t* a,
+                                     float a_scale, int32_t a_zero_point, const int8_t* b,
+                                     const float* b_scale, const int32_t* b_row_sum,
+                                     const float* bias, float* out) {
+  const int64_t kRowBlockSize = 16;
+  auto RowBlockHandler = [&](size_t block_id) {
+    const int64_t row_begin = block_id * kRowBlockSize;
+    const int64_t row_end = std::min(row_begin + kRowBlockSize, m);
+    FOR_RANGE(int64_t, i, row_begin, row_end) {
+      const uint8_t* a_row = a + i * k;
+      float* out_row = out + i * n;
+      FOR_RANGE(int64_t, j, 0, n) {
+        const int32_t acc = DotU8S8S32(k, a_row, b + j * k) - a_zero_point * b_row_sum[j];
+        out_row[j] = a_scale * b_scale[j] * static_cast<float>(acc);
+        if (bias != nullptr) { out_row[j] += bias[j]; }
+      }
+    }
+  };
+  const int64_t block_num = RoundUp(m, kRowBlockSize) / kRowBlockSize;
+  MaybeMultiThreadLoop(block_num, RowBlockHandler);
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_QUANTIZATION_UTIL_H_
@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/quantization_util.h"
+
+namespace oneflow {
+
+TEST(Quantization, uint8_param_keeps_zero_exact) {
+  const QuantizationParam param = ChooseUint8QuantizationParam(-1.0f, 3.0f);
+  ASSERT_FLOAT_EQ(param.scale, 4.0f / 255.0f);
+  ASSERT_EQ(QuantizeValue<uint8_t>(0.0f, 1.0f / param.scale, param.zero_point), param.zero_point);
+  ASSERT_EQ(QuantizeValue<uint8_t>(-100.0f, 1.0f / param.scale, param.zero_point), 0);
+  ASSERT_EQ(QuantizeValue<uint8_t>(100.0f, 1.0f / param.scale, param.zero_point), 255);
+
+  const QuantizationParam positive_param = ChooseUint8QuantizationParam(2.0f, 4.0f);
+  ASSERT_EQ(positive_param.zero_point, 0);
+}
+
+TEST(Quantization, gemm_u8s8_matches_float_reference) {
+  const int64_t m = 37;
+  const int64_t n = 5;
+  const int64_t k = 19;
+  std::vector<float> a(m * k);
+  std::vector<float> b(n * k);
+  FOR_RANGE(int64_t, i, 0, a.size()) { a[i] = static_cast<float>((i * 7) % 23) / 11.0f - 0.5f; }
+  FOR_RANGE(int64_t, i, 0, b.size()) { b[i] = static_cast<float>((i * 5) % 17) / 8.0f - 1.0f; }
+
+  const QuantizationParam a_param = ChooseUint8QuantizationParam(-0.5f, 22.0f / 11.0f - 0.5f);
+  std::vector<uint8_t> a_q(a.size());
+  FOR_RANGE(int64_t, i, 0, a.size()) {
+    a_q[i] = QuantizeValue<uint8_t>(a[i], 1.0f / a_param.scale, a_param.zero_point);
+  }
+  std::vector<float> b_scale(n);
+  std::vector<int8_t> b_q(b.size());
+  std::vector<int32_t> b_row_sum(n);
+  FOR_RANGE(int64_t, j, 0, n) {
+    float abs_max = 0.0f;
+    FOR_RANGE(int64_t, i, 0, k) { abs_max = std::max(abs_max, std::abs(b[j * k + i])); }
+    b_scale[j] = ChooseInt8SymmetricScale(abs_max);
+    FOR_RANGE(int64_t, i, 0, k) {
+      b_q[j * k + i] = QuantizeValue<int8_t>(b[j * k + i], 1.0f / b_scale[j], 0);
+    }
+    b_row_sum[j] = SumS8S32(k, b_q.data() + j * k);
+  }
+  std::vector<float> bias(n, 0.25f);
+  std::vector<float> out(m * n);
+  QuantizedGemmU8S8ToFloat(m, n, k, a_q.data(), a_param.scale, a_param.zero_point, b_q.data(),
+                           b_scale.data(), b_row_sum.data(), bias.data(), out.data());
+  FOR_RANGE(int64_t, i, 0, m) {
+    FOR_RANGE(int64_t, j, 0, n) {
+      float expected = bias[j];
+      FOR_RANGE(int64_t, l, 0, k) { expected += a[i * k + l] * b[j * k + l]; }
+      ASSERT_NEAR(out[i * n + j], expected, 0.1f);
+    }
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,145 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cstring>
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/quantization_util.h"
+
+namespace oneflow {
+
+namespace {
+
+struct QuantizedConv2dTmpLayout {
+  int64_t col_size;
+  int64_t out_size;
+  int64_t weight_row_sum_size;
+};
+
+QuantizedConv2dTmpLayout GetTmpLayout(const ShapeView& in_shape, const ShapeView& out_shape,
+                                      const std::vector<int32_t>& kernel_size) {
+  const int64_t out_spatial = out_shape.Count(2);
+  QuantizedConv2dTmpLayout layout;
+  layout.col_size =
+      GetCudaAlignedSize(out_spatial * in_shape.At(1) * kernel_size.at(0) * kernel_size.at(1));
+  layout.out_size = GetCudaAlignedSize(out_spatial * out_shape.At(1) * sizeof(float));
+  layout.weight_row_sum_size = GetCudaAlignedSize(out_shape.At(1) * sizeof(int32_t));
+  return layout;
+}
+
+// col is (out_h * out_w) x (channels * kernel_h * kernel_w), padded with the zero point so that
+// padding dequantizes to exactly 0. Output rows are filled in parallel.
+void Im2ColU8(const uint8_t* in, int64_t channels, int64_t in_h, int64_t in_w, int64_t out_h,
+              int64_t out_w, const std::vector<int32_t>& kernel_size,
+              const std::vector<int32_t>& padding_before, const std::vector<int32_t>& strides,
+              const std::vector<int32_t>& dilation_rate, uint8_t pad_value, uint8_t* col) {
+  const int64_t kernel_h = kernel_size.at(0);
+  const int64_t kernel_w = kernel_size.at(1);
+  const int64_t col_row_size = channels * kernel_h * kernel_w;
+  auto OutRowHandler = [&](size_t oh) {
+    uint8_t* col_ptr = col + oh * out_w * col_row_size;
+    FOR_RANGE(int64_t, ow, 0, out_w) {
+      const int64_t iw_begin = ow * strides.at(1) - padding_before.at(1);
+      const int64_t iw_last = iw_begin + (kernel_w - 1) * dilation_rate.at(1);
+      // a kernel row without dilation and padding is a contiguous run of the input row
+      const bool is_row_contiguous = dilation_rate.at(1) == 1 && iw_begin >= 0 && iw_last < in_w;
+      FOR_RANGE(int64_t, c, 0, channels) {
+        FOR_RANGE(int64_t, kh, 0, kernel_h) {
+          const int64_t ih = oh * strides.at(0) - padding_before.at(0) + kh * dilation_rate.at(0);
+          if (ih < 0 || ih >= in_h) {
+            std::memset(col_ptr, pad_value, kernel_w);
+          } else if (is_row_contiguous) {
+            std::memcpy(col_ptr, in + (c * in_h + ih) * in_w + iw_begin, kernel_w);
+          } else {
+            FOR_RANGE(int64_t, kw, 0, kernel_w) {
+              const int64_t iw = iw_begin + kw * dilation_rate.at(1);
+              col_ptr[kw] = iw >= 0 && iw < in_w ? in[(c * in_h + ih) * in_w + iw] : pad_value;
+            }
+          }
+          col_ptr += kernel_w;
+        }
+      }
+    }
+  };
+  MaybeMultiThreadLoop(out_h, OutRowHandler);
+}
+
+}  // namespace
+
+class QuantizedConv2dKernel final : public user_op::OpKernel {
+ public:
+  QuantizedConv2dKernel() = default;
+  ~QuantizedConv2dKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* weight_scale = ctx->Tensor4ArgNameAndIndex("weight_scale", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+    const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+    const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+    const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+    const float in_scale = ctx->Attr<float>("in_scale");
+    const int32_t in_zero_point = ctx->Attr<int32_t>("in_zero_point");
+    const QuantizedConv2dTmpLayout layout = GetTmpLayout(in->shape(), out->shape(), kernel_size);
+    uint8_t* col = tmp_buffer->mut_dptr<uint8_t>();
+    float* col_out = reinterpret_cast<float*>(tmp_buffer->mut_dptr<char>() + layout.col_size);
+    int32_t* weight_row_sum = reinterpret_cast<int32_t*>(tmp_buffer->mut_dptr<char>()
+                                                         + layout.col_size + layout.out_size);
+
+    const int64_t batch = in->shape().At(0);
+    const int64_t channels = in->shape().At(1);
+    const int64_t filters = out->shape().At(1);
+    const int64_t out_spatial = out->shape().Count(2);
+    const int64_t k = weight->shape().Count(1);
+    const int8_t* weight_ptr = weight->dptr<int8_t>();
+    // the weight may change between runs, e.g. by load_variables, so its sums are not kept
+    FOR_RANGE(int64_t, f, 0, filters) { weight_row_sum[f] = SumS8S32(k, weight_ptr + f * k); }
+    FOR_RANGE(int64_t, i, 0, batch) {
+      Im2ColU8(in->dptr<uint8_t>() + i * in->shape().Count(1), channels, in->shape().At(2),
+               in->shape().At(3), out->shape().At(2), out->shape().At(3), kernel_size,
+               padding_before, strides, dilation_rate, static_cast<uint8_t>(in_zero_point), col);
+      QuantizedGemmU8S8ToFloat(out_spatial, filters, k, col, in_scale, in_zero_point, weight_ptr,
+                               weight_scale->dptr<float>(), weight_row_sum,
+                               bias == nullptr ? nullptr : bias->dptr<float>(), col_out);
+      // col_out is spatial x filters, out is channels_first
+      float* out_ptr = out->mut_dptr<float>() + i * filters * out_spatial;
+      auto FilterHandler = [&](size_t f) {
+        FOR_RANGE(int64_t, p, 0, out_spatial) {
+          out_ptr[f * out_spatial + p] = col_out[p * filters + f];
+        }
+      };
+      MaybeMultiThreadLoop(filters, FilterHandler);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_conv2d")
+    .SetCreateFn<QuantizedConv2dKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceType() == DeviceType::kCPU)
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      const QuantizedConv2dTmpLayout layout =
+          GetTmpLayout(ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape(),
+                       ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape(),
+                       ctx->Attr<std::vector<int32_t>>("kernel_size"));
+      return layout.col_size + layout.out_size + layout.weight_row_sum_size;
+    });
+
+}  // namespace oneflow
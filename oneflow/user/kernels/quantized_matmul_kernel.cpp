@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/quantization_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// b is only known at run time, e.g. a variable changed by load_variables, so its packed form and
+// row sums are made by every Compute. Both are O(n * k), against O(m * n * k) for the gemm.
+struct QuantizedMatmulTmpLayout {
+  int64_t packed_b_size;
+  int64_t b_row_sum_size;
+};
+
+QuantizedMatmulTmpLayout GetTmpLayout(int64_t n, int64_t k, bool transpose_b) {
+  QuantizedMatmulTmpLayout layout;
+  // b as n x k, none if b is transposed already
+  layout.packed_b_size = transpose_b ? 0 : GetCudaAlignedSize(n * k * sizeof(int8_t));
+  layout.b_row_sum_size = GetCudaAlignedSize(n * sizeof(int32_t));
+  return layout;
+}
+
+}  // namespace
+
+class QuantizedMatmulKernel final : public user_op::OpKernel {
+ public:
+  QuantizedMatmulKernel() = default;
+  ~QuantizedMatmulKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* b_scale = ctx->Tensor4ArgNameAndIndex("b_scale", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int64_t m = out->shape().At(0);
+    const int64_t n = out->shape().At(1);
+    const int64_t k = a->shape().At(1);
+    const bool transpose_b = ctx->Attr<bool>("transpose_b");
+    const QuantizedMatmulTmpLayout layout = GetTmpLayout(n, k, transpose_b);
+    const int8_t* b_ptr = b->dptr<int8_t>();
+    if (!transpose_b) {
+      // pack b to n x k so that every output element is a contiguous dot product
+      int8_t* packed_b = tmp_buffer->mut_dptr<int8_t>();
+      FOR_RANGE(int64_t, i, 0, k) {
+        FOR_RANGE(int64_t, j, 0, n) { packed_b[j * k + i] = b_ptr[i * n + j]; }
+      }
+      b_ptr = packed_b;
+    }
+    int32_t* b_row_sum =
+        reinterpret_cast<int32_t*>(tmp_buffer->mut_dptr<char>() + layout.packed_b_size);
+    FOR_RANGE(int64_t, j, 0, n) { b_row_sum[j] = SumS8S32(k, b_ptr + j * k); }
+    QuantizedGemmU8S8ToFloat(m, n, k, a->dptr<uint8_t>(), ctx->Attr<float>("a_scale"),
+                             ctx->Attr<int32_t>("a_zero_point"), b_ptr, b_scale->dptr<float>(),
+                             b_row_sum, bias == nullptr ? nullptr : bias->dptr<float>(),
+                             out->mut_dptr<float>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<QuantizedMatmulKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceType() == DeviceType::kCPU)
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      const Shape* out_shape = ctx->Shape4ArgNameAndIndex("out", 0);
+      const QuantizedMatmulTmpLayout layout =
+          GetTmpLayout(out_shape->At(1), ctx->Shape4ArgNameAndIndex("a", 0)->At(1),
+                       ctx->Attr<bool>("transpose_b"));
+      return layout.packed_b_size + layout.b_row_sum_size;
+    });
+
+}  // namespace oneflow
@@ -14,15 +14,26 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/random_mask_generator.h"
+#include "oneflow/core/kernel/philox_random.h"
 
 namespace oneflow {
 
 void RandomMaskGenerator<DeviceType::kCPU>::Generate(DeviceCtx* device_ctx, const int64_t n,
                                                      const float rate, int8_t* mask) {
   CHECK_GE(n, 0);
-  std::uniform_real_distribution<float> random_distribution(GetZeroVal<float>(),
-                                                            GetOneVal<float>());
-  for (int64_t i = 0; i < n; ++i) { mask[i] = random_distribution(mt19937_generator_) > rate; }
+  const int64_t block_size = PhiloxRandom::kResultElementCount;
+  const uint64_t seed = seed_;
+  const uint64_t offset = offset_;
+  PhiloxParallelFor(n, block_size, [&](int64_t begin, int64_t end) {
+    PhiloxRandom gen(seed, 0, offset + begin / block_size);
+    for (int64_t i = begin; i < end; i += block_size) {
+      const PhiloxRandom::ResultType sample = gen();
+      FOR_RANGE(int64_t, j, 0, std::min(block_size, end - i)) {
+        mask[i + j] = Uint32ToFloat(sample[j]) > rate;
+      }
+    }
+  });
+  offset_ += PhiloxBlockNum(n, block_size);
 }
 
 template class RandomMaskGenerator<DeviceType::kCPU>;
@@ -0,0 +1,166 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/slice_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// Elements copied by one task of the thread pool, below it the slice runs in one thread.
+const int64_t kSliceTaskElemCnt = 1 << 14;
+
+// The sliced tensor as rows of one contiguous run each. The run covers the innermost axes that
+// have stride 1, up to and including the first of them that is not taken whole.
+struct SliceRunLayout {
+  int64_t run_axis;
+  int64_t run_len;
+  int64_t row_cnt;
+  int64_t entire_strides[kSliceMaxDims];
+};
+
+SliceRunLayout GetSliceRunLayout(const SliceParams& params) {
+  SliceRunLayout layout;
+  layout.run_axis = params.ndims;
+  layout.run_len = 1;
+  for (int64_t i = params.ndims - 1; i >= 0; --i) {
+    if (params.stride[i] != 1) { break; }
+    layout.run_axis = i;
+    layout.run_len *= params.sliced_dims[i];
+    if (params.sliced_dims[i] != params.dims[i]) { break; }
+  }
+  layout.row_cnt = 1;
+  FOR_RANGE(int64_t, i, 0, layout.run_axis) { layout.row_cnt *= params.sliced_dims[i]; }
+  layout.entire_strides[params.ndims - 1] = 1;
+  for (int64_t i = params.ndims - 2; i >= 0; --i) {
+    layout.entire_strides[i] = layout.entire_strides[i + 1] * params.dims[i + 1];
+  }
+  return layout;
+}
+
+// Calls Handler(entire_offset, sliced_offset) for every run of rows [row_begin, row_end).
+template<typename Handler>
+void ForEachSliceRun(const SliceParams& params, const SliceRunLayout& layout, int64_t row_begin,
+                     int64_t row_end, const Handler& handler) {
+  const int64_t run_axis = layout.run_axis;
+  const int64_t* entire_strides = layout.entire_strides;
+  int64_t index[kSliceMaxDims];
+  int64_t entire_offset =
+      run_axis < params.ndims ? params.begin[run_axis] * entire_strides[run_axis] : 0;
+  int64_t remaining = row_begin;
+  for (int64_t i = run_axis - 1; i >= 0; --i) {
+    index[i] = remaining % params.sliced_dims[i];
+    remaining /= params.sliced_dims[i];
+    entire_offset += (params.begin[i] + params.stride[i] * index[i]) * entire_strides[i];
+  }
+  FOR_RANGE(int64_t, row, row_begin, row_end) {
+    handler(entire_offset, row * layout.run_len);
+    for (int64_t i = run_axis - 1; i >= 0; --i) {
+      entire_offset += params.stride[i] * entire_strides[i];
+      if (++index[i] < params.sliced_dims[i]) { break; }
+      entire_offset -= params.sliced_dims[i] * params.stride[i] * entire_strides[i];
+      index[i] = 0;
+    }
+  }
+}
+
+template<typename Handler>
+void ParallelForEachSliceRun(const SliceParams& params, const Handler& handler) {
+  const SliceRunLayout layout = GetSliceRunLayout(params);
+  const int64_t rows_per_task = std::max<int64_t>(1, kSliceTaskElemCnt / layout.run_len);
+  const int64_t task_num = RoundUp(layout.row_cnt, rows_per_task) / rows_per_task;
+  auto Task = [&](size_t task_id) {
+    const int64_t row_begin = task_id * rows_per_task;
+    const int64_t row_end = std::min(row_begin + rows_per_task, layout.row_cnt);
+    ForEachSliceRun(params, layout, row_begin, row_end, handler);
+  };
+  MaybeMultiThreadLoop(task_num, Task);
+}
+
+template<typename T>
+void CopyRun(const T* src, T* dst, int64_t run_len) {
+  if (run_len == 1) {
+    *dst = *src;
+  } else {
+    std::memcpy(dst, src, run_len * sizeof(T));
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class SliceCpuKernel final : public user_op::OpKernel {
+ public:
+  SliceCpuKernel() = default;
+  ~SliceCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* output = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const SliceParams params = ConstructSliceParams(ctx, input, output);
+    const int64_t run_len = GetSliceRunLayout(params).run_len;
+    const T* entire = input->dptr<T>();
+    T* part = output->mut_dptr<T>();
+    ParallelForEachSliceRun(params, [&](int64_t entire_offset, int64_t part_offset) {
+      CopyRun(entire + entire_offset, part + part_offset, run_len);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class SliceGradCpuKernel final : public user_op::OpKernel {
+ public:
+  SliceGradCpuKernel() = default;
+  ~SliceGradCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    size_t dx_byte_size = dx->shape().elem_cnt() * sizeof(T);
+    Memset<DeviceType::kCPU>(ctx->device_ctx(), dx->mut_dptr<T>(), 0, dx_byte_size);
+    const SliceParams params = ConstructSliceParams(ctx, dx, dy);
+    const int64_t run_len = GetSliceRunLayout(params).run_len;
+    const T* part = dy->dptr<T>();
+    T* entire = dx->mut_dptr<T>();
+    ParallelForEachSliceRun(params, [&](int64_t entire_offset, int64_t part_offset) {
+      CopyRun(part + part_offset, entire + entire_offset, run_len);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_SLICE_CPU_KERNEL(dtype)                                               \
+  REGISTER_USER_KERNEL("slice_v2")                                                     \
+      .SetCreateFn<SliceCpuKernel<dtype>>()                                            \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                  \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)); \
+  REGISTER_USER_KERNEL("slice_grad_v2")                                                \
+      .SetCreateFn<SliceGradCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                  \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_SLICE_CPU_KERNEL(float)
+REGISTER_SLICE_CPU_KERNEL(double)
+REGISTER_SLICE_CPU_KERNEL(int32_t)
+REGISTER_SLICE_CPU_KERNEL(int64_t)
+REGISTER_SLICE_CPU_KERNEL(int8_t)
+
+}  // namespace oneflow
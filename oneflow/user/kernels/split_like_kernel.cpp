@@ -62,7 +62,10 @@ class SplitLikeKernel final : public user_op::OpKernel {
           ctx->Tensor4ArgNameAndIndex(out_arg_pair.first, out_arg_pair.second);
       const int64_t out_cols = out_tensor->shape().Count(axis);
       CHECK_EQ(out_tensor->shape().elem_cnt(), rows * out_cols);
-      if (out_cols > 0) {
+      // the output may have been planned as a view into in, then it is already in place
+      const bool is_inplace =
+          rows == 1 && out_tensor->dptr<T>() == in_tensor->dptr<T>() + in_col_offset;
+      if (out_cols > 0 && !is_inplace) {
         NewKernelUtil<device_type>::CopyColsRegion(ctx->device_ctx(), rows, out_cols,
                                                    in_tensor->dptr<T>(), in_col_offset, in_cols,
                                                    out_tensor->mut_dptr<T>(), 0, out_cols);
@@ -16,11 +16,15 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/user/kernels/cpu_radix_sort.h"
 
 namespace oneflow {
 
 namespace {
 
+// k up to this is selected with a heap and larger k with a radix selection, as on gpu.
+const int32_t kMaxHeapSelectionK = 128;
+
 template<typename T>
 void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, int32_t* out_ptr) {
   FOR_RANGE(int32_t, i, range.begin(), range.end()) {
@@ -29,32 +33,115 @@ void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, i
   }
 }
 
+// Larger values first, equal values by index.
 template<typename T>
-void ComputeTopK(const T* in_ptr, int32_t* indices_ptr, const Range& range, int32_t instance_size,
-                 int32_t k, bool sorted, int32_t* out_ptr) {
-  FOR_RANGE(int32_t, i, range.begin(), range.end()) {
-    const int32_t offset = i * instance_size;
-    const T* in_ptr_i = in_ptr + offset;
-    int32_t* indices_ptr_i = indices_ptr + offset;
-    std::iota(indices_ptr_i, indices_ptr_i + instance_size, 0);
-    auto comp = [&](const int32_t lhs, const int32_t rhs) {
-      const T l = in_ptr_i[lhs];
-      const T r = in_ptr_i[rhs];
-      if (l == r) {
-        return lhs < rhs;
-      } else {
-        return l > r;
-      }
-    };
-    std::nth_element(indices_ptr_i, indices_ptr_i + k, indices_ptr_i + instance_size, comp);
-    if (sorted) { std::sort(indices_ptr_i, indices_ptr_i + k, comp); }
-    std::copy(indices_ptr_i, indices_ptr_i + k, out_ptr + i * k);
+bool IsBetterTopKElem(const T* in_ptr_i, int32_t lhs, int32_t rhs) {
+  const T l = in_ptr_i[lhs];
+  const T r = in_ptr_i[rhs];
+  if (l == r) {
+    return lhs < rhs;
+  } else {
+    return l > r;
+  }
+}
+
+// Keeps the k best indices in a heap whose top is the worst of them, so most elements of the row
+// are rejected by a single comparison.
+template<typename T>
+void HeapSelectionTopK(const T* in_ptr_i, int32_t instance_size, int32_t k, bool sorted,
+                       int32_t* out_ptr_i) {
+  if (k == 0) { return; }
+  auto comp = [&](const int32_t lhs, const int32_t rhs) {
+    return IsBetterTopKElem(in_ptr_i, lhs, rhs);
+  };
+  int32_t* heap_end = out_ptr_i + k;
+  std::iota(out_ptr_i, heap_end, 0);
+  std::make_heap(out_ptr_i, heap_end, comp);
+  FOR_RANGE(int32_t, j, k, instance_size) {
+    if (comp(j, *out_ptr_i)) {
+      std::pop_heap(out_ptr_i, heap_end, comp);
+      *(heap_end - 1) = j;
+      std::push_heap(out_ptr_i, heap_end, comp);
+    }
+  }
+  if (sorted) { std::sort_heap(out_ptr_i, heap_end, comp); }
+}
+
+template<typename Key>
+struct RadixSelectionBuffer {
+  RadixSelectionBuffer(int32_t instance_size, int32_t k)
+      : keys(instance_size), selected_keys(k), keys_buf(k), indices_buf(k) {}
+  std::vector<Key> keys;
+  std::vector<Key> selected_keys;
+  std::vector<Key> keys_buf;
+  std::vector<int32_t> indices_buf;
+};
+
+// Finds the k-th best key digit by digit from the most significant one, each pass only counting
+// the keys that still share the found prefix, then collects the keys up to it.
+template<typename T>
+void RadixSelectionTopK(const T* in_ptr_i, int32_t instance_size, int32_t k, bool sorted,
+                        RadixSelectionBuffer<typename cpu_radix_sort::RadixKeyTraits<T>::Key>* buf,
+                        int32_t* out_ptr_i) {
+  using namespace cpu_radix_sort;
+  using Key = typename RadixKeyTraits<T>::Key;
+  // descending keys, so that the better element has the smaller key
+  Key* keys = buf->keys.data();
+  FOR_RANGE(int32_t, j, 0, instance_size) { keys[j] = ToRadixKey(in_ptr_i[j], true); }
+  Key prefix = 0;
+  Key mask = 0;
+  int64_t remaining = k;
+  std::array<int64_t, kRadixSize> hist;
+  for (int32_t shift = sizeof(Key) * 8 - kRadixBits; shift >= 0; shift -= kRadixBits) {
+    hist.fill(0);
+    FOR_RANGE(int32_t, j, 0, instance_size) {
+      if ((keys[j] & mask) == prefix) { ++hist[(keys[j] >> shift) & (kRadixSize - 1)]; }
+    }
+    int32_t digit = 0;
+    while (hist[digit] < remaining) {
+      remaining -= hist[digit];
+      ++digit;
+    }
+    prefix |= static_cast<Key>(digit) << shift;
+    mask |= static_cast<Key>(kRadixSize - 1) << shift;
+  }
+  // prefix is now the k-th best key, of which the first remaining ones in index order are kept
+  int32_t cnt = 0;
+  FOR_RANGE(int32_t, j, 0, instance_size) {
+    if (keys[j] < prefix || (keys[j] == prefix && remaining > 0)) {
+      if (keys[j] == prefix) { --remaining; }
+      buf->selected_keys[cnt] = keys[j];
+      out_ptr_i[cnt] = j;
+      ++cnt;
+    }
+  }
+  CHECK_EQ(cnt, k);
+  if (sorted) {
+    CpuRadixSortPairs<Key, int32_t>(k, buf->selected_keys.data(), out_ptr_i, buf->keys_buf.data(),
+                                    buf->indices_buf.data(), 1);
+  }
+}
+
+template<typename T>
+void ComputeTopK(const T* in_ptr, const Range& range, int32_t instance_size, int32_t k,
+                 bool sorted, int32_t* out_ptr) {
+  if (k <= kMaxHeapSelectionK) {
+    FOR_RANGE(int32_t, i, range.begin(), range.end()) {
+      HeapSelectionTopK(in_ptr + i * instance_size, instance_size, k, sorted, out_ptr + i * k);
+    }
+  } else {
+    RadixSelectionBuffer<typename cpu_radix_sort::RadixKeyTraits<T>::Key> buf(instance_size, k);
+    FOR_RANGE(int32_t, i, range.begin(), range.end()) {
+      RadixSelectionTopK(in_ptr + i * instance_size, instance_size, k, sorted, &buf,
+                         out_ptr + i * k);
+    }
   }
 }
 
 template<typename T>
-void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t* indices_ptr, int32_t instance_num,
-             int32_t instance_size, int32_t k, bool sorted, int32_t* out_ptr) {
+void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t instance_num, int32_t instance_size,
+             int32_t k, bool sorted, int32_t* out_ptr) {
+  if (k == 0 || instance_num == 0) { return; }
   const int32_t num_thread = std::min(instance_num, Global<ThreadPool>::Get()->thread_num());
   const BalancedSplitter bs(instance_num, num_thread);
   BlockingCounter bc(num_thread);
@@ -64,7 +151,7 @@ void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t* indices_ptr, int32_t inst
       if (k == 1) {
         ComputeTopOne(in_ptr, range, instance_size, out_ptr);
       } else {
-        ComputeTopK(in_ptr, indices_ptr, range, instance_size, k, sorted, out_ptr);
+        ComputeTopK(in_ptr, range, instance_size, k, sorted, out_ptr);
       }
       bc.Decrease();
     });
@@ -84,27 +171,22 @@ class TopKCpuKernel final : public user_op::OpKernel {
   void Compute(user_op::KernelComputeContext* ctx) const override {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
-    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
     const int32_t instance_size = in->shape().At(in->shape().NumAxes() - 1);
+    if (instance_size == 0) { return; }
     const int32_t instance_num = in->shape().elem_cnt() / instance_size;
     const int32_t k = std::min(ctx->Attr<int32_t>("k"), instance_size);
-    int32_t* indices_ptr = tmp_buffer ? tmp_buffer->mut_dptr<int32_t>() : nullptr;
-    CpuTopK(ctx->device_ctx(), in->dptr<T>(), indices_ptr, instance_num, instance_size, k,
+    CpuTopK(ctx->device_ctx(), in->dptr<T>(), instance_num, instance_size, k,
             ctx->Attr<bool>("sorted"), out->mut_dptr<int32_t>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_CPU_TOP_K_KERNEL(dtype)                                                 \
-  REGISTER_USER_KERNEL("top_k")                                                          \
-      .SetCreateFn<TopKCpuKernel<dtype>>()                                               \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                    \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))   \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                \
-        const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);                     \
-        return ctx->Attr<int32_t>("k") > 1 ? in_shape->elem_cnt() * sizeof(int32_t) : 0; \
-      });
+#define REGISTER_CPU_TOP_K_KERNEL(dtype)                              \
+  REGISTER_USER_KERNEL("top_k")                                       \
+      .SetCreateFn<TopKCpuKernel<dtype>>()                            \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value));
 
 REGISTER_CPU_TOP_K_KERNEL(float)
 REGISTER_CPU_TOP_K_KERNEL(double)
@@ -0,0 +1,263 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// Output elements produced by one task of the thread pool, tasks are whole (n, c) planes.
+const int64_t kUpsampleTaskElemCnt = 1 << 14;
+
+int64_t GetNearestInputIndex(const int64_t out_dim_idx, const float scale,
+                             const int64_t in_dim_size) {
+  return std::max(
+      std::min(static_cast<int64_t>(std::floor((static_cast<float>(out_dim_idx) + 0.5f) * scale)),
+               in_dim_size - 1),
+      static_cast<int64_t>(0));
+}
+
+struct LinearParam {
+  int64_t lower_index;
+  int64_t upper_index;
+  float lerp;
+};
+
+// Same source coordinates as the bilinear gpu kernels, per output row or column.
+std::vector<LinearParam> GetLinearParams(const int64_t out_size, const int64_t in_size,
+                                         const float scale) {
+  std::vector<LinearParam> params(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    const float in_i = (static_cast<float>(i) + 0.5f) * scale - 0.5f;
+    params[i].lower_index = in_i > 0.0 ? std::floor(in_i) : 0;
+    params[i].upper_index = (in_i < in_size - 1) ? std::ceil(in_i) : in_size - 1;
+    params[i].lerp = in_i - std::floor(in_i);
+  }
+  return params;
+}
+
+// Calls Handler(plane) for every n * c plane, several planes per task when they are small.
+void ForEachPlane(const int64_t plane_num, const int64_t plane_size,
+                  const std::function<void(int64_t)>& Handler) {
+  const int64_t planes_per_task = std::max<int64_t>(1, kUpsampleTaskElemCnt / plane_size);
+  const int64_t task_num = RoundUp(plane_num, planes_per_task) / planes_per_task;
+  auto Task = [&](size_t task_id) {
+    const int64_t plane_begin = task_id * planes_per_task;
+    const int64_t plane_end = std::min(plane_begin + planes_per_task, plane_num);
+    FOR_RANGE(int64_t, plane, plane_begin, plane_end) { Handler(plane); }
+  };
+  MaybeMultiThreadLoop(task_num, Task);
+}
+
+}  // namespace
+
+template<typename T>
+class UpsampleNearestCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestCPUKernel() = default;
+  ~UpsampleNearestCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const float scale_h = 1.f / ctx->Attr<float>("height_scale");
+    const float scale_w = 1.f / ctx->Attr<float>("width_scale");
+    const int64_t in_height = x_blob->shape().At(2);
+    const int64_t in_width = x_blob->shape().At(3);
+    const int64_t out_height = y_blob->shape().At(2);
+    const int64_t out_width = y_blob->shape().At(3);
+    std::vector<int64_t> in_w_indices(out_width);
+    FOR_RANGE(int64_t, w, 0, out_width) {
+      in_w_indices[w] = GetNearestInputIndex(w, scale_w, in_width);
+    }
+    const T* x_dptr = x_blob->dptr<T>();
+    T* y_dptr = y_blob->mut_dptr<T>();
+    ForEachPlane(x_blob->shape().Count(0, 2), out_height * out_width, [&](int64_t plane) {
+      const T* x_plane = x_dptr + plane * in_height * in_width;
+      T* y_row = y_dptr + plane * out_height * out_width;
+      FOR_RANGE(int64_t, h, 0, out_height) {
+        const T* x_row = x_plane + GetNearestInputIndex(h, scale_h, in_height) * in_width;
+        FOR_RANGE(int64_t, w, 0, out_width) { y_row[w] = x_row[in_w_indices[w]]; }
+        y_row += out_width;
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleNearestGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestGradCPUKernel() = default;
+  ~UpsampleNearestGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const float scale_h = 1.f / ctx->Attr<float>("height_scale");
+    const float scale_w = 1.f / ctx->Attr<float>("width_scale");
+    const int64_t dx_height = dx_blob->shape().At(2);
+    const int64_t dx_width = dx_blob->shape().At(3);
+    const int64_t dy_height = dy_blob->shape().At(2);
+    const int64_t dy_width = dy_blob->shape().At(3);
+    std::vector<int64_t> dx_w_indices(dy_width);
+    FOR_RANGE(int64_t, w, 0, dy_width) {
+      dx_w_indices[w] = GetNearestInputIndex(w, scale_w, dx_width);
+    }
+    const T* dy_dptr = dy_blob->dptr<T>();
+    T* dx_dptr = dx_blob->mut_dptr<T>();
+    // every plane of dx is accumulated by one thread only
+    ForEachPlane(dx_blob->shape().Count(0, 2), dy_height * dy_width, [&](int64_t plane) {
+      T* dx_plane = dx_dptr + plane * dx_height * dx_width;
+      const T* dy_row = dy_dptr + plane * dy_height * dy_width;
+      std::fill(dx_plane, dx_plane + dx_height * dx_width, GetZeroVal<T>());
+      FOR_RANGE(int64_t, h, 0, dy_height) {
+        T* dx_row = dx_plane + GetNearestInputIndex(h, scale_h, dx_height) * dx_width;
+        FOR_RANGE(int64_t, w, 0, dy_width) { dx_row[dx_w_indices[w]] += dy_row[w]; }
+        dy_row += dy_width;
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                       \
+      .SetCreateFn<UpsampleNearestCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                 \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                  \
+      .SetCreateFn<UpsampleNearestGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                 \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                 \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest")));
+
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(double)
+
+template<typename T>
+class UpsampleBilinearCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearCPUKernel() = default;
+  ~UpsampleBilinearCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const int64_t in_height = x_blob->shape().At(2);
+    const int64_t in_width = x_blob->shape().At(3);
+    const int64_t out_height = y_blob->shape().At(2);
+    const int64_t out_width = y_blob->shape().At(3);
+    const std::vector<LinearParam> h_params =
+        GetLinearParams(out_height, in_height, 1.f / ctx->Attr<float>("height_scale"));
+    const std::vector<LinearParam> w_params =
+        GetLinearParams(out_width, in_width, 1.f / ctx->Attr<float>("width_scale"));
+    const T* x_dptr = x_blob->dptr<T>();
+    T* y_dptr = y_blob->mut_dptr<T>();
+    ForEachPlane(x_blob->shape().Count(0, 2), out_height * out_width, [&](int64_t plane) {
+      const T* x_plane = x_dptr + plane * in_height * in_width;
+      T* y_row = y_dptr + plane * out_height * out_width;
+      for (const LinearParam& h_param : h_params) {
+        const T* top_row = x_plane + h_param.lower_index * in_width;
+        const T* bottom_row = x_plane + h_param.upper_index * in_width;
+        FOR_RANGE(int64_t, w, 0, out_width) {
+          const LinearParam& w_param = w_params[w];
+          const T top_left = top_row[w_param.lower_index];
+          const T bottom_left = bottom_row[w_param.lower_index];
+          const T top = top_left + (top_row[w_param.upper_index] - top_left) * w_param.lerp;
+          const T bottom =
+              bottom_left + (bottom_row[w_param.upper_index] - bottom_left) * w_param.lerp;
+          y_row[w] = top + (bottom - top) * h_param.lerp;
+        }
+        y_row += out_width;
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleBilinearGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearGradCPUKernel() = default;
+  ~UpsampleBilinearGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const int64_t dx_height = dx_blob->shape().At(2);
+    const int64_t dx_width = dx_blob->shape().At(3);
+    const int64_t dy_height = dy_blob->shape().At(2);
+    const int64_t dy_width = dy_blob->shape().At(3);
+    const std::vector<LinearParam> h_params =
+        GetLinearParams(dy_height, dx_height, 1.f / ctx->Attr<float>("height_scale"));
+    const std::vector<LinearParam> w_params =
+        GetLinearParams(dy_width, dx_width, 1.f / ctx->Attr<float>("width_scale"));
+    const T* dy_dptr = dy_blob->dptr<T>();
+    T* dx_dptr = dx_blob->mut_dptr<T>();
+    // every plane of dx is accumulated by one thread only
+    ForEachPlane(dx_blob->shape().Count(0, 2), dy_height * dy_width, [&](int64_t plane) {
+      T* dx_plane = dx_dptr + plane * dx_height * dx_width;
+      const T* dy_row = dy_dptr + plane * dy_height * dy_width;
+      std::fill(dx_plane, dx_plane + dx_height * dx_width, GetZeroVal<T>());
+      for (const LinearParam& h_param : h_params) {
+        T* top_row = dx_plane + h_param.lower_index * dx_width;
+        T* bottom_row = dx_plane + h_param.upper_index * dx_width;
+        FOR_RANGE(int64_t, w, 0, dy_width) {
+          const LinearParam& w_param = w_params[w];
+          const T dbottom = h_param.lerp * dy_row[w];
+          const T dtop = dy_row[w] - dbottom;
+          bottom_row[w_param.lower_index] += (1 - w_param.lerp) * dbottom;
+          bottom_row[w_param.upper_index] += w_param.lerp * dbottom;
+          top_row[w_param.lower_index] += (1 - w_param.lerp) * dtop;
+          top_row[w_param.upper_index] += w_param.lerp * dtop;
+        }
+        dy_row += dy_width;
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                        \
+      .SetCreateFn<UpsampleBilinearCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                  \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                   \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                   \
+      .SetCreateFn<UpsampleBilinearGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                  \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear")));
+
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(double)
+
+}  // namespace oneflow
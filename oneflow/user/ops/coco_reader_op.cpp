@@ -34,6 +34,9 @@ REGISTER_CPU_ONLY_USER_OP("COCOReader")
     .Attr<bool>("group_by_ratio", UserOpAttrType::kAtBool, true)
     .Attr<bool>("remove_images_without_annotations", UserOpAttrType::kAtBool, true)
     .Attr<bool>("stride_partition", UserOpAttrType::kAtBool, false)
+    .Attr<std::string>("annotation_index_file", UserOpAttrType::kAtString, "")
+    .Attr<int32_t>("image_reader_num", UserOpAttrType::kAtInt32, 4)
+    .Attr<int32_t>("image_prefetch_num", UserOpAttrType::kAtInt32, 64)
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       const SbpParallel& sbp = ctx->SbpParallel4ArgNameAndIndex("image", 0);
       CHECK_OR_RETURN(sbp == ctx->SbpParallel4ArgNameAndIndex("image_id", 0));
@@ -0,0 +1,144 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// out[b] = pool(weight[indices[b][0]], ..., weight[indices[b][bag_size - 1]]), pool being a sum
+// or a mean over the bag, without materializing the gathered rows.
+REGISTER_USER_OP("embedding_bag")
+    .Input("weight")
+    .Input("indices")
+    .Output("out")
+    .Attr<std::string>("mode", UserOpAttrType::kAtString, "sum")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      const user_op::TensorDesc* indices = ctx->TensorDesc4ArgNameAndIndex("indices", 0);
+      CHECK_EQ_OR_RETURN(weight->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(indices->shape().NumAxes(), 2);
+      CHECK_OR_RETURN(IsIndexDataType(indices->data_type()));
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *weight;
+      *out->mut_shape() = Shape({indices->shape().At(0), weight->shape().At(1)});
+      out->set_is_dynamic(indices->is_dynamic());
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* indices_modifier = GetInputArgModifierFn("indices", 0);
+      CHECK_NOTNULL(indices_modifier);
+      indices_modifier->set_requires_grad(false);
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      const OptInt64* indices_batch_axis = ctx->BatchAxis4ArgNameAndIndex("indices", 0);
+      if (indices_batch_axis->has_value() && indices_batch_axis->value() == 0) {
+        *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *indices_batch_axis;
+      } else {
+        ctx->BatchAxis4ArgNameAndIndex("out", 0)->clear_value();
+      }
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("weight", 0))
+          .Split(user_op::OpArg("indices", 0), 0)
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("weight", 0), 1)
+          .Broadcast(user_op::OpArg("indices", 0))
+          .Split(user_op::OpArg("out", 0), 1)
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& op_def,
+                       const user_op::UserOpConfWrapper& op_conf) -> Maybe<void> {
+      const std::string& mode = op_conf.attr<std::string>("mode");
+      CHECK_OR_RETURN(mode == "sum" || mode == "mean");
+      return Maybe<void>::Ok();
+    });
+
+// dx = scatter-add of dy[b] (divided by bag_size for mean) to the rows indices[b] of a zero like
+REGISTER_USER_OP("embedding_bag_grad")
+    .Input("dy")
+    .Input("indices")
+    .Input("like")
+    .Output("dx")
+    .Attr<std::string>("mode", UserOpAttrType::kAtString, "sum")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* dy = ctx->TensorDesc4ArgNameAndIndex("dy", 0);
+      const user_op::TensorDesc* indices = ctx->TensorDesc4ArgNameAndIndex("indices", 0);
+      const user_op::TensorDesc* like = ctx->TensorDesc4ArgNameAndIndex("like", 0);
+      CHECK_EQ_OR_RETURN(dy->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(indices->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(like->shape().NumAxes(), 2);
+      CHECK_OR_RETURN(IsIndexDataType(indices->data_type()));
+      CHECK_EQ_OR_RETURN(dy->shape().At(0), indices->shape().At(0));
+      CHECK_EQ_OR_RETURN(dy->shape().At(1), like->shape().At(1));
+      CHECK_EQ_OR_RETURN(dy->data_type(), like->data_type());
+      user_op::TensorDesc* dx = ctx->TensorDesc4ArgNameAndIndex("dx", 0);
+      *dx->mut_shape() = like->shape();
+      *dx->mut_data_type() = like->data_type();
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* indices_modifier = GetInputArgModifierFn("indices", 0);
+      CHECK_NOTNULL(indices_modifier);
+      indices_modifier->set_requires_grad(false);
+      user_op::InputArgModifier* like_modifier = GetInputArgModifierFn("like", 0);
+      CHECK_NOTNULL(like_modifier);
+      like_modifier->set_use_header_only(true);
+      like_modifier->set_requires_grad(false);
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("dx", 0) = *ctx->BatchAxis4ArgNameAndIndex("like", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("dy", 0), 0)
+          .Split(user_op::OpArg("indices", 0), 0)
+          .Broadcast(user_op::OpArg("like", 0))
+          .PartialSum(user_op::OpArg("dx", 0))
+          .Build();
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("dy", 0), 1)
+          .Broadcast(user_op::OpArg("indices", 0))
+          .Split(user_op::OpArg("like", 0), 1)
+          .Split(user_op::OpArg("dx", 0), 1)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP_GRAD("embedding_bag")
+    .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
+      if (op.NeedGenGradTensor4OpInput("weight", 0)) {
+        user_op::UserOpConfWrapperBuilder builder(op.op_name() + "_grad");
+        user_op::UserOpConfWrapper grad_op =
+            builder.Op("embedding_bag_grad")
+                .Input("dy", op.GetGradTensorWithOpOutput("out", 0))
+                .Input("indices", op.input("indices", 0))
+                .Input("like", op.input("weight", 0))
+                .Output("dx")
+                .Attr("mode", op.attr<std::string>("mode"))
+                .Build();
+        op.BindGradTensorWithOpInput(grad_op.output("dx", 0), "weight", 0);
+        AddOp(grad_op);
+      }
+    });
+
+}  // namespace oneflow
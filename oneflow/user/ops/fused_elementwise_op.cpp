@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsScalarInput(const Shape& shape) { return shape.NumAxes() == 1 && shape.At(0) == 1; }
+
+}  // namespace
+
+// Applies op_types[i] in order to in_0. Step i reads in_{operand_indices[i]} as its other operand
+// (-1 for none, scalar_operands[i] is used by scalar_add/scalar_mul), with swap_operands[i] != 0
+// meaning the chain value is the right hand side. out is cast to out_data_type at the end.
+REGISTER_USER_OP("fused_elementwise")
+    .InputWithMinimum("in", 1)
+    .Output("out")
+    .Attr("op_types", UserOpAttrType::kAtListString)
+    .Attr("operand_indices", UserOpAttrType::kAtListInt32)
+    .Attr("swap_operands", UserOpAttrType::kAtListInt32)
+    .Attr("scalar_operands", UserOpAttrType::kAtListFloat)
+    .Attr("out_data_type", UserOpAttrType::kAtDataType)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in_0 = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      FOR_RANGE(int32_t, i, 1, ctx->user_op_conf().input_size("in")) {
+        const user_op::TensorDesc* in_i = ctx->TensorDesc4ArgNameAndIndex("in", i);
+        CHECK_EQ_OR_RETURN(in_i->data_type(), in_0->data_type());
+        CHECK_OR_RETURN(in_i->shape() == in_0->shape() || IsScalarInput(in_i->shape()));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in_0;
+      *out->mut_data_type() = ctx->Attr<DataType>("out_data_type");
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const Shape& shape = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0).shape();
+      std::vector<std::pair<std::string, int32_t>> full_inputs;
+      std::vector<std::pair<std::string, int32_t>> scalar_inputs;
+      for (const auto& input : ctx->inputs()) {
+        const Shape& in_shape =
+            ctx->LogicalTensorDesc4InputArgNameAndIndex(input.first, input.second).shape();
+        if (in_shape != shape && IsScalarInput(in_shape)) {
+          scalar_inputs.push_back(input);
+        } else {
+          full_inputs.push_back(input);
+        }
+      }
+      FOR_RANGE(int64_t, axis, 0, shape.NumAxes()) {
+        ctx->NewBuilder()
+            .Split(full_inputs, axis)
+            .Broadcast(scalar_inputs)
+            .Split(ctx->outputs(), axis)
+            .Build();
+      }
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& op_def,
+                       const user_op::UserOpConfWrapper& op_conf) -> Maybe<void> {
+      const size_t step_num = op_conf.attr<std::vector<std::string>>("op_types").size();
+      CHECK_GT_OR_RETURN(step_num, 0);
+      CHECK_EQ_OR_RETURN(op_conf.attr<std::vector<int32_t>>("operand_indices").size(), step_num);
+      CHECK_EQ_OR_RETURN(op_conf.attr<std::vector<int32_t>>("swap_operands").size(), step_num);
+      CHECK_EQ_OR_RETURN(op_conf.attr<std::vector<float>>("scalar_operands").size(), step_num);
+      for (const int32_t index : op_conf.attr<std::vector<int32_t>>("operand_indices")) {
+        CHECK_OR_RETURN(index == -1 || (index >= 0 && index < op_conf.input_size("in")));
+      }
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
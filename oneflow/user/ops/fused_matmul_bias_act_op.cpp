@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// out = activation(matmul(a, b) + bias), bias is added along the last axis of out
+REGISTER_USER_OP("fused_matmul_bias_act")
+    .Input("a")
+    .Input("b")
+    .Input("bias")
+    .Output("out")
+    .Attr<bool>("transpose_a", UserOpAttrType::kAtBool, false)
+    .Attr<bool>("transpose_b", UserOpAttrType::kAtBool, false)
+    .Attr<std::string>("activation", UserOpAttrType::kAtString, "none")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(bias->shape().NumAxes(), 1);
+      CHECK_EQ_OR_RETURN(a->data_type(), b->data_type());
+      CHECK_EQ_OR_RETURN(a->data_type(), bias->data_type());
+      const bool transpose_a = ctx->Attr<bool>("transpose_a");
+      const bool transpose_b = ctx->Attr<bool>("transpose_b");
+      const int64_t m = transpose_a ? a->shape().At(1) : a->shape().At(0);
+      const int64_t k = transpose_a ? a->shape().At(0) : a->shape().At(1);
+      CHECK_EQ_OR_RETURN(k, transpose_b ? b->shape().At(1) : b->shape().At(0));
+      const int64_t n = transpose_b ? b->shape().At(0) : b->shape().At(1);
+      CHECK_EQ_OR_RETURN(bias->shape().At(0), n);
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *a;
+      *out->mut_shape() = Shape({m, n});
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      OptInt64 a_batch_axis(*ctx->BatchAxis4ArgNameAndIndex("a", 0));
+      if (a_batch_axis.has_value() && ctx->Attr<bool>("transpose_a")) {
+        a_batch_axis.set_value(1 - a_batch_axis.value());
+      }
+      OptInt64 b_batch_axis(*ctx->BatchAxis4ArgNameAndIndex("b", 0));
+      if (b_batch_axis.has_value() && ctx->Attr<bool>("transpose_b")) {
+        b_batch_axis.set_value(1 - b_batch_axis.value());
+      }
+      if (a_batch_axis.has_value() && a_batch_axis.value() == 0) {
+        *ctx->BatchAxis4ArgNameAndIndex("out", 0) = a_batch_axis;
+      } else if (b_batch_axis.has_value() && b_batch_axis.value() == 1) {
+        *ctx->BatchAxis4ArgNameAndIndex("out", 0) = b_batch_axis;
+      } else {
+        ctx->BatchAxis4ArgNameAndIndex("out", 0)->clear_value();
+      }
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // partial sum is not allowed, neither the bias nor the activation distributes over it
+      const int32_t m_axis = ctx->Attr<bool>("transpose_a") ? 1 : 0;
+      const int32_t n_axis = ctx->Attr<bool>("transpose_b") ? 0 : 1;
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("a", 0), m_axis)
+          .Broadcast(user_op::OpArg("b", 0))
+          .Broadcast(user_op::OpArg("bias", 0))
+          .Split(ctx->outputs(), 0)
+          .Build();
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("a", 0))
+          .Split(user_op::OpArg("b", 0), n_axis)
+          .Split(user_op::OpArg("bias", 0), 0)
+          .Split(ctx->outputs(), 1)
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& op_def,
+                       const user_op::UserOpConfWrapper& op_conf) -> Maybe<void> {
+      const std::string& activation = op_conf.attr<std::string>("activation");
+      CHECK_OR_RETURN(activation == "none" || activation == "relu" || activation == "gelu");
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,121 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// Optimizer state inputs updated in place together with model, one per model tensor.
+std::vector<std::string> StateArgNames4Optimizer(const std::string& optimizer) {
+  if (optimizer == "adam") {
+    return {"m", "v"};
+  } else if (optimizer == "momentum" || optimizer == "lars") {
+    return {"momentum"};
+  } else {
+    return {};
+  }
+}
+
+}  // namespace
+
+// Applies one optimizer step to every model[i] with model_diff[i] in a single kernel. It replaces
+// a group of *_model_update ops that share placement, data type, learning rate and train step.
+REGISTER_USER_OP("multi_tensor_model_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .Input("train_step")
+    .OptionalInputWithMinimum("m", 1)
+    .OptionalInputWithMinimum("v", 1)
+    .OptionalInputWithMinimum("beta1_t", 1)
+    .OptionalInputWithMinimum("beta2_t", 1)
+    .OptionalInputWithMinimum("momentum", 1)
+    .Attr("optimizer", UserOpAttrType::kAtString)
+    .Attr("weight_decay", UserOpAttrType::kAtListFloat)
+    .Attr<float>("beta1", UserOpAttrType::kAtFloat, 0.9)
+    .Attr<float>("beta2", UserOpAttrType::kAtFloat, 0.999)
+    .Attr<float>("epsilon", UserOpAttrType::kAtFloat, 1e-8)
+    .Attr<bool>("do_bias_correction", UserOpAttrType::kAtBool, false)
+    .Attr<float>("beta", UserOpAttrType::kAtFloat, 0.9)
+    .Attr<float>("decay_rate", UserOpAttrType::kAtFloat, 0.99)
+    .Attr<float>("lars_coefficient", UserOpAttrType::kAtFloat, 0.0001)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::UserOpConfWrapper& conf = ctx->user_op_conf();
+      std::vector<std::string> state_arg_names =
+          StateArgNames4Optimizer(ctx->Attr<std::string>("optimizer"));
+      state_arg_names.push_back("model_diff");
+      const DataType data_type = ctx->TensorDesc4ArgNameAndIndex("model", 0)->data_type();
+      FOR_RANGE(int32_t, i, 0, conf.input_size("model")) {
+        const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", i);
+        CHECK_OR_RETURN(!model->is_dynamic());
+        CHECK_EQ_OR_RETURN(model->data_type(), data_type);
+        for (const std::string& arg_name : state_arg_names) {
+          const user_op::TensorDesc* state = ctx->TensorDesc4ArgNameAndIndex(arg_name, i);
+          CHECK_OR_RETURN(state->shape() == model->shape());
+          CHECK_EQ_OR_RETURN(state->data_type(), data_type);
+        }
+      }
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("learning_rate", 0)->data_type(),
+                         DataType::kFloat);
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("train_step", 0)->data_type(),
+                         DataType::kInt64);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // LARS needs whole tensors for its norms, and model tensors of a group split on different
+      // axes can not share one signature, so every rank updates a full copy
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) {
+      std::vector<std::string> mutable_arg_names =
+          StateArgNames4Optimizer(conf.attr<std::string>("optimizer"));
+      mutable_arg_names.push_back("model");
+      if (conf.has_input("beta1_t", 0)) {
+        mutable_arg_names.push_back("beta1_t");
+        mutable_arg_names.push_back("beta2_t");
+      }
+      for (const std::string& arg_name : mutable_arg_names) {
+        FOR_RANGE(int32_t, i, 0, conf.input_size(arg_name)) {
+          user_op::InputArgModifier* modifier = GetInputArgModifierFn(arg_name, i);
+          CHECK(modifier != nullptr);
+          modifier->set_is_mutable(true);
+        }
+      }
+    })
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& op_def,
+                       const user_op::UserOpConfWrapper& op_conf) -> Maybe<void> {
+      const std::string& optimizer = op_conf.attr<std::string>("optimizer");
+      CHECK_OR_RETURN(optimizer == "naive" || optimizer == "momentum" || optimizer == "rmsprop"
+                      || optimizer == "lars" || optimizer == "adam");
+      const int32_t tensor_num = op_conf.input_size("model");
+      CHECK_EQ_OR_RETURN(op_conf.input_size("model_diff"), tensor_num);
+      CHECK_EQ_OR_RETURN(op_conf.attr<std::vector<float>>("weight_decay").size(),
+                         static_cast<size_t>(tensor_num));
+      for (const std::string& arg_name : StateArgNames4Optimizer(optimizer)) {
+        CHECK_EQ_OR_RETURN(op_conf.input_size(arg_name), tensor_num);
+      }
+      if (optimizer == "adam" && op_conf.attr<bool>("do_bias_correction")) {
+        CHECK_EQ_OR_RETURN(op_conf.input_size("beta1_t"), tensor_num);
+        CHECK_EQ_OR_RETURN(op_conf.input_size("beta2_t"), tensor_num);
+      }
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -26,6 +26,26 @@ REGISTER_CPU_ONLY_USER_OP("ofrecord_raw_decoder")
     .Attr("data_type", UserOpAttrType::kAtDataType)
     .Attr<bool>("dim1_varying_length", UserOpAttrType::kAtBool, false)
     .Attr<bool>("auto_zero_padding", UserOpAttrType::kAtBool, false)
+    .Attr<std::vector<int64_t>>("dim1_length_buckets", UserOpAttrType::kAtListInt64,
+                                std::vector<int64_t>())
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& def,
+                       const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+      const auto& buckets = conf.attr<std::vector<int64_t>>("dim1_length_buckets");
+      if (buckets.empty()) { return Maybe<void>::Ok(); }
+      // the batch is padded up to the smallest bucket holding its longest sample, so the last
+      // bucket has to be the static length
+      const Shape& shape = conf.attr<Shape>("shape");
+      CHECK_GE_OR_RETURN(shape.NumAxes(), 1);
+      CHECK_OR_RETURN(conf.attr<bool>("dim1_varying_length")
+                      || conf.attr<bool>("auto_zero_padding"))
+          << "dim1_length_buckets needs dim1_varying_length or auto_zero_padding";
+      CHECK_GT_OR_RETURN(buckets.front(), 0);
+      FOR_RANGE(size_t, i, 1, buckets.size()) {
+        CHECK_GT_OR_RETURN(buckets.at(i), buckets.at(i - 1));
+      }
+      CHECK_EQ_OR_RETURN(buckets.back(), shape.At(0));
+      return Maybe<void>::Ok();
+    })
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* in_tensor = ctx->TensorDesc4ArgNameAndIndex("in", 0);
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
@@ -37,6 +57,9 @@ REGISTER_CPU_ONLY_USER_OP("ofrecord_raw_decoder")
       for (int i = 1; i < dim_vec.size(); ++i) { dim_vec[i] = conf_shape.At(i - 1); }
       *out_tensor->mut_shape() = Shape(dim_vec);
       *out_tensor->mut_data_type() = ctx->Attr<DataType>("data_type");
+      if (!ctx->Attr<std::vector<int64_t>>("dim1_length_buckets").empty()) {
+        out_tensor->set_is_dynamic(true);
+      }
       return Maybe<void>::Ok();
     })
     .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
@@ -45,6 +68,13 @@ REGISTER_CPU_ONLY_USER_OP("ofrecord_raw_decoder")
       CHECK_NOTNULL(in_modifier);
       in_modifier->set_requires_grad(false);
     })
+    .SetOutputArgModifyFn([](user_op::GetOutputArgModifier GetOutputArgModifierFn,
+                             const user_op::UserOpConfWrapper& conf) {
+      if (conf.attr<std::vector<int64_t>>("dim1_length_buckets").empty()) { return; }
+      user_op::OutputArgModifier* out_modifier = GetOutputArgModifierFn("out", 0);
+      CHECK(out_modifier != nullptr);
+      out_modifier->set_header_infered_before_compute(false);
+    })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
       ctx->NewBuilder()
           .Split(user_op::OpArg("in", 0), 0)
@@ -0,0 +1,258 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+std::vector<std::pair<std::string, int32_t>> InputsExcept(
+    const user_op::SbpContext* ctx, const std::vector<std::string>& excluded_names) {
+  std::vector<std::pair<std::string, int32_t>> args;
+  for (const auto& pair : ctx->inputs()) {
+    if (std::find(excluded_names.begin(), excluded_names.end(), pair.first)
+        == excluded_names.end()) {
+      args.push_back(pair);
+    }
+  }
+  return args;
+}
+
+}  // namespace
+
+// Records the running min and max of "in" into output_path, per tensor when per_channel_axis is
+// -1, otherwise one line per channel. With more than one rank, rank i writes the range of its
+// slice to output_path-i.
+REGISTER_CPU_ONLY_USER_OP("min_max_observer")
+    .Input("in")
+    .Attr("output_path", UserOpAttrType::kAtString)
+    .Attr<int32_t>("per_channel_axis", UserOpAttrType::kAtInt32, -1)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_OR_RETURN(IsFloatingDataType(in->data_type()));
+      const int32_t axis = ctx->Attr<int32_t>("per_channel_axis");
+      CHECK_GE_OR_RETURN(axis, -1);
+      CHECK_LT_OR_RETURN(axis, in->shape().NumAxes());
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // the ranges of the slices merge into the per tensor range, so any split works
+      if (ctx->Attr<int32_t>("per_channel_axis") == -1) {
+        const int64_t num_axes =
+            ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0).shape().NumAxes();
+        FOR_RANGE(int64_t, axis, 0, num_axes) {
+          ctx->NewBuilder().Split(user_op::OpArg("in", 0), axis).Build();
+        }
+      }
+      ctx->NewBuilder().Broadcast(user_op::OpArg("in", 0)).Build();
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("quantize")
+    .Input("in")
+    .Output("out")
+    .Attr("scale", UserOpAttrType::kAtFloat)
+    .Attr("zero_point", UserOpAttrType::kAtInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kFloat);
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kUInt8;
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetGetSbpFn(user_op::GetSbpFnUtil::SplitForEachAxis)
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& op_def,
+                       const user_op::UserOpConfWrapper& op_conf) -> Maybe<void> {
+      CHECK_GT_OR_RETURN(op_conf.attr<float>("scale"), 0);
+      CHECK_GE_OR_RETURN(op_conf.attr<int32_t>("zero_point"), 0);
+      CHECK_LE_OR_RETURN(op_conf.attr<int32_t>("zero_point"), 255);
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("dequantize")
+    .Input("in")
+    .Output("out")
+    .Attr("scale", UserOpAttrType::kAtFloat)
+    .Attr("zero_point", UserOpAttrType::kAtInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kUInt8);
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kFloat;
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetGetSbpFn(user_op::GetSbpFnUtil::SplitForEachAxis);
+
+// Symmetric int8 quantization with one scale per slice along axis, computed from the data. "in"
+// is expected to be a constant weight: the cpu kernel quantizes it on the first run only.
+REGISTER_USER_OP("quantize_weight")
+    .Input("in")
+    .Output("out")
+    .Output("scale")
+    .Attr("axis", UserOpAttrType::kAtInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kFloat);
+      const int32_t axis = ctx->Attr<int32_t>("axis");
+      CHECK_GE_OR_RETURN(axis, 0);
+      CHECK_LT_OR_RETURN(axis, in->shape().NumAxes());
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kInt8;
+      user_op::TensorDesc* scale = ctx->TensorDesc4ArgNameAndIndex("scale", 0);
+      *scale = *in;
+      *scale->mut_shape() = Shape({in->shape().At(axis)});
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      ctx->BatchAxis4ArgNameAndIndex("out", 0)->clear_value();
+      ctx->BatchAxis4ArgNameAndIndex("scale", 0)->clear_value();
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const int32_t axis = ctx->Attr<int32_t>("axis");
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("in", 0), axis)
+          .Split(user_op::OpArg("out", 0), axis)
+          .Split(user_op::OpArg("scale", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+// out = a_scale * b_scale * (a - a_zero_point) * b + bias, with uint8 a, int8 b and float out.
+// b is expected to be constant, its packed layout and row sums are computed on the first run.
+REGISTER_USER_OP("quantized_matmul")
+    .Input("a")
+    .Input("b")
+    .Input("b_scale")
+    .OptionalInput("bias")
+    .Output("out")
+    .Attr<bool>("transpose_b", UserOpAttrType::kAtBool, false)
+    .Attr("a_scale", UserOpAttrType::kAtFloat)
+    .Attr("a_zero_point", UserOpAttrType::kAtInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      CHECK_EQ_OR_RETURN(a->data_type(), DataType::kUInt8);
+      CHECK_EQ_OR_RETURN(b->data_type(), DataType::kInt8);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      const bool transpose_b = ctx->Attr<bool>("transpose_b");
+      const int64_t m = a->shape().At(0);
+      const int64_t k = a->shape().At(1);
+      CHECK_EQ_OR_RETURN(k, transpose_b ? b->shape().At(1) : b->shape().At(0));
+      const int64_t n = transpose_b ? b->shape().At(0) : b->shape().At(1);
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("b_scale", 0)->shape(), Shape({n}));
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      if (bias != nullptr) { CHECK_EQ_OR_RETURN(bias->shape(), Shape({n})); }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *a;
+      *out->mut_data_type() = DataType::kFloat;
+      *out->mut_shape() = Shape({m, n});
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      const OptInt64* a_batch_axis = ctx->BatchAxis4ArgNameAndIndex("a", 0);
+      if (a_batch_axis->has_value() && a_batch_axis->value() == 0) {
+        *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *a_batch_axis;
+      } else {
+        ctx->BatchAxis4ArgNameAndIndex("out", 0)->clear_value();
+      }
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const int32_t n_axis = ctx->Attr<bool>("transpose_b") ? 0 : 1;
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("a", 0), 0)
+          .Broadcast(InputsExcept(ctx, {"a"}))
+          .Split(ctx->outputs(), 0)
+          .Build();
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("a", 0))
+          .Split(user_op::OpArg("b", 0), n_axis)
+          .Split(InputsExcept(ctx, {"a", "b"}), 0)
+          .Split(ctx->outputs(), 1)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+// 2-D convolution over channels_first uint8 input and int8 weight, producing float output.
+// weight is expected to be constant, its row sums are computed on the first run.
+REGISTER_USER_OP("quantized_conv2d")
+    .Input("in")
+    .Input("weight")
+    .Input("weight_scale")
+    .OptionalInput("bias")
+    .Output("out")
+    .Attr("filters", UserOpAttrType::kAtInt32)
+    .Attr("padding_before", UserOpAttrType::kAtListInt32)
+    .Attr("kernel_size", UserOpAttrType::kAtListInt32)
+    .Attr("strides", UserOpAttrType::kAtListInt32)
+    .Attr("dilation_rate", UserOpAttrType::kAtListInt32)
+    .Attr("in_scale", UserOpAttrType::kAtFloat)
+    .Attr("in_zero_point", UserOpAttrType::kAtInt32)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kUInt8);
+      CHECK_EQ_OR_RETURN(weight->data_type(), DataType::kInt8);
+      CHECK_EQ_OR_RETURN(in->shape().NumAxes(), 4);
+      const int32_t filters = ctx->Attr<int32_t>("filters");
+      const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+      const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+      const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+      const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+      CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+      CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+      CHECK_EQ_OR_RETURN(strides.size(), 2);
+      CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+      CHECK_EQ_OR_RETURN(weight->shape(), Shape({filters, in->shape().At(1), kernel_size.at(0),
+                                                 kernel_size.at(1)}));
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("weight_scale", 0)->shape(),
+                         Shape({filters}));
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      if (bias != nullptr) { CHECK_EQ_OR_RETURN(bias->shape(), Shape({filters})); }
+      DimVector out_shape = {in->shape().At(0), filters, 0, 0};
+      for (int32_t i = 0; i < 2; ++i) {
+        CalcConvOut(in->shape().At(2 + i), kernel_size.at(i), dilation_rate.at(i), strides.at(i),
+                    padding_before.at(i), &out_shape.at(2 + i));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kFloat;
+      *out->mut_shape() = Shape(out_shape);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("in", 0), 0)
+          .Broadcast(InputsExcept(ctx, {"in"}))
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/summary/crc32c.h"
+#include <cstring>
+#include "oneflow/core/common/platform.h"
+
+#if defined(PLATFORM_IS_X86) && defined(__x86_64__) && defined(__GNUC__)
+#define OF_CRC32C_WITH_SSE42
+#include <nmmintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace summary {
+
+namespace {
+
+// reflected Castagnoli polynomial
+const uint32_t kCrc32cPoly = 0x82f63b78;
+
+// table[k][b] is the crc of byte b followed by k zero bytes.
+struct Crc32cTables {
+  uint32_t table[8][256];
+
+  Crc32cTables() {
+    FOR_RANGE(uint32_t, b, 0, 256) {
+      uint32_t crc = b;
+      FOR_RANGE(int32_t, bit, 0, 8) { crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPoly : 0); }
+      table[0][b] = crc;
+    }
+    FOR_RANGE(uint32_t, b, 0, 256) {
+      FOR_RANGE(int32_t, k, 1, 8) {
+        table[k][b] = table[0][table[k - 1][b] & 0xff] ^ (table[k - 1][b] >> 8);
+      }
+    }
+  }
+};
+
+uint32_t ExtendCrc32cSlicingBy8(uint32_t crc, const uint8_t* p, size_t size) {
+  static const Crc32cTables tables;
+  const auto& t = tables.table;
+  for (; size >= 8; p += 8, size -= 8) {
+    crc ^= static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+           | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^ t[5][(crc >> 16) & 0xff] ^ t[4][crc >> 24]
+          ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+  }
+  for (; size > 0; ++p, --size) { crc = t[0][(crc ^ *p) & 0xff] ^ (crc >> 8); }
+  return crc;
+}
+
+#ifdef OF_CRC32C_WITH_SSE42
+__attribute__((target("sse4.2"))) uint32_t ExtendCrc32cSse42(uint32_t crc, const uint8_t* p,
+                                                             size_t size) {
+  uint64_t crc64 = crc;
+  for (; size >= 8; p += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; ++p, --size) { crc = _mm_crc32_u8(crc, *p); }
+  return crc;
+}
+#endif
+
+using ExtendCrc32cFn = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+ExtendCrc32cFn ChooseExtendCrc32cFn() {
+#ifdef OF_CRC32C_WITH_SSE42
+  if (__builtin_cpu_supports("sse4.2")) { return &ExtendCrc32cSse42; }
+#endif
+  return &ExtendCrc32cSlicingBy8;
+}
+
+}  // namespace
+
+uint32_t GetCrc32(const char* buf, size_t size) {
+  static const ExtendCrc32cFn ExtendCrc32c = ChooseExtendCrc32cFn();
+  return ExtendCrc32c(0xffffffffu, reinterpret_cast<const uint8_t*>(buf), size) ^ 0xffffffffu;
+}
+
+}  // namespace summary
+
+}  // namespace oneflow
@@ -0,0 +1,54 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/summary/crc32c.h"
+
+namespace oneflow {
+
+namespace summary {
+
+namespace {
+
+uint32_t BitwiseCrc32c(const char* buf, size_t size) {
+  uint32_t crc = 0xffffffffu;
+  FOR_RANGE(size_t, i, 0, size) {
+    crc ^= static_cast<uint8_t>(buf[i]);
+    FOR_RANGE(int32_t, bit, 0, 8) { crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0); }
+  }
+  return crc ^ 0xffffffffu;
+}
+
+}  // namespace
+
+TEST(Crc32c, known_values) {
+  ASSERT_EQ(GetCrc32("", 0), 0);
+  ASSERT_EQ(GetCrc32("123456789", 9), 0xe3069283);
+  const std::string zeros(32, '\0');
+  ASSERT_EQ(GetCrc32(zeros.data(), zeros.size()), 0x8a9136aa);
+}
+
+TEST(Crc32c, matches_bitwise_on_unaligned_buffers) {
+  std::string data(300, '\0');
+  FOR_RANGE(size_t, i, 0, data.size()) { data[i] = static_cast<char>(i * 131 + 7); }
+  FOR_RANGE(size_t, offset, 0, 8) {
+    FOR_RANGE(size_t, size, 0, data.size() - offset) {
+      ASSERT_EQ(GetCrc32(data.data() + offset, size), BitwiseCrc32c(data.data() + offset, size));
+    }
+  }
+}
+
+}  // namespace summary
+
+}  // namespace oneflow
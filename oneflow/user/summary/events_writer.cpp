@@ -21,17 +21,28 @@ namespace oneflow {
 
 namespace summary {
 
-EventsWriter::EventsWriter() : is_inited_(false) {}
+EventsWriter::EventsWriter()
+    : is_inited_(false),
+      unflushed_byte_size_(0),
+      last_flush_time_(0),
+      last_file_check_time_(0),
+      appended_event_cnt_(0),
+      flushed_event_cnt_(0),
+      flush_requested_(false) {}
 
 EventsWriter::~EventsWriter() { Close(); }
 
 Maybe<void> EventsWriter::Init(const std::string& logdir) {
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  if (is_inited_) { return Maybe<void>::Ok(); }
   file_system_ = std::make_unique<fs::PosixFileSystem>();
   log_dir_ = logdir + "/event";
   file_system_->RecursivelyCreateDirIfNotExist(log_dir_);
   TryToInit();
   is_inited_ = true;
   last_flush_time_ = CurrentMircoTime();
+  last_file_check_time_ = last_flush_time_;
+  writer_thread_ = std::thread(&EventsWriter::WriterLoop, this);
   return Maybe<void>::Ok();
 }
 
@@ -56,60 +67,104 @@ Maybe<void> EventsWriter::TryToInit() {
     event.set_wall_time(current_time);
     event.set_file_version(FILE_VERSION);
     WriteEvent(event);
-    Flush();
+    FileFlush();
   }
   return Maybe<void>::Ok();
 }
 
 void EventsWriter::AppendQueue(std::unique_ptr<Event> event) {
-  queue_mutex.lock();
-  event_queue_.emplace_back(std::move(event));
-  queue_mutex.unlock();
-  if (event_queue_.size() > MAX_QUEUE_NUM || CurrentMircoTime() - last_flush_time_ > FLUSH_TIME) {
-    Flush();
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  producer_cond_.wait(
+      lock, [this]() { return event_queue_.size() < kMaxPendingEventNum || !is_inited_; });
+  if (!is_inited_) {
+    LOG(WARNING) << "Event dropped because the summary writer is not created or closed.";
+    return;
   }
+  event_queue_.emplace_back(std::move(event));
+  appended_event_cnt_ += 1;
+  if (event_queue_.size() == 1) { writer_cond_.notify_one(); }
 }
 
 void EventsWriter::Flush() {
-  queue_mutex.lock();
-  for (const std::unique_ptr<Event>& e : event_queue_) { WriteEvent(*e); }
-  event_queue_.clear();
-  queue_mutex.unlock();
-  FileFlush();
-  last_flush_time_ = CurrentMircoTime();
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  if (!is_inited_) { return; }
+  const int64_t event_cnt = appended_event_cnt_;
+  flush_requested_ = true;
+  writer_cond_.notify_one();
+  producer_cond_.wait(lock, [&]() { return flushed_event_cnt_ >= event_cnt; });
 }
 
-void EventsWriter::WriteEvent(const Event& event) {
-  std::string event_str;
-  event.AppendToString(&event_str);
-  if (!TryToInit().IsOk()) {
-    LOG(ERROR) << "Write failed because file could not be opened.";
-    return;
+void EventsWriter::WriterLoop() {
+  std::vector<std::unique_ptr<Event>> events;
+  bool is_closing = false;
+  while (!is_closing) {
+    bool flush_requested = false;
+    int64_t event_cnt = 0;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      writer_cond_.wait_for(lock, std::chrono::microseconds(kFlushMicroTime), [this]() {
+        return !event_queue_.empty() || flush_requested_ || !is_inited_;
+      });
+      // the queue gets back the cleared buffer of the last round, so appending does not allocate
+      events.swap(event_queue_);
+      event_cnt = appended_event_cnt_;
+      is_closing = !is_inited_;
+      flush_requested = flush_requested_ || is_closing;
+      flush_requested_ = false;
+    }
+    producer_cond_.notify_all();
+    const uint64_t now = CurrentMircoTime();
+    if (now - last_file_check_time_ >= kFileCheckMicroTime) {
+      if (!TryToInit().IsOk()) { LOG(ERROR) << "Write failed because file could not be opened."; }
+      last_file_check_time_ = now;
+    }
+    for (const std::unique_ptr<Event>& e : events) { WriteEvent(*e); }
+    events.clear();
+    if (flush_requested || unflushed_byte_size_ >= kFlushByteSize
+        || (unflushed_byte_size_ > 0 && now - last_flush_time_ >= kFlushMicroTime)) {
+      FileFlush();
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        flushed_event_cnt_ = event_cnt;
+      }
+      producer_cond_.notify_all();
+    }
   }
+}
+
+void EventsWriter::WriteEvent(const Event& event) {
   if (writable_file_ == nullptr) {
     LOG(WARNING) << "Log file is closed!";
     return;
   }
-
+  event_str_.clear();
+  event.AppendToString(&event_str_);
   char head[kHeadSize];
   char tail[kTailSize];
-  EncodeHead(head, event_str.size());
-  EncodeTail(tail, event_str.data(), event_str.size());
+  EncodeHead(head, event_str_.size());
+  EncodeTail(tail, event_str_.data(), event_str_.size());
   writable_file_->Append(head, sizeof(head));
-  writable_file_->Append(event_str.data(), event_str.size());
+  writable_file_->Append(event_str_.data(), event_str_.size());
   writable_file_->Append(tail, sizeof(tail));
-  FileFlush();
+  unflushed_byte_size_ += sizeof(head) + event_str_.size() + sizeof(tail);
 }
 
 void EventsWriter::FileFlush() {
   if (writable_file_ == nullptr) { return; }
   writable_file_->Flush();
+  unflushed_byte_size_ = 0;
+  last_flush_time_ = CurrentMircoTime();
 }
 
 void EventsWriter::Close() {
-  if (!is_inited_) { return; }
-  queue_mutex.unlock();
-  Flush();
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if (!is_inited_) { return; }
+    is_inited_ = false;
+  }
+  writer_cond_.notify_one();
+  producer_cond_.notify_all();
+  writer_thread_.join();
   if (writable_file_ != nullptr) {
     writable_file_->Close();
     writable_file_.reset(nullptr);
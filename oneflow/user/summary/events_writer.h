@@ -23,32 +23,42 @@ limitations under the License.
 
 #include <time.h>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
 
 namespace oneflow {
 
 namespace summary {
 
-#define MAX_QUEUE_NUM 10
-#define FLUSH_TIME 3 * 60 * 1000 * 1000
 #define FILE_VERSION "brain.Event:3"
 const size_t kHeadSize = sizeof(uint64_t) + sizeof(uint32_t);
 const size_t kTailSize = sizeof(uint32_t);
-
+// AppendQueue blocks only when this many events wait for the writer thread.
+const size_t kMaxPendingEventNum = 4096;
+// Group commit: the file is flushed once this many bytes or this much time has accumulated.
+const size_t kFlushByteSize = 1 << 20;
+const uint64_t kFlushMicroTime = 1000 * 1000;
+// Period of the check that the log file was not removed under us.
+const uint64_t kFileCheckMicroTime = 10 * 1000 * 1000;
+
+// Events are encoded, written and flushed by a background thread so that the summary kernels only
+// pay for a queue push.
 class EventsWriter {
  public:
   EventsWriter();
   ~EventsWriter();
 
   Maybe<void> Init(const std::string& logdir);
-  void WriteEvent(const Event& event);
+  void AppendQueue(std::unique_ptr<Event> event);
+  // Returns once every event appended before the call is in the file.
   void Flush();
   void Close();
 
-  void AppendQueue(std::unique_ptr<Event> event);
-  void FileFlush();
-
  private:
+  void WriterLoop();
   Maybe<void> TryToInit();
+  void WriteEvent(const Event& event);
+  void FileFlush();
   inline static void EncodeHead(char* head, size_t size);
   inline static void EncodeTail(char* tail, const char* data, size_t size);
 
@@ -57,9 +67,20 @@ class EventsWriter {
   std::string filename_;
   std::unique_ptr<fs::FileSystem> file_system_;
   std::unique_ptr<fs::WritableFile> writable_file_;
+  // owned by the writer thread
+  std::string event_str_;
+  size_t unflushed_byte_size_;
   uint64_t last_flush_time_;
+  uint64_t last_file_check_time_;
+  // guarded by queue_mutex_
   std::vector<std::unique_ptr<Event>> event_queue_;
-  std::mutex queue_mutex;
+  int64_t appended_event_cnt_;
+  int64_t flushed_event_cnt_;
+  bool flush_requested_;
+  std::mutex queue_mutex_;
+  std::condition_variable writer_cond_;
+  std::condition_variable producer_cond_;
+  std::thread writer_thread_;
   OF_DISALLOW_COPY(EventsWriter);
 };
 